@@ -40,6 +40,18 @@ const std::unordered_map<LmdEstimatorType, std::string> LmdEstimatorTypeToString
 		{{CHI2, "CHI2"},{LOG_LIKELIHOOD, "LOG_LIKELIHOOD"}};
 #endif
 
+enum LmdMinimizerType {
+	MINUIT, LEVENBERG_MARQUARDT
+};
+
+#ifndef __CINT__
+const std::unordered_map<std::string, LmdMinimizerType> StringToLmdMinimizerType =
+		{{"MINUIT", MINUIT},{"LEVENBERG_MARQUARDT", LEVENBERG_MARQUARDT}};
+
+const std::unordered_map<LmdMinimizerType, std::string> LmdMinimizerTypeToString =
+		{{MINUIT, "MINUIT"},{LEVENBERG_MARQUARDT, "LEVENBERG_MARQUARDT"}};
+#endif
+
 enum LmdDataType {
 	HISTOGRAM, EFFICIENCY
 };
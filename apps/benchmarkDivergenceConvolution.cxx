@@ -0,0 +1,283 @@
+/*
+ * Benchmark of the divergence smearing convolution. Compares the former
+ * per bin stencil of PndLmdDifferentialSmearingConvolutionModel2D (every
+ * grid bin evaluates the unsmeared model at all shifted positions of the
+ * divergence kernel) with the GridConvolution2D engine in its direct, fft
+ * and separable (two 1D passes) mode, for a range of kernel sizes. The
+ * unsmeared model and the divergence kernel are gaussians, so no input files
+ * are required.
+ */
+
+#include "core/WorkerPool.h"
+#include "models2d/GaussianModel2D.h"
+#include "operators2d/convolution/GridConvolution2D.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+struct GridSetup {
+  unsigned int bins;
+  mydouble range_low;
+  mydouble bin_size;
+};
+
+std::vector<mydouble> createGaussianKernel1D(int half_width,
+    double sigma_in_bins) {
+  std::vector<mydouble> kernel(2 * half_width + 1);
+  mydouble sum(0.0);
+  for (int d = -half_width; d <= half_width; ++d) {
+    kernel[d + half_width] = std::exp(
+        -0.5 * d * d / (sigma_in_bins * sigma_in_bins));
+    sum += kernel[d + half_width];
+  }
+  for (auto &value : kernel)
+    value /= sum;
+  return kernel;
+}
+
+std::vector<mydouble> createOuterProduct(const std::vector<mydouble> &kernel_x,
+    const std::vector<mydouble> &kernel_y) {
+  std::vector<mydouble> kernel(kernel_x.size() * kernel_y.size());
+  for (unsigned int ix = 0; ix < kernel_x.size(); ++ix) {
+    for (unsigned int iy = 0; iy < kernel_y.size(); ++iy)
+      kernel[ix * kernel_y.size() + iy] = kernel_x[ix] * kernel_y[iy];
+  }
+  return kernel;
+}
+
+// the former implementation: the model is evaluated at every shifted
+// position of every bin and the contributions are summed pairwise
+void convolveWithStencil(std::shared_ptr<Model2D> model,
+    const GridSetup &grid, int half_width, const std::vector<mydouble> &kernel,
+    std::vector<mydouble> &output, WorkerPool &pool) {
+  WorkerPool::Task task = [&](unsigned int index) {
+    unsigned int rows_per_thread(grid.bins / pool.getNumberOfThreads() + 1);
+    unsigned int begin(index * rows_per_thread);
+    unsigned int end(std::min(begin + rows_per_thread, grid.bins));
+    std::vector<mydouble> numbers;
+    mydouble x[2];
+    mydouble xx[2];
+    for (unsigned int ix = begin; ix < end; ++ix) {
+      x[0] = grid.range_low + grid.bin_size * (0.5 + ix);
+      for (unsigned int iy = 0; iy < grid.bins; ++iy) {
+        x[1] = grid.range_low + grid.bin_size * (0.5 + iy);
+        numbers.clear();
+        for (int dx = -half_width; dx <= half_width; ++dx) {
+          for (int dy = -half_width; dy <= half_width; ++dy) {
+            xx[0] = x[0] - grid.bin_size * dx;
+            xx[1] = x[1] - grid.bin_size * dy;
+            numbers.push_back(
+                model->evaluate(xx)
+                    * kernel[(dx + half_width) * (2 * half_width + 1) + dy
+                        + half_width]);
+          }
+        }
+        while (numbers.size() > 1) {
+          std::vector<mydouble> temp_sum;
+          for (unsigned int i = 0; i + 1 < numbers.size(); i = i + 2)
+            temp_sum.push_back(numbers[i] + numbers[i + 1]);
+          if (numbers.size() % 2 == 1)
+            temp_sum.push_back(numbers.back());
+          numbers = temp_sum;
+        }
+        output[ix * grid.bins + iy] = numbers[0];
+      }
+    }
+  };
+  pool.run(task, pool.getNumberOfThreads());
+}
+
+// the new implementation: the model is evaluated once per bin of the
+// extended grid, then the grid is convolved with the kernel
+void convolveWithEngine(std::shared_ptr<Model2D> model,
+    const GridSetup &grid, GridConvolution2D &convolution,
+    std::vector<mydouble> &input, std::vector<mydouble> &output,
+    WorkerPool &pool) {
+  const unsigned int input_bins_x(convolution.getInputBinsX());
+  const unsigned int input_bins_y(convolution.getInputBinsY());
+  const int half_width_x(convolution.getKernelHalfWidthX());
+  const int half_width_y(convolution.getKernelHalfWidthY());
+  input.resize(input_bins_x * input_bins_y);
+
+  WorkerPool::Task task = [&](unsigned int index) {
+    unsigned int rows_per_thread(input_bins_x / pool.getNumberOfThreads() + 1);
+    unsigned int begin(index * rows_per_thread);
+    unsigned int end(std::min(begin + rows_per_thread, input_bins_x));
+    std::vector<mydouble> coordinates(2 * input_bins_y);
+    for (unsigned int ix = begin; ix < end; ++ix) {
+      for (unsigned int iy = 0; iy < input_bins_y; ++iy) {
+        coordinates[2 * iy] = grid.range_low
+            + grid.bin_size * (0.5 + (int) ix - half_width_x);
+        coordinates[2 * iy + 1] = grid.range_low
+            + grid.bin_size * (0.5 + (int) iy - half_width_y);
+      }
+      model->evaluateBatch(coordinates.data(), input_bins_y,
+          &input[ix * input_bins_y]);
+    }
+  };
+  pool.run(task, pool.getNumberOfThreads());
+  convolution.convolve(input.data(), output.data(), pool);
+}
+
+template<typename Function>
+double measureMilliSecondsPerCall(Function f, unsigned int iterations) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < iterations; ++i)
+    f();
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(stop - start).count()
+      / iterations;
+}
+
+double maximalRelativeDeviation(const std::vector<mydouble> &reference,
+    const std::vector<mydouble> &values) {
+  mydouble maximum(0.0);
+  for (auto const value : reference)
+    maximum = std::max(maximum, std::abs(value));
+  // relative to the bin content, ignoring the bins far out in the tails
+  double deviation(0.0);
+  for (unsigned int i = 0; i < reference.size(); ++i) {
+    if (std::abs(reference[i]) > 1e-9 * maximum)
+      deviation = std::max(deviation,
+          (double) std::abs((values[i] - reference[i]) / reference[i]));
+  }
+  return deviation;
+}
+
+void benchmarkDivergenceConvolution(unsigned int bins, unsigned int nthreads,
+    unsigned int iterations, unsigned int max_half_width) {
+  GridSetup grid;
+  grid.bins = bins;
+  grid.range_low = -10.0;
+  grid.bin_size = 20.0 / bins;
+
+  std::shared_ptr<Model2D> model(new GaussianModel2D("unsmeared_model"));
+  ModelParSet &par_set = model->getModelParameterSet();
+  par_set.getModelParameter("gauss_sigma_var1")->setValue(2.0);
+  par_set.getModelParameter("gauss_sigma_var2")->setValue(1.5);
+  par_set.getModelParameter("gauss_mean_var1")->setValue(0.5);
+  par_set.getModelParameter("gauss_mean_var2")->setValue(-0.5);
+  par_set.getModelParameter("gauss_rho")->setValue(0.3);
+  par_set.getModelParameter("gauss_amplitude")->setValue(1e6);
+
+  WorkerPool pool(nthreads);
+
+  cout << "grid: " << bins << "x" << bins << " bins, " << nthreads
+      << " threads, " << iterations << " iterations" << endl;
+  cout << "times per grid in ms" << endl;
+  cout << "kernel     stencil    direct    fft       separable  automatic  "
+      "dev(direct)  dev(fft)  dev(separable)" << endl;
+
+  std::vector<mydouble> stencil_output(bins * bins);
+  std::vector<mydouble> direct_output(bins * bins);
+  std::vector<mydouble> fft_output(bins * bins);
+  std::vector<mydouble> separable_output(bins * bins);
+  std::vector<mydouble> input;
+
+  for (unsigned int half_width = 1; half_width <= max_half_width;
+      half_width *= 2) {
+    // kernel up to about three sigma, like the divergence map
+    std::vector<mydouble> kernel_1d(
+        createGaussianKernel1D(half_width, half_width / 3.0));
+    std::vector<mydouble> kernel(createOuterProduct(kernel_1d, kernel_1d));
+
+    GridConvolution2D direct_convolution(bins, bins);
+    direct_convolution.setMethod(GridConvolution2D::DIRECT);
+    direct_convolution.setKernel(half_width, half_width, kernel);
+    GridConvolution2D fft_convolution(bins, bins);
+    fft_convolution.setMethod(GridConvolution2D::FFT);
+    GridConvolution2D separable_convolution(bins, bins);
+    separable_convolution.setSeparableKernel(half_width, half_width,
+        kernel_1d, kernel_1d);
+    GridConvolution2D automatic_convolution(bins, bins);
+    automatic_convolution.setKernel(half_width, half_width, kernel);
+
+    double stencil_time = measureMilliSecondsPerCall(
+        [&]() {convolveWithStencil(model, grid, half_width, kernel,
+              stencil_output, pool);}, iterations);
+    double direct_time = measureMilliSecondsPerCall(
+        [&]() {convolveWithEngine(model, grid, direct_convolution, input,
+              direct_output, pool);}, iterations);
+    // the kernel spectrum is part of the fft timing, as it is recomputed
+    // whenever the divergence changes
+    double fft_time = measureMilliSecondsPerCall([&]() {
+      fft_convolution.setKernel(half_width, half_width, kernel);
+      convolveWithEngine(model, grid, fft_convolution, input, fft_output,
+          pool);}, iterations);
+    double separable_time = measureMilliSecondsPerCall(
+        [&]() {convolveWithEngine(model, grid, separable_convolution, input,
+              separable_output, pool);}, iterations);
+
+    cout << (2 * half_width + 1) << "x" << (2 * half_width + 1) << "\t   "
+        << stencil_time << "\t" << direct_time << "\t" << fft_time << "\t"
+        << separable_time << "\t   "
+        << (automatic_convolution.getUsedMethod() == GridConvolution2D::FFT ?
+            "fft" : "direct") << "\t     "
+        << maximalRelativeDeviation(stencil_output, direct_output) << "\t  "
+        << maximalRelativeDeviation(stencil_output, fft_output) << "\t  "
+        << maximalRelativeDeviation(stencil_output, separable_output) << endl;
+  }
+}
+
+void displayInfo() {
+  cout << "Optional arguments are: " << endl;
+  cout << "-b [number of bins per axis] (default 200)" << endl;
+  cout << "-m [number of threads] (default 4)" << endl;
+  cout << "-n [number of iterations] (default 5)" << endl;
+  cout << "-k [maximal kernel half width in bins] (default 32)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  unsigned int bins(200);
+  unsigned int nthreads(4);
+  unsigned int iterations(5);
+  unsigned int max_half_width(32);
+
+  int c;
+
+  while ((c = getopt(argc, argv, "hb:m:n:k:")) != -1) {
+    switch (c) {
+      case 'b':
+        bins = atoi(optarg);
+        break;
+      case 'm':
+        nthreads = atoi(optarg);
+        break;
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 'k':
+        max_half_width = atoi(optarg);
+        break;
+      case '?':
+        if (optopt == 'b' || optopt == 'm' || optopt == 'n' || optopt == 'k')
+          cerr << "Option -" << optopt << " requires an argument." << endl;
+        else
+          cerr << "Unknown option -" << optopt << "." << endl;
+        return 1;
+      case 'h':
+        displayInfo();
+        return 1;
+      default:
+        return 1;
+    }
+  }
+
+  if (bins == 0 || nthreads == 0 || iterations == 0 || max_half_width == 0) {
+    displayInfo();
+    return 1;
+  }
+
+  benchmarkDivergenceConvolution(bins, nthreads, iterations, max_half_width);
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Microbenchmark comparing the per evaluate() threading overhead of the
+ * former ModelEstimator implementation (a fresh boost::thread_group with heap
+ * allocated packaged_tasks for every call) with the persistent WorkerPool.
+ */
+
+#include "core/WorkerPool.h"
+#include "fit/data/Data.h"
+#include "fit/estimatorImpl/LogLikelihoodEstimator.h"
+#include "models2d/GaussianModel2D.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+
+#include <boost/thread.hpp>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+std::shared_ptr<Data> createGaussianData(unsigned int bins) {
+  std::shared_ptr<Data> data(new Data(2));
+  BinnedDataSet &binned_data = data->getBinnedDataSet();
+  binned_data.reserve(bins * bins);
+  double low(-5.0);
+  double bin_width(10.0 / bins);
+  for (unsigned int ix = 0; ix < bins; ++ix) {
+    for (unsigned int iy = 0; iy < bins; ++iy) {
+      double x = low + (ix + 0.5) * bin_width;
+      double y = low + (iy + 0.5) * bin_width;
+      double z = 1e6 * bin_width * bin_width
+          * std::exp(-0.5 * (x * x + y * y)) / (2.0 * M_PI);
+      binned_data.addDataPoint(x, y, bin_width, bin_width, z, std::sqrt(z));
+    }
+  }
+  return data;
+}
+
+std::vector<std::shared_ptr<Data> > chopData(std::shared_ptr<Data> data,
+    unsigned int nthreads) {
+  std::vector<std::shared_ptr<Data> > chunks;
+  const BinnedDataSet &binned_data = data->getBinnedDataSet();
+  unsigned int points_per_chunk = binned_data.size() / nthreads + 1;
+  for (unsigned int i = 0; i < binned_data.size(); i += points_per_chunk) {
+    std::shared_ptr<Data> chunk(new Data(data->getDimension()));
+    chunk->getBinnedDataSet().addDataPoints(binned_data, i,
+        i + points_per_chunk);
+    chunks.push_back(chunk);
+  }
+  return chunks;
+}
+
+mydouble evaluateWithThreadGroup(ModelEstimator &estimator,
+    std::vector<std::shared_ptr<Data> > &chunks) {
+  // this is the threading scheme ModelEstimator::evaluate used before
+  boost::thread_group threads;
+
+  std::vector<boost::unique_future<mydouble> > futures;
+  std::vector<boost::packaged_task<mydouble>*> pts;
+
+  for (unsigned int i = 0; i < chunks.size(); i++) {
+    pts.push_back(
+        new boost::packaged_task<mydouble>(
+            boost::bind(&ModelEstimator::eval, &estimator, chunks[i])));
+    futures.push_back(pts[i]->get_future());
+
+    threads.create_thread(
+        boost::bind(&boost::packaged_task<mydouble>::operator(), pts[i]));
+  }
+
+  threads.join_all();
+
+  mydouble estimator_value(0.0);
+  for (unsigned int i = 0; i < futures.size(); i++) {
+    estimator_value += futures[i].get();
+  }
+
+  for (unsigned int i = 0; i < pts.size(); i++) {
+    delete pts[i];
+  }
+  return estimator_value;
+}
+
+mydouble evaluateWithWorkerPool(WorkerPool &pool, ModelEstimator &estimator,
+    std::vector<std::shared_ptr<Data> > &chunks,
+    std::vector<mydouble> &chunk_values) {
+  WorkerPool::Task task = [&](unsigned int i) {
+    chunk_values[i] = estimator.eval(chunks[i]);
+  };
+  pool.run(task, chunks.size());
+
+  mydouble estimator_value(0.0);
+  for (unsigned int i = 0; i < chunk_values.size(); i++) {
+    estimator_value += chunk_values[i];
+  }
+  return estimator_value;
+}
+
+template<typename Function>
+double measureMicroSecondsPerCall(Function f, unsigned int iterations) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < iterations; ++i)
+    f();
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(stop - start).count()
+      / iterations;
+}
+
+void benchmarkEstimatorThreading(unsigned int bins, unsigned int nthreads,
+    unsigned int iterations) {
+  std::shared_ptr<Model2D> model(new GaussianModel2D("gauss"));
+  ModelParSet &par_set = model->getModelParameterSet();
+  par_set.getModelParameter("gauss_sigma_var1")->setValue(1.0);
+  par_set.getModelParameter("gauss_sigma_var2")->setValue(1.0);
+  par_set.getModelParameter("gauss_mean_var1")->setValue(0.0);
+  par_set.getModelParameter("gauss_mean_var2")->setValue(0.0);
+  par_set.getModelParameter("gauss_rho")->setValue(0.0);
+  par_set.getModelParameter("gauss_amplitude")->setValue(1e6);
+
+  LogLikelihoodEstimator estimator;
+  estimator.setModel(model);
+  std::shared_ptr<Data> data(createGaussianData(bins));
+  estimator.setData(data);
+
+  std::vector<std::shared_ptr<Data> > chunks(chopData(data, nthreads));
+  std::vector<std::shared_ptr<Data> > empty_chunks;
+  for (unsigned int i = 0; i < chunks.size(); ++i)
+    empty_chunks.push_back(std::shared_ptr<Data>(new Data(2)));
+  std::vector<mydouble> chunk_values(chunks.size());
+
+  WorkerPool pool(nthreads);
+
+  cout << "data: " << bins << "x" << bins << " bins, " << chunks.size()
+      << " chunks, " << nthreads << " threads, " << iterations
+      << " iterations" << endl;
+
+  // pure threading overhead: the chunks contain no data points
+  double old_overhead = measureMicroSecondsPerCall(
+      [&]() {evaluateWithThreadGroup(estimator, empty_chunks);}, iterations);
+  double new_overhead = measureMicroSecondsPerCall(
+      [&]() {evaluateWithWorkerPool(pool, estimator, empty_chunks, chunk_values);},
+      iterations);
+
+  // full evaluation of the likelihood
+  mydouble old_value(0.0);
+  mydouble new_value(0.0);
+  double old_full = measureMicroSecondsPerCall(
+      [&]() {old_value = evaluateWithThreadGroup(estimator, chunks);},
+      iterations);
+  double new_full = measureMicroSecondsPerCall(
+      [&]() {new_value = evaluateWithWorkerPool(pool, estimator, chunks, chunk_values);},
+      iterations);
+
+  cout << "threading overhead per evaluate call:" << endl;
+  cout << "  thread_group + packaged_task: " << old_overhead << " us" << endl;
+  cout << "  persistent worker pool:       " << new_overhead << " us" << endl;
+  cout << "full estimator evaluation per call:" << endl;
+  cout << "  thread_group + packaged_task: " << old_full << " us" << endl;
+  cout << "  persistent worker pool:       " << new_full << " us" << endl;
+  cout << "estimator values: " << old_value << " vs " << new_value << endl;
+}
+
+void displayInfo() {
+  cout << "Optional arguments are: " << endl;
+  cout << "-b [number of bins per axis] (default 200)" << endl;
+  cout << "-m [number of threads] (default 4)" << endl;
+  cout << "-n [number of iterations] (default 1000)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  unsigned int bins(200);
+  unsigned int nthreads(4);
+  unsigned int iterations(1000);
+
+  int c;
+
+  while ((c = getopt(argc, argv, "hb:m:n:")) != -1) {
+    switch (c) {
+      case 'b':
+        bins = atoi(optarg);
+        break;
+      case 'm':
+        nthreads = atoi(optarg);
+        break;
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case '?':
+        if (optopt == 'b' || optopt == 'm' || optopt == 'n')
+          cerr << "Option -" << optopt << " requires an argument." << endl;
+        else
+          cerr << "Unknown option -" << optopt << "." << endl;
+        return 1;
+      case 'h':
+        displayInfo();
+        return 1;
+      default:
+        return 1;
+    }
+  }
+
+  if (bins == 0 || nthreads == 0 || iterations == 0) {
+    displayInfo();
+    return 1;
+  }
+
+  benchmarkEstimatorThreading(bins, nthreads, iterations);
+  return 0;
+}
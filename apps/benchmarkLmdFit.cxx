@@ -0,0 +1,688 @@
+/*
+ * Benchmark of the stages of a 2D luminosity fit on synthetic inputs, so no
+ * data or resolution files are required:
+ *
+ * - the elastic events are generated with the dpm event generator
+ *   (PbarPElasticScattering::generateEvents()), smeared with a gaussian
+ *   beam divergence, passed through a box shaped acceptance, smeared with a
+ *   gaussian detector resolution and filled into a theta_x theta_y histogram
+ * - the resolution is given as the hit map of a gaussian, which is converted
+ *   into the sparse resolution matrix of PndLmdSmearingModel2D
+ * - the acceptance is a box (1 inside, 0 outside) on the data binning
+ *
+ * Each stage (dpm evaluation, cached grid build, divergence map, resolution
+ * smearing, estimator evaluation and the full fit) is timed separately and
+ * the results are stored in a json file. A call in compare mode (-c) reads a
+ * baseline and a current result file and reports the ratio of the timings
+ * per stage. Stages which became slower by more than the threshold are
+ * reported as regressions and the exit code is non zero, so the compare mode
+ * can be used in scripts.
+ *
+ * The model grids are computed with the number of threads of the runtime
+ * configuration (single threaded by default), -m sets the number of threads
+ * of the estimator.
+ */
+
+#include "ProjectWideSettings.h"
+#include "model/PndLmdDPMAngModel1D.h"
+#include "model/PndLmdDPMModelParametrization.h"
+#include "model/PndLmdFastDPMAngModel2D.h"
+#include "model/CachedModel2D.h"
+#include "model/PndLmdDivergenceSmearingModel2D.h"
+#include "model/PndLmdDifferentialSmearingConvolutionModel2D.h"
+#include "model/PndLmdSmearingModel2D.h"
+#include "model/PndLmdSmearingConvolutionModel2D.h"
+#include "models2d/DataModel2D.h"
+#include "models2d/GaussianModel2D.h"
+#include "operators2d/ProductModel2D.h"
+#include "fit/ModelFitFacade.h"
+#include "fit/ModelFitResult.h"
+#include "fit/data/Data.h"
+#include "fit/estimatorImpl/LogLikelihoodEstimator.h"
+#include "fit/minimizerImpl/ROOT/ROOTMinimizer.h"
+#include "tools/PbarPElasticScatteringEventGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unistd.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "TClonesArray.h"
+#include "TParticle.h"
+#include "TRandom3.h"
+#include "TTree.h"
+
+using std::string;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+struct BenchmarkSetup {
+  double plab;
+  unsigned int bins;
+  // the histograms cover [-theta_max, theta_max] in theta_x and theta_y
+  double theta_max;
+  double bin_size;
+  // radial fit range
+  double theta_min_fit;
+  double theta_max_fit;
+  // the acceptance is 1 for |theta_x|, |theta_y| below this value
+  double acceptance_half_width;
+  double divergence_sigma;
+  double resolution_sigma;
+
+  LumiFit::LmdDimension dim_x;
+  LumiFit::LmdDimension dim_y;
+};
+
+struct StageTiming {
+  unsigned int iterations;
+  double mean_ms;
+  double min_ms;
+};
+
+template<typename Function>
+StageTiming measureStage(const string &name, Function f,
+    unsigned int iterations) {
+  cout << "benchmarking " << name << "..." << endl;
+  // warm up, e.g. to build the caches which are not part of the stage
+  f();
+  StageTiming timing;
+  timing.iterations = iterations;
+  timing.mean_ms = 0.0;
+  timing.min_ms = std::numeric_limits<double>::max();
+  for (unsigned int i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double, std::milli>(
+        stop - start).count();
+    timing.mean_ms += duration / iterations;
+    timing.min_ms = std::min(timing.min_ms, duration);
+  }
+  cout << name << ": " << timing.mean_ms << " ms (mean), " << timing.min_ms
+      << " ms (min)" << endl;
+  return timing;
+}
+
+BenchmarkSetup createSetup(unsigned int bins) {
+  BenchmarkSetup setup;
+  setup.plab = 1.5;
+  setup.bins = bins;
+  setup.theta_max = 0.01;
+  setup.bin_size = 2.0 * setup.theta_max / bins;
+  setup.theta_min_fit = 0.003;
+  setup.theta_max_fit = 0.008;
+  setup.acceptance_half_width = 0.0075;
+  setup.divergence_sigma = 0.0001;
+  setup.resolution_sigma = 0.00015;
+
+  setup.dim_x.bins = bins;
+  setup.dim_x.dimension_range.setRangeLow(-setup.theta_max);
+  setup.dim_x.dimension_range.setRangeHigh(setup.theta_max);
+  setup.dim_x.calculateBinSize();
+  setup.dim_x.dimension_options.dimension_type = LumiFit::THETA_X;
+  setup.dim_y = setup.dim_x.clone();
+  setup.dim_y.calculateBinSize();
+  setup.dim_y.dimension_options.dimension_type = LumiFit::THETA_Y;
+  return setup;
+}
+
+double getBinCenter(const BenchmarkSetup &setup, int index) {
+  return -setup.theta_max + (index + 0.5) * setup.bin_size;
+}
+
+std::shared_ptr<PndLmdFastDPMAngModel2D> createDPMModel(
+    const BenchmarkSetup &setup) {
+  std::shared_ptr<PndLmdDPMAngModel1D> dpm_angular_1d(
+      new PndLmdDPMAngModel1D("dpm_angular_1d", LumiFit::ALL,
+          LumiFit::APPROX));
+  std::shared_ptr<Parametrization> dpm_parametrization(
+      new PndLmdDPMModelParametrization(
+          dpm_angular_1d->getModelParameterSet()));
+  dpm_angular_1d->getModelParameterHandler().registerParametrizations(
+      dpm_angular_1d->getModelParameterSet(), dpm_parametrization);
+
+  std::shared_ptr<PndLmdFastDPMAngModel2D> dpm_model_2d(
+      new PndLmdFastDPMAngModel2D("dpm_angular_2d", dpm_angular_1d));
+  ModelParSet &par_set = dpm_model_2d->getModelParameterSet();
+  par_set.setModelParameterValue("p_lab", setup.plab);
+  par_set.setModelParameterValue("luminosity", 1.0);
+  par_set.setModelParameterValue("tilt_x", 0.0);
+  par_set.setModelParameterValue("tilt_y", 0.0);
+  return dpm_model_2d;
+}
+
+std::shared_ptr<CachedModel2D> createCachedDPMModel(
+    const BenchmarkSetup &setup) {
+  // radial lookup table as in the model factory
+  std::shared_ptr<PndLmdFastDPMAngModel2D> dpm_model(createDPMModel(setup));
+  dpm_model->useRadialLookupTable(
+      std::sqrt(2.0) * setup.theta_max + 0.005, 0.01 * setup.bin_size);
+  std::shared_ptr<CachedModel2D> cached_model(
+      new CachedModel2D("dpm_angular_2d_cached", dpm_model, setup.dim_x,
+          setup.dim_y));
+  cached_model->setLinearScaleParameter("luminosity");
+  return cached_model;
+}
+
+std::shared_ptr<GaussianModel2D> createDivergenceModel(
+    const BenchmarkSetup &setup) {
+  std::shared_ptr<GaussianModel2D> divergence_model(
+      new GaussianModel2D("divergence_model", 5.0));
+  ModelParSet &par_set = divergence_model->getModelParameterSet();
+  par_set.setModelParameterValue("gauss_sigma_var1", setup.divergence_sigma);
+  par_set.setModelParameterValue("gauss_sigma_var2", setup.divergence_sigma);
+  par_set.setModelParameterValue("gauss_mean_var1", 0.0);
+  par_set.setModelParameterValue("gauss_mean_var2", 0.0);
+  par_set.setModelParameterValue("gauss_rho", 0.0);
+  divergence_model->init();
+  return divergence_model;
+}
+
+// probability that an event at the center of a bin is reconstructed in the
+// bin with the given offset
+std::vector<double> createGaussianBinTransferWeights(
+    const BenchmarkSetup &setup, int half_width) {
+  std::vector<double> weights(2 * half_width + 1);
+  double scale(setup.bin_size / (std::sqrt(2.0) * setup.resolution_sigma));
+  for (int d = -half_width; d <= half_width; ++d) {
+    weights[d + half_width] = 0.5
+        * (std::erf((d + 0.5) * scale) - std::erf((d - 0.5) * scale));
+  }
+  return weights;
+}
+
+std::shared_ptr<PndLmdSmearingModel2D> createResolutionSmearingModel(
+    const BenchmarkSetup &setup) {
+  int half_width(std::ceil(5.0 * setup.resolution_sigma / setup.bin_size));
+  std::vector<double> weights(
+      createGaussianBinTransferWeights(setup, half_width));
+
+  std::vector<RecoBinSmearingContributions> smearing_param;
+  smearing_param.reserve(setup.bins * setup.bins);
+  for (int ix = 0; ix < (int) setup.bins; ++ix) {
+    for (int iy = 0; iy < (int) setup.bins; ++iy) {
+      RecoBinSmearingContributions rbsc;
+      rbsc.reco_bin_x = getBinCenter(setup, ix);
+      rbsc.reco_bin_y = getBinCenter(setup, iy);
+      // only mc bins inside of the binning contribute
+      for (int mx = std::max(0, ix - half_width);
+          mx <= std::min((int) setup.bins - 1, ix + half_width); ++mx) {
+        for (int my = std::max(0, iy - half_width);
+            my <= std::min((int) setup.bins - 1, iy + half_width); ++my) {
+          ContributorCoordinateWeight cw;
+          cw.bin_center_x = getBinCenter(setup, mx);
+          cw.bin_center_y = getBinCenter(setup, my);
+          cw.smear_weight = weights[ix - mx + half_width]
+              * weights[iy - my + half_width];
+          rbsc.contributor_coordinate_weight_list.push_back(cw);
+        }
+      }
+      smearing_param.push_back(rbsc);
+    }
+  }
+
+  std::shared_ptr<PndLmdSmearingModel2D> smearing_model(
+      new PndLmdSmearingModel2D(setup.dim_x, setup.dim_y));
+  smearing_model->setSmearingParameterization(smearing_param);
+  return smearing_model;
+}
+
+bool isAccepted(const BenchmarkSetup &setup, double theta_x, double theta_y) {
+  return std::abs(theta_x) <= setup.acceptance_half_width
+      && std::abs(theta_y) <= setup.acceptance_half_width;
+}
+
+std::shared_ptr<DataModel2D> createBoxAcceptance(const BenchmarkSetup &setup) {
+  // the acceptance map extends beyond the binning, so that the interpolation
+  // never has to treat the border of the map
+  const int margin(2);
+  std::map<std::pair<mydouble, mydouble>, mydouble> datamap;
+  for (int ix = -margin; ix < (int) setup.bins + margin; ++ix) {
+    for (int iy = -margin; iy < (int) setup.bins + margin; ++iy) {
+      std::pair<mydouble, mydouble> pos(getBinCenter(setup, ix),
+          getBinCenter(setup, iy));
+      datamap[pos] = isAccepted(setup, pos.first, pos.second) ? 1.0 : 0.0;
+    }
+  }
+  std::shared_ptr<DataModel2D> acceptance(new DataModel2D("acceptance_2d"));
+  acceptance->setData(datamap);
+  return acceptance;
+}
+
+// the same chain of models as in PndLmdModelFactory::generate2DModel() with
+// all corrections active
+std::shared_ptr<Model2D> createFullModel(const BenchmarkSetup &setup,
+    std::shared_ptr<GaussianModel2D> divergence_model,
+    std::shared_ptr<DataModel2D> acceptance,
+    std::shared_ptr<PndLmdSmearingModel2D> resolution_smearing_model) {
+  std::shared_ptr<PndLmdDivergenceSmearingModel2D> divergence_smearing_model(
+      new PndLmdDivergenceSmearingModel2D(divergence_model, setup.dim_x,
+          setup.dim_y));
+  std::shared_ptr<PndLmdDifferentialSmearingConvolutionModel2D> div_smeared_model(
+      new PndLmdDifferentialSmearingConvolutionModel2D(
+          "dpm_angular_2d_cached_div_smeared", createCachedDPMModel(setup),
+          divergence_smearing_model, setup.dim_x, setup.dim_y, 1));
+  div_smeared_model->setLinearScaleParameter("luminosity");
+  div_smeared_model->injectModelParameter(
+      divergence_model->getModelParameterSet().getModelParameter(
+          "gauss_sigma_var1"));
+  div_smeared_model->injectModelParameter(
+      divergence_model->getModelParameterSet().getModelParameter(
+          "gauss_sigma_var2"));
+
+  std::shared_ptr<Model2D> acc_corrected_model(
+      new ProductModel2D("dpm_angular_2d_cached_div_smeared_acceptance_corrected",
+          div_smeared_model, acceptance));
+  acc_corrected_model->getModelParameterSet().getModelParameter("offset_x")->setValue(
+      0.0);
+  acc_corrected_model->getModelParameterSet().getModelParameter("offset_y")->setValue(
+      0.0);
+
+  std::shared_ptr<PndLmdSmearingConvolutionModel2D> model(
+      new PndLmdSmearingConvolutionModel2D(
+          "dpm_angular_2d_cached_div_smeared_acceptance_corrected_res_smeared",
+          acc_corrected_model, resolution_smearing_model, setup.dim_x,
+          setup.dim_y));
+  model->setLinearScaleParameter("luminosity");
+
+  if (model->init()) {
+    cerr << "ERROR: Not all parameters of the model were successfully initialized!"
+        << endl;
+    model->getModelParameterSet().printInfo();
+  }
+  return model;
+}
+
+std::shared_ptr<Data> createSyntheticData(const BenchmarkSetup &setup,
+    unsigned int num_events, unsigned int seed, double &true_luminosity) {
+  // the corners of the histogram are outside of the generated theta range,
+  // but also outside of the acceptance
+  std::pair<TTree*, double> events = PbarPElasticScattering::generateEvents(
+      setup.plab, num_events, 2.0, 12.0, seed);
+  true_luminosity = num_events / events.second;
+
+  TClonesArray *particles = new TClonesArray("TParticle", 2);
+  TTree &tree(*events.first);
+  tree.SetBranchAddress("Particles", &particles);
+
+  TRandom3 random(seed + 1);
+  std::vector<double> counts(setup.bins * setup.bins, 0.0);
+  for (unsigned int i = 0; i < tree.GetEntries(); ++i) {
+    tree.GetEntry(i);
+    for (int np = 0; np < particles->GetEntries(); ++np) {
+      TParticle *particle = (TParticle*) particles->At(np);
+      if (particle->GetPdgCode() != -2212)
+        continue;
+      double theta_x = particle->Px() / particle->Pz()
+          + random.Gaus(0.0, setup.divergence_sigma);
+      double theta_y = particle->Py() / particle->Pz()
+          + random.Gaus(0.0, setup.divergence_sigma);
+      if (!isAccepted(setup, theta_x, theta_y))
+        continue;
+      theta_x += random.Gaus(0.0, setup.resolution_sigma);
+      theta_y += random.Gaus(0.0, setup.resolution_sigma);
+      int ix = std::floor((theta_x + setup.theta_max) / setup.bin_size);
+      int iy = std::floor((theta_y + setup.theta_max) / setup.bin_size);
+      if (ix >= 0 && ix < (int) setup.bins && iy >= 0
+          && iy < (int) setup.bins)
+        counts[ix * setup.bins + iy] += 1.0;
+    }
+  }
+  delete particles;
+  delete events.first;
+
+  std::shared_ptr<Data> data(new Data(2));
+  BinnedDataSet &binned_data = data->getBinnedDataSet();
+  binned_data.reserve(setup.bins * setup.bins);
+  for (unsigned int ix = 0; ix < setup.bins; ++ix) {
+    for (unsigned int iy = 0; iy < setup.bins; ++iy) {
+      double value = counts[ix * setup.bins + iy];
+      binned_data.addDataPoint(getBinCenter(setup, ix),
+          getBinCenter(setup, iy), setup.bin_size, setup.bin_size, value,
+          std::sqrt(value));
+    }
+  }
+  return data;
+}
+
+EstimatorOptions createEstimatorOptions(const BenchmarkSetup &setup) {
+  // radial fit range and no integral scaling, same as in the luminosity fits
+  EstimatorOptions est_opt;
+  est_opt.setWithIntegralScaling(false);
+  DataStructs::DimensionRange fit_range(setup.theta_min_fit,
+      setup.theta_max_fit);
+  est_opt.setFitRangeX(fit_range);
+  est_opt.setFitRangeY(fit_range);
+  return est_opt;
+}
+
+void putStageTiming(boost::property_tree::ptree &stages, const string &name,
+    const StageTiming &timing) {
+  boost::property_tree::ptree stage;
+  stage.put("iterations", timing.iterations);
+  stage.put("mean_ms", timing.mean_ms);
+  stage.put("min_ms", timing.min_ms);
+  stages.add_child(name, stage);
+}
+
+void runBenchmark(const string &output_file, unsigned int bins,
+    unsigned int nthreads, unsigned int num_events, unsigned int iterations,
+    unsigned int fit_iterations, unsigned int seed) {
+  BenchmarkSetup setup(createSetup(bins));
+
+  cout << "floating point precision: " << LMDFIT_PRECISION_NAME << " ("
+      << sizeof(mydouble) << " bytes)" << endl;
+
+  double true_luminosity(0.0);
+  std::shared_ptr<Data> data(
+      createSyntheticData(setup, num_events, seed, true_luminosity));
+  std::shared_ptr<DataModel2D> acceptance(createBoxAcceptance(setup));
+  std::shared_ptr<PndLmdSmearingModel2D> resolution_smearing_model(
+      createResolutionSmearingModel(setup));
+
+  boost::property_tree::ptree stages;
+
+  // all bin centers of the histogram, point by point
+  std::vector<mydouble> coordinates(2 * bins * bins);
+  for (unsigned int ix = 0; ix < bins; ++ix) {
+    for (unsigned int iy = 0; iy < bins; ++iy) {
+      coordinates[2 * (ix * bins + iy)] = getBinCenter(setup, ix);
+      coordinates[2 * (ix * bins + iy) + 1] = getBinCenter(setup, iy);
+    }
+  }
+
+  // direct evaluation of the dpm model at every bin center
+  std::shared_ptr<PndLmdFastDPMAngModel2D> dpm_model(createDPMModel(setup));
+  dpm_model->init();
+  dpm_model->updateModel();
+  std::vector<mydouble> values(bins * bins);
+  putStageTiming(stages, "dpm_evaluation",
+      measureStage("dpm evaluation",
+          [&]() {dpm_model->evaluateBatch(coordinates.data(), bins * bins,
+                values.data());}, iterations));
+
+  // full regeneration of the cached dpm grid, forced by a change of the tilt
+  std::shared_ptr<CachedModel2D> cached_model(createCachedDPMModel(setup));
+  cached_model->init();
+  std::shared_ptr<ModelPar> tilt_x(
+      cached_model->getModelParameterSet().getModelParameter("tilt_x"));
+  tilt_x->setParameterFixed(false);
+  bool tilted(false);
+  putStageTiming(stages, "cached_grid_build", measureStage("cached grid build",
+      [&]() {
+        tilted = !tilted;
+        tilt_x->setValue(tilted ? 1e-5 : 0.0);
+        cached_model->updateModel();}, iterations));
+
+  // regeneration of the divergence map, forced by a change of the divergence
+  std::shared_ptr<GaussianModel2D> divergence_model(
+      createDivergenceModel(setup));
+  PndLmdDivergenceSmearingModel2D divergence_smearing_model(divergence_model,
+      setup.dim_x, setup.dim_y);
+  std::shared_ptr<ModelPar> divergence_sigma(
+      divergence_model->getModelParameterSet().getModelParameter(
+          "gauss_sigma_var1"));
+  divergence_sigma->setParameterFixed(false);
+  bool widened(false);
+  putStageTiming(stages, "divergence_map", measureStage("divergence map",
+      [&]() {
+        widened = !widened;
+        divergence_sigma->setValue(
+            (widened ? 1.1 : 1.0) * setup.divergence_sigma);
+        divergence_smearing_model.updateSmearingModel();}, iterations));
+
+  // resolution smearing of a cheap unsmeared model, forced by a shift of it
+  std::shared_ptr<GaussianModel2D> unsmeared_model(
+      new GaussianModel2D("unsmeared_model", 5.0));
+  ModelParSet &unsmeared_par_set = unsmeared_model->getModelParameterSet();
+  unsmeared_par_set.setModelParameterValue("gauss_sigma_var1", 0.003);
+  unsmeared_par_set.setModelParameterValue("gauss_sigma_var2", 0.003);
+  unsmeared_par_set.setModelParameterValue("gauss_mean_var2", 0.0);
+  unsmeared_par_set.setModelParameterValue("gauss_rho", 0.0);
+  unsmeared_par_set.setModelParameterValue("gauss_amplitude", 1.0);
+  std::shared_ptr<ModelPar> unsmeared_mean(
+      unsmeared_par_set.getModelParameter("gauss_mean_var1"));
+  unsmeared_mean->setParameterFixed(false);
+  unsmeared_mean->setValue(0.0);
+  std::shared_ptr<PndLmdSmearingConvolutionModel2D> res_smeared_model(
+      new PndLmdSmearingConvolutionModel2D("unsmeared_model_res_smeared",
+          unsmeared_model, resolution_smearing_model, setup.dim_x,
+          setup.dim_y));
+  res_smeared_model->init();
+  bool shifted(false);
+  putStageTiming(stages, "resolution_smearing",
+      measureStage("resolution smearing", [&]() {
+        shifted = !shifted;
+        unsmeared_mean->setValue(shifted ? 1e-4 : 0.0);
+        res_smeared_model->updateModel();}, iterations));
+
+  // estimator evaluation of the full model, only the luminosity changes so
+  // the model grids are rescaled and not recomputed
+  std::shared_ptr<Model2D> full_model(
+      createFullModel(setup, createDivergenceModel(setup), acceptance,
+          resolution_smearing_model));
+  full_model->getModelParameterSet().freeModelParameter("luminosity");
+  full_model->getModelParameterSet().setModelParameterValue("luminosity",
+      true_luminosity);
+  full_model->getModelParameterSet().freeModelParameter("gauss_sigma_var1");
+  full_model->getModelParameterSet().freeModelParameter("gauss_sigma_var2");
+
+  std::shared_ptr<ModelEstimator> estimator(new LogLikelihoodEstimator());
+  estimator->setNumberOfThreads(nthreads);
+  estimator->setModel(full_model);
+  estimator->setData(data);
+  estimator->applyEstimatorOptions(createEstimatorOptions(setup));
+  std::vector<mydouble> pars;
+  unsigned int luminosity_index(0);
+  for (auto const &param : estimator->getFreeParameters()) {
+    if (param.first.second == "luminosity")
+      luminosity_index = pars.size();
+    pars.push_back(param.second->getValue());
+  }
+  bool scaled(false);
+  putStageTiming(stages, "estimator_evaluation",
+      measureStage("estimator evaluation", [&]() {
+        scaled = !scaled;
+        pars[luminosity_index] = (scaled ? 1.01 : 1.0) * true_luminosity;
+        estimator->evaluate(pars.data());}, iterations));
+
+  // full fit of the luminosity and the divergence, with a fresh model for
+  // every fit so that no grids are reused
+  ModelFitResult fit_result;
+  putStageTiming(stages, "full_fit", measureStage("full fit", [&]() {
+    std::shared_ptr<GaussianModel2D> fit_divergence_model(
+        createDivergenceModel(setup));
+    std::shared_ptr<Model2D> fit_model(
+        createFullModel(setup, fit_divergence_model, acceptance,
+            resolution_smearing_model));
+    ModelParSet &fit_par_set = fit_model->getModelParameterSet();
+    fit_par_set.freeModelParameter("luminosity");
+    fit_par_set.setModelParameterValue("luminosity", 1.1 * true_luminosity);
+    fit_par_set.freeModelParameter("gauss_sigma_var1");
+    fit_par_set.freeModelParameter("gauss_sigma_var2");
+    fit_par_set.setModelParameterValue("gauss_sigma_var1",
+        1.2 * setup.divergence_sigma);
+    fit_par_set.setModelParameterValue("gauss_sigma_var2",
+        1.2 * setup.divergence_sigma);
+
+    ModelFitFacade model_fit_facade;
+    std::shared_ptr<ModelEstimator> fit_estimator(new LogLikelihoodEstimator());
+    fit_estimator->setNumberOfThreads(nthreads);
+    model_fit_facade.setEstimator(fit_estimator);
+    model_fit_facade.setModel(fit_model);
+    model_fit_facade.setData(data);
+    model_fit_facade.setEstimatorOptions(createEstimatorOptions(setup));
+    model_fit_facade.setMinimizer(
+        std::shared_ptr<ROOTMinimizer>(new ROOTMinimizer()));
+    fit_result = model_fit_facade.Fit();}, fit_iterations));
+
+  ModelStructs::minimization_parameter lumi = fit_result.getFitParameter(
+      "luminosity");
+  cout << "true luminosity: " << true_luminosity << endl;
+  cout << "fitted luminosity: " << lumi.value << " +- " << lumi.error << endl;
+
+  boost::property_tree::ptree result;
+  result.put("precision", LMDFIT_PRECISION_NAME);
+  result.put("bins", bins);
+  result.put("threads", nthreads);
+  result.put("events", num_events);
+  result.put("seed", seed);
+  result.put("resolution_matrix_entries",
+      resolution_smearing_model->getNumberOfMatrixEntries());
+  result.add_child("stages", stages);
+  result.put("fit.status", fit_result.getFitStatus());
+  result.put("fit.true_luminosity", true_luminosity);
+  result.put("fit.luminosity", lumi.value);
+  result.put("fit.luminosity_error", lumi.error);
+  result.put("fit.estimator_value", fit_result.getFinalEstimatorValue());
+  boost::property_tree::write_json(output_file, result);
+  cout << "wrote benchmark results to " << output_file << endl;
+}
+
+bool compareBenchmarks(const string &baseline_file, const string &current_file,
+    double threshold) {
+  boost::property_tree::ptree baseline;
+  boost::property_tree::ptree current;
+  boost::property_tree::read_json(baseline_file, baseline);
+  boost::property_tree::read_json(current_file, current);
+
+  const std::vector<string> settings = { "precision", "bins", "threads",
+      "events", "seed" };
+  for (auto const &setting : settings) {
+    if (baseline.get<string>(setting) != current.get<string>(setting)) {
+      cerr << "WARNING: the benchmarks were run with different settings ("
+          << setting << ": " << baseline.get<string>(setting) << " vs. "
+          << current.get<string>(setting) << ")!" << endl;
+    }
+  }
+
+  // the minimal times are compared, as they are the least affected by other
+  // processes on the machine
+  bool regression(false);
+  cout << std::left << std::setw(24) << "stage" << std::right
+      << std::setw(16) << "baseline [ms]" << std::setw(16) << "current [ms]"
+      << std::setw(10) << "ratio" << endl;
+  for (auto const &stage : baseline.get_child("stages")) {
+    auto current_stage =
+        current.get_child_optional("stages." + stage.first);
+    if (!current_stage) {
+      cerr << "WARNING: the stage " << stage.first
+          << " is missing in the current benchmark!" << endl;
+      continue;
+    }
+    double baseline_time(stage.second.get<double>("min_ms"));
+    double current_time(current_stage->get<double>("min_ms"));
+    double ratio(current_time / baseline_time);
+    cout << std::left << std::setw(24) << stage.first << std::right
+        << std::setw(16) << baseline_time << std::setw(16) << current_time
+        << std::setw(10) << ratio;
+    if (ratio > 1.0 + threshold) {
+      cout << "  REGRESSION";
+      regression = true;
+    }
+    cout << endl;
+  }
+
+  double baseline_lumi(baseline.get<double>("fit.luminosity"));
+  double current_lumi(current.get<double>("fit.luminosity"));
+  cout << "relative luminosity difference: "
+      << (current_lumi - baseline_lumi) / baseline_lumi << endl;
+  return regression;
+}
+
+void displayInfo() {
+  cout << "Benchmark mode (stores the timings of all stages in a json file):"
+      << endl;
+  cout << "-o [output json file]" << endl;
+  cout << "Optional arguments are: " << endl;
+  cout << "-b [number of bins per axis] (default 100)" << endl;
+  cout << "-m [number of estimator threads] (default 1)" << endl;
+  cout << "-e [number of generated events] (default 1e6)" << endl;
+  cout << "-n [number of iterations per stage] (default 5)" << endl;
+  cout << "-f [number of full fits] (default 1)" << endl;
+  cout << "-s [random seed] (default 12345)" << endl;
+  cout << "Compare mode (exit code 2 if a stage got slower):" << endl;
+  cout << "-c [baseline json file] [current json file]" << endl;
+  cout << "Optional arguments are: " << endl;
+  cout << "-t [tolerated relative slowdown] (default 0.1)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  string output_file("");
+  string baseline_file("");
+  unsigned int bins(100);
+  unsigned int nthreads(1);
+  unsigned int num_events(1000000);
+  unsigned int iterations(5);
+  unsigned int fit_iterations(1);
+  unsigned int seed(12345);
+  double threshold(0.1);
+
+  int c;
+
+  while ((c = getopt(argc, argv, "ho:c:b:m:e:n:f:s:t:")) != -1) {
+    switch (c) {
+      case 'o':
+        output_file = optarg;
+        break;
+      case 'c':
+        baseline_file = optarg;
+        break;
+      case 'b':
+        bins = atoi(optarg);
+        break;
+      case 'm':
+        nthreads = atoi(optarg);
+        break;
+      case 'e':
+        num_events = atof(optarg);
+        break;
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 'f':
+        fit_iterations = atoi(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case 't':
+        threshold = atof(optarg);
+        break;
+      case '?':
+        if (optopt == 'o' || optopt == 'c' || optopt == 'b' || optopt == 'm'
+            || optopt == 'e' || optopt == 'n' || optopt == 'f'
+            || optopt == 's' || optopt == 't')
+          cerr << "Option -" << optopt << " requires an argument." << endl;
+        else
+          cerr << "Unknown option -" << optopt << "." << endl;
+        return 1;
+      case 'h':
+        displayInfo();
+        return 1;
+      default:
+        return 1;
+    }
+  }
+
+  if (baseline_file != "" && optind < argc) {
+    if (compareBenchmarks(baseline_file, argv[optind], threshold))
+      return 2;
+  } else if (output_file != "" && bins > 0 && nthreads > 0 && num_events > 0
+      && iterations > 0 && fit_iterations > 0)
+    runBenchmark(output_file, bins, nthreads, num_events, iterations,
+        fit_iterations, seed);
+  else
+    displayInfo();
+  return 0;
+}
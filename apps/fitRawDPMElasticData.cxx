@@ -432,16 +432,19 @@ void fit2D(hist_bunch histograms, data_options &data_opt, bool binned = true) {
     model->getModelParameterSet().freeModelParameter("luminosity");
     model->getModelParameterSet().setModelParameterValue("luminosity", 1163.33);
   } else {
+    // the extended likelihood determines the luminosity from the number of
+    // events, the normalization integral is only rescaled when it changes
     std::shared_ptr<UnbinnedLogLikelihoodEstimator> loglikelihood_est(
-        new UnbinnedLogLikelihoodEstimator());
+        new UnbinnedLogLikelihoodEstimator(true));
+    loglikelihood_est->setNormalizationScaleParameterName("luminosity");
     fit_facade.setEstimator(loglikelihood_est);
     fit_facade.setData(histograms.unbinned_data);
 
     double lumi_start = integral_data / integral_func;
     std::cout << "Using start luminosity: " << lumi_start << std::endl;
     model->getModelParameterSet().freeModelParameter("luminosity");
-    model->getModelParameterSet().setModelParameterValue("luminosity", 5700.33); // change this to num events or something...
-    model->getModelParameterSet().getModelParameter("luminosity")->setParameterFixed(true);
+    model->getModelParameterSet().setModelParameterValue("luminosity",
+        lumi_start);
   }
 
   fit_facade.setModel(model);
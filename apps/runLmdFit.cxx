@@ -2,6 +2,7 @@
 #include "ui/PndLmdFitFacade.h"
 #include "ui/PndLmdDataFacade.h"
 #include "data/PndLmdAngularData.h"
+#include "core/FitTracer.h"
 
 #include <iostream>
 #include <string>
@@ -17,12 +18,14 @@ using std::cerr;
 using std::endl;
 
 void runLmdFit(string input_file_dir, string fit_config_path, string acceptance_file_dir,
-    string reference_acceptance_file_dir, unsigned int nthreads) {
+    string reference_acceptance_file_dir, unsigned int nthreads,
+    unsigned int nconcurrent_fits) {
 
   boost::chrono::thread_clock::time_point start = boost::chrono::thread_clock::now();
 
   PndLmdRuntimeConfiguration& lmd_runtime_config = PndLmdRuntimeConfiguration::Instance();
   lmd_runtime_config.setNumberOfThreads(nthreads);
+  lmd_runtime_config.setNumberOfConcurrentFits(nconcurrent_fits);
   lmd_runtime_config.setGeneralConfigDirectory(fit_config_path);
 
   lmd_runtime_config.readAcceptanceOffsetTransformationParameters("offset_trafo_matrix.json");
@@ -127,6 +130,11 @@ void runLmdFit(string input_file_dir, string fit_config_path, string acceptance_
   all_lmd_res_map.clear();
   my_lmd_acc_vec.clear();
 
+  // the trace files are only written if the fit tracing is enabled
+  FitTracer::Instance().setOutputPrefix(
+      lmd_runtime_config.getElasticDataInputDirectory().string()
+          + "/lmdfit_trace");
+
   // do actual fits
   PndLmdFitDataBundle fit_result(lmd_fit_facade.doLuminosityFits(my_lmd_data_vec));
 
@@ -151,6 +159,8 @@ void displayInfo() {
   cout << "-c [path to fit config file]" << endl;
   cout << "Optional arguments are: " << endl;
   cout << "-m [number of threads]" << endl;
+  cout << "-j [number of fits running at the same time, sharing the threads]"
+      << endl;
   cout << "-a [path to box gen data] (acceptance)" << endl;
   cout << "-r [path to reference box gen data] (acceptance)" << endl;
 }
@@ -161,11 +171,12 @@ int main(int argc, char* argv[]) {
   string fit_config_path("");
   string ref_acc_path("");
   unsigned int nthreads(1);
+  unsigned int nconcurrent_fits(1);
   bool is_data_set(false), is_config_set(false), is_acc_set(false), is_nthreads_set(false);
 
   int c;
 
-  while ((c = getopt(argc, argv, "hc:a:m:r:d:X:Y:")) != -1) {
+  while ((c = getopt(argc, argv, "hc:a:m:j:r:d:X:Y:")) != -1) {
     switch (c) {
       case 'a':
         acc_path = optarg;
@@ -186,8 +197,11 @@ int main(int argc, char* argv[]) {
         nthreads = atoi(optarg);
         is_nthreads_set = true;
         break;
+      case 'j':
+        nconcurrent_fits = atoi(optarg);
+        break;
       case '?':
-        if (optopt == 'm' || optopt == 'd' || optopt == 'a' || optopt == 'c' || optopt == 'r')
+        if (optopt == 'm' || optopt == 'j' || optopt == 'd' || optopt == 'a' || optopt == 'c' || optopt == 'r')
           cerr << "Option -" << optopt << " requires an argument." << endl;
         else if (isprint(optopt))
           cerr << "Unknown option -" << optopt << "." << endl;
@@ -203,7 +217,8 @@ int main(int argc, char* argv[]) {
   }
 
   if (is_data_set && is_config_set)
-    runLmdFit(data_path, fit_config_path, acc_path, ref_acc_path, nthreads);
+    runLmdFit(data_path, fit_config_path, acc_path, ref_acc_path, nthreads,
+        nconcurrent_fits);
   else
     displayInfo();
   return 0;
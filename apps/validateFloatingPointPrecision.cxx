@@ -0,0 +1,289 @@
+/*
+ * Validation of the compile time selectable floating point precision
+ * (mydouble, see ProjectWideSettings.h).
+ *
+ * The precision is fixed per build, so this app is run once in a build with
+ * the default long double precision and once in a build configured with
+ * -DLMDFIT_DOUBLE_PRECISION=ON. Each run fits a pseudo dataset generated
+ * with the same seed (single counts can differ, as the model is evaluated in
+ * the precision of the build) and stores the luminosity and the fit
+ * duration in a json file. A third call in compare mode (-c) reads both files and reports the
+ * relative luminosity difference and the speedup.
+ */
+
+#include "ProjectWideSettings.h"
+#include "ui/PndLmdRuntimeConfiguration.h"
+#include "model/PndLmdDPMAngModel1D.h"
+#include "model/PndLmdDPMModelParametrization.h"
+#include "model/PndLmdFastDPMAngModel2D.h"
+#include "model/CachedModel2D.h"
+#include "fit/ModelFitFacade.h"
+#include "fit/ModelFitResult.h"
+#include "fit/data/Data.h"
+#include "fit/estimatorImpl/LogLikelihoodEstimator.h"
+#include "fit/minimizerImpl/ROOT/ROOTMinimizer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "TRandom3.h"
+
+using std::string;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+std::shared_ptr<Model2D> createModel(double plab, unsigned int bins,
+    double theta_max) {
+  std::shared_ptr<PndLmdDPMAngModel1D> dpm_angular_1d(
+      new PndLmdDPMAngModel1D("dpm_angular_1d", LumiFit::ALL,
+          LumiFit::APPROX));
+  std::shared_ptr<Parametrization> dpm_parametrization(
+      new PndLmdDPMModelParametrization(
+          dpm_angular_1d->getModelParameterSet()));
+  dpm_angular_1d->getModelParameterHandler().registerParametrizations(
+      dpm_angular_1d->getModelParameterSet(), dpm_parametrization);
+
+  LumiFit::LmdDimension dim_x;
+  dim_x.bins = bins;
+  dim_x.dimension_range.setRangeLow(-theta_max);
+  dim_x.dimension_range.setRangeHigh(theta_max);
+  dim_x.calculateBinSize();
+  LumiFit::LmdDimension dim_y(dim_x.clone());
+  dim_y.calculateBinSize();
+
+  std::shared_ptr<Model2D> dpm_model_2d(
+      new PndLmdFastDPMAngModel2D("dpm_angular_2d", dpm_angular_1d));
+  std::shared_ptr<CachedModel2D> model(
+      new CachedModel2D("dpm_angular_2d_cached", dpm_model_2d, dim_x, dim_y));
+  model->setLinearScaleParameter("luminosity");
+
+  ModelParSet &par_set = model->getModelParameterSet();
+  par_set.setModelParameterValue("p_lab", plab);
+  par_set.setModelParameterValue("luminosity", 1.0);
+  par_set.setModelParameterValue("tilt_x", 0.0);
+  par_set.setModelParameterValue("tilt_y", 0.0);
+  if (model->init()) {
+    cerr << "ERROR: Not all parameters of the model were successfully initialized!"
+        << endl;
+    par_set.printInfo();
+  }
+  return model;
+}
+
+std::shared_ptr<Data> createPseudoData(std::shared_ptr<Model2D> model,
+    unsigned int bins, double theta_max, double theta_min_fit,
+    double theta_max_fit, double events, unsigned int seed,
+    double &true_luminosity) {
+  double bin_size(2.0 * theta_max / bins);
+
+  // expected counts for a luminosity of 1. The model is evaluated in
+  // mydouble, so the Poisson means of the two builds agree only up to the
+  // precision of the double build and single counts may differ
+  std::vector<double> expectation(bins * bins);
+  double sum_in_fit_range(0.0);
+  for (unsigned int ix = 0; ix < bins; ++ix) {
+    for (unsigned int iy = 0; iy < bins; ++iy) {
+      mydouble x[2] = { -theta_max + (ix + 0.5) * bin_size, -theta_max
+          + (iy + 0.5) * bin_size };
+      double value = (double) model->evaluate(x) * bin_size * bin_size;
+      expectation[ix * bins + iy] = value;
+      double r = std::sqrt((double) (x[0] * x[0] + x[1] * x[1]));
+      if (r >= theta_min_fit && r <= theta_max_fit)
+        sum_in_fit_range += value;
+    }
+  }
+  true_luminosity = events / sum_in_fit_range;
+
+  TRandom3 random(seed);
+  std::shared_ptr<Data> data(new Data(2));
+  BinnedDataSet &binned_data = data->getBinnedDataSet();
+  binned_data.reserve(bins * bins);
+  for (unsigned int ix = 0; ix < bins; ++ix) {
+    for (unsigned int iy = 0; iy < bins; ++iy) {
+      double counts = random.Poisson(
+          true_luminosity * expectation[ix * bins + iy]);
+      binned_data.addDataPoint(-theta_max + (ix + 0.5) * bin_size,
+          -theta_max + (iy + 0.5) * bin_size, bin_size, bin_size, counts,
+          std::sqrt(counts));
+    }
+  }
+  return data;
+}
+
+void runValidationFit(const string &output_file, unsigned int bins,
+    unsigned int nthreads, double events, unsigned int seed) {
+  double plab(1.5);
+  double theta_max(0.01);
+  double theta_min_fit(0.003);
+  double theta_max_fit(0.008);
+
+  PndLmdRuntimeConfiguration::Instance().setNumberOfThreads(nthreads);
+
+  cout << "floating point precision: " << LMDFIT_PRECISION_NAME << " ("
+      << sizeof(mydouble) << " bytes)" << endl;
+
+  std::shared_ptr<Model2D> model(createModel(plab, bins, theta_max));
+  double true_luminosity(0.0);
+  std::shared_ptr<Data> data(
+      createPseudoData(model, bins, theta_max, theta_min_fit, theta_max_fit,
+          events, seed, true_luminosity));
+
+  // start 10% off the true value
+  model->getModelParameterSet().setModelParameterValue("luminosity",
+      1.1 * true_luminosity);
+  model->getModelParameterSet().freeModelParameter("luminosity");
+
+  ModelFitFacade model_fit_facade;
+  std::shared_ptr<ModelEstimator> estimator(new LogLikelihoodEstimator());
+  estimator->setNumberOfThreads(nthreads);
+  model_fit_facade.setEstimator(estimator);
+  model_fit_facade.setModel(model);
+  model_fit_facade.setData(data);
+
+  // radial fit range, same as in the luminosity fits
+  EstimatorOptions est_opt;
+  DataStructs::DimensionRange fit_range(theta_min_fit, theta_max_fit);
+  est_opt.setFitRangeX(fit_range);
+  est_opt.setFitRangeY(fit_range);
+  model_fit_facade.setEstimatorOptions(est_opt);
+
+  std::shared_ptr<ROOTMinimizer> minuit_minimizer(new ROOTMinimizer());
+  model_fit_facade.setMinimizer(minuit_minimizer);
+
+  auto start = std::chrono::steady_clock::now();
+  ModelFitResult fit_result = model_fit_facade.Fit();
+  auto stop = std::chrono::steady_clock::now();
+  double fit_duration = std::chrono::duration<double>(stop - start).count();
+
+  ModelStructs::minimization_parameter lumi = fit_result.getFitParameter(
+      "luminosity");
+
+  cout << "true luminosity: " << true_luminosity << endl;
+  cout << "fitted luminosity: " << lumi.value << " +- " << lumi.error << endl;
+  cout << "fit duration: " << fit_duration << " s" << endl;
+
+  boost::property_tree::ptree result;
+  result.put("precision", LMDFIT_PRECISION_NAME);
+  result.put("bins", bins);
+  result.put("threads", nthreads);
+  result.put("events", events);
+  result.put("seed", seed);
+  result.put("fit_status", fit_result.getFitStatus());
+  result.put("true_luminosity", true_luminosity);
+  result.put("luminosity", lumi.value);
+  result.put("luminosity_error", lumi.error);
+  result.put("estimator_value", fit_result.getFinalEstimatorValue());
+  result.put("fit_duration", fit_duration);
+  boost::property_tree::write_json(output_file, result);
+}
+
+void compareValidationFits(const string &reference_file,
+    const string &other_file) {
+  boost::property_tree::ptree reference;
+  boost::property_tree::ptree other;
+  boost::property_tree::read_json(reference_file, reference);
+  boost::property_tree::read_json(other_file, other);
+
+  if (reference.get<unsigned int>("bins") != other.get<unsigned int>("bins")
+      || reference.get<double>("events") != other.get<double>("events")
+      || reference.get<unsigned int>("seed")
+          != other.get<unsigned int>("seed")) {
+    cerr << "WARNING: the two results were obtained with different datasets!"
+        << endl;
+  }
+
+  double lumi_ref(reference.get<double>("luminosity"));
+  double lumi_other(other.get<double>("luminosity"));
+  double lumi_error_ref(reference.get<double>("luminosity_error"));
+
+  cout << reference.get<string>("precision") << ": luminosity = " << lumi_ref
+      << " +- " << lumi_error_ref << ", fit duration = "
+      << reference.get<double>("fit_duration") << " s" << endl;
+  cout << other.get<string>("precision") << ": luminosity = " << lumi_other
+      << " +- " << other.get<double>("luminosity_error")
+      << ", fit duration = " << other.get<double>("fit_duration") << " s"
+      << endl;
+  cout << "relative luminosity difference: "
+      << (lumi_other - lumi_ref) / lumi_ref << endl;
+  if (lumi_error_ref > 0.0)
+    cout << "luminosity difference in units of the fit error: "
+        << (lumi_other - lumi_ref) / lumi_error_ref << endl;
+  if (other.get<double>("fit_duration") > 0.0)
+    cout << "speedup: "
+        << reference.get<double>("fit_duration")
+            / other.get<double>("fit_duration") << endl;
+}
+
+void displayInfo() {
+  cout << "Fit mode (stores the result of one build in a json file):" << endl;
+  cout << "-o [output json file]" << endl;
+  cout << "Optional arguments are: " << endl;
+  cout << "-b [number of bins per axis] (default 200)" << endl;
+  cout << "-m [number of threads] (default 1)" << endl;
+  cout << "-e [number of events in the fit range] (default 1e6)" << endl;
+  cout << "-s [random seed] (default 12345)" << endl;
+  cout << "Compare mode:" << endl;
+  cout << "-c [reference json file] [other json file]" << endl;
+}
+
+int main(int argc, char* argv[]) {
+  string output_file("");
+  string reference_file("");
+  unsigned int bins(200);
+  unsigned int nthreads(1);
+  double events(1e6);
+  unsigned int seed(12345);
+
+  int c;
+
+  while ((c = getopt(argc, argv, "ho:c:b:m:e:s:")) != -1) {
+    switch (c) {
+      case 'o':
+        output_file = optarg;
+        break;
+      case 'c':
+        reference_file = optarg;
+        break;
+      case 'b':
+        bins = atoi(optarg);
+        break;
+      case 'm':
+        nthreads = atoi(optarg);
+        break;
+      case 'e':
+        events = atof(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case '?':
+        if (optopt == 'o' || optopt == 'c' || optopt == 'b' || optopt == 'm'
+            || optopt == 'e' || optopt == 's')
+          cerr << "Option -" << optopt << " requires an argument." << endl;
+        else
+          cerr << "Unknown option -" << optopt << "." << endl;
+        return 1;
+      case 'h':
+        displayInfo();
+        return 1;
+      default:
+        return 1;
+    }
+  }
+
+  if (reference_file != "" && optind < argc)
+    compareValidationFits(reference_file, argv[optind]);
+  else if (output_file != "" && bins > 0 && nthreads > 0)
+    runValidationFit(output_file, bins, nthreads, events, seed);
+  else
+    displayInfo();
+  return 0;
+}
@@ -10,7 +10,7 @@
 ClassImp(PndLmdFitOptions)
 
 PndLmdFitOptions::PndLmdFitOptions() :
-		estimator_type(LumiFit::LOG_LIKELIHOOD) {
+		estimator_type(LumiFit::LOG_LIKELIHOOD), minimizer_type(LumiFit::MINUIT) {
 }
 
 boost::property_tree::ptree PndLmdFitOptions::getModelOptionsPropertyTree() const {
@@ -129,6 +129,9 @@ std::ostream& operator<<(std::ostream& os,
 	os << "Estimator type: "
 			<< LumiFit::LmdEstimatorTypeToString.at(fit_options.estimator_type)
 			<< std::endl;
+	os << "Minimizer type: "
+			<< LumiFit::LmdMinimizerTypeToString.at(fit_options.minimizer_type)
+			<< std::endl;
 	os << fit_options.getEstimatorOptions();
 
 	os << std::endl
@@ -24,6 +24,7 @@
  * - model options
  * - fit ranges
  * - estimator type
+ * - minimizer type
  * - estimator options
  *
  * The fields can only be set by the user within the #PndLmdFitFacade class, to
@@ -43,6 +44,7 @@ private:
 #endif /* __CINT __ */
 
 	LumiFit::LmdEstimatorType estimator_type;
+	LumiFit::LmdMinimizerType minimizer_type;
 
 	std::set<std::string, ModelStructs::string_comp> free_parameter_names;
 
@@ -84,7 +86,7 @@ public:
 	friend std::ostream & operator <<(std::ostream & os,
 			const PndLmdFitOptions & fit_options);
 
-ClassDef(PndLmdFitOptions,1)
+ClassDef(PndLmdFitOptions,2)
 	;
 };
 
@@ -1,10 +1,13 @@
 #include "model/CachedModel2D.h"
 #include "ui/PndLmdRuntimeConfiguration.h"
+#include "core/ModelCloner.h"
+#include "core/FitTracer.h"
 #include "operators2d/integration/IntegralStrategyGSL2D.h"
-#include "operators2d/integration/SimpleIntegralStrategy2D.h"
+#include "operators2d/integration/GaussLegendreIntegralStrategy2D.h"
 
 #include "boost/thread.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <thread>
 #include <future>
@@ -15,7 +18,7 @@ CachedModel2D::CachedModel2D(const std::string& name,
     std::shared_ptr<Model2D> model_, const LumiFit::LmdDimension& data_dim_x_,
     const LumiFit::LmdDimension& data_dim_y_) :
     Model2D(name), model(model_), data_dim_x(data_dim_x_), data_dim_y(
-        data_dim_y_), integral_precision(1e-6) {
+        data_dim_y_), integral_precision(1e-6), grid_scale_factor(1.0) {
   nthreads = PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
 
   addModelToList(model);
@@ -28,17 +31,14 @@ CachedModel2D::CachedModel2D(const std::string& name,
 }
 
 CachedModel2D::~CachedModel2D() {
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    delete[] (model_grid[i]);
-  }
-  delete[] (model_grid);
 }
 
 void CachedModel2D::initializeModelGrid() {
-  model_grid = new mydouble*[data_dim_x.bins];
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    model_grid[i] = new mydouble[data_dim_y.bins];
-  }
+  model_grid.resize(data_dim_x.bins, data_dim_y.bins,
+      Grid2D<mydouble>::cache_line_values);
+  model_grid.setAxes(data_dim_x.dimension_range.getRangeLow(),
+      data_dim_x.bin_size, data_dim_y.dimension_range.getRangeLow(),
+      data_dim_y.bin_size);
 
   mydouble div_bin_size_x = data_dim_x.bin_size;
   mydouble div_bin_size_y = data_dim_y.bin_size;
@@ -88,9 +88,25 @@ void CachedModel2D::initializeModelGrid() {
 void CachedModel2D::initModelParameters() {
 }
 
+void CachedModel2D::setLinearScaleParameter(
+    const std::string &scale_parameter_name) {
+  dependency_tracker.setScaleParameterName(scale_parameter_name);
+}
+
+void CachedModel2D::setNumberOfThreads(unsigned int number_of_threads) {
+  nthreads = std::max(1u, number_of_threads);
+  // the bins are distributed to the threads anew
+  int_ranges_lists.clear();
+  initializeModelGrid();
+  dependency_tracker.invalidate();
+}
+
 void CachedModel2D::generateModelGrid2D() {
  // std::cout << "generating model grid...\n";
- // optimizeNumericalIntegration();
+#ifdef LMDFIT_ENABLE_TRACING
+  unsigned long long evaluations(
+      integral_strategy->getNumberOfFunctionEvaluations());
+#endif
 
   // create threads and let them evaluate a part of the data
   boost::thread_group threads;
@@ -102,109 +118,89 @@ void CachedModel2D::generateModelGrid2D() {
   }
 
   threads.join_all();
+#ifdef LMDFIT_ENABLE_TRACING
+  LMDFIT_TRACE_COUNTER(getName() + ": integrand evaluations",
+      integral_strategy->getNumberOfFunctionEvaluations() - evaluations);
+#endif
 //  std::cout << "done!\n";
 }
 
 void CachedModel2D::optimizeNumericalIntegration() {
-  double div_bin_size_x = data_dim_x.bin_size;
-  double div_bin_size_y = data_dim_y.bin_size;
-
-  //integral_strategy.reset(
-  //    new IntegralStrategyGSL2D());
-  std::shared_ptr<SimpleIntegralStrategy2D> integral_strategy(
-      new SimpleIntegralStrategy2D());
+  // the bins are integrated adaptively, so only the flat bins are integrated
+  // with few evaluations and the steep ones (e.g. the coulomb peak at small
+  // theta) are refined
+  integral_strategy.reset(new GaussLegendreIntegralStrategy2D());
   model->setIntegralStrategy(integral_strategy);
-
-  unsigned int calls(5);
-  /*std::vector<std::future<unsigned int> > future_list;
-   std::vector<std::thread> thread_list;
-
-   std::mt19937 gen;
-   for (unsigned int i = 0; i < nthreads; i++) {
-   if (int_ranges_lists[i].size() > 0) {
-   std::uniform_int_distribution<unsigned int> random_index(0,
-   int_ranges_lists[i].size() - 1);
-   unsigned int index = random_index(gen);
-
-   std::packaged_task<unsigned int()> task(
-   std::bind(&IntegralStrategyGSL2D::determineOptimalCallNumber,
-   integral_strategy.get(), model.get(),
-   std::cref(int_ranges_lists[i][index].int_range), integral_precision));
-   future_list.push_back(task.get_future());
-   thread_list.push_back(std::thread(std::move(task)));
-   }
-   }
-
-   // wait for futures and compute maximum number of calls
-   for (auto& future : future_list) {
-   unsigned int temp_calls = future.get();
-   if (temp_calls > calls)
-   calls = temp_calls;
-   }
-
-   // join all threads
-   for (auto& thread : thread_list) {
-   if (thread.joinable())
-   thread.join();
-   }*/
-
-  //std::cout << "using start call: " << calls << std::endl;
-  integral_strategy->setUsedEvaluationGridConstant(calls);
-  //integral_strategy->setStartNumberOfFunctionEvaluations(calls);
 }
 
 void CachedModel2D::generateModelGrid2D(
     const std::vector<IntRange2D>& int_ranges) {
-  mydouble x[2];
-
-  std::shared_ptr<SimpleIntegralStrategy2D> test_integral_strategy(
-      new SimpleIntegralStrategy2D());
-  test_integral_strategy->setUsedEvaluationGridConstant(5);
-
   //std::cout << "num pairs: " << xy_pairs.size() << std::endl;
   for (unsigned int i = 0; i < int_ranges.size(); ++i) {
-    //x[0] = int_ranges[i].int_range[0].getDimensionMean();
-    //x[1] = int_ranges[i].int_range[1].getDimensionMean();
-    //model_grid[int_ranges[i].index_x][int_ranges[i].index_y] = model->eval(x);
-
     // calculate integral over the model bin
-    model_grid[int_ranges[i].index_x][int_ranges[i].index_y] = inverse_bin_area
+    model_grid(int_ranges[i].index_x, int_ranges[i].index_y) = inverse_bin_area
         * model->Integral(int_ranges[i].int_range, integral_precision);
-
-    //std::cout << int_ranges[i].index_x << ":" << int_ranges[i].index_y << " = "
-    //    << model_grid[int_ranges[i].index_x][int_ranges[i].index_y]
-    //    << std::endl;
   }
 }
 
 mydouble CachedModel2D::eval(const mydouble *x) const {
-  int ix = (x[0] - data_dim_x.dimension_range.getRangeLow())
-      / data_dim_x.bin_size;
-  int iy = (x[1] - data_dim_y.dimension_range.getRangeLow())
-      / data_dim_y.bin_size;
-
-  if (ix >= data_dim_x.bins || iy >= data_dim_y.bins || ix < 0 || iy < 0) {
-    /* std::cout << ix << "?=(" << x[0] << "-"
-     << data_dim_x.dimension_range.getRangeLow() << ")/"
-     << data_dim_x.bin_size << std::endl;*/
-    return 0.0;
-  }
+  return grid_scale_factor * model_grid.evaluateConstant(x[0], x[1]);
+}
+
+void CachedModel2D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  model_grid.evaluateConstant(xs, n, out);
+  const mydouble scale(grid_scale_factor);
+  for (unsigned int i = 0; i < n; ++i)
+    out[i] *= scale;
+}
+
+bool CachedModel2D::hasParameterDerivative(
+    const std::shared_ptr<ModelPar> &parameter) const {
+  return dependency_tracker.isScaleParameter(
+      model->getModelParameterSet(), parameter)
+      || Model2D::hasParameterDerivative(parameter);
+}
 
-  return model_grid[ix][iy];
+void CachedModel2D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  Model2D::evalParameterDerivatives(x, parameters, derivatives);
+  ModelParSet &dependencies = model->getModelParameterSet();
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    if (dependency_tracker.isScaleParameter(dependencies, parameters[i]))
+      derivatives[i] = model_grid.evaluateConstant(x[0], x[1])
+          * dependency_tracker.getScaleFactorDerivative();
+  }
 }
 
 void CachedModel2D::updateDomain() {
   // ok lets do a check if parameters have changed
-  bool recalculate(false);
-  for (auto model_par : model->getModelParameterSet().getModelParameterMap()) {
-    //std::cout<<"checking if model parameter has changed "<<model_par.first.second<<std::endl;
-    if (model_par.second->isModified()) {
-      recalculate = true;
+  ModelParSet &dependencies = model->getModelParameterSet();
+  switch (dependency_tracker.checkForUpdate(dependencies)) {
+    case ModelParameterDependencyTracker::FULL_UPDATE: {
+      LMDFIT_TRACE_SCOPE("grid", getName());
+      LMDFIT_TRACE_COUNTER(getName() + ": full grid updates", 1.0);
+      generateModelGrid2D();
+      dependency_tracker.markComputed(dependencies);
+      grid_scale_factor = 1.0;
       break;
     }
+    case ModelParameterDependencyTracker::RESCALE:
+      LMDFIT_TRACE_COUNTER(getName() + ": grid rescales", 1.0);
+      grid_scale_factor = dependency_tracker.getScaleFactor(dependencies);
+      break;
+    default:
+      break;
   }
+}
 
-  if (recalculate) {
-    generateModelGrid2D();
-  }
+std::shared_ptr<Model> CachedModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  std::shared_ptr<CachedModel2D> copy(
+      new CachedModel2D(getName(), cloner.clone(model), data_dim_x,
+          data_dim_y));
+  copy->setLinearScaleParameter(dependency_tracker.getScaleParameterName());
+  copy->setNumberOfThreads(nthreads);
+  return copy;
 }
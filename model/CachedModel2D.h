@@ -1,10 +1,14 @@
 #ifndef MODEL_CACHEDMODEL2D_H_
 #define MODEL_CACHEDMODEL2D_H_
 
+#include <core/Grid2D.h>
 #include <core/Model2D.h>
+#include <core/ModelParameterDependencyTracker.h>
 #include "LumiFitStructs.h"
 #include "operators2d/integration/IntegralStrategyGSL2D.h"
 
+class GaussLegendreIntegralStrategy2D;
+
 class CachedModel2D: public Model2D {
   struct IntRange2D {
     std::vector<DataStructs::DimensionRange> int_range;
@@ -17,12 +21,21 @@ class CachedModel2D: public Model2D {
   mydouble integral_precision;
 
   std::shared_ptr<Model2D> model;
+  // the strategy remembers the refinement of each bin between regenerations
+  // of the grid
+  std::shared_ptr<GaussLegendreIntegralStrategy2D> integral_strategy;
 
   LumiFit::LmdDimension data_dim_x;
   LumiFit::LmdDimension data_dim_y;
   mydouble inverse_bin_area;
 
-  mydouble **model_grid;
+  Grid2D<mydouble> model_grid;
+
+  // the grid is recomputed only if a parameter of the model has changed
+  ModelParameterDependencyTracker dependency_tracker;
+  // ratio of the current scale parameter value and the one the grid was
+  // computed with
+  mydouble grid_scale_factor;
 
   std::vector<std::vector<IntRange2D> > int_ranges_lists;
 
@@ -32,6 +45,9 @@ class CachedModel2D: public Model2D {
   void optimizeNumericalIntegration();
   void generateModelGrid2D(const std::vector<IntRange2D>& int_ranges);
 
+protected:
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
   CachedModel2D(const std::string& name, std::shared_ptr<Model2D> model_,
       const LumiFit::LmdDimension& data_dim_x_,
@@ -40,8 +56,34 @@ public:
 
   void initModelParameters();
 
+  /**
+   * Declares the model parameter with name scale_parameter_name to be a pure
+   * scale factor of the cached model (e.g. the luminosity). Changes of only
+   * this parameter then rescale the grid instead of recomputing it.
+   */
+  void setLinearScaleParameter(const std::string &scale_parameter_name);
+
+  /**
+   * Sets the number of threads integrating the grid. The default is the
+   * number of threads of the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads);
+
   mydouble eval(const mydouble *x) const;
 
+  void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+  /**
+   * The model is proportional to the linear scale parameter (see
+   * #setLinearScaleParameter()), so its derivative is known analytically.
+   */
+  bool hasParameterDerivative(
+      const std::shared_ptr<ModelPar> &parameter) const;
+
+  void evalParameterDerivatives(const mydouble *x,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble *derivatives) const;
+
   virtual void updateDomain();
 };
 
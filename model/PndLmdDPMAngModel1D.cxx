@@ -6,23 +6,24 @@
  */
 
 #include "PndLmdDPMAngModel1D.h"
+#include "core/ModelCloner.h"
 
+#include <algorithm>
 #include <cmath>
 
-#include "TLorentzVector.h"
 #include "TMath.h"
 
 PndLmdDPMAngModel1D::PndLmdDPMAngModel1D(std::string name_,
     LumiFit::DPMElasticParts elastic_type_,
-    LumiFit::TransformationOption trafo_type) :
-    PndLmdDPMMTModel1D(name_, elastic_type_) {
+    LumiFit::TransformationOption trafo_type_) :
+    PndLmdDPMMTModel1D(name_, elastic_type_), trafo_type(trafo_type_) {
 
   initModelParameters();
 
   if (trafo_type == LumiFit::CORRECT) {
-    trafo_func = &PndLmdDPMAngModel1D::getMomentumTransferFromThetaCorrect;
+    trafo_func = &PndLmdDPMAngModel1D::transformThetaCorrect;
   } else {
-    trafo_func = &PndLmdDPMAngModel1D::getMomentumTransferFromThetaApprox;
+    trafo_func = &PndLmdDPMAngModel1D::transformThetaApprox;
   }
 }
 
@@ -30,59 +31,102 @@ PndLmdDPMAngModel1D::~PndLmdDPMAngModel1D() {
   // TODO Auto-generated destructor stub
 }
 
+void PndLmdDPMAngModel1D::transformThetaCorrect(const mydouble theta,
+    mydouble &t, mydouble &jacobian) const {
+  // the momentum only changes its direction, so t = -|p_after - p_before|^2
+  // = -2 p^2 (1 - cos(theta))
+  mydouble p2(p_lab->getValue() * p_lab->getValue());
+  mydouble sin_half_theta(std::sin(0.5 * theta));
+  t = -4.0L * p2 * sin_half_theta * sin_half_theta;
+  jacobian = std::fabs(2.0L * p2 * std::sin(theta));
+}
+
+void PndLmdDPMAngModel1D::transformThetaApprox(const mydouble theta,
+    mydouble &t, mydouble &jacobian) const {
+  // read lmd note/tdr for a derivation of this formula
+  // t = -2 pcm2 (1 + signum / sqrt(1 + u^2)), u = p sin(theta) / (gamma * d)
+  const mydouble p(p_lab->getValue());
+  const mydouble beta_e(beta_lab_cms->getValue() * E_lab->getValue());
+  const mydouble sin_theta(std::sin(theta));
+  const mydouble cos_theta(std::cos(theta));
+
+  mydouble denominator = p * cos_theta - beta_e;
+  mydouble u(p * sin_theta / (gamma->getValue() * denominator));
+  mydouble root(std::sqrt(1.0L + u * u));
+  if (0.0 > denominator) {
+    t = -2.0L * pcm2->getValue() * (1.0L + 1.0L / root);
+  } else {
+    // 1 - 1 / root without the cancellation at small angles
+    t = -2.0L * pcm2->getValue() * u * u / (root * (root + 1.0L));
+  }
+  // |dt/du * du/dtheta|
+  mydouble du_dtheta(
+      p * (p - beta_e * cos_theta)
+          / (gamma->getValue() * denominator * denominator));
+  jacobian = std::fabs(
+      2.0L * pcm2->getValue() * u * du_dtheta / (root * root * root));
+}
+
 mydouble PndLmdDPMAngModel1D::getMomentumTransferFromThetaCorrect(
     const mydouble theta) const {
-  TLorentzVector before(0, 0, p_lab->getValue(), E_lab->getValue());
-  TLorentzVector after(before);
-  after.SetTheta(theta);
-
-  //after.Boost(0.0, 0.0, -beta_lab_cms->getValue());
-  return (after - before).M2();
+  mydouble t, jacobian;
+  transformThetaCorrect(theta, t, jacobian);
+  return t;
 }
 
 mydouble PndLmdDPMAngModel1D::getMomentumTransferFromThetaApprox(
     const mydouble theta) const {
-  // read lmd note/tdr for a derivation of this formula
-  mydouble signum = -1.0L;
-  mydouble denominator = p_lab->getValue() * cos(theta)
-      - beta_lab_cms->getValue() * E_lab->getValue();
-  if (0.0 > denominator)
-    signum = 1.0L;
-
-  mydouble temp(
-      p_lab->getValue() * sin(theta) / (gamma->getValue() * denominator));
-  mydouble t = -2.0L * pcm2->getValue()
-      * (1.0L + signum / std::sqrt(1.0L + temp * temp));
+  mydouble t, jacobian;
+  transformThetaApprox(theta, t, jacobian);
   return t;
 }
 
 mydouble PndLmdDPMAngModel1D::getMomentumTransferFromTheta(
     const mydouble theta) const {
-  return (this->*trafo_func)(theta);
+  mydouble t, jacobian;
+  (this->*trafo_func)(theta, t, jacobian);
+  return t;
 }
 
 mydouble PndLmdDPMAngModel1D::getThetaMomentumTransferJacobian(
     const mydouble theta) const {
-  //numerical derivate calculation
-  //is quite accurate with relatively easy implementation
-  //via f (x) ≈ [f(x + h) − f(x − h)] / 2h
-  //important!: pick h appropriately
-  mydouble e_m = 1.0L * 1e-16L; // machine precision
-  mydouble h = std::pow(e_m, 0.33) * theta;
-
-  return std::fabs(
-      ((this->*trafo_func)(theta + h) - (this->*trafo_func)(theta - h))
-          / (h*2.0));
+  mydouble t, jacobian;
+  (this->*trafo_func)(theta, t, jacobian);
+  return jacobian;
 }
 
 mydouble PndLmdDPMAngModel1D::eval(const mydouble *x) const {
   //return luminosity->getValue();
 
-  mydouble t = (this->*trafo_func)(x[0]);
-  mydouble jaco = getThetaMomentumTransferJacobian(x[0]);
+  mydouble t, jaco;
+  (this->*trafo_func)(x[0], t, jaco);
   return PndLmdDPMMTModel1D::eval(&t) * jaco;
 }
 
+void PndLmdDPMAngModel1D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  // transform the theta values chunkwise to t and evaluate the momentum
+  // transfer model on the whole chunk
+  const unsigned int chunk_size(128);
+  mydouble t[chunk_size];
+  mydouble jaco[chunk_size];
+  for (unsigned int offset = 0; offset < n; offset += chunk_size) {
+    unsigned int chunk = std::min(chunk_size, n - offset);
+    for (unsigned int i = 0; i < chunk; ++i)
+      (this->*trafo_func)(xs[offset + i], t[i], jaco[i]);
+    PndLmdDPMMTModel1D::evalBatch(t, chunk, &out[offset]);
+    for (unsigned int i = 0; i < chunk; ++i)
+      out[offset + i] *= jaco[i];
+  }
+}
+
 void PndLmdDPMAngModel1D::updateDomain() {
   setDomain(0, TMath::Pi());
+  updateCoefficients();
+}
+
+std::shared_ptr<Model> PndLmdDPMAngModel1D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(
+      new PndLmdDPMAngModel1D(getName(), elastic_type, trafo_type));
 }
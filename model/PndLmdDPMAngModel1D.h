@@ -11,13 +11,24 @@
 #include "PndLmdDPMMTModel1D.h"
 
 class PndLmdDPMAngModel1D: public PndLmdDPMMTModel1D {
-// function pointer used to switch between different algorithms for interpolation
-  typedef mydouble (PndLmdDPMAngModel1D::*trans_function)(const mydouble theta) const;
+// function pointer used to switch between the theta -> t transformations,
+// which compute t and the jacobian |dt/dtheta| in closed form
+  typedef void (PndLmdDPMAngModel1D::*trans_function)(const mydouble theta,
+      mydouble &t, mydouble &jacobian) const;
 
   trans_function trafo_func;
+  LumiFit::TransformationOption trafo_type;
+
+  void transformThetaCorrect(const mydouble theta, mydouble &t,
+      mydouble &jacobian) const;
+  void transformThetaApprox(const mydouble theta, mydouble &t,
+      mydouble &jacobian) const;
+
+protected:
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
 
 public:
-    PndLmdDPMAngModel1D(std::string name_, LumiFit::DPMElasticParts elastic_type_, LumiFit::TransformationOption trafo_type);
+    PndLmdDPMAngModel1D(std::string name_, LumiFit::DPMElasticParts elastic_type_, LumiFit::TransformationOption trafo_type_);
     virtual ~PndLmdDPMAngModel1D();
 
     mydouble getMomentumTransferFromThetaCorrect(const mydouble theta) const;
@@ -35,6 +46,8 @@ public:
      * par */
     mydouble eval(const mydouble *x) const;
 
+    void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
     virtual void updateDomain();
 };
 
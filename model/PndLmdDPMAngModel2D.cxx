@@ -6,13 +6,17 @@
  */
 
 #include "PndLmdDPMAngModel2D.h"
+#include "core/ModelCloner.h"
+
+#include <algorithm>
+#include <cmath>
 
 #include "TMath.h"
-#include "TVector3.h"
 
 PndLmdDPMAngModel2D::PndLmdDPMAngModel2D(std::string name_,
 		std::shared_ptr<PndLmdDPMAngModel1D> dpm_model_1d_) :
 		Model2D(name_), dpm_model_1d(dpm_model_1d_) {
+	one_over_two_pi = 0.5 / TMath::Pi();
 	initModelParameters();
 	this->addModelToList(dpm_model_1d);
 	//getModelParameterSet().addModelParameters(
@@ -23,84 +27,96 @@ PndLmdDPMAngModel2D::~PndLmdDPMAngModel2D() {
 	// TODO Auto-generated destructor stub
 }
 
-std::pair<mydouble, mydouble> PndLmdDPMAngModel2D::calculateThetaFromTiltedSystem(
-		const mydouble theta, const mydouble phi) const {
-	mydouble x = tan(tilt_x->getValue());
-	mydouble y = tan(tilt_y->getValue());
-	TVector3 tilt(x, y, 1.0);
-	TVector3 rotate_axis(y, -x, 0.0);
-	TVector3 measured_direction(sin(theta) * cos(phi), sin(theta) * sin(phi),
-			cos(theta));
-	measured_direction.Rotate(tilt.Theta(), rotate_axis);
-	return std::make_pair(measured_direction.Theta(), measured_direction.Phi());
-	/*
-	 TVector3 tilt(tan(tilt_x->getValue()), tan(tilt_y->getValue()), 1.0);
-	 TVector3 measured_direction(sin(theta) * cos(phi), sin(theta) * sin(phi),
-	 cos(theta));
-
-	 // determine euler angles for going from xyz to tilted frame
-	 TVector3 zprime = tilt.Unit();
-	 TVector3 yprime(-zprime.Y(), zprime.X(), 0.0);
-	 TVector3 xprime = yprime.Cross(zprime);
-	 double beta = acos(zprime.Z());
-	 double alpha = atan2(zprime.X(), -zprime.Y());
-	 double gamma = atan2(xprime.Z(), yprime.Z());
-
-	 // this would be the transformation from xyz to tilted frame
-	 //measured_direction.RotateZ(alpha);
-	 //measured_direction.Rotate(beta, yprime);
-	 //measured_direction.Rotate(gamma, zprime);
-	 // this is the inverse
-	 measured_direction.Rotate(-gamma, zprime);
-	 measured_direction.Rotate(-beta, yprime);
-	 measured_direction.RotateZ(-alpha);
+PndLmdDPMAngModel2D::TiltRotation PndLmdDPMAngModel2D::calculateTiltRotation() const {
+	// rotation by the polar angle of the beam around the axis (y, -x, 0)
+	// (rodrigues formula), with cos(angle) = 1 / norm. 1 - cos(angle) is
+	// written as r^2 / (norm * (norm + 1)), so that the matrix has no
+	// cancellation at small tilts and no special case for a vanishing axis.
+	mydouble x = std::tan(tilt_x->getValue());
+	mydouble y = std::tan(tilt_y->getValue());
+	mydouble norm = std::sqrt(1.0 + x * x + y * y);
+	mydouble c = 1.0 / norm;
+	mydouble a = c / (norm + 1.0);
 
-	 return std::make_pair(measured_direction.Theta(), measured_direction.Phi());*/
+	TiltRotation rotation;
+	rotation.matrix[0][0] = c + y * y * a;
+	rotation.matrix[0][1] = -x * y * a;
+	rotation.matrix[0][2] = -x * c;
+	rotation.matrix[1][0] = -x * y * a;
+	rotation.matrix[1][1] = c + x * x * a;
+	rotation.matrix[1][2] = -y * c;
+	rotation.matrix[2][0] = x * c;
+	rotation.matrix[2][1] = y * c;
+	rotation.matrix[2][2] = c;
+	return rotation;
 }
 
-mydouble PndLmdDPMAngModel2D::calculateJacobianDeterminant(const mydouble theta,
-		const mydouble phi) const {
-	mydouble e_m = 1.0 * 1e-16; // machine precision
-	mydouble ht = pow(e_m, 0.33) * theta;
-	mydouble hp = pow(e_m, 0.33) * phi;
-
-	std::pair<mydouble, mydouble> shift_plus_ht = calculateThetaFromTiltedSystem(
-			theta + ht, phi);
-	std::pair<mydouble, mydouble> shift_min_ht = calculateThetaFromTiltedSystem(
-			theta - ht, phi);
-	std::pair<mydouble, mydouble> shift_plus_hp = calculateThetaFromTiltedSystem(
-			theta, phi + hp);
-	std::pair<mydouble, mydouble> shift_min_hp = calculateThetaFromTiltedSystem(theta,
-			phi - hp);
-
-	mydouble j11 = (shift_plus_ht.first - shift_min_ht.first) / (2 * ht);
-	mydouble j12 = (shift_plus_hp.first - shift_min_hp.first) / (2 * hp);
-	mydouble j21 = (shift_plus_ht.second - shift_min_ht.second) / (2 * ht);
-	mydouble j22 = (shift_plus_hp.second - shift_min_hp.second) / (2 * hp);
-
-	return j11 * j22 - j21 * j12;
+mydouble PndLmdDPMAngModel2D::calculateThetaFromTiltedSystem(
+		const TiltRotation &rotation, const mydouble theta, const mydouble phi,
+		mydouble &jacobian) const {
+	const mydouble sin_theta(std::sin(theta));
+	const mydouble direction[3] = { sin_theta * std::cos(phi), sin_theta
+			* std::sin(phi), std::cos(theta) };
+	mydouble tilted_direction[3];
+	for (unsigned int i = 0; i < 3; ++i) {
+		tilted_direction[i] = rotation.matrix[i][0] * direction[0]
+				+ rotation.matrix[i][1] * direction[1]
+				+ rotation.matrix[i][2] * direction[2];
+	}
+	// the sine from the transverse components is accurate at small angles,
+	// unlike acos of the z component
+	mydouble sin_theta_tilted = std::sqrt(
+			tilted_direction[0] * tilted_direction[0]
+					+ tilted_direction[1] * tilted_direction[1]);
+	// the direction of the beam itself is a coordinate singularity of the
+	// tilted frame, the density is taken to vanish there
+	jacobian = 0.0;
+	if (sin_theta_tilted > 0.0)
+		jacobian = sin_theta / sin_theta_tilted;
+	return std::atan2(sin_theta_tilted, tilted_direction[2]);
 }
 
 void PndLmdDPMAngModel2D::initModelParameters() {
 	tilt_x = getModelParameterSet().addModelParameter("tilt_x");
+	tilt_x->setValue(0.0);
 	tilt_y = getModelParameterSet().addModelParameter("tilt_y");
+	tilt_y->setValue(0.0);
 }
 
 mydouble PndLmdDPMAngModel2D::eval(const mydouble *x) const {
-	/*double theta_tilted(calculateThetaFromTiltedSystem(x[0], x[1]).first);
-	double jaco(calculateJacobianDeterminant(x[0], x[1]));*/
-/*	std::cout << "measured theta,phi: " << x[0] << "," << x[1]
-			<< " -> transforms to evaluated theta of: " << theta_tilted << std::endl;
-	std::cout << "jacobian: " << jaco << std::endl;*/
-  /*if(theta_tilted > 0.001 && theta_tilted < 0.002) {
-  	return jaco*1.0;
-  }
-  return 0.0;*/
-	//return jaco * dpm_model_1d->eval(&theta_tilted) / (2.0 * TMath::Pi());
-	return dpm_model_1d->eval(x) / (2.0 * TMath::Pi());
+	mydouble jacobian;
+	mydouble theta_tilted = calculateThetaFromTiltedSystem(
+			calculateTiltRotation(), x[0], x[1], jacobian);
+	return jacobian * dpm_model_1d->eval(&theta_tilted) * one_over_two_pi;
+}
+
+void PndLmdDPMAngModel2D::evalBatch(const mydouble *xs, unsigned int n,
+		mydouble *out) const {
+	const TiltRotation rotation(calculateTiltRotation());
+	const unsigned int chunk_size(128);
+	mydouble theta_tilted[chunk_size];
+	mydouble jacobian[chunk_size];
+	for (unsigned int offset = 0; offset < n; offset += chunk_size) {
+		unsigned int chunk = std::min(chunk_size, n - offset);
+		for (unsigned int i = 0; i < chunk; ++i) {
+			theta_tilted[i] = calculateThetaFromTiltedSystem(rotation,
+					xs[2 * (offset + i)], xs[2 * (offset + i) + 1], jacobian[i]);
+		}
+		dpm_model_1d->evalBatch(theta_tilted, chunk, &out[offset]);
+		for (unsigned int i = 0; i < chunk; ++i)
+			out[offset + i] *= jacobian[i] * one_over_two_pi;
+	}
 }
 
 void PndLmdDPMAngModel2D::updateDomain() {
 	setVar1Domain(0, TMath::Pi());
 	setVar2Domain(-TMath::Pi(), TMath::Pi());
 }
+
+std::shared_ptr<Model> PndLmdDPMAngModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(
+      new PndLmdDPMAngModel2D(getName(),
+          cloner.clone(
+              std::dynamic_pointer_cast<PndLmdDPMAngModel1D>(dpm_model_1d))));
+}
@@ -11,17 +11,42 @@
 #include "core/Model2D.h"
 #include "PndLmdDPMAngModel1D.h"
 
+/**
+ * Angular distribution of the elastic scattering in (theta, phi) of the
+ * measurement frame, for a beam tilted by tilt_x and tilt_y. The measured
+ * direction is rotated into the frame of the beam, in which the distribution
+ * is the one of the 1D dpm model. The rotation and the jacobian determinant
+ * are computed in closed form, so the model is exact also for large tilts.
+ */
 class PndLmdDPMAngModel2D: public Model2D {
+	struct TiltRotation {
+		mydouble matrix[3][3];
+	};
+
+	mydouble one_over_two_pi;
+
 	std::shared_ptr<Model> dpm_model_1d;
 
 	std::shared_ptr<ModelPar> tilt_x;
 	std::shared_ptr<ModelPar> tilt_y;
 
-	std::pair<mydouble, mydouble> calculateThetaFromTiltedSystem(const mydouble theta,
-			const mydouble phi) const;
+	/**
+	 * Returns the rotation which maps the beam direction
+	 * (tan(tilt_x), tan(tilt_y), 1) onto the z axis.
+	 */
+	TiltRotation calculateTiltRotation() const;
 
-	mydouble calculateJacobianDeterminant(const mydouble theta,
-			const mydouble phi) const;
+	/**
+	 * Returns the polar angle of the measured direction (theta, phi) in the
+	 * tilted frame. As the rotation preserves the solid angle, the jacobian
+	 * determinant of (theta, phi) -> (theta', phi') is sin(theta) /
+	 * sin(theta'), which is written to jacobian.
+	 */
+	mydouble calculateThetaFromTiltedSystem(const TiltRotation &rotation,
+			const mydouble theta, const mydouble phi, mydouble &jacobian) const;
+
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
 
 public:
 	PndLmdDPMAngModel2D(std::string name_,
@@ -32,6 +57,8 @@ public:
 
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
 	virtual void updateDomain();
 };
 
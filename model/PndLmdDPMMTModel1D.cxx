@@ -6,6 +6,7 @@
  */
 
 #include "PndLmdDPMMTModel1D.h"
+#include "core/ModelCloner.h"
 
 #include <cmath>
 #include <map>
@@ -16,7 +17,7 @@
 
 PndLmdDPMMTModel1D::PndLmdDPMMTModel1D(std::string name_,
     LumiFit::DPMElasticParts elastic_type_) :
-    Model1D(name_) {
+    Model1D(name_), coefficients() {
 
   elastic_type = elastic_type_;
   if (elastic_type == LumiFit::COUL) {
@@ -78,17 +79,46 @@ void PndLmdDPMMTModel1D::initModelParameters() {
   T2 = getModelParameterSet().addModelParameter("T2");
 }
 
+void PndLmdDPMMTModel1D::updateCoefficients() {
+  ModelParSet &dependencies = getModelParameterSet();
+  if (dependency_tracker.checkForUpdate(dependencies)
+      == ModelParameterDependencyTracker::NO_UPDATE)
+    return;
+
+  coefficients.luminosity = luminosity->getValue();
+  coefficients.coulomb_factor = alpha_squared_4pi * hbarc2
+      / (beta->getValue() * beta->getValue());
+  coefficients.interference_factor = alpha * sigma_tot->getValue()
+      / beta->getValue();
+  coefficients.b = b->getValue();
+  coefficients.half_b = 0.5 * b->getValue();
+  coefficients.rho = rho->getValue();
+  coefficients.A1 = A1->getValue();
+  coefficients.A2 = A2->getValue();
+  coefficients.A3 = A3->getValue();
+  coefficients.half_over_T1 = 0.5 / T1->getValue();
+  coefficients.half_over_T2 = 0.5 / T2->getValue();
+  coefficients.rho_b_sigtot_hadronic_factor = sigma_tot->getValue()
+      * sigma_tot->getValue() * (1.0 + rho->getValue() * rho->getValue())
+      * one_over_16pi_hbarc2;
+
+  dependency_tracker.markComputed(dependencies);
+}
+
 mydouble PndLmdDPMMTModel1D::getDelta(const mydouble t) const {
-  return 1.408450704L * TMath::Abs(t); //TMath::Abs(t) / 0.71; division costs more
+  return 1.408450704L * std::fabs(t); //std::fabs(t) / 0.71; division costs more
 }
 
 mydouble PndLmdDPMMTModel1D::getProtonDipoleFormFactor(const mydouble t) const {
-  return std::pow((1.0 + getDelta(t)), -2);
+  mydouble one_plus_delta(1.0 + getDelta(t));
+  return 1.0 / (one_plus_delta * one_plus_delta);
 }
 
 mydouble PndLmdDPMMTModel1D::getRawCoulombPart(const mydouble *x) const {
-  mydouble p1 = alpha_squared_4pi * std::pow(getProtonDipoleFormFactor(x[0]), 4)
-      * hbarc2 / std::pow(beta->getValue() * x[0], 2); //Coulomb part
+  mydouble form_factor_squared(getProtonDipoleFormFactor(x[0]));
+  form_factor_squared *= form_factor_squared;
+  mydouble p1 = coefficients.coulomb_factor * form_factor_squared
+      * form_factor_squared / (x[0] * x[0]); //Coulomb part
   return p1;
 }
 
@@ -98,18 +128,17 @@ mydouble PndLmdDPMMTModel1D::getRawInterferencePart(const mydouble *x) const {
   // however in case of theta fitting the t is automatically calculated to be negative
   // to make them both work this step is necessary
   // (ok maybe for later its better to always give positive t here...)
-  mydouble t = -std::fabs(x[0]);
-  mydouble del = getDelta(t);
+  mydouble abs_t = std::fabs(x[0]);
+  mydouble del = getDelta(abs_t);
 
-  mydouble dd2 = 4.0 * del, dd1 = 0.5 * b->getValue() * std::fabs(t) + dd2;
+  mydouble dd2 = 4.0 * del, dd1 = coefficients.half_b * abs_t + dd2;
   mydouble logdd1 = std::log(dd1), logdd2 = std::log(dd2);
   mydouble delta = alpha * (0.577 + logdd1 + dd2 * logdd2 + 2.0 * del);
 
-  mydouble int_part = alpha * sigma_tot->getValue()
-      * std::pow(getProtonDipoleFormFactor(t), 2)
-      * std::exp(0.5 * b->getValue() * t)
-      * (rho->getValue() * cos(delta) + sin(delta))
-      / (beta->getValue() * std::fabs(t)); //Exact version as dpm states
+  mydouble form_factor(getProtonDipoleFormFactor(abs_t));
+  mydouble int_part = coefficients.interference_factor * form_factor
+      * form_factor * std::exp(-coefficients.half_b * abs_t)
+      * (coefficients.rho * std::cos(delta) + std::sin(delta)) / abs_t; //Exact version as dpm states
 
   return int_part;
 }
@@ -117,12 +146,13 @@ mydouble PndLmdDPMMTModel1D::getRawInterferencePart(const mydouble *x) const {
 mydouble PndLmdDPMMTModel1D::getRawHadronicPart(const mydouble *x) const {
   mydouble t = -std::fabs(x[0]);
 
-  mydouble t_over_T2(t / T2->getValue());
-  mydouble had_part = A1->getValue()
-      * std::pow(
-          std::exp(t / (2.0 * T1->getValue()))
-              - A2->getValue() * std::exp(0.5 * t_over_T2), 2)
-      + A3->getValue() * std::exp(t_over_T2);
+  // exp(t / T2) = exp(t / (2 T2))^2
+  mydouble exp_t_over_2T2(std::exp(coefficients.half_over_T2 * t));
+  mydouble difference(
+      std::exp(coefficients.half_over_T1 * t)
+          - coefficients.A2 * exp_t_over_2T2);
+  mydouble had_part = coefficients.A1 * difference * difference
+      + coefficients.A3 * exp_t_over_2T2 * exp_t_over_2T2;
 
   return had_part;
 }
@@ -130,9 +160,8 @@ mydouble PndLmdDPMMTModel1D::getRawHadronicPart(const mydouble *x) const {
 mydouble PndLmdDPMMTModel1D::getRawRhoBSigtotHadronicPart(const mydouble *x) const {
   mydouble t = -std::fabs(x[0]);
 
-  mydouble had_part = std::pow(sigma_tot->getValue(), 2)
-      * (1.0 + std::pow(rho->getValue(), 2)) * std::exp(b->getValue() * t)
-      * one_over_16pi_hbarc2;
+  mydouble had_part = coefficients.rho_b_sigtot_hadronic_factor
+      * std::exp(coefficients.b * t);
 
   return had_part;
 }
@@ -148,9 +177,51 @@ mydouble PndLmdDPMMTModel1D::getRawRhoBSigtotFullElastic(const mydouble *x) cons
 }
 
 mydouble PndLmdDPMMTModel1D::eval(const mydouble *x) const {
-  return luminosity->getValue() * (this->*model_func)(x);
+  return coefficients.luminosity * (this->*model_func)(x);
+}
+
+namespace {
+// the part is passed as a lambda, so that it is inlined into the loop instead
+// of being called through the member function pointer for each point
+template<typename ElasticPart>
+void evaluateElasticPart(const mydouble *xs, unsigned int n, mydouble *out,
+    const mydouble luminosity, ElasticPart elastic_part) {
+  for (unsigned int i = 0; i < n; ++i)
+    out[i] = luminosity * elastic_part(&xs[i]);
+}
+}
+
+void PndLmdDPMMTModel1D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  const mydouble lumi = coefficients.luminosity;
+  if (elastic_type == LumiFit::COUL) {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawCoulombPart(x);});
+  } else if (elastic_type == LumiFit::INT) {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawInterferencePart(x);});
+  } else if (elastic_type == LumiFit::HAD) {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawHadronicPart(x);});
+  } else if (elastic_type == LumiFit::HAD_RHO_B_SIGTOT) {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawRhoBSigtotHadronicPart(x);});
+  } else if (elastic_type == LumiFit::ALL_RHO_B_SIGTOT) {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawRhoBSigtotFullElastic(x);});
+  } else {
+    evaluateElasticPart(xs, n, out, lumi,
+        [this](const mydouble *x) {return getRawFullElastic(x);});
+  }
 }
 
 void PndLmdDPMMTModel1D::updateDomain() {
   setDomain(0, std::numeric_limits<mydouble>::max());
+  updateCoefficients();
+}
+
+std::shared_ptr<Model> PndLmdDPMMTModel1D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(
+      new PndLmdDPMMTModel1D(getName(), elastic_type));
 }
@@ -9,6 +9,7 @@
 #define PNDLMDDPMMTMODEL1D_H_
 
 #include "core/Model1D.h"
+#include "core/ModelParameterDependencyTracker.h"
 #include "LumiFitStructs.h"
 
 /**
@@ -60,6 +61,38 @@ class PndLmdDPMMTModel1D: public Model1D {
 
 		function model_func;
 
+		/**
+		 * All parameter dependent factors of the DPM description, so that an
+		 * evaluation does not have to look up any parameter.
+		 */
+		struct DPMCoefficients {
+			mydouble luminosity;
+			// alpha^2 4 pi hbarc^2 / beta^2
+			mydouble coulomb_factor;
+			// alpha sigma_tot / beta
+			mydouble interference_factor;
+			mydouble b;
+			mydouble half_b;
+			mydouble rho;
+			mydouble A1;
+			mydouble A2;
+			mydouble A3;
+			mydouble half_over_T1;
+			mydouble half_over_T2;
+			// sigma_tot^2 (1 + rho^2) / (16 pi hbarc^2)
+			mydouble rho_b_sigtot_hadronic_factor;
+		};
+		DPMCoefficients coefficients;
+		// the coefficients are only recomputed if a parameter has changed
+		ModelParameterDependencyTracker dependency_tracker;
+
+		/**
+		 * Recomputes the #coefficients if a parameter of the model has changed.
+		 * Is called on each domain update, so derived classes which overwrite
+		 * #updateDomain() have to call it as well.
+		 */
+		void updateCoefficients();
+
 		/**
 		 *  initializes the above parameters of the DPM cross section that are
 		 *  absolutely fixed (so not dependent on the beam momentum for example)
@@ -68,6 +101,8 @@ class PndLmdDPMMTModel1D: public Model1D {
 
 		void updateDomainFromPars(mydouble *par);
 
+		std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 	public:
 		LumiFit::DPMElasticParts elastic_type;
 
@@ -101,6 +136,9 @@ class PndLmdDPMMTModel1D: public Model1D {
 
 		virtual mydouble eval(const mydouble *x) const;
 
+		virtual void evalBatch(const mydouble *xs, unsigned int n,
+				mydouble *out) const;
+
 		virtual void updateDomain();
 };
 
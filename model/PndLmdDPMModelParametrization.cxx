@@ -120,3 +120,9 @@ void PndLmdDPMModelParametrization::parametrize() {
 	adjustStrictParameters();
 	adjustNonStrictParameters();
 }
+
+std::shared_ptr<Parametrization> PndLmdDPMModelParametrization::clone(
+		ModelParSet &model_par_set_) const {
+	return std::shared_ptr<Parametrization>(
+			new PndLmdDPMModelParametrization(model_par_set_));
+}
@@ -1,11 +1,15 @@
 #include "PndLmdDifferentialSmearingConvolutionModel2D.h"
 #include "ui/PndLmdRuntimeConfiguration.h"
+#include "core/ModelCloner.h"
+#include "core/FitTracer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <iomanip>
-
-#include <boost/thread.hpp>
+#include <stdexcept>
 
 #include "TMath.h"
 
@@ -14,9 +18,15 @@ PndLmdDifferentialSmearingConvolutionModel2D::PndLmdDifferentialSmearingConvolut
     std::shared_ptr<PndLmdDivergenceSmearingModel2D> smearing_model_,
     const LumiFit::LmdDimension& data_dim_x_,
     const LumiFit::LmdDimension& data_dim_y_, unsigned int combine_factor_) :
-    Model2D(name_), data_dim_x(data_dim_x_), data_dim_y(data_dim_y_), combine_factor(
-        combine_factor_) {
-  nthreads = PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
+    Model2D(name_), data_dim_x(data_dim_x_), data_dim_y(data_dim_y_), grid_scale_factor(
+        1.0), nthreads(
+        PndLmdRuntimeConfiguration::Instance().getNumberOfThreads()), worker_pool(
+        new WorkerPool(nthreads)), combine_factor(combine_factor_), divergence_convolution(
+        data_dim_x_.bins * combine_factor_,
+        data_dim_y_.bins * combine_factor_), convolution_kernel_valid(false) {
+  unsmeared_model_evaluation_task = std::bind(
+      &PndLmdDifferentialSmearingConvolutionModel2D::evaluateUnsmearedModel,
+      this, std::placeholders::_1);
 
   unsmeared_model = unsmeared_model_;
   smearing_model = smearing_model_;
@@ -31,88 +41,37 @@ PndLmdDifferentialSmearingConvolutionModel2D::PndLmdDifferentialSmearingConvolut
   calc_data_dim_y.bins *= combine_factor;
   calc_data_dim_y.calculateBinSize();
 
+  // the divergence map shifts by multiples of its bin sizes, so it is only
+  // translation invariant on a calculation grid with the same bin sizes
+  if (std::fabs(binsizes.first - calc_data_dim_x.bin_size)
+      > 1e-6 * calc_data_dim_x.bin_size
+      || std::fabs(binsizes.second - calc_data_dim_y.bin_size)
+          > 1e-6 * calc_data_dim_y.bin_size) {
+    throw std::runtime_error(
+        "PndLmdDifferentialSmearingConvolutionModel2D: the bin sizes of the divergence map and the calculation grid differ!");
+  }
+
   addModelToList(unsmeared_model);
 
   setVar1Domain(-TMath::Pi(), TMath::Pi());
   setVar2Domain(-TMath::Pi(), TMath::Pi());
 
-  unsigned int bins_per_thread_x(calc_data_dim_x.bins / nthreads);
-  unsigned int bins_per_thread_y(calc_data_dim_y.bins / nthreads);
-
-  bool use_x_splitting(true);
-  if (calc_data_dim_x.bins % nthreads != 0) {
-    if (calc_data_dim_y.bins % nthreads == 0)
-      use_x_splitting = false;
-    else {
-      if (calc_data_dim_x.bins < 0 && calc_data_dim_y.bins < 0) {
-        if (calc_data_dim_y.bins > calc_data_dim_x.bins) {
-          use_x_splitting = false;
-          nthreads = calc_data_dim_y.bins;
-        } else {
-          nthreads = calc_data_dim_x.bins;
-        }
-      } else {
-        if (calc_data_dim_y.bins % nthreads > calc_data_dim_y.bins % nthreads) {
-          use_x_splitting = false;
-          bins_per_thread_y++;
-        }
-
-        else {
-          bins_per_thread_x++;
-        }
-      }
-    }
-  }
-  binrange br;
-  br.x_bin_low = 0;
-  br.x_bin_high = calc_data_dim_x.bins;
-  br.y_bin_low = 0;
-  br.y_bin_high = calc_data_dim_y.bins;
-  for (unsigned int i = 0; i < nthreads; ++i) {
-    if (use_x_splitting) {
-      br.x_bin_low = i * bins_per_thread_x;
-      br.x_bin_high = (i + 1) * bins_per_thread_x;
-      if (i == nthreads - 1)
-        br.x_bin_high = calc_data_dim_x.bins;
-    } else {
-      br.y_bin_low = i * bins_per_thread_y;
-      br.y_bin_high = (i + 1) * bins_per_thread_y;
-      if (i == nthreads - 1)
-        br.y_bin_high = calc_data_dim_y.bins;
-    }
-    list_of_bin_ranges.push_back(br);
-  }
-
-  model_grid = new mydouble*[data_dim_x.bins];
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    model_grid[i] = new mydouble[data_dim_y.bins];
-  }
-  fine_model_grid = new mydouble*[calc_data_dim_x.bins];
-  for (unsigned int i = 0; i < calc_data_dim_x.bins; i++) {
-    fine_model_grid[i] = new mydouble[calc_data_dim_y.bins];
-  }
-
-  previous_model_grid = new mydouble*[data_dim_x.bins];
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    previous_model_grid[i] = new mydouble[data_dim_y.bins];
+  fine_model_grid.resize(calc_data_dim_x.bins, calc_data_dim_y.bins);
+  fine_model_grid.setAxes(calc_data_dim_x.dimension_range.getRangeLow(),
+      calc_data_dim_x.bin_size, calc_data_dim_y.dimension_range.getRangeLow(),
+      calc_data_dim_y.bin_size);
+  evaluation_grid = &fine_model_grid;
+  if (combine_factor > 1) {
+    model_grid.resize(data_dim_x.bins, data_dim_y.bins,
+        Grid2D<mydouble>::cache_line_values);
+    model_grid.setAxes(data_dim_x.dimension_range.getRangeLow(),
+        data_dim_x.bin_size, data_dim_y.dimension_range.getRangeLow(),
+        data_dim_y.bin_size);
+    evaluation_grid = &model_grid;
   }
 }
 
 PndLmdDifferentialSmearingConvolutionModel2D::~PndLmdDifferentialSmearingConvolutionModel2D() {
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    delete[] (model_grid[i]);
-  }
-  delete[] (model_grid);
-
-  for (unsigned int i = 0; i < calc_data_dim_x.bins; i++) {
-    delete[] (fine_model_grid[i]);
-  }
-  delete[] (fine_model_grid);
-
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    delete[] (previous_model_grid[i]);
-  }
-  delete[] (previous_model_grid);
 }
 
 void PndLmdDifferentialSmearingConvolutionModel2D::initModelParameters() {
@@ -123,19 +82,91 @@ void PndLmdDifferentialSmearingConvolutionModel2D::injectModelParameter(
   getModelParameterSet().addModelParameter(model_param);
 }
 
+void PndLmdDifferentialSmearingConvolutionModel2D::setLinearScaleParameter(
+    const std::string &scale_parameter_name) {
+  dependency_tracker.setScaleParameterName(scale_parameter_name);
+}
+
+void PndLmdDifferentialSmearingConvolutionModel2D::setConvolutionMethod(
+    GridConvolution2D::Method method) {
+  divergence_convolution.setMethod(method);
+  convolution_kernel_valid = false;
+}
+
+void PndLmdDifferentialSmearingConvolutionModel2D::updateConvolutionKernel() {
+  LMDFIT_TRACE_SCOPE("kernel", getName());
+  int half_width_x(0);
+  int half_width_y(0);
+  if (smearing_model->isSeparable()) {
+    const std::vector<mydouble> &kernel_x =
+        smearing_model->getSeparableKernelX();
+    const std::vector<mydouble> &kernel_y =
+        smearing_model->getSeparableKernelY();
+    half_width_x = kernel_x.size() / 2;
+    half_width_y = kernel_y.size() / 2;
+    divergence_convolution.setSeparableKernel(half_width_x, half_width_y,
+        kernel_x, kernel_y);
+  } else {
+    const std::vector<DifferentialCoordinateContribution> &contributors =
+        smearing_model->getListOfContributors(0);
+
+    for (auto const& contributor : contributors) {
+      half_width_x = std::max(half_width_x,
+          std::abs(contributor.coordinate_delta.first));
+      half_width_y = std::max(half_width_y,
+          std::abs(contributor.coordinate_delta.second));
+    }
+
+    std::vector<mydouble> kernel(
+        (2 * half_width_x + 1) * (2 * half_width_y + 1), 0.0);
+    for (auto const& contributor : contributors) {
+      kernel[(contributor.coordinate_delta.first + half_width_x)
+          * (2 * half_width_y + 1) + contributor.coordinate_delta.second
+          + half_width_y] += contributor.contribution_factor;
+    }
+    divergence_convolution.setKernel(half_width_x, half_width_y, kernel);
+  }
+  unsmeared_model_values.resize(
+      divergence_convolution.getInputBinsX()
+          * divergence_convolution.getInputBinsY());
+  convolution_kernel_valid = true;
+
+  std::string method_name("direct");
+  if (divergence_convolution.getUsedMethod() == GridConvolution2D::FFT)
+    method_name = "fft";
+  else if (divergence_convolution.getUsedMethod()
+      == GridConvolution2D::SEPARABLE)
+    method_name = "separable";
+  std::cout << "divergence smearing uses the " << method_name
+      << " convolution with a "
+      << (2 * half_width_x + 1) << " x " << (2 * half_width_y + 1)
+      << " kernel" << std::endl;
+}
+
+void PndLmdDifferentialSmearingConvolutionModel2D::setNumberOfThreads(
+    unsigned int number_of_threads) {
+  nthreads = std::max(1u, number_of_threads);
+  if (worker_pool->getNumberOfThreads() != nthreads)
+    worker_pool.reset(new WorkerPool(nthreads));
+  smearing_model->setNumberOfThreads(nthreads);
+}
+
 void PndLmdDifferentialSmearingConvolutionModel2D::generateModelGrid2D() {
   //std::cout << "generating divergence smeared grid..." << std::endl;
-  // create threads and let them evaluate a part of the data
-  boost::thread_group threads;
-
-  for (unsigned int i = 0; i < nthreads; i++) {
-    threads.create_thread(
-        boost::bind(
-            &PndLmdDifferentialSmearingConvolutionModel2D::generateModelGrid2D,
-            this, boost::cref(list_of_bin_ranges[i])));
+  // the unsmeared model is evaluated only once per bin of the extended grid
+  worker_pool->run(unsmeared_model_evaluation_task, nthreads);
+  divergence_convolution.convolve(unsmeared_model_values.data(),
+      fine_model_grid.data(), *worker_pool);
+  if (divergence_convolution.getUsedMethod() == GridConvolution2D::FFT) {
+    // the rounding errors of the fft can turn bins with a vanishing content
+    // slightly negative, which a smeared density cannot be
+    mydouble *values(fine_model_grid.data());
+    for (unsigned int i = 0; i < calc_data_dim_x.bins * calc_data_dim_y.bins;
+        ++i) {
+      if (values[i] < 0.0)
+        values[i] = 0.0;
+    }
   }
-
-  threads.join_all();
   //std::cout << "done!" << std::endl;
 
   if (combine_factor > 1) {
@@ -144,35 +175,16 @@ void PndLmdDifferentialSmearingConvolutionModel2D::generateModelGrid2D() {
         ix = ix + combine_factor) {
       for (unsigned int iy = 0; iy < calc_data_dim_y.bins;
           iy = iy + combine_factor) {
-        mydouble temp(fine_model_grid[ix][iy]);
-        temp += fine_model_grid[ix][iy + 1];
-        mydouble temp2(fine_model_grid[ix + 1][iy]);
-        temp2 += fine_model_grid[ix + 1][iy + 1];
-        model_grid[ix / combine_factor][iy / combine_factor] = (temp + temp2)
+        mydouble temp(fine_model_grid(ix, iy));
+        temp += fine_model_grid(ix, iy + 1);
+        mydouble temp2(fine_model_grid(ix + 1, iy));
+        temp2 += fine_model_grid(ix + 1, iy + 1);
+        model_grid(ix / combine_factor, iy / combine_factor) = (temp + temp2)
             / (combine_factor * combine_factor);
       }
     }
-    evaluation_grid = model_grid;
-  } else {
-    evaluation_grid = fine_model_grid;
   }
 
-  /*mydouble mean_relative_error(0.0);
-   unsigned int counter(0);
-   std::cout << "comparing with previous grid...\n";
-   for (unsigned int i = 0; i < data_dim_x.bins; ++i) {
-   for (unsigned int j = 0; j < data_dim_y.bins; ++j) {
-   if (model_grid[i][j] != 0.0) {
-   mean_relative_error += std::abs(
-   (model_grid[i][j] - previous_model_grid[i][j]) / model_grid[i][j]);
-   ++counter;
-   }
-   previous_model_grid[i][j] = model_grid[i][j];
-   }
-   }
-   std::cout << "mean relative error to previous variation:"
-   << mean_relative_error / counter << std::endl;*/
-
   /*const auto &asdf = getModelParameterSet().getFreeModelParameters();
    for (const auto blub : asdf) {
    std::cout << blub.first.first << " : " << blub.first.second << ":  "
@@ -186,113 +198,100 @@ void PndLmdDifferentialSmearingConvolutionModel2D::generateModelGrid2D() {
    }*/
 }
 
-void PndLmdDifferentialSmearingConvolutionModel2D::generateModelGrid2D(
-    const binrange &br) {
-  mydouble x[2];
-  //std::cout<<br.x_bin_low<<" "<<br.x_bin_high<<std::endl;
-  //std::cout<<br.y_bin_low<<" "<<br.y_bin_high<<std::endl;
-
-  for (unsigned int ix = br.x_bin_low; ix < br.x_bin_high; ix++) {
-    x[0] = calc_data_dim_x.dimension_range.getRangeLow()
-        + calc_data_dim_x.bin_size * (0.5 + ix);
-    for (unsigned int iy = br.y_bin_low; iy < br.y_bin_high; iy++) {
-      x[1] = calc_data_dim_y.dimension_range.getRangeLow()
-          + calc_data_dim_y.bin_size * (0.5 + iy);
-
-      //mydouble value(0.0);
-
-      const std::vector<DifferentialCoordinateContribution> &mc_element_contributors =
-          smearing_model->getListOfContributors(x);
-
-      std::vector<mydouble> numbers;
-      numbers.reserve(mc_element_contributors.size());
-
-
-      //std::cout<<"contributors: "<<mc_element_contributors.size()<<std::endl;
-      std::vector<DifferentialCoordinateContribution>::const_iterator mc_element_it;
-      for (mc_element_it = mc_element_contributors.begin();
-          mc_element_it != mc_element_contributors.end(); ++mc_element_it) {
-        mydouble xx[2];
-        xx[0] = x[0] - binsizes.first * mc_element_it->coordinate_delta.first;
-        xx[1] = x[1] - binsizes.second * mc_element_it->coordinate_delta.second;
-        //The negative sign in the above equations is crucial!!!
-        //So we calculate the final value of one single bin x[] from all its neighbouring bins!
-        //We turn around the definition so that we can use multi-threading!
-        mydouble integral_unsmeared_model = unsmeared_model->evaluate(xx);
-
-        //integral_unsmeared_model = integral_unsmeared_model * area_xy;
-        numbers.push_back(
-            integral_unsmeared_model * mc_element_it->contribution_factor);
-        //value = value + numbers.back();
-
-        /*if (value != value) {
-         std::cout << xx[0] << ", " << xx[1] << std::endl;
-         std::cout << integral_unsmeared_model << " " << mc_element_it->contribution_factor
-         << std::endl;
-         }*/
-
-        /*if (fabs(x[0] + 0.00615) < 0.0001 && fabs(x[1] + 0.00705) < 0.0001) {
-         std::cout << xx[0] << ", " << xx[1] << std::endl;
-         std::cout << integral_unsmeared_model << " " << mc_element_it->second
-         << std::endl;
-         }*/
-      }
-      while (numbers.size() > 2) {
-        std::vector<mydouble> temp_sum;
-        temp_sum.reserve(numbers.size() / 2 + 1);
-        if (numbers.size() % 2 == 0) {
-          for (unsigned int i = 0; i < numbers.size(); i = i + 2) {
-            temp_sum.push_back(numbers[i] + numbers[i + 1]);
-          }
-        } else {
-          for (unsigned int i = 0; i < numbers.size() - 1; i = i + 2) {
-            temp_sum.push_back(numbers[i] + numbers[i + 1]);
-          }
-          temp_sum.push_back(numbers.back());
-        }
-        numbers = temp_sum;
-      }
-      mydouble sum_value(numbers[0]);
-      if (numbers.size() == 2)
-        sum_value += numbers[1];
-
-      /*if(value != 0) {
-       if(std::fabs((value-sum_value)/sum_value) > 0.001)
-       std::cout<<std::setprecision(9) << "compare standard summation: "<<value<<" with pairwise summation: "<<sum_value<<std::endl;
-       }*/
-      /*if (fabs(x[0] + 0.00615) < 0.0001 && fabs(x[1] + 0.00705) < 0.0001) {
-       std::cout << x[0] << ", " << x[1] << " value: " << value << std::endl;
-       std::cout << "contribution size: " << mc_element_contributors.size()
-       << std::endl;
-       }*/
-
-      fine_model_grid[ix][iy] = sum_value;
-    }
+void PndLmdDifferentialSmearingConvolutionModel2D::evaluateUnsmearedModel(
+    unsigned int index) {
+  const unsigned int input_bins_x(divergence_convolution.getInputBinsX());
+  const unsigned int input_bins_y(divergence_convolution.getInputBinsY());
+  const int half_width_x(divergence_convolution.getKernelHalfWidthX());
+  const int half_width_y(divergence_convolution.getKernelHalfWidthY());
+
+  unsigned int rows_per_thread(input_bins_x / nthreads + 1);
+  unsigned int begin(index * rows_per_thread);
+  unsigned int end(std::min(begin + rows_per_thread, input_bins_x));
+
+  std::vector<mydouble> coordinates(2 * input_bins_y);
+  for (unsigned int iy = 0; iy < input_bins_y; ++iy) {
+    coordinates[2 * iy + 1] = calc_data_dim_y.dimension_range.getRangeLow()
+        + calc_data_dim_y.bin_size * (0.5 + (int) iy - half_width_y);
+  }
+  for (unsigned int ix = begin; ix < end; ++ix) {
+    mydouble x(
+        calc_data_dim_x.dimension_range.getRangeLow()
+            + calc_data_dim_x.bin_size * (0.5 + (int) ix - half_width_x));
+    for (unsigned int iy = 0; iy < input_bins_y; ++iy)
+      coordinates[2 * iy] = x;
+    unsmeared_model->evaluateBatch(coordinates.data(), input_bins_y,
+        &unsmeared_model_values[ix * input_bins_y]);
   }
 }
 
 mydouble PndLmdDifferentialSmearingConvolutionModel2D::eval(
     const mydouble *x) const {
-  int ix = (x[0] - data_dim_x.dimension_range.getRangeLow())
-      / data_dim_x.bin_size;
-  int iy = (x[1] - data_dim_y.dimension_range.getRangeLow())
-      / data_dim_y.bin_size;
-
-  /*std::cout << ix << " " << iy << " " << data_dim_x.bins << " "
-   << data_dim_y.bins << " " << x[0] << " "
-   << data_dim_x.dimension_range.getRangeLow() << " - "
-   << data_dim_x.dimension_range.getRangeHigh() << " " << x[1] << " "
-   << data_dim_y.dimension_range.getRangeLow() << " - "
-   << data_dim_y.dimension_range.getRangeHigh() << std::endl;*/
-
-  if (ix >= data_dim_x.bins || iy >= data_dim_y.bins || ix < 0 || iy < 0)
-    return 0.0;
-
-  return evaluation_grid[ix][iy];
+  return grid_scale_factor * evaluation_grid->evaluateConstant(x[0], x[1]);
+}
+
+void PndLmdDifferentialSmearingConvolutionModel2D::evalBatch(
+    const mydouble *xs, unsigned int n, mydouble *out) const {
+  evaluation_grid->evaluateConstant(xs, n, out);
+  const mydouble scale(grid_scale_factor);
+  for (unsigned int i = 0; i < n; ++i)
+    out[i] *= scale;
+}
+
+bool PndLmdDifferentialSmearingConvolutionModel2D::hasParameterDerivative(
+    const std::shared_ptr<ModelPar> &parameter) const {
+  return dependency_tracker.isScaleParameter(
+      unsmeared_model->getModelParameterSet(), parameter)
+      || Model2D::hasParameterDerivative(parameter);
+}
+
+void PndLmdDifferentialSmearingConvolutionModel2D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  Model2D::evalParameterDerivatives(x, parameters, derivatives);
+  ModelParSet &dependencies = unsmeared_model->getModelParameterSet();
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    if (dependency_tracker.isScaleParameter(dependencies, parameters[i]))
+      derivatives[i] = evaluation_grid->evaluateConstant(x[0], x[1])
+          * dependency_tracker.getScaleFactorDerivative();
+  }
 }
 
 void PndLmdDifferentialSmearingConvolutionModel2D::updateDomain() {
-  smearing_model->updateSmearingModel();
+  if (smearing_model->updateSmearingModel() || !convolution_kernel_valid) {
+    updateConvolutionKernel();
+    dependency_tracker.invalidate();
+  }
   unsmeared_model->updateDomain();
-  generateModelGrid2D();
+
+  ModelParSet &dependencies = unsmeared_model->getModelParameterSet();
+  switch (dependency_tracker.checkForUpdate(dependencies)) {
+    case ModelParameterDependencyTracker::FULL_UPDATE: {
+      LMDFIT_TRACE_SCOPE("grid", getName());
+      LMDFIT_TRACE_COUNTER(getName() + ": full grid updates", 1.0);
+      generateModelGrid2D();
+      dependency_tracker.markComputed(dependencies);
+      grid_scale_factor = 1.0;
+      break;
+    }
+    case ModelParameterDependencyTracker::RESCALE:
+      LMDFIT_TRACE_COUNTER(getName() + ": grid rescales", 1.0);
+      grid_scale_factor = dependency_tracker.getScaleFactor(dependencies);
+      break;
+    default:
+      break;
+  }
+}
+
+std::shared_ptr<Model>
+PndLmdDifferentialSmearingConvolutionModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  std::shared_ptr<PndLmdDifferentialSmearingConvolutionModel2D> copy(
+      new PndLmdDifferentialSmearingConvolutionModel2D(getName(),
+          cloner.clone(unsmeared_model), smearing_model->clone(cloner),
+          data_dim_x, data_dim_y, combine_factor));
+  copy->setLinearScaleParameter(dependency_tracker.getScaleParameterName());
+  copy->setConvolutionMethod(divergence_convolution.getMethod());
+  copy->setNumberOfThreads(nthreads);
+  return copy;
 }
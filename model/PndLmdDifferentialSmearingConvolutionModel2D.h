@@ -1,17 +1,23 @@
 #ifndef PNDLMDDIFFERENTIALSMEARINGCONVOLUTIONMODEL2D_H_
 #define PNDLMDDIFFERENTIALSMEARINGCONVOLUTIONMODEL2D_H_
 
+#include "core/Grid2D.h"
 #include "core/Model2D.h"
+#include "core/ModelParameterDependencyTracker.h"
+#include "core/WorkerPool.h"
+#include "operators2d/convolution/GridConvolution2D.h"
 #include "PndLmdDivergenceSmearingModel2D.h"
 
+/**
+ * Smears the unsmeared model with the beam divergence. The divergence map
+ * is translation invariant on the (fine) calculation grid, so the smearing
+ * is a discrete 2D convolution of the unsmeared model, evaluated once per
+ * bin on the calculation grid extended by the kernel half widths, with the
+ * divergence kernel. It is carried out by a #GridConvolution2D, which uses
+ * two 1D passes for separable divergence maps, and otherwise an fft for
+ * large kernels and the direct summation for small ones.
+ */
 class PndLmdDifferentialSmearingConvolutionModel2D: public Model2D {
-  struct binrange {
-    unsigned int x_bin_low;
-    unsigned int x_bin_high;
-    unsigned int y_bin_low;
-    unsigned int y_bin_high;
-  };
-
   std::shared_ptr<Model2D> unsmeared_model;
   std::shared_ptr<PndLmdDivergenceSmearingModel2D> smearing_model;
 
@@ -21,21 +27,41 @@ class PndLmdDifferentialSmearingConvolutionModel2D: public Model2D {
   LumiFit::LmdDimension calc_data_dim_x;
   LumiFit::LmdDimension calc_data_dim_y;
 
-  mydouble **model_grid;
-  mydouble **fine_model_grid;
-  mydouble **previous_model_grid;
-  mydouble **evaluation_grid;
+  // the smeared model on the calculation grid, which is the output of the
+  // convolution and therefore contiguous
+  Grid2D<mydouble> fine_model_grid;
+  // the fine grid merged to the data binning, only used if the calculation
+  // grid is finer than the data binning
+  Grid2D<mydouble> model_grid;
+  const Grid2D<mydouble> *evaluation_grid;
+
+  // the smeared grid is recomputed only if the unsmeared model or the
+  // divergence map has changed
+  ModelParameterDependencyTracker dependency_tracker;
+  mydouble grid_scale_factor;
 
   unsigned int nthreads;
-  std::vector<binrange> list_of_bin_ranges;
+  std::unique_ptr<WorkerPool> worker_pool;
   unsigned int combine_factor;
 
   std::pair<mydouble, mydouble> binsizes;
   double area_xy;
 
+  GridConvolution2D divergence_convolution;
+  bool convolution_kernel_valid;
+  // unsmeared model on the calculation grid extended by the kernel half
+  // widths, row major
+  std::vector<mydouble> unsmeared_model_values;
+  WorkerPool::Task unsmeared_model_evaluation_task;
+
+  void updateConvolutionKernel();
+
   void generateModelGrid2D();
 
-  void generateModelGrid2D(const binrange &br);
+  void evaluateUnsmearedModel(unsigned int index);
+
+protected:
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
 
 public:
   PndLmdDifferentialSmearingConvolutionModel2D(std::string name_,
@@ -50,8 +76,42 @@ public:
 
   void injectModelParameter(std::shared_ptr<ModelPar> model_param);
 
+  /**
+   * Declares the model parameter with name scale_parameter_name to be a pure
+   * scale factor of the unsmeared model (e.g. the luminosity). As the
+   * smearing is linear, changes of only this parameter then rescale the
+   * smeared grid instead of recomputing it.
+   */
+  void setLinearScaleParameter(const std::string &scale_parameter_name);
+
+  /**
+   * Sets the number of threads evaluating and smearing the grid and
+   * generating the divergence map. The default is the number of threads of
+   * the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads);
+
+  /**
+   * Selects the convolution method, see GridConvolution2D::setMethod(). The
+   * default is the automatic choice.
+   */
+  void setConvolutionMethod(GridConvolution2D::Method method);
+
   mydouble eval(const mydouble *x) const;
 
+  void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+  /**
+   * Only the derivative with respect to the linear scale parameter is known,
+   * as the smeared model is proportional to it. All others are numerical.
+   */
+  bool hasParameterDerivative(
+      const std::shared_ptr<ModelPar> &parameter) const;
+
+  void evalParameterDerivatives(const mydouble *x,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble *derivatives) const;
+
   void updateDomain();
 };
 
@@ -8,11 +8,14 @@
 #include "LumiFitStructs.h"
 #include "model/PndLmdDivergenceSmearingModel2D.h"
 #include "ui/PndLmdRuntimeConfiguration.h"
+#include "core/ModelCloner.h"
+#include "models2d/GaussianModel2D.h"
 #include "operators2d/integration/IntegralStrategyGSL2D.h"
 #include "operators2d/integration/SimpleIntegralStrategy2D.h"
 
 #include "boost/thread.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <thread>
 #include <future>
@@ -24,13 +27,29 @@ PndLmdDivergenceSmearingModel2D::PndLmdDivergenceSmearingModel2D(
     const LumiFit::LmdDimension& data_dim_x_,
     const LumiFit::LmdDimension& data_dim_y_) :
     divergence_model(divergence_model_), data_dim_x(data_dim_x_), data_dim_y(
-        data_dim_y_), integral_precision(1e-5) {
+        data_dim_y_), integral_precision(1e-5), nthreads(
+        PndLmdRuntimeConfiguration::Instance().getNumberOfThreads()), separable(
+        false) {
 
 }
 
 PndLmdDivergenceSmearingModel2D::~PndLmdDivergenceSmearingModel2D() {
 }
 
+std::shared_ptr<PndLmdDivergenceSmearingModel2D> PndLmdDivergenceSmearingModel2D::clone(
+    ModelCloner &cloner) const {
+  std::shared_ptr<PndLmdDivergenceSmearingModel2D> copy(
+      new PndLmdDivergenceSmearingModel2D(cloner.clone(divergence_model),
+          data_dim_x, data_dim_y));
+  copy->setNumberOfThreads(nthreads);
+  return copy;
+}
+
+void PndLmdDivergenceSmearingModel2D::setNumberOfThreads(
+    unsigned int number_of_threads) {
+  nthreads = std::max(1u, number_of_threads);
+}
+
 std::pair<mydouble, mydouble> PndLmdDivergenceSmearingModel2D::getBinsizes() const {
   return std::make_pair(data_dim_x.bin_size, data_dim_y.bin_size);
 }
@@ -40,11 +59,74 @@ const std::vector<DifferentialCoordinateContribution>& PndLmdDivergenceSmearingM
   return list_of_contributors;
 }
 
+bool PndLmdDivergenceSmearingModel2D::isSeparable() const {
+  return separable;
+}
+
+const std::vector<mydouble>& PndLmdDivergenceSmearingModel2D::getSeparableKernelX() const {
+  return separable_kernel_x;
+}
+
+const std::vector<mydouble>& PndLmdDivergenceSmearingModel2D::getSeparableKernelY() const {
+  return separable_kernel_y;
+}
+
+bool PndLmdDivergenceSmearingModel2D::generateSeparableDivergenceMap() {
+  std::shared_ptr<GaussianModel2D> gaussian_model = std::dynamic_pointer_cast<
+      GaussianModel2D>(divergence_model);
+  if (!gaussian_model || !gaussian_model->isSeparable())
+    return false;
+
+  std::cout << "generating separable divergence map..." << std::endl;
+
+  mydouble div_bin_size_x = data_dim_x.bin_size;
+  mydouble div_bin_size_y = data_dim_y.bin_size;
+
+  int div_bining_x = divergence_model->getVar1DomainRange() / div_bin_size_x
+      / 2.0;
+  int div_bining_y = divergence_model->getVar2DomainRange() / div_bin_size_y
+      / 2.0;
+
+  std::cout << "using " << (2 * div_bining_x + 1) << " x "
+      << (2 * div_bining_y + 1) << " binning!" << std::endl;
+
+  // the amplitude is put into the x kernel
+  separable_kernel_x.resize(2 * div_bining_x + 1);
+  for (int ibinx = -div_bining_x; ibinx <= div_bining_x; ++ibinx) {
+    separable_kernel_x[ibinx + div_bining_x] = gaussian_model->getAmplitude()
+        * gaussian_model->getMarginalIntegralVar1((ibinx - 0.5) * div_bin_size_x,
+            (ibinx + 0.5) * div_bin_size_x);
+  }
+  separable_kernel_y.resize(2 * div_bining_y + 1);
+  for (int ibiny = -div_bining_y; ibiny <= div_bining_y; ++ibiny) {
+    separable_kernel_y[ibiny + div_bining_y] =
+        gaussian_model->getMarginalIntegralVar2((ibiny - 0.5) * div_bin_size_y,
+            (ibiny + 0.5) * div_bin_size_y);
+  }
+
+  list_of_contributors.clear();
+  list_of_contributors.reserve(
+      separable_kernel_x.size() * separable_kernel_y.size());
+  for (int ibinx = -div_bining_x; ibinx <= div_bining_x; ++ibinx) {
+    for (int ibiny = -div_bining_y; ibiny <= div_bining_y; ++ibiny) {
+      DifferentialCoordinateContribution dcc(ibinx, ibiny, 0.0);
+      dcc.contribution_factor = separable_kernel_x[ibinx + div_bining_x]
+          * separable_kernel_y[ibiny + div_bining_y];
+      list_of_contributors.push_back(dcc);
+    }
+  }
+
+  std::cout << " number of divergence smearing contribution bins: "
+      << list_of_contributors.size() << std::endl;
+  return true;
+}
+
 void PndLmdDivergenceSmearingModel2D::generate2DDivergenceMap() {
-  std::cout << "generating divergence map..." << std::endl;
+  separable = generateSeparableDivergenceMap();
+  if (separable)
+    return;
 
-  unsigned int nthreads =
-      PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
+  std::cout << "generating divergence map..." << std::endl;
 
   mydouble div_bin_size_x = data_dim_x.bin_size;
   mydouble div_bin_size_y = data_dim_y.bin_size;
@@ -101,7 +183,9 @@ void PndLmdDivergenceSmearingModel2D::generate2DDivergenceMap() {
   //std::vector<std::vector<DifferentialCoordinateContribution> > list_of_contributors_per_thread;
   //list_of_contributors_per_thread.resize(nthreads);
 
-  optimizeNumericalIntegration(xy_pairs_lists);
+  // closed form bin integrals need no tuning of the numerical integration
+  if (!divergence_model->hasAnalyticIntegral())
+    optimizeNumericalIntegration(xy_pairs_lists);
 
   //boost::thread_group threads;
   std::vector<std::thread> thread_list;
@@ -143,9 +227,6 @@ void PndLmdDivergenceSmearingModel2D::generate2DDivergenceMap() {
 
 void PndLmdDivergenceSmearingModel2D::optimizeNumericalIntegration(
     const std::vector<std::vector<std::pair<int, int> > >& xy_pairs_lists) {
-  unsigned int nthreads =
-      PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
-
   /*std::shared_ptr<SimpleIntegralStrategy2D> integral_strategy(
       new SimpleIntegralStrategy2D());
   divergence_model->setIntegralStrategy(integral_strategy);
@@ -265,7 +346,14 @@ void PndLmdDivergenceSmearingModel2D::generate2DDivergenceMapPart(
   //std::cout << "done!" << std::endl;
 }
 
-void PndLmdDivergenceSmearingModel2D::updateSmearingModel() {
+bool PndLmdDivergenceSmearingModel2D::updateSmearingModel() {
+  ModelParSet &dependencies = divergence_model->getModelParameterSet();
+  if (dependency_tracker.checkForUpdate(dependencies)
+      == ModelParameterDependencyTracker::NO_UPDATE)
+    return false;
+
   divergence_model->updateDomain();
   generate2DDivergenceMap();
+  dependency_tracker.markComputed(dependencies);
+  return true;
 }
@@ -9,9 +9,12 @@
 #define PNDLMDDIVERGENCESMEARINGMODEL2D_H_
 
 #include <core/Model2D.h>
+#include <core/ModelParameterDependencyTracker.h>
 
 #include "LumiFitStructs.h"
 
+class ModelCloner;
+
 struct DifferentialCoordinateContribution {
   std::pair<int, int> coordinate_delta;
   mydouble contribution_factor;
@@ -33,14 +36,30 @@ class PndLmdDivergenceSmearingModel2D {
   std::shared_ptr<Model2D> divergence_model;
 
   double integral_precision;
+  unsigned int nthreads;
 
   LumiFit::LmdDimension data_dim_x;
   LumiFit::LmdDimension data_dim_y;
 
   std::vector<DifferentialCoordinateContribution> list_of_contributors;
 
+  // 1D kernels, if the divergence model factorizes in x and y
+  bool separable;
+  std::vector<mydouble> separable_kernel_x;
+  std::vector<mydouble> separable_kernel_y;
+
+  // the divergence map only depends on the divergence model parameters
+  ModelParameterDependencyTracker dependency_tracker;
+
   void generate2DDivergenceMap();
 
+  /**
+   * Generates the divergence map of a separable gaussian divergence model
+   * from closed form bin integrals of its marginal distributions.
+   * @returns false if the divergence model is not a separable gaussian
+   */
+  bool generateSeparableDivergenceMap();
+
   void optimizeNumericalIntegration(
       const std::vector<std::vector<std::pair<int, int> > >& xy_pairs_lists);
 
@@ -61,12 +80,40 @@ public:
       const LumiFit::LmdDimension& data_dim_y_);
   virtual ~PndLmdDivergenceSmearingModel2D();
 
+  /**
+   * Creates a divergence smearing model for the clone of the divergence
+   * model (see #ModelCloner). The divergence map of the copy is generated on
+   * its first update.
+   */
+  std::shared_ptr<PndLmdDivergenceSmearingModel2D> clone(
+      ModelCloner &cloner) const;
+
+  /**
+   * Sets the number of threads generating the divergence map. The default
+   * is the number of threads of the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads);
+
   std::pair<mydouble, mydouble> getBinsizes() const;
 
   const std::vector<DifferentialCoordinateContribution>& getListOfContributors(
       const mydouble *x) const;
 
-  void updateSmearingModel();
+  /**
+   * @returns true if the current divergence map factorizes into the kernels
+   * #getSeparableKernelX() and #getSeparableKernelY(), which are indexed by
+   * the coordinate delta plus the half width (size / 2)
+   */
+  bool isSeparable() const;
+  const std::vector<mydouble>& getSeparableKernelX() const;
+  const std::vector<mydouble>& getSeparableKernelY() const;
+
+  /**
+   * Regenerates the divergence map if a parameter of the divergence model
+   * has changed since the last generation.
+   * @returns true if the divergence map was regenerated
+   */
+  bool updateSmearingModel();
 };
 
 #endif /* PNDLMDDIVERGENCESMEARINGMODEL2D_H_ */
@@ -127,3 +127,9 @@ void PndLmdE760LikeModelParametrization::parametrize() {
 	adjustStrictParameters();
 	adjustNonStrictParameters();
 }
+
+std::shared_ptr<Parametrization> PndLmdE760LikeModelParametrization::clone(
+		ModelParSet &model_par_set_) const {
+	return std::shared_ptr<Parametrization>(
+			new PndLmdE760LikeModelParametrization(model_par_set_));
+}
@@ -39,6 +39,8 @@ public:
 	void adjustNonStrictParameters();
 
 	void parametrize();
+
+	std::shared_ptr<Parametrization> clone(ModelParSet &model_par_set_) const;
 };
 
 #endif /* PNDLMDE760MODELPARAMETRIZATION_H_ */
@@ -133,3 +133,9 @@ void PndLmdE760ModelParametrization::parametrize() {
 	adjustStrictParameters();
 	adjustNonStrictParameters();
 }
+
+std::shared_ptr<Parametrization> PndLmdE760ModelParametrization::clone(
+		ModelParSet &model_par_set_) const {
+	return std::shared_ptr<Parametrization>(
+			new PndLmdE760ModelParametrization(model_par_set_));
+}
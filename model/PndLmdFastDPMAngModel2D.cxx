@@ -1,5 +1,8 @@
 #include "PndLmdFastDPMAngModel2D.h"
+#include "core/ModelCloner.h"
+#include "core/FitTracer.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "TMath.h"
@@ -7,8 +10,12 @@
 
 PndLmdFastDPMAngModel2D::PndLmdFastDPMAngModel2D(std::string name_,
     std::shared_ptr<PndLmdDPMAngModel1D> dpm_model_1d_) :
-    Model2D(name_), dpm_model_1d(dpm_model_1d_) {
+    Model2D(name_), dpm_model_1d(dpm_model_1d_), radial_table_active(false), radial_table_max_radius(
+        0.0), radial_table_node_spacing(0.0), inverse_radial_table_node_spacing(
+        0.0), radial_table_scale_factor(1.0) {
   one_over_two_pi = 0.5 / TMath::Pi();
+  // the dpm model is proportional to the luminosity
+  radial_table_dependency_tracker.setScaleParameterName("luminosity");
   initModelParameters();
   this->addModelToList(dpm_model_1d);
 
@@ -26,6 +33,49 @@ void PndLmdFastDPMAngModel2D::initModelParameters() {
   tilt_y->setValue(0.0);
 }
 
+void PndLmdFastDPMAngModel2D::useRadialLookupTable(mydouble max_radius,
+    mydouble node_spacing) {
+  radial_table_active = true;
+  radial_table_max_radius = max_radius;
+  radial_table_node_spacing = node_spacing;
+  inverse_radial_table_node_spacing = 1.0 / node_spacing;
+  radial_table_dependency_tracker.invalidate();
+}
+
+void PndLmdFastDPMAngModel2D::generateRadialTable() {
+  // one node beyond the maximum radius, so that every radius below it has
+  // an upper neighbor
+  unsigned int nodes = std::max(4u,
+      (unsigned int) std::ceil(
+          radial_table_max_radius * inverse_radial_table_node_spacing) + 2);
+  radial_table.resize(nodes);
+
+  std::vector<mydouble> radii(nodes - 1);
+  for (unsigned int i = 1; i < nodes; ++i)
+    radii[i - 1] = radial_table_node_spacing * i;
+  dpm_model_1d->evalBatch(radii.data(), nodes - 1, &radial_table[1]);
+  // r^4 * jacobian (1/r) * dpm(r) / 2pi
+  for (unsigned int i = 1; i < nodes; ++i) {
+    mydouble radius(radii[i - 1]);
+    radial_table[i] *= radius * radius * radius * one_over_two_pi;
+  }
+  // the dpm model diverges at the origin, so the first node is extrapolated
+  radial_table[0] = 3.0 * (radial_table[1] - radial_table[2])
+      + radial_table[3];
+}
+
+mydouble PndLmdFastDPMAngModel2D::interpolateRadialTable(
+    const mydouble radius) const {
+  mydouble position(radius * inverse_radial_table_node_spacing);
+  unsigned int index(position);
+  mydouble fraction(position - index);
+  mydouble radius_squared(radius * radius);
+  return radial_table_scale_factor
+      * (radial_table[index]
+          + fraction * (radial_table[index + 1] - radial_table[index]))
+      / (radius_squared * radius_squared);
+}
+
 mydouble PndLmdFastDPMAngModel2D::calculateThetaFromTiltedSystem(
     const mydouble thetax, const mydouble thetay) const {
 
@@ -80,8 +130,11 @@ mydouble PndLmdFastDPMAngModel2D::calculateJacobianDeterminant(
 }
 
 mydouble PndLmdFastDPMAngModel2D::eval(const mydouble *x) const {
-  mydouble jaco = calculateJacobianDeterminant(x[0], x[1]);
   mydouble theta_tilted = calculateThetaFromTiltedSystem(x[0], x[1]);
+  if (radial_table_active && theta_tilted < radial_table_max_radius)
+    return interpolateRadialTable(theta_tilted);
+
+  mydouble jaco = calculateJacobianDeterminant(x[0], x[1]);
 
   /*std::cout << "measured thetax, thetay: " << x[0] << "," << x[1]
    << " -> transforms to evaluated theta of: " << theta_tilted
@@ -93,5 +146,72 @@ mydouble PndLmdFastDPMAngModel2D::eval(const mydouble *x) const {
   return jaco * dpm_model_1d->eval(&theta_tilted) * one_over_two_pi;
 }
 
+void PndLmdFastDPMAngModel2D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  const mydouble tilt[2] = { tilt_x->getValue(), tilt_y->getValue() };
+  if (radial_table_active) {
+    for (unsigned int i = 0; i < n; ++i) {
+      mydouble diff_theta_x(xs[2 * i] - tilt[0]);
+      mydouble diff_theta_y(xs[2 * i + 1] - tilt[1]);
+      mydouble theta_tilted(
+          std::sqrt(diff_theta_x * diff_theta_x + diff_theta_y * diff_theta_y));
+      if (theta_tilted < radial_table_max_radius)
+        out[i] = interpolateRadialTable(theta_tilted);
+      else
+        out[i] = dpm_model_1d->eval(&theta_tilted) * one_over_two_pi
+            / theta_tilted;
+    }
+    return;
+  }
+
+  const unsigned int chunk_size(128);
+  mydouble theta_tilted[chunk_size];
+  for (unsigned int offset = 0; offset < n; offset += chunk_size) {
+    unsigned int chunk = std::min(chunk_size, n - offset);
+    for (unsigned int i = 0; i < chunk; ++i) {
+      mydouble diff_theta_x(xs[2 * (offset + i)] - tilt[0]);
+      mydouble diff_theta_y(xs[2 * (offset + i) + 1] - tilt[1]);
+      theta_tilted[i] = std::sqrt(
+          diff_theta_x * diff_theta_x + diff_theta_y * diff_theta_y);
+    }
+    dpm_model_1d->evalBatch(theta_tilted, chunk, &out[offset]);
+    // the jacobian determinant is 1/theta_tilted
+    for (unsigned int i = 0; i < chunk; ++i)
+      out[offset + i] *= one_over_two_pi / theta_tilted[i];
+  }
+}
+
 void PndLmdFastDPMAngModel2D::updateDomain() {
+  if (!radial_table_active)
+    return;
+
+  ModelParSet &dependencies = dpm_model_1d->getModelParameterSet();
+  switch (radial_table_dependency_tracker.checkForUpdate(dependencies)) {
+    case ModelParameterDependencyTracker::FULL_UPDATE: {
+      LMDFIT_TRACE_SCOPE("grid", getName() + ": radial table");
+      LMDFIT_TRACE_COUNTER(getName() + ": radial table updates", 1.0);
+      generateRadialTable();
+      radial_table_dependency_tracker.markComputed(dependencies);
+      radial_table_scale_factor = 1.0;
+      break;
+    }
+    case ModelParameterDependencyTracker::RESCALE:
+      radial_table_scale_factor = radial_table_dependency_tracker.getScaleFactor(
+          dependencies);
+      break;
+    default:
+      break;
+  }
+}
+
+std::shared_ptr<Model> PndLmdFastDPMAngModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  std::shared_ptr<PndLmdFastDPMAngModel2D> copy(
+      new PndLmdFastDPMAngModel2D(getName(),
+          cloner.clone(
+              std::dynamic_pointer_cast<PndLmdDPMAngModel1D>(dpm_model_1d))));
+  if (radial_table_active)
+    copy->useRadialLookupTable(radial_table_max_radius,
+        radial_table_node_spacing);
+  return copy;
 }
@@ -2,8 +2,18 @@
 #define PNDLMDFASTDPMANGMODEL2D_H_
 
 #include "core/Model2D.h"
+#include "core/ModelParameterDependencyTracker.h"
 #include "PndLmdDPMAngModel1D.h"
 
+#include <vector>
+
+/**
+ * Small angle approximation of the 2D dpm angular distribution in theta_x
+ * and theta_y. The value only depends on the radius of the tilted point
+ * sqrt((theta_x - tilt_x)^2 + (theta_y - tilt_y)^2), so the model can
+ * optionally interpolate from a radial lookup table (see
+ * #useRadialLookupTable()) instead of evaluating the dpm model.
+ */
 class PndLmdFastDPMAngModel2D: public Model2D {
   mydouble one_over_two_pi;
 
@@ -12,12 +22,30 @@ class PndLmdFastDPMAngModel2D: public Model2D {
 	std::shared_ptr<ModelPar> tilt_x;
 	std::shared_ptr<ModelPar> tilt_y;
 
+	bool radial_table_active;
+	mydouble radial_table_max_radius;
+	mydouble radial_table_node_spacing;
+	mydouble inverse_radial_table_node_spacing;
+	// r^4 times the 2d model value at radius r for equidistant radii, which
+	// is smooth also at small radii where the coulomb part dominates
+	std::vector<mydouble> radial_table;
+	// the table only depends on the parameters of the dpm model, a change of
+	// the tilts does not require a new table
+	ModelParameterDependencyTracker radial_table_dependency_tracker;
+	mydouble radial_table_scale_factor;
+
+	void generateRadialTable();
+	mydouble interpolateRadialTable(const mydouble radius) const;
+
 	mydouble calculateThetaFromTiltedSystem(const mydouble theta,
 			const mydouble phi) const;
 
 	mydouble calculateJacobianDeterminant(const mydouble theta,
 			const mydouble phi) const;
 
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
 	PndLmdFastDPMAngModel2D(std::string name_,
 			std::shared_ptr<PndLmdDPMAngModel1D> dpm_model_1d_);
@@ -25,8 +53,20 @@ public:
 
 	virtual void initModelParameters();
 
+	/**
+	 * Switches to the evaluation from a radial lookup table, which is linearly
+	 * interpolated. The table is regenerated only if a parameter of the dpm
+	 * model changes and just rescaled if only the luminosity changes. Points
+	 * with a radius beyond max_radius are still evaluated directly.
+	 * @param max_radius is the largest radius covered by the table
+	 * @param node_spacing is the distance of the table nodes
+	 */
+	void useRadialLookupTable(mydouble max_radius, mydouble node_spacing);
+
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
 	virtual void updateDomain();
 };
 
@@ -39,6 +39,8 @@
 #include "ui/PndLmdDataFacade.h"
 #include "data/PndLmdAngularData.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "boost/property_tree/ptree.hpp"
@@ -47,7 +49,9 @@
 #include "TH2.h"
 #include "TCanvas.h"
 
-PndLmdModelFactory::PndLmdModelFactory() {
+PndLmdModelFactory::PndLmdModelFactory() :
+    number_of_threads(
+        PndLmdRuntimeConfiguration::Instance().getNumberOfThreads()) {
 
 }
 
@@ -167,6 +171,7 @@ std::shared_ptr<PndLmdSmearingModel2D> PndLmdModelFactory::generate2DSmearingMod
 
   std::shared_ptr<PndLmdSmearingModel2D> detector_smearing_model(
       new PndLmdSmearingModel2D(dimx, dimy));
+  detector_smearing_model->setNumberOfThreads(number_of_threads);
 
   detector_smearing_model->setSmearingParameterization(smearing_param);
   //detector_smearing_model->setSearchDistances(
@@ -425,6 +430,7 @@ std::shared_ptr<PndLmdSmearingModel2D> PndLmdModelFactory::generate2DSmearingMod
 
   std::shared_ptr<PndLmdSmearingModel2D> detector_smearing_model(
       new PndLmdSmearingModel2D(dimx, dimy));
+  detector_smearing_model->setNumberOfThreads(number_of_threads);
 
   detector_smearing_model->setSmearingParameterization(smearing_param);
   return detector_smearing_model;
@@ -526,9 +532,127 @@ std::shared_ptr<Model1D> PndLmdModelFactory::generate1DModel(
   return current_model;
 }
 
-std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
+std::shared_ptr<DataModel2D> PndLmdModelFactory::generate2DAcceptanceModel(
     const boost::property_tree::ptree& model_opt_ptree,
     const PndLmdAngularData& data) const {
+  const LumiFit::LmdDimension& data_primary_dimension =
+      data.getPrimaryDimension();
+  const LumiFit::LmdDimension& data_secondary_dimension =
+      data.getSecondaryDimension();
+
+  std::shared_ptr<DataModel2D> acc(
+      new DataModel2D("acceptance_2d",
+          LumiFit::StringToInterpolationType.at(
+              model_opt_ptree.get<std::string>(
+                  "acceptance_interpolation"))));
+
+  TVirtualPad* curpad = gPad;
+  TCanvas c;
+  TEfficiency* eff2 = acceptance.getAcceptance2D();
+  eff2->Draw("colz");
+  c.Update();
+  TH2 *hist = acceptance.getAcceptance2D()->GetPaintedHistogram();
+
+  double angular_offsets[2];
+  angular_offsets[0] = 0.0;
+  angular_offsets[1] = 0.0;
+
+  if (model_opt_ptree.get<bool>("automatic_acceptance_shifting_active")) {
+    // get offset values as measured by the offset determination (user should have specified that)
+    std::pair<double, double> ip_offsets = data.getIPOffsets();
+    // then read transformation json file
+    auto pt =
+        PndLmdRuntimeConfiguration::Instance().getAcceptanceOffsetsTranformationParameters();
+
+    double trans_params[6];
+    trans_params[0] = pt.get_child("matrix").get<double>("m11");
+    trans_params[1] = pt.get_child("matrix").get<double>("m12");
+    trans_params[2] = pt.get_child("matrix").get<double>("m21");
+    trans_params[3] = pt.get_child("matrix").get<double>("m22");
+    trans_params[4] = pt.get_child("before_translation").get<double>("t1");
+    trans_params[5] = pt.get_child("before_translation").get<double>("t2");
+
+    // and do the transformation from offset coordinates to the angular shift coordinates
+
+    ip_offsets.first += trans_params[4];
+    ip_offsets.second += trans_params[5];
+    angular_offsets[0] = trans_params[0] * ip_offsets.first
+        + trans_params[1] * ip_offsets.second;
+    angular_offsets[1] = trans_params[2] * ip_offsets.first
+        + trans_params[3] * ip_offsets.second;
+    angular_offsets[0] /= 1000.0; // convert to mrad
+    angular_offsets[1] /= 1000.0;
+  }
+
+  // then use these coordinates to create a corrected acceptance
+  std::pair<mydouble, mydouble> pos;
+  std::pair<mydouble, mydouble> eval_pos;
+  std::map<std::pair<mydouble, mydouble>, mydouble> datamap;
+  for (unsigned int ix = 0; ix < data_primary_dimension.bins; ix++) {
+    for (unsigned int iy = 0; iy < data_secondary_dimension.bins; iy++) {
+      pos.first = data_primary_dimension.dimension_range.getRangeLow()
+          + (0.5 + ix) * data_primary_dimension.bin_size;
+      pos.second = data_secondary_dimension.dimension_range.getRangeLow()
+          + (0.5 + iy) * data_secondary_dimension.bin_size;
+
+      eval_pos.first = pos.first - angular_offsets[0];
+      eval_pos.second = pos.second - angular_offsets[1];
+
+      /*int bin = eff2->FindFixBin(pos.first, pos.second);
+       double eff_value = eff2->GetEfficiency(bin)
+       + 0.5
+       * (eff2->GetEfficiencyErrorUp(bin)
+       - eff2->GetEfficiencyErrorLow(bin))
+       / std::sqrt(2 * M_PI);
+
+       datamap[pos] = eff_value;*/
+      //int bin = hist->FindFixBin(pos.first, pos.second);
+      //datamap[pos] = hist->GetBinContent(bin);
+      if (eval_pos.first
+          < data_primary_dimension.dimension_range.getRangeLow()
+          || eval_pos.first
+              > data_primary_dimension.dimension_range.getRangeHigh()
+          || eval_pos.second
+              < data_secondary_dimension.dimension_range.getRangeLow()
+          || eval_pos.first
+              > data_secondary_dimension.dimension_range.getRangeHigh()) {
+        datamap[pos] = 0.0;
+      } else {
+        datamap[pos] = hist->Interpolate(eval_pos.first, eval_pos.second);
+      }
+      /*std::cout << data_primary_dimension.dimension_range.getRangeLow()
+       << " " << ix << " " << data_primary_dimension.bin_size
+       << std::endl;
+       std::cout << eval_pos.first << ", " << eval_pos.second << ": "
+       << hist->Interpolate(pos.first, pos.second) << std::endl;*/
+    }
+  }
+ 
+  boost::optional<double> forced_lower_acc_bound = model_opt_ptree.get_optional<double>("override_lower_acceptance_bound");
+  if(forced_lower_acc_bound) {
+    double lowboundsquared(std::pow(forced_lower_acc_bound.get(), 2));
+    std::vector<std::pair<mydouble, mydouble> > keystoremove;
+    for(auto const& x : datamap) {
+      if((std::pow(x.first.first, 2) + std::pow(x.first.second, 2)) < lowboundsquared) {
+        keystoremove.push_back(x.first);
+      }
+    }
+    std::cout<<"WARNING: erasing "<<keystoremove.size()<<" acceptance entries, which are below the forced bound of "
+             <<forced_lower_acc_bound.get()<<std::endl;
+    for(auto k : keystoremove)
+      datamap.erase(k);
+  }
+
+  gPad = curpad;
+
+  acc->setData(datamap);
+
+  return acc;
+}
+
+std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
+    const boost::property_tree::ptree& model_opt_ptree,
+    const PndLmdAngularData& data, ModelComponents& components) const {
   std::shared_ptr<Model2D> current_model;
 
   std::stringstream model_name;
@@ -573,11 +697,32 @@ std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
     std::shared_ptr<PndLmdFastDPMAngModel2D> dpm_model_2d(
         new PndLmdFastDPMAngModel2D(model_name.str(), dpm_angular_1d));
 
+    if (model_opt_ptree.get<bool>("dpm_radial_lookup_table_active", true)) {
+      // the table covers the corners of the binning plus a few mrad for the
+      // beam tilts and resolves the evaluation grid of the bin integrals
+      double max_abs_x(
+          std::max(std::fabs(temp_prim_dim.dimension_range.getRangeLow()),
+              std::fabs(temp_prim_dim.dimension_range.getRangeHigh())));
+      double max_abs_y(
+          std::max(std::fabs(temp_sec_dim.dimension_range.getRangeLow()),
+              std::fabs(temp_sec_dim.dimension_range.getRangeHigh())));
+      double max_radius(
+          std::sqrt(max_abs_x * max_abs_x + max_abs_y * max_abs_y) + 0.005);
+      double node_spacing(
+          0.01 * std::min(temp_prim_dim.bin_size, temp_sec_dim.bin_size));
+      dpm_model_2d->useRadialLookupTable(max_radius, node_spacing);
+    }
+
     model_name << "_cached";
 
-    current_model.reset(
+    std::shared_ptr<CachedModel2D> cached_model(
         new CachedModel2D(model_name.str(), dpm_model_2d, temp_prim_dim,
             temp_sec_dim));
+    cached_model->setNumberOfThreads(number_of_threads);
+    // the dpm model is proportional to the luminosity, so a change of only
+    // the luminosity just rescales the cached grids
+    cached_model->setLinearScaleParameter("luminosity");
+    current_model = cached_model;
 
     if (model_opt_ptree.get<bool>("divergence_smearing_active")
         && data_primary_dimension.is_active
@@ -601,6 +746,8 @@ std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
           new PndLmdDifferentialSmearingConvolutionModel2D(model_name.str(),
               current_model, divergence_smearing_model, data_primary_dimension,
               data_secondary_dimension, combine));
+      div_smeared_model->setNumberOfThreads(number_of_threads);
+      div_smeared_model->setLinearScaleParameter("luminosity");
       div_smeared_model->injectModelParameter(
           divergence_model->getModelParameterSet().getModelParameter(
               "gauss_sigma_var1"));
@@ -626,117 +773,18 @@ std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
 
   if (model_opt_ptree.get<bool>("acceptance_correction_active")) { // with acceptance corr
     if (acceptance.getAcceptance2D()) {
-      std::shared_ptr<DataModel2D> acc(
-          new DataModel2D("acceptance_2d",
-              LumiFit::StringToInterpolationType.at(
-                  model_opt_ptree.get<std::string>(
-                      "acceptance_interpolation"))));
-
-      TVirtualPad* curpad = gPad;
-      TCanvas c;
-      TEfficiency* eff2 = acceptance.getAcceptance2D();
-      eff2->Draw("colz");
-      c.Update();
-      TH2 *hist = acceptance.getAcceptance2D()->GetPaintedHistogram();
-
-      double angular_offsets[2];
-      angular_offsets[0] = 0.0;
-      angular_offsets[1] = 0.0;
-
-      if (model_opt_ptree.get<bool>("automatic_acceptance_shifting_active")) {
-        // get offset values as measured by the offset determination (user should have specified that)
-        std::pair<double, double> ip_offsets = data.getIPOffsets();
-        // then read transformation json file
-        auto pt =
-            PndLmdRuntimeConfiguration::Instance().getAcceptanceOffsetsTranformationParameters();
-
-        double trans_params[6];
-        trans_params[0] = pt.get_child("matrix").get<double>("m11");
-        trans_params[1] = pt.get_child("matrix").get<double>("m12");
-        trans_params[2] = pt.get_child("matrix").get<double>("m21");
-        trans_params[3] = pt.get_child("matrix").get<double>("m22");
-        trans_params[4] = pt.get_child("before_translation").get<double>("t1");
-        trans_params[5] = pt.get_child("before_translation").get<double>("t2");
-
-        // and do the transformation from offset coordinates to the angular shift coordinates
-
-        ip_offsets.first += trans_params[4];
-        ip_offsets.second += trans_params[5];
-        angular_offsets[0] = trans_params[0] * ip_offsets.first
-            + trans_params[1] * ip_offsets.second;
-        angular_offsets[1] = trans_params[2] * ip_offsets.first
-            + trans_params[3] * ip_offsets.second;
-        angular_offsets[0] /= 1000.0; // convert to mrad
-        angular_offsets[1] /= 1000.0;
+      if (!components.acceptance_2d) {
+        components.acceptance_2d = generate2DAcceptanceModel(model_opt_ptree,
+            data);
+      } else {
+        std::cout << "reusing the acceptance model..." << std::endl;
       }
 
-      // then use these coordinates to create a corrected acceptance
-      std::pair<mydouble, mydouble> pos;
-      std::pair<mydouble, mydouble> eval_pos;
-      std::map<std::pair<mydouble, mydouble>, mydouble> datamap;
-      for (unsigned int ix = 0; ix < data_primary_dimension.bins; ix++) {
-        for (unsigned int iy = 0; iy < data_secondary_dimension.bins; iy++) {
-          pos.first = data_primary_dimension.dimension_range.getRangeLow()
-              + (0.5 + ix) * data_primary_dimension.bin_size;
-          pos.second = data_secondary_dimension.dimension_range.getRangeLow()
-              + (0.5 + iy) * data_secondary_dimension.bin_size;
-
-          eval_pos.first = pos.first - angular_offsets[0];
-          eval_pos.second = pos.second - angular_offsets[1];
-
-          /*int bin = eff2->FindFixBin(pos.first, pos.second);
-           double eff_value = eff2->GetEfficiency(bin)
-           + 0.5
-           * (eff2->GetEfficiencyErrorUp(bin)
-           - eff2->GetEfficiencyErrorLow(bin))
-           / std::sqrt(2 * M_PI);
-
-           datamap[pos] = eff_value;*/
-          //int bin = hist->FindFixBin(pos.first, pos.second);
-          //datamap[pos] = hist->GetBinContent(bin);
-          if (eval_pos.first
-              < data_primary_dimension.dimension_range.getRangeLow()
-              || eval_pos.first
-                  > data_primary_dimension.dimension_range.getRangeHigh()
-              || eval_pos.second
-                  < data_secondary_dimension.dimension_range.getRangeLow()
-              || eval_pos.first
-                  > data_secondary_dimension.dimension_range.getRangeHigh()) {
-            datamap[pos] = 0.0;
-          } else {
-            datamap[pos] = hist->Interpolate(eval_pos.first, eval_pos.second);
-          }
-          /*std::cout << data_primary_dimension.dimension_range.getRangeLow()
-           << " " << ix << " " << data_primary_dimension.bin_size
-           << std::endl;
-           std::cout << eval_pos.first << ", " << eval_pos.second << ": "
-           << hist->Interpolate(pos.first, pos.second) << std::endl;*/
-        }
-      }
-     
-      boost::optional<double> forced_lower_acc_bound = model_opt_ptree.get_optional<double>("override_lower_acceptance_bound");
-      if(forced_lower_acc_bound) {
-        double lowboundsquared(std::pow(forced_lower_acc_bound.get(), 2));
-        std::vector<std::pair<mydouble, mydouble> > keystoremove;
-        for(auto const& x : datamap) {
-          if((std::pow(x.first.first, 2) + std::pow(x.first.second, 2)) < lowboundsquared) {
-            keystoremove.push_back(x.first);
-          }
-        }
-        std::cout<<"WARNING: erasing "<<keystoremove.size()<<" acceptance entries, which are below the forced bound of "
-                 <<forced_lower_acc_bound.get()<<std::endl;
-        for(auto k : keystoremove)
-          datamap.erase(k);
-      }
-
-      gPad = curpad;
-
-      acc->setData(datamap);
-
       model_name << "_acceptance_corrected";
 
       current_model.reset(
-          new ProductModel2D(model_name.str(), current_model, acc));
+          new ProductModel2D(model_name.str(), current_model,
+              components.acceptance_2d));
 
       current_model->getModelParameterSet().getModelParameter("offset_x")->setValue(
           0.0);
@@ -767,11 +815,20 @@ std::shared_ptr<Model2D> PndLmdModelFactory::generate2DModel(
 
     model_name << "_res_smeared";
 
-    current_model.reset(
+    if (!components.resolution_smearing_2d) {
+      components.resolution_smearing_2d = generate2DSmearingModel(
+          data.getPrimaryDimension(), data.getSecondaryDimension());
+    } else {
+      std::cout << "reusing the resolution smearing model..." << std::endl;
+    }
+
+    std::shared_ptr<PndLmdSmearingConvolutionModel2D> res_smeared_model(
         new PndLmdSmearingConvolutionModel2D(model_name.str(), current_model,
-            generate2DSmearingModel(data.getPrimaryDimension(),
-                data.getSecondaryDimension()), data.getPrimaryDimension(),
+            components.resolution_smearing_2d, data.getPrimaryDimension(),
             data.getSecondaryDimension()));
+    res_smeared_model->setNumberOfThreads(number_of_threads);
+    res_smeared_model->setLinearScaleParameter("luminosity");
+    current_model = res_smeared_model;
   }
 
   // every model has superior parameters which have to be set by the user
@@ -809,6 +866,10 @@ void PndLmdModelFactory::setResolutions(
   resolutions = resolutions_;
 }
 
+void PndLmdModelFactory::setNumberOfThreads(unsigned int number_of_threads_) {
+  number_of_threads = number_of_threads_;
+}
+
 std::shared_ptr<Model1D> PndLmdModelFactory::generate1DVertexModel(
     const boost::property_tree::ptree& model_opt_ptree) const {
   std::shared_ptr<Model1D> vertex_model;
@@ -833,6 +894,13 @@ std::shared_ptr<Model1D> PndLmdModelFactory::generate1DVertexModel(
 std::shared_ptr<Model> PndLmdModelFactory::generateModel(
     const boost::property_tree::ptree& model_opt_ptree,
     const PndLmdAngularData& data) const {
+  ModelComponents components;
+  return generateModel(model_opt_ptree, data, components);
+}
+
+std::shared_ptr<Model> PndLmdModelFactory::generateModel(
+    const boost::property_tree::ptree& model_opt_ptree,
+    const PndLmdAngularData& data, ModelComponents& components) const {
   std::shared_ptr<Model> current_model;
 
   std::cout << "Generating model ... " << std::endl;
@@ -842,7 +910,7 @@ std::shared_ptr<Model> PndLmdModelFactory::generateModel(
   if (fit_dimension == 1) {
     current_model = generate1DModel(model_opt_ptree, data);
   } else if (fit_dimension == 2) {
-    current_model = generate2DModel(model_opt_ptree, data);
+    current_model = generate2DModel(model_opt_ptree, data, components);
   } else {
     std::cout << "WARNING: Requesting a model of dimension " << fit_dimension
         << " which is NOT available! Returning NULL pointer." << std::endl;
@@ -13,16 +13,33 @@
 #include "boost/property_tree/ptree_fwd.hpp"
 
 class PndLmdAngularData;
+class DataModel2D;
 
 /**
  * Class for creating Models. User is supposed to only use this factory to create
  * his models.
  */
 class PndLmdModelFactory {
+public:
+  /**
+   * Components of a model, which depend only on the data and the acceptance
+   * and resolution of the factory, but not on the other model options. The
+   * generateModel() calls which share an instance build each component only
+   * once and reuse it afterwards, e.g. the stages of a staged fit. So an
+   * instance must be used only with one data object and one set of
+   * acceptance and resolution options. Only 2D models use components.
+   */
+  struct ModelComponents {
+    std::shared_ptr<DataModel2D> acceptance_2d;
+    std::shared_ptr<PndLmdSmearingModel2D> resolution_smearing_2d;
+  };
+
 private:
   PndLmdAcceptance acceptance;
   std::vector<PndLmdHistogramData> resolutions;
   PndLmdMapData resolution_map_data;
+  // threads of the models which parallelize their updates
+  unsigned int number_of_threads;
 
   std::shared_ptr<PndLmdSmearingModel2D> generate2DSmearingModel(
       const LumiFit::LmdDimension &dimx,
@@ -45,6 +62,10 @@ private:
    * @param model_opt_ptree are the options which model will be built and returned
    */
   std::shared_ptr<Model2D> generate2DModel(
+      const boost::property_tree::ptree& model_opt_ptree,
+      const PndLmdAngularData& data, ModelComponents& components) const;
+
+  std::shared_ptr<DataModel2D> generate2DAcceptanceModel(
       const boost::property_tree::ptree& model_opt_ptree,
       const PndLmdAngularData& data) const;
 public:
@@ -58,6 +79,11 @@ public:
   void setAcceptance(const PndLmdAcceptance& acceptance_);
   void setResolutionMapData(const PndLmdMapData& res_map_);
   void setResolutions(const std::vector<PndLmdHistogramData>& resolutions_);
+  /**
+   * Sets the number of threads of the generated models. The default is the
+   * number of threads of the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads_);
 
   std::shared_ptr<Model1D> generate1DVertexModel(
       const boost::property_tree::ptree& model_opt_ptree) const;
@@ -65,6 +91,13 @@ public:
   std::shared_ptr<Model> generateModel(
       const boost::property_tree::ptree& model_opt_ptree,
       const PndLmdAngularData& data) const;
+  /**
+   * Same as above, but the components which are already set in components
+   * are reused and the missing ones are built and stored there.
+   */
+  std::shared_ptr<Model> generateModel(
+      const boost::property_tree::ptree& model_opt_ptree,
+      const PndLmdAngularData& data, ModelComponents& components) const;
 };
 
 #endif /* PNDLMDMODELFACTORY_H_ */
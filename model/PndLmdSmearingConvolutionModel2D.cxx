@@ -1,18 +1,28 @@
 #include "PndLmdSmearingConvolutionModel2D.h"
 #include "ui/PndLmdRuntimeConfiguration.h"
+#include "core/ModelCloner.h"
+#include "core/FitTracer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <iomanip>
 
-#include <boost/thread.hpp>
-
 PndLmdSmearingConvolutionModel2D::PndLmdSmearingConvolutionModel2D(
     std::string name_, std::shared_ptr<Model2D> unsmeared_model_,
     std::shared_ptr<PndLmdSmearingModel2D> smearing_model_,
     const LumiFit::LmdDimension& data_dim_x_,
     const LumiFit::LmdDimension& data_dim_y_) :
-    Model2D(name_), data_dim_x(data_dim_x_), data_dim_y(data_dim_y_) {
-  nthreads = PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
+    Model2D(name_), data_dim_x(data_dim_x_), data_dim_y(data_dim_y_), model_grid(
+        data_dim_x_.bins, data_dim_y_.bins,
+        Grid2D<mydouble>::cache_line_values), grid_scale_factor(1.0), nthreads(
+        PndLmdRuntimeConfiguration::Instance().getNumberOfThreads()), worker_pool(
+        new WorkerPool(nthreads)) {
+  mc_bin_evaluation_task = std::bind(
+      &PndLmdSmearingConvolutionModel2D::evaluateMCBins, this,
+      std::placeholders::_1);
+  smearing_task = std::bind(&PndLmdSmearingConvolutionModel2D::smearRecoBins,
+      this, std::placeholders::_1);
 
   unsmeared_model = unsmeared_model_;
   smearing_model = smearing_model_;
@@ -22,19 +32,12 @@ PndLmdSmearingConvolutionModel2D::PndLmdSmearingConvolutionModel2D(
   // setVar1Domain(-TMath::Pi(), TMath::Pi());
   // setVar2Domain(-TMath::Pi(), TMath::Pi());
 
-  model_grid = new mydouble*[data_dim_x.bins];
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    model_grid[i] = new mydouble[data_dim_y.bins];
-  }
-
+  model_grid.setAxes(data_dim_x.dimension_range.getRangeLow(),
+      data_dim_x.bin_size, data_dim_y.dimension_range.getRangeLow(),
+      data_dim_y.bin_size);
 }
 
 PndLmdSmearingConvolutionModel2D::~PndLmdSmearingConvolutionModel2D() {
-  for (unsigned int i = 0; i < data_dim_x.bins; i++) {
-    delete[] (model_grid[i]);
-  }
-  delete[] (model_grid);
-
 }
 
 void PndLmdSmearingConvolutionModel2D::initModelParameters() {
@@ -45,102 +48,107 @@ void PndLmdSmearingConvolutionModel2D::injectModelParameter(
   getModelParameterSet().addModelParameter(model_param);
 }
 
-void PndLmdSmearingConvolutionModel2D::generateModelGrid2D() {
-  std::cout << "generating resolution smeared grid..." << std::endl;
-  // create threads and let them evaluate a part of the data
-  boost::thread_group threads;
+void PndLmdSmearingConvolutionModel2D::setLinearScaleParameter(
+    const std::string &scale_parameter_name) {
+  dependency_tracker.setScaleParameterName(scale_parameter_name);
+}
 
-  for (unsigned int i = 0; i < nthreads; i++) {
-    threads.create_thread(
-        boost::bind(&PndLmdSmearingConvolutionModel2D::generateModelGrid2D,
-            this, i));
-  }
+void PndLmdSmearingConvolutionModel2D::setNumberOfThreads(
+    unsigned int number_of_threads) {
+  nthreads = std::max(1u, number_of_threads);
+  if (worker_pool->getNumberOfThreads() != nthreads)
+    worker_pool.reset(new WorkerPool(nthreads));
+}
 
-  threads.join_all();
+void PndLmdSmearingConvolutionModel2D::generateModelGrid2D() {
+  std::cout << "generating resolution smeared grid..." << std::endl;
+  // the unsmeared model is evaluated only once per mc bin, then the
+  // resolution matrix is applied to these values
+  mc_bin_values.resize(smearing_model->getNumberOfMCBins());
+  worker_pool->run(mc_bin_evaluation_task, nthreads);
+  worker_pool->run(smearing_task, smearing_model->getRowRanges().size());
   std::cout << "done!" << std::endl;
 }
-void PndLmdSmearingConvolutionModel2D::generateModelGrid2D(unsigned int index) {
-  auto const& res_param = smearing_model->getListOfContributors(index);
-
-  mydouble xx[2];
-  for (auto const& reco_bin : res_param) {
-    std::vector<mydouble> numbers;
-    numbers.reserve(reco_bin.contributor_coordinate_weight_list.size() + 1);
-    numbers.push_back(0.0);
-    for (auto const& mc_element_coordinate_and_weight : reco_bin.contributor_coordinate_weight_list) {
-      xx[0] = mc_element_coordinate_and_weight.bin_center_x;
-      xx[1] = mc_element_coordinate_and_weight.bin_center_y;
-      mydouble integral_unsmeared_model = unsmeared_model->evaluate(xx);
-      /*integral_unsmeared_model = integral_unsmeared_model
-       * mc_element_coordinate_and_weight.area;*/
-      //value = value
-      //    + integral_unsmeared_model
-      //        * mc_element_coordinate_and_weight.smear_weight;
-      numbers.push_back(
-          integral_unsmeared_model
-              * mc_element_coordinate_and_weight.smear_weight);
-     /* if (std::isnan(integral_unsmeared_model)
-          || std::isnan(mc_element_coordinate_and_weight.smear_weight))
-        std::cout << xx[0] << " : " << xx[1] << " -> "
-            << integral_unsmeared_model << " * "
-            << mc_element_coordinate_and_weight.smear_weight << std::endl;*/
-    }
-
-    while (numbers.size() > 2) {
-      std::vector<mydouble> temp_sum;
-      temp_sum.reserve(numbers.size() / 2 + 1);
-      if (numbers.size() % 2 == 0) {
-        for (unsigned int i = 0; i < numbers.size(); i = i + 2) {
-          temp_sum.push_back(numbers[i] + numbers[i + 1]);
-        }
-      } else {
-        for (unsigned int i = 0; i < numbers.size() - 1; i = i + 2) {
-          temp_sum.push_back(numbers[i] + numbers[i + 1]);
-        }
-        temp_sum.push_back(numbers.back());
-      }
-      numbers = temp_sum;
-    }
-    mydouble sum_value(numbers[0]);
-    if (numbers.size() == 2)
-      sum_value += numbers[1];
-
-    int ix = (reco_bin.reco_bin_x - data_dim_x.dimension_range.getRangeLow())
-        / data_dim_x.bin_size;
-    int iy = (reco_bin.reco_bin_y - data_dim_y.dimension_range.getRangeLow())
-        / data_dim_y.bin_size;
 
-//    std::cout<<res_param[i].reco_bin_x<<" - "<<data_dim_x.dimension_range.getRangeLow()<<std::endl;
+void PndLmdSmearingConvolutionModel2D::evaluateMCBins(unsigned int index) {
+  unsigned int mc_bins_per_thread(mc_bin_values.size() / nthreads + 1);
+  unsigned int begin(index * mc_bins_per_thread);
+  unsigned int end(std::min(begin + mc_bins_per_thread,
+      (unsigned int) mc_bin_values.size()));
+  if (begin >= end)
+    return;
+
+  unsmeared_model->evaluateBatch(
+      &smearing_model->getMCBinCoordinates()[2 * begin], end - begin,
+      &mc_bin_values[begin]);
+}
 
- /*   if (std::isnan(sum_value))
-      std::cout << ix << " " << iy << " " << sum_value << std::endl;*/
-    model_grid[ix][iy] = sum_value;
-  }
+void PndLmdSmearingConvolutionModel2D::smearRecoBins(unsigned int index) {
+  auto const& row_range = smearing_model->getRowRanges()[index];
+  smearing_model->smear(mc_bin_values.data(), row_range.first,
+      row_range.second, model_grid);
 }
 
 mydouble PndLmdSmearingConvolutionModel2D::eval(const mydouble *x) const {
-  int ix = (x[0] - data_dim_x.dimension_range.getRangeLow())
-      / data_dim_x.bin_size;
-  int iy = (x[1] - data_dim_y.dimension_range.getRangeLow())
-      / data_dim_y.bin_size;
-
-  /*std::cout << ix << " " << iy << " " << data_dim_x.bins << " "
-   << data_dim_y.bins << " " << x[0] << " "
-   << data_dim_x.dimension_range.getRangeLow() << " - "
-   << data_dim_x.dimension_range.getRangeHigh() << " " << x[1] << " "
-   << data_dim_y.dimension_range.getRangeLow() << " - "
-   << data_dim_y.dimension_range.getRangeHigh() << std::endl;*/
+  return grid_scale_factor * model_grid.evaluateConstant(x[0], x[1]);
+}
 
-  if (ix >= data_dim_x.bins || iy >= data_dim_y.bins || ix < 0 || iy < 0)
-    return 0.0;
+void PndLmdSmearingConvolutionModel2D::evalBatch(const mydouble *xs,
+    unsigned int n, mydouble *out) const {
+  model_grid.evaluateConstant(xs, n, out);
+  const mydouble scale(grid_scale_factor);
+  for (unsigned int i = 0; i < n; ++i)
+    out[i] *= scale;
+}
 
-  /*if(std::isnan(model_grid[ix][iy]))
-    std::cout<<ix<<" "<<iy<<" is nan!\n";*/
+bool PndLmdSmearingConvolutionModel2D::hasParameterDerivative(
+    const std::shared_ptr<ModelPar> &parameter) const {
+  return dependency_tracker.isScaleParameter(
+      unsmeared_model->getModelParameterSet(), parameter)
+      || Model2D::hasParameterDerivative(parameter);
+}
 
-  return model_grid[ix][iy];
+void PndLmdSmearingConvolutionModel2D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  Model2D::evalParameterDerivatives(x, parameters, derivatives);
+  ModelParSet &dependencies = unsmeared_model->getModelParameterSet();
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    if (dependency_tracker.isScaleParameter(dependencies, parameters[i]))
+      derivatives[i] = model_grid.evaluateConstant(x[0], x[1])
+          * dependency_tracker.getScaleFactorDerivative();
+  }
 }
 
 void PndLmdSmearingConvolutionModel2D::updateDomain() {
   smearing_model->updateSmearingModel();
-  generateModelGrid2D();
+
+  ModelParSet &dependencies = unsmeared_model->getModelParameterSet();
+  switch (dependency_tracker.checkForUpdate(dependencies)) {
+    case ModelParameterDependencyTracker::FULL_UPDATE: {
+      LMDFIT_TRACE_SCOPE("grid", getName());
+      LMDFIT_TRACE_COUNTER(getName() + ": full grid updates", 1.0);
+      generateModelGrid2D();
+      dependency_tracker.markComputed(dependencies);
+      grid_scale_factor = 1.0;
+      break;
+    }
+    case ModelParameterDependencyTracker::RESCALE:
+      LMDFIT_TRACE_COUNTER(getName() + ": grid rescales", 1.0);
+      grid_scale_factor = dependency_tracker.getScaleFactor(dependencies);
+      break;
+    default:
+      break;
+  }
+}
+
+std::shared_ptr<Model> PndLmdSmearingConvolutionModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  std::shared_ptr<PndLmdSmearingConvolutionModel2D> copy(
+      new PndLmdSmearingConvolutionModel2D(getName(),
+          cloner.clone(unsmeared_model), smearing_model, data_dim_x,
+          data_dim_y));
+  copy->setLinearScaleParameter(dependency_tracker.getScaleParameterName());
+  copy->setNumberOfThreads(nthreads);
+  return copy;
 }
@@ -1,7 +1,10 @@
 #ifndef PNDLMDSMEARINGCONVOLUTIONMODEL2D_H_
 #define PNDLMDSMEARINGCONVOLUTIONMODEL2D_H_
 
+#include "core/Grid2D.h"
 #include "core/Model2D.h"
+#include "core/ModelParameterDependencyTracker.h"
+#include "core/WorkerPool.h"
 #include "PndLmdSmearingModel2D.h"
 
 class PndLmdSmearingConvolutionModel2D: public Model2D {
@@ -11,12 +14,30 @@ class PndLmdSmearingConvolutionModel2D: public Model2D {
   LumiFit::LmdDimension data_dim_x;
   LumiFit::LmdDimension data_dim_y;
 
-  mydouble **model_grid;
+  Grid2D<mydouble> model_grid;
+
+  // the smeared grid is recomputed only if the unsmeared model has changed
+  ModelParameterDependencyTracker dependency_tracker;
+  mydouble grid_scale_factor;
 
   unsigned int nthreads;
+  std::unique_ptr<WorkerPool> worker_pool;
+
+  // unsmeared model values at the mc bins of the resolution matrix
+  std::vector<mydouble> mc_bin_values;
+  WorkerPool::Task mc_bin_evaluation_task;
+  WorkerPool::Task smearing_task;
 
   void generateModelGrid2D();
-  void generateModelGrid2D(unsigned int index);
+  void evaluateMCBins(unsigned int index);
+  void smearRecoBins(unsigned int index);
+
+protected:
+  /**
+   * The resolution matrix is not changed during a fit, so it is shared with
+   * the clone.
+   */
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
 
 public:
   PndLmdSmearingConvolutionModel2D(std::string name_,
@@ -30,8 +51,35 @@ public:
 
   void injectModelParameter(std::shared_ptr<ModelPar> model_param);
 
+  /**
+   * Declares the model parameter with name scale_parameter_name to be a pure
+   * scale factor of the unsmeared model (e.g. the luminosity). As the
+   * smearing is linear, changes of only this parameter then rescale the
+   * smeared grid instead of recomputing it.
+   */
+  void setLinearScaleParameter(const std::string &scale_parameter_name);
+
+  /**
+   * Sets the number of threads smearing the grid. The default is the number
+   * of threads of the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads);
+
   mydouble eval(const mydouble *x) const;
 
+  void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+  /**
+   * Only the derivative with respect to the linear scale parameter is known,
+   * as the smeared model is proportional to it. All others are numerical.
+   */
+  bool hasParameterDerivative(
+      const std::shared_ptr<ModelPar> &parameter) const;
+
+  void evalParameterDerivatives(const mydouble *x,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble *derivatives) const;
+
   void updateDomain();
 };
 
@@ -7,10 +7,16 @@
 
 #include <model/PndLmdSmearingModel2D.h>
 #include "ui/PndLmdRuntimeConfiguration.h"
+#include "core/PairwiseSum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 PndLmdSmearingModel2D::PndLmdSmearingModel2D(const LumiFit::LmdDimension &dimx_,
     const LumiFit::LmdDimension &dimy_) :
-    dim_x(dimx_), dim_y(dimy_) {
+    dim_x(dimx_), dim_y(dimy_), number_of_row_ranges(
+        PndLmdRuntimeConfiguration::Instance().getNumberOfThreads()) {
 }
 
 PndLmdSmearingModel2D::~PndLmdSmearingModel2D() {
@@ -18,82 +24,136 @@ PndLmdSmearingModel2D::~PndLmdSmearingModel2D() {
 
 void PndLmdSmearingModel2D::setSmearingParameterization(
     const std::vector<RecoBinSmearingContributions>& smearing_parameterization_) {
-  unsigned int nthreads =
-      PndLmdRuntimeConfiguration::Instance().getNumberOfThreads();
-
-  std::cout<<"chopping smearing parameterization for multithreading...\n";
-  unsigned int bins_per_thread_x(dim_x.bins / nthreads);
-  unsigned int bins_per_thread_y(dim_y.bins / nthreads);
-
-  bool use_x_splitting(true);
-  if (dim_x.bins % nthreads != 0) {
-    if (dim_y.bins % nthreads == 0)
-      use_x_splitting = false;
-    else {
-      if (dim_y.bins % nthreads > dim_x.bins % nthreads) {
-        use_x_splitting = false;
-        bins_per_thread_y++;
-      } else {
-        bins_per_thread_x++;
+  std::cout << "converting smearing parameterization to sparse matrix...\n";
+
+  const unsigned int number_of_reco_bins(dim_x.bins * dim_y.bins);
+
+  // first collect the entries of each reco bin and assign an index to each
+  // unique mc bin
+  std::vector<std::vector<std::pair<unsigned int, mydouble> > > rows(
+      number_of_reco_bins);
+  std::map<std::pair<mydouble, mydouble>, unsigned int> mc_bin_indices;
+  mc_bin_coordinates.clear();
+
+  for (auto const& reco_bin : smearing_parameterization_) {
+    int ix = std::floor(
+        (reco_bin.reco_bin_x - dim_x.dimension_range.getRangeLow())
+            / dim_x.bin_size);
+    int iy = std::floor(
+        (reco_bin.reco_bin_y - dim_y.dimension_range.getRangeLow())
+            / dim_y.bin_size);
+    if (ix < 0 || iy < 0 || ix >= (int) dim_x.bins || iy >= (int) dim_y.bins)
+      continue;
+
+    auto &row = rows[ix * dim_y.bins + iy];
+    for (auto const& contributor : reco_bin.contributor_coordinate_weight_list) {
+      std::pair<mydouble, mydouble> mc_bin(contributor.bin_center_x,
+          contributor.bin_center_y);
+      auto mc_bin_index = mc_bin_indices.find(mc_bin);
+      unsigned int column(mc_bin_coordinates.size() / 2);
+      if (mc_bin_index == mc_bin_indices.end()) {
+        mc_bin_indices[mc_bin] = column;
+        mc_bin_coordinates.push_back(mc_bin.first);
+        mc_bin_coordinates.push_back(mc_bin.second);
+      }
+      else {
+        column = mc_bin_index->second;
       }
+      row.push_back(std::make_pair(column, contributor.smear_weight));
     }
   }
 
-  binrange br;
-  br.x_bin_low = 0;
-  br.x_bin_high = dim_x.bins;
-  br.y_bin_low = 0;
-  br.y_bin_high = dim_y.bins;
-  for (unsigned int i = 0; i < nthreads; ++i) {
-    if (use_x_splitting) {
-      br.x_bin_low = i * bins_per_thread_x;
-      br.x_bin_high = (i + 1) * bins_per_thread_x;
-      if (i == nthreads - 1)
-        br.x_bin_high = dim_x.bins;
-    } else {
-      br.y_bin_low = i * bins_per_thread_y;
-      br.y_bin_high = (i + 1) * bins_per_thread_y;
-      if (i == nthreads - 1)
-        br.y_bin_high = dim_y.bins;
+  // then compress the rows
+  unsigned int number_of_entries(0);
+  for (auto const& row : rows)
+    number_of_entries += row.size();
+
+  row_offsets.clear();
+  row_offsets.reserve(number_of_reco_bins + 1);
+  column_indices.clear();
+  column_indices.reserve(number_of_entries);
+  smear_weights.clear();
+  smear_weights.reserve(number_of_entries);
+
+  row_offsets.push_back(0);
+  for (auto &row : rows) {
+    // sorted columns give a more linear access of the mc bin values
+    std::sort(row.begin(), row.end());
+    for (auto const& entry : row) {
+      column_indices.push_back(entry.first);
+      smear_weights.push_back(entry.second);
     }
-    smearing_parameterization_lists.push_back(
-        createSmearingParameterizationPart(smearing_parameterization_, br));
+    row_offsets.push_back(column_indices.size());
   }
-  std::cout<<"done!\n";
+
+  createRowRanges(number_of_row_ranges);
+
+  std::cout << "resolution matrix: " << getNumberOfRecoBins() << " reco bins, "
+      << getNumberOfMCBins() << " mc bins, " << getNumberOfMatrixEntries()
+      << " entries";
+  if (getNumberOfMCBins() > 0)
+    std::cout << " (average of " << 1.0 * getNumberOfMatrixEntries()
+        / getNumberOfMCBins() << " reco bins per mc bin)";
+  std::cout << std::endl;
 }
 
-std::vector<RecoBinSmearingContributions> PndLmdSmearingModel2D::createSmearingParameterizationPart(
-    const std::vector<RecoBinSmearingContributions>& smearing_parameterization_,
-    const binrange &br) const {
-  std::vector<RecoBinSmearingContributions> smearing_param_part;
-
-  mydouble x[2];
-  for (unsigned int ix = br.x_bin_low; ix < br.x_bin_high; ix++) {
-    x[0] = dim_x.dimension_range.getRangeLow() + dim_x.bin_size * (0.5 + ix);
-    for (unsigned int iy = br.y_bin_low; iy < br.y_bin_high; iy++) {
-      x[1] = dim_y.dimension_range.getRangeLow() + dim_y.bin_size * (0.5 + iy);
-      auto result =
-          std::find_if(smearing_parameterization_.begin(),
-              smearing_parameterization_.end(),
-              [&] (const RecoBinSmearingContributions& rec_bin) {if(std::fabs(rec_bin.reco_bin_x - x[0]) < dim_x.bin_size/2 && std::fabs(rec_bin.reco_bin_y - x[1]) < dim_y.bin_size/2) return true; else return false;});
-      if (result != smearing_parameterization_.end()) {
-        smearing_param_part.push_back(*result);
-        //std::cout << "found corresponding reco bin!\n";
-      } else {
-        //std::cout << "did not find a corresponding reco bin...\n";
-        RecoBinSmearingContributions temp;
-        temp.reco_bin_x = x[0];
-        temp.reco_bin_y = x[1];
-        smearing_param_part.push_back(temp);
-      }
+void PndLmdSmearingModel2D::setNumberOfThreads(
+    unsigned int number_of_threads) {
+  number_of_row_ranges = number_of_threads;
+  if (!row_offsets.empty())
+    createRowRanges(number_of_row_ranges);
+}
+
+void PndLmdSmearingModel2D::createRowRanges(unsigned int number_of_ranges) {
+  if (number_of_ranges == 0)
+    number_of_ranges = 1;
+  row_ranges.clear();
+
+  // split the rows so that each range has a similar number of entries
+  unsigned int entries_per_range(
+      getNumberOfMatrixEntries() / number_of_ranges + 1);
+  unsigned int row_begin(0);
+  for (unsigned int row = 0; row < getNumberOfRecoBins(); ++row) {
+    if (row_offsets[row + 1] - row_offsets[row_begin] >= entries_per_range
+        && row_ranges.size() + 1 < number_of_ranges) {
+      row_ranges.push_back(std::make_pair(row_begin, row + 1));
+      row_begin = row + 1;
     }
   }
-  return smearing_param_part;
+  row_ranges.push_back(std::make_pair(row_begin, getNumberOfRecoBins()));
+}
+
+unsigned int PndLmdSmearingModel2D::getNumberOfMCBins() const {
+  return mc_bin_coordinates.size() / 2;
+}
+
+unsigned int PndLmdSmearingModel2D::getNumberOfRecoBins() const {
+  return row_offsets.size() > 0 ? row_offsets.size() - 1 : 0;
+}
+
+unsigned int PndLmdSmearingModel2D::getNumberOfMatrixEntries() const {
+  return column_indices.size();
 }
 
-const std::vector<RecoBinSmearingContributions>& PndLmdSmearingModel2D::getListOfContributors(
-    unsigned int index) const {
-  return smearing_parameterization_lists[index];
+const std::vector<mydouble>& PndLmdSmearingModel2D::getMCBinCoordinates() const {
+  return mc_bin_coordinates;
+}
+
+const std::vector<std::pair<unsigned int, unsigned int> >& PndLmdSmearingModel2D::getRowRanges() const {
+  return row_ranges;
+}
+
+void PndLmdSmearingModel2D::smear(const mydouble *mc_bin_values,
+    unsigned int row_begin, unsigned int row_end,
+    Grid2D<mydouble> &reco_grid) const {
+  for (unsigned int row = row_begin; row < row_end; ++row) {
+    PairwiseSum sum;
+    for (unsigned int entry = row_offsets[row]; entry < row_offsets[row + 1];
+        ++entry) {
+      sum.add(smear_weights[entry] * mc_bin_values[column_indices[entry]]);
+    }
+    reco_grid(row / dim_y.bins, row % dim_y.bins) = sum.sum();
+  }
 }
 
 void PndLmdSmearingModel2D::updateSmearingModel() {
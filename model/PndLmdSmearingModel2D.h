@@ -9,8 +9,11 @@
 #define PNDLMDSMEARINGMODEL2D_H_
 
 #include "LumiFitStructs.h"
+#include "core/Grid2D.h"
 
 #include <map>
+#include <utility>
+#include <vector>
 
 struct ContributorCoordinateWeight {
   mydouble bin_center_x;
@@ -26,32 +29,72 @@ struct RecoBinSmearingContributions {
   std::vector<ContributorCoordinateWeight> contributor_coordinate_weight_list;
 };
 
+/**
+ * Detector resolution smearing of a 2D model on the reco binning given by
+ * dim_x and dim_y.
+ *
+ * The resolution is stored as a sparse matrix in compressed sparse row (CSR)
+ * format. Each row belongs to one reco bin (row index ix * dim_y.bins + iy),
+ * each column to one unique mc bin. So the smeared grid is obtained by
+ * evaluating the unsmeared model once per mc bin and multiplying the matrix
+ * with the resulting vector, see #smear().
+ */
 class PndLmdSmearingModel2D {
-  struct binrange {
-    unsigned int x_bin_low;
-    unsigned int x_bin_high;
-    unsigned int y_bin_low;
-    unsigned int y_bin_high;
-  };
-
-  std::vector<std::vector<RecoBinSmearingContributions> > smearing_parameterization_lists;
-
   const LumiFit::LmdDimension dim_x;
   const LumiFit::LmdDimension dim_y;
 
-  std::vector<RecoBinSmearingContributions> createSmearingParameterizationPart(
-      const std::vector<RecoBinSmearingContributions>& smearing_parameterization_,
-      const binrange &br) const;
+  // bin centers of the unique mc bins, stored point by point (x, y)
+  std::vector<mydouble> mc_bin_coordinates;
+
+  std::vector<unsigned int> row_offsets;
+  std::vector<unsigned int> column_indices;
+  std::vector<mydouble> smear_weights;
+
+  // row ranges with a similar number of matrix entries, one per thread
+  std::vector<std::pair<unsigned int, unsigned int> > row_ranges;
+  unsigned int number_of_row_ranges;
+
+  void createRowRanges(unsigned int number_of_ranges);
 
 public:
   PndLmdSmearingModel2D(const LumiFit::LmdDimension &dimx_,
       const LumiFit::LmdDimension &dimy_);
   virtual ~PndLmdSmearingModel2D();
 
+  /**
+   * Converts the smearing parameterization into the sparse matrix. Reco
+   * bins outside of the binning are ignored.
+   */
   void setSmearingParameterization(
       const std::vector<RecoBinSmearingContributions>& smearing_parameterization_);
 
-  virtual const std::vector<RecoBinSmearingContributions>& getListOfContributors(unsigned int index) const;
+  /**
+   * Sets the number of threads the rows are split for, see #getRowRanges().
+   * The default is the number of threads of the runtime configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads);
+
+  unsigned int getNumberOfMCBins() const;
+  unsigned int getNumberOfRecoBins() const;
+  unsigned int getNumberOfMatrixEntries() const;
+
+  /**
+   * Returns the bin centers of the mc bins (point by point), i.e. the
+   * positions at which the unsmeared model has to be evaluated.
+   */
+  const std::vector<mydouble>& getMCBinCoordinates() const;
+
+  const std::vector<std::pair<unsigned int, unsigned int> >& getRowRanges() const;
+
+  /**
+   * Sparse matrix vector product for the reco bins (rows) in the range
+   * [row_begin, row_end). mc_bin_values holds the unsmeared model values of
+   * all mc bins, the smeared value of reco bin (ix, iy) is written to
+   * reco_grid(ix, iy). Each row is summed pairwise (see #PairwiseSum), so
+   * the result does not depend on how the rows are distributed on threads.
+   */
+  void smear(const mydouble *mc_bin_values, unsigned int row_begin,
+      unsigned int row_end, Grid2D<mydouble> &reco_grid) const;
 
   virtual void updateSmearingModel();
 };
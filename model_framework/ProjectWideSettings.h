@@ -1,6 +1,20 @@
 #ifndef PROJECTWIDESETTINGS_H_
 #define PROJECTWIDESETTINGS_H_
 
+/**
+ * Floating point type used throughout the framework (model parameters, data,
+ * model evaluation, estimators and the model grids). It is selected at
+ * compile time with the CMake option LMDFIT_DOUBLE_PRECISION, which defines
+ * LMDFIT_USE_DOUBLE_PRECISION for all targets. The default is long double.
+ * Since the type is part of the interfaces, all libraries and apps of one
+ * build share the same precision.
+ */
+#ifdef LMDFIT_USE_DOUBLE_PRECISION
+using mydouble = double;
+#define LMDFIT_PRECISION_NAME "double"
+#else
 using mydouble = long double;
+#define LMDFIT_PRECISION_NAME "long double"
+#endif
 
-#endif /* PROJECTWIDESETTINGS_H_ */
\ No newline at end of file
+#endif /* PROJECTWIDESETTINGS_H_ */
@@ -0,0 +1,256 @@
+/*
+ * FitTracer.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "FitTracer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <boost/thread/lock_guard.hpp>
+
+namespace {
+std::string escapeJSON(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    if ((unsigned char) c >= 0x20)
+      escaped += c;
+  }
+  return escaped;
+}
+}
+
+FitTracer::FitTracer() :
+    start_time(Clock::now()), output_prefix("lmdfit_trace"), number_of_fits(
+        0), number_of_active_fits(0) {
+}
+
+FitTracer& FitTracer::Instance() {
+  static FitTracer instance;
+  return instance;
+}
+
+void FitTracer::setOutputPrefix(const std::string &output_prefix_) {
+  boost::lock_guard<boost::mutex> lock(mtx);
+  output_prefix = output_prefix_;
+}
+
+long long FitTracer::now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      Clock::now() - start_time).count();
+}
+
+FitTracer::ThreadBuffer& FitTracer::getThreadBuffer() {
+  // the buffers are owned by the tracer, so that the events of a thread
+  // survive the thread
+  thread_local ThreadBuffer *thread_buffer(0);
+  if (!thread_buffer) {
+    boost::lock_guard<boost::mutex> lock(mtx);
+    thread_buffers.push_back(
+        std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+    thread_buffer = thread_buffers.back().get();
+    thread_buffer->thread_id = thread_buffers.size();
+  }
+  return *thread_buffer;
+}
+
+void FitTracer::openScope() {
+  OpenScope scope;
+  scope.nested_duration = 0;
+  getThreadBuffer().scope_stack.push_back(scope);
+}
+
+void FitTracer::closeScope(const char *category, const std::string &name,
+    long long begin, bool aggregate_only) {
+  long long duration(now() - begin);
+  // the scope stack is only used by the own thread
+  ThreadBuffer &thread_buffer = getThreadBuffer();
+  long long nested_duration(thread_buffer.scope_stack.back().nested_duration);
+  thread_buffer.scope_stack.pop_back();
+  if (!thread_buffer.scope_stack.empty())
+    thread_buffer.scope_stack.back().nested_duration += duration;
+
+  boost::lock_guard<boost::mutex> lock(thread_buffer.mtx);
+  if (aggregate_only) {
+    ScopeSummary &scope = thread_buffer.aggregated_scopes[std::make_pair(
+        std::string(category), name)];
+    ++scope.calls;
+    scope.duration += duration;
+    scope.self_duration += duration - nested_duration;
+  }
+  else {
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.begin = begin;
+    event.duration = duration;
+    event.self_duration = duration - nested_duration;
+    event.counter_value = 0.0;
+    event.is_counter = false;
+    thread_buffer.events.push_back(event);
+  }
+}
+
+void FitTracer::addCounter(const std::string &name, double value) {
+  TraceEvent event;
+  event.name = name;
+  event.category = "counter";
+  event.begin = now();
+  event.duration = 0;
+  event.self_duration = 0;
+  event.counter_value = value;
+  event.is_counter = true;
+
+  ThreadBuffer &thread_buffer = getThreadBuffer();
+  boost::lock_guard<boost::mutex> lock(thread_buffer.mtx);
+  thread_buffer.events.push_back(event);
+}
+
+long long FitTracer::beginFit() {
+  boost::lock_guard<boost::mutex> lock(mtx);
+  ++number_of_active_fits;
+  return now();
+}
+
+void FitTracer::endFit(const std::string &fit_name, long long begin) {
+  boost::lock_guard<boost::mutex> lock(mtx);
+
+  std::vector<std::pair<unsigned int, TraceEvent> > events;
+  ScopeSummaryMap aggregated_scopes;
+  for (auto const &thread_buffer : thread_buffers) {
+    boost::lock_guard<boost::mutex> buffer_lock(thread_buffer->mtx);
+    for (auto const &event : thread_buffer->events) {
+      if (event.begin >= begin)
+        events.push_back(std::make_pair(thread_buffer->thread_id, event));
+    }
+    for (auto const &scope : thread_buffer->aggregated_scopes) {
+      ScopeSummary &summed_scope = aggregated_scopes[scope.first];
+      summed_scope.calls += scope.second.calls;
+      summed_scope.duration += scope.second.duration;
+      summed_scope.self_duration += scope.second.self_duration;
+    }
+  }
+
+  std::stringstream file_name;
+  file_name << output_prefix << "_" << number_of_fits << ".json";
+  ++number_of_fits;
+
+  writeTraceFile(file_name.str(), events);
+  printSummary(fit_name, events, aggregated_scopes);
+
+  --number_of_active_fits;
+  if (number_of_active_fits == 0) {
+    for (auto const &thread_buffer : thread_buffers) {
+      boost::lock_guard<boost::mutex> buffer_lock(thread_buffer->mtx);
+      thread_buffer->events.clear();
+      thread_buffer->aggregated_scopes.clear();
+    }
+  }
+}
+
+void FitTracer::writeTraceFile(const std::string &file_name,
+    const std::vector<std::pair<unsigned int, TraceEvent> > &events) const {
+  std::ofstream file(file_name.c_str());
+  if (!file) {
+    std::cout << "FitTracer: could not open the trace file " << file_name
+        << "!" << std::endl;
+    return;
+  }
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first(true);
+  for (auto const &thread_buffer : thread_buffers) {
+    file << (first ? "\n" : ",\n");
+    first = false;
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << thread_buffer->thread_id << ",\"args\":{\"name\":\"thread "
+        << thread_buffer->thread_id << "\"}}";
+  }
+  // the timestamps of the trace format are in microseconds
+  for (auto const &event : events) {
+    file << (first ? "\n" : ",\n");
+    first = false;
+    if (event.second.is_counter) {
+      file << "{\"name\":\"" << escapeJSON(event.second.name)
+          << "\",\"ph\":\"C\",\"pid\":1,\"tid\":" << event.first
+          << ",\"ts\":" << event.second.begin / 1000.0
+          << ",\"args\":{\"value\":" << event.second.counter_value << "}}";
+    }
+    else {
+      file << "{\"name\":\"" << escapeJSON(event.second.name)
+          << "\",\"cat\":\"" << event.second.category
+          << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.first
+          << ",\"ts\":" << event.second.begin / 1000.0 << ",\"dur\":"
+          << event.second.duration / 1000.0 << "}";
+    }
+  }
+  file << "\n]}\n";
+  std::cout << "FitTracer: wrote " << events.size() << " events to "
+      << file_name << std::endl;
+}
+
+void FitTracer::printSummary(const std::string &fit_name,
+    const std::vector<std::pair<unsigned int, TraceEvent> > &events,
+    const ScopeSummaryMap &aggregated_scopes) const {
+  struct CounterSummary {
+    unsigned long entries;
+    double sum;
+  };
+  ScopeSummaryMap scopes(aggregated_scopes);
+  std::map<std::string, CounterSummary> counters;
+  for (auto const &event : events) {
+    if (event.second.is_counter) {
+      CounterSummary &counter = counters[event.second.name];
+      ++counter.entries;
+      counter.sum += event.second.counter_value;
+    }
+    else {
+      ScopeSummary &scope = scopes[std::make_pair(
+          std::string(event.second.category), event.second.name)];
+      ++scope.calls;
+      scope.duration += event.second.duration;
+      scope.self_duration += event.second.self_duration;
+    }
+  }
+
+  // the most expensive scopes first
+  std::vector<std::pair<std::pair<std::string, std::string>, ScopeSummary> > sorted_scopes(
+      scopes.begin(), scopes.end());
+  std::sort(sorted_scopes.begin(), sorted_scopes.end(),
+      [](const std::pair<std::pair<std::string, std::string>, ScopeSummary> &lhs,
+          const std::pair<std::pair<std::string, std::string>, ScopeSummary> &rhs) {
+        return lhs.second.self_duration > rhs.second.self_duration;
+      });
+
+  std::cout << "FitTracer: summary of " << fit_name
+      << " (times of all threads in ms)" << std::endl;
+  std::cout << std::left << std::setw(16) << "category" << std::setw(60)
+      << "name" << std::right << std::setw(10) << "calls" << std::setw(14)
+      << "total" << std::setw(14) << "self" << std::setw(14) << "mean"
+      << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  for (auto const &scope : sorted_scopes) {
+    std::cout << std::left << std::setw(16) << scope.first.first
+        << std::setw(60) << scope.first.second << std::right << std::setw(10)
+        << scope.second.calls << std::setw(14)
+        << scope.second.duration / 1e6 << std::setw(14)
+        << scope.second.self_duration / 1e6 << std::setw(14)
+        << scope.second.duration / 1e6 / scope.second.calls << std::endl;
+  }
+  for (auto const &counter : counters) {
+    std::cout << std::left << std::setw(16) << "counter" << std::setw(60)
+        << counter.first << std::right << std::setw(10)
+        << counter.second.entries << std::setw(14) << counter.second.sum
+        << std::endl;
+  }
+  std::cout.unsetf(std::ios_base::floatfield);
+  std::cout << std::setprecision(6);
+}
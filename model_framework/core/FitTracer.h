@@ -0,0 +1,192 @@
+/*
+ * FitTracer.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef FITTRACER_H_
+#define FITTRACER_H_
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Timeline tracing of fits.
+ *
+ * The hot spots of a fit (estimator evaluations, model updates, grid
+ * regenerations and the minimizer) are wrapped in #LMDFIT_TRACE_SCOPE(),
+ * which records the begin and duration of the scope in a buffer of the
+ * calling thread. Scopes which are nested on the same thread are subtracted
+ * from the time of the enclosing scope, so the self time of e.g. the
+ * minimizer scope is the overhead of the minimizer itself. Scopes which are
+ * entered very often, like the integral over a single bin or the batch
+ * evaluation of a model node, use #LMDFIT_TRACE_AGGREGATED_SCOPE()
+ * instead, which only adds to the call count and times of the scope in the
+ * summary. #LMDFIT_TRACE_COUNTER() records a value, e.g. the kind of update
+ * of a cached grid.
+ *
+ * #LMDFIT_TRACE_FIT() marks the duration of one fit. At its end all events
+ * of this fit are written to a trace file in the Chrome trace event format,
+ * which can be opened with chrome://tracing or https://ui.perfetto.dev, and
+ * a summary table of the call counts and times per scope is printed. Fits
+ * which run at the same time share the timeline, so their trace files
+ * overlap and their aggregated scopes are summed up.
+ *
+ * The macros are empty unless the framework is compiled with
+ * LMDFIT_ENABLE_TRACING (cmake option LMDFIT_TRACING), so there is no
+ * overhead in normal builds. Single point evaluations (Model::evaluate())
+ * are never traced, they are far too frequent.
+ */
+class FitTracer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+private:
+  struct TraceEvent {
+    std::string name;
+    const char *category;
+    long long begin;
+    long long duration;
+    long long self_duration;
+    double counter_value;
+    bool is_counter;
+  };
+
+  // an open scope on the stack of a thread
+  struct OpenScope {
+    long long nested_duration;
+  };
+
+  struct ScopeSummary {
+    unsigned long calls;
+    long long duration;
+    long long self_duration;
+  };
+  typedef std::map<std::pair<std::string, std::string>, ScopeSummary> ScopeSummaryMap;
+
+  struct ThreadBuffer {
+    unsigned int thread_id;
+    boost::mutex mtx;
+    std::vector<TraceEvent> events;
+    ScopeSummaryMap aggregated_scopes;
+    std::vector<OpenScope> scope_stack;
+  };
+
+  Clock::time_point start_time;
+
+  boost::mutex mtx;
+  std::vector<std::unique_ptr<ThreadBuffer> > thread_buffers;
+  std::string output_prefix;
+  unsigned int number_of_fits;
+  unsigned int number_of_active_fits;
+
+  FitTracer();
+
+  ThreadBuffer& getThreadBuffer();
+
+  void writeTraceFile(const std::string &file_name,
+      const std::vector<std::pair<unsigned int, TraceEvent> > &events) const;
+  void printSummary(const std::string &fit_name,
+      const std::vector<std::pair<unsigned int, TraceEvent> > &events,
+      const ScopeSummaryMap &aggregated_scopes) const;
+
+public:
+  static FitTracer& Instance();
+
+  /**
+   * The trace file of the n-th fit is named <prefix>_<n>.json. The default
+   * prefix is "lmdfit_trace".
+   */
+  void setOutputPrefix(const std::string &output_prefix_);
+
+  /**
+   * @returns the current time in ns since the construction of the tracer.
+   */
+  long long now() const;
+
+  void openScope();
+  /**
+   * Closes the innermost open scope of the calling thread. With
+   * aggregate_only the scope is only added to the summary.
+   */
+  void closeScope(const char *category, const std::string &name,
+      long long begin, bool aggregate_only);
+  void addCounter(const std::string &name, double value);
+
+  /**
+   * @returns the begin of the fit, which has to be passed to #endFit().
+   */
+  long long beginFit();
+  /**
+   * Writes the trace file and prints the summary of all events since begin.
+   * The buffers are cleared once no fit is active anymore.
+   */
+  void endFit(const std::string &fit_name, long long begin);
+};
+
+/**
+ * Records the scope from its construction to its destruction, see
+ * #LMDFIT_TRACE_SCOPE().
+ */
+class FitTraceScope {
+  const char *category;
+  std::string name;
+  bool aggregate_only;
+  long long begin;
+
+public:
+  FitTraceScope(const char *category_, const std::string &name_,
+      bool aggregate_only_ = false) :
+      category(category_), name(name_), aggregate_only(aggregate_only_), begin(
+          FitTracer::Instance().now()) {
+    FitTracer::Instance().openScope();
+  }
+  ~FitTraceScope() {
+    FitTracer::Instance().closeScope(category, name, begin, aggregate_only);
+  }
+};
+
+/**
+ * Records a complete fit, see #LMDFIT_TRACE_FIT().
+ */
+class FitTraceRecording {
+  std::string fit_name;
+  long long begin;
+
+public:
+  FitTraceRecording(const std::string &fit_name_) :
+      fit_name(fit_name_), begin(FitTracer::Instance().beginFit()) {
+  }
+  ~FitTraceRecording() {
+    FitTracer::Instance().endFit(fit_name, begin);
+  }
+};
+
+#define LMDFIT_TRACE_CONCATENATE_(a, b) a##b
+#define LMDFIT_TRACE_CONCATENATE(a, b) LMDFIT_TRACE_CONCATENATE_(a, b)
+
+#ifdef LMDFIT_ENABLE_TRACING
+#define LMDFIT_TRACE_SCOPE(category, name) \
+  FitTraceScope LMDFIT_TRACE_CONCATENATE(fit_trace_scope_, __LINE__)( \
+      category, name)
+#define LMDFIT_TRACE_AGGREGATED_SCOPE(category, name) \
+  FitTraceScope LMDFIT_TRACE_CONCATENATE(fit_trace_scope_, __LINE__)( \
+      category, name, true)
+#define LMDFIT_TRACE_COUNTER(name, value) \
+  FitTracer::Instance().addCounter(name, value)
+#define LMDFIT_TRACE_FIT(name) \
+  FitTraceRecording LMDFIT_TRACE_CONCATENATE(fit_trace_recording_, __LINE__)( \
+      name)
+#else
+#define LMDFIT_TRACE_SCOPE(category, name)
+#define LMDFIT_TRACE_AGGREGATED_SCOPE(category, name)
+#define LMDFIT_TRACE_COUNTER(name, value)
+#define LMDFIT_TRACE_FIT(name)
+#endif
+
+#endif /* FITTRACER_H_ */
@@ -0,0 +1,325 @@
+/*
+ * Grid2D.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef GRID2D_H_
+#define GRID2D_H_
+
+#include "ProjectWideSettings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * Regular 2D grid of values, e.g. the bin contents of a cached model or an
+ * acceptance map.
+ *
+ * All values live in a single allocation, which is aligned to a cache line.
+ * The grid is stored row major, i.e. a row holds the values of all y bins of
+ * one x bin, and row ix starts at #data() + ix * #getStride(). By default
+ * the rows are contiguous (the stride is the number of y bins). With a row
+ * alignment the stride is rounded up, so that every row starts on its own
+ * boundary.
+ *
+ * After #setAxes() the grid also describes a function of the plane. Bin
+ * (ix, iy) covers [low_x + ix * spacing_x, low_x + (ix + 1) * spacing_x) x
+ * [low_y + iy * spacing_y, ...) and its value belongs to the bin center. The
+ * function vanishes outside of the covered area, and the interpolations
+ * treat the missing neighbors of the border bins as zero. Each evaluation
+ * exists for single points and for batches of points (stored point by
+ * point like in Model::evalBatch()). The batch loops are free of branches,
+ * so that the compiler can vectorize them for the double precision build.
+ */
+template<typename T> class Grid2D {
+public:
+  /// the alignment of the allocation in bytes
+  static const std::size_t alignment = 64;
+  /// row alignment which lets every row start on a cache line
+  static const unsigned int cache_line_values = alignment / sizeof(T);
+
+private:
+  unsigned int bins_x;
+  unsigned int bins_y;
+  unsigned int stride;
+
+  std::unique_ptr<unsigned char[]> storage;
+  T *values;
+
+  mydouble low[2];
+  mydouble spacing[2];
+  mydouble inverse_spacing[2];
+
+  void allocate(unsigned int row_alignment) {
+    stride = bins_y;
+    if (row_alignment > 1)
+      stride = (bins_y + row_alignment - 1) / row_alignment * row_alignment;
+
+    std::size_t size(sizeof(T) * bins_x * stride);
+    std::size_t space(size + alignment);
+    storage.reset(new unsigned char[space]);
+    void *aligned_storage(storage.get());
+    values = static_cast<T*>(std::align(alignment, size, aligned_storage,
+        space));
+    std::fill(values, values + bins_x * stride, T(0));
+  }
+
+  // position of x in units of the bin size, relative to the low edge
+  mydouble getPosition(unsigned int dimension, mydouble x) const {
+    return (x - low[dimension]) * inverse_spacing[dimension];
+  }
+
+  bool isInside(mydouble position_x, mydouble position_y) const {
+    return (position_x >= 0.0) & (position_x < bins_x) & (position_y >= 0.0)
+        & (position_y < bins_y);
+  }
+
+  // the value of bin (ix, iy), or zero for bins beyond the border
+  T getValueOrZero(int ix, int iy) const {
+    bool inside((ix >= 0) & (ix < (int) bins_x) & (iy >= 0)
+        & (iy < (int) bins_y));
+    int clamped_ix(std::min(std::max(ix, 0), (int) bins_x - 1));
+    int clamped_iy(std::min(std::max(iy, 0), (int) bins_y - 1));
+    return inside ? values[clamped_ix * stride + clamped_iy] : T(0);
+  }
+
+  // catmull-rom weights of the four nodes around a position with the
+  // fraction t between the two inner nodes
+  static void getCubicWeights(mydouble t, mydouble *weights) {
+    mydouble t2(t * t);
+    mydouble t3(t2 * t);
+    weights[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+    weights[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+    weights[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+    weights[3] = 0.5 * (t3 - t2);
+  }
+
+  // the position is clamped before the conversion, so that the conversion
+  // of points far outside is well defined
+  int getLowerNode(unsigned int dimension, mydouble position) const {
+    mydouble lowest(-2.0);
+    mydouble highest((dimension == 0 ? bins_x : bins_y) + 1.0);
+    return (int) std::floor(std::min(std::max(position, lowest), highest));
+  }
+
+public:
+  Grid2D() :
+      bins_x(0), bins_y(0), stride(0), values(0) {
+    setAxes(0.0, 1.0, 0.0, 1.0);
+  }
+
+  /**
+   * @param row_alignment rounds the stride up to a multiple of this number
+   * of values. The default keeps the rows contiguous.
+   */
+  Grid2D(unsigned int bins_x_, unsigned int bins_y_,
+      unsigned int row_alignment = 1) :
+      bins_x(bins_x_), bins_y(bins_y_), values(0) {
+    allocate(row_alignment);
+    setAxes(0.0, 1.0, 0.0, 1.0);
+  }
+
+  Grid2D(const Grid2D &grid) :
+      bins_x(grid.bins_x), bins_y(grid.bins_y), values(0) {
+    // rounding the y bins up to a multiple of the stride reproduces it
+    allocate(grid.stride);
+    std::copy(grid.values, grid.values + bins_x * stride, values);
+    setAxes(grid.low[0], grid.spacing[0], grid.low[1], grid.spacing[1]);
+  }
+
+  Grid2D& operator=(const Grid2D &grid) {
+    if (this != &grid) {
+      Grid2D copy(grid);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  Grid2D(Grid2D &&grid) = default;
+  Grid2D& operator=(Grid2D &&grid) = default;
+
+  /**
+   * Reallocates the grid with the given number of bins. All values are set
+   * to zero, the axes are kept.
+   */
+  void resize(unsigned int bins_x_, unsigned int bins_y_,
+      unsigned int row_alignment = 1) {
+    bins_x = bins_x_;
+    bins_y = bins_y_;
+    allocate(row_alignment);
+  }
+
+  /**
+   * Places the grid in the plane, see #Grid2D.
+   */
+  void setAxes(mydouble low_x, mydouble spacing_x, mydouble low_y,
+      mydouble spacing_y) {
+    low[0] = low_x;
+    low[1] = low_y;
+    spacing[0] = spacing_x;
+    spacing[1] = spacing_y;
+    inverse_spacing[0] = 1.0 / spacing_x;
+    inverse_spacing[1] = 1.0 / spacing_y;
+  }
+
+  unsigned int getBinsX() const {
+    return bins_x;
+  }
+  unsigned int getBinsY() const {
+    return bins_y;
+  }
+  /**
+   * @returns the distance of two consecutive rows in number of values
+   */
+  unsigned int getStride() const {
+    return stride;
+  }
+
+  T* data() {
+    return values;
+  }
+  const T* data() const {
+    return values;
+  }
+
+  T* row(unsigned int ix) {
+    return values + ix * stride;
+  }
+  const T* row(unsigned int ix) const {
+    return values + ix * stride;
+  }
+
+  /**
+   * Unchecked access to the value of bin (ix, iy).
+   */
+  T& operator()(unsigned int ix, unsigned int iy) {
+    return values[ix * stride + iy];
+  }
+  const T& operator()(unsigned int ix, unsigned int iy) const {
+    return values[ix * stride + iy];
+  }
+
+  /**
+   * Access to the value of bin (ix, iy), which throws a std::out_of_range
+   * exception if the bin does not exist.
+   */
+  T& at(unsigned int ix, unsigned int iy) {
+    checkBin(ix, iy);
+    return values[ix * stride + iy];
+  }
+  const T& at(unsigned int ix, unsigned int iy) const {
+    checkBin(ix, iy);
+    return values[ix * stride + iy];
+  }
+
+  void checkBin(unsigned int ix, unsigned int iy) const {
+    if (ix >= bins_x || iy >= bins_y) {
+      std::stringstream message;
+      message << "Grid2D: bin (" << ix << ", " << iy
+          << ") is outside of the grid with " << bins_x << " x " << bins_y
+          << " bins!";
+      throw std::out_of_range(message.str());
+    }
+  }
+
+  void fill(T value) {
+    for (unsigned int ix = 0; ix < bins_x; ++ix)
+      std::fill(row(ix), row(ix) + bins_y, value);
+  }
+
+  /**
+   * @returns the value of the bin containing (x, y)
+   */
+  T evaluateConstant(mydouble x, mydouble y) const {
+    mydouble position_x(getPosition(0, x));
+    mydouble position_y(getPosition(1, y));
+    return isInside(position_x, position_y) ?
+        getValueOrZero(getLowerNode(0, position_x),
+            getLowerNode(1, position_y)) :
+        T(0);
+  }
+
+  /**
+   * @returns the bilinear interpolation of the bin centers around (x, y)
+   */
+  T evaluateBilinear(mydouble x, mydouble y) const {
+    mydouble position_x(getPosition(0, x));
+    mydouble position_y(getPosition(1, y));
+    bool inside(isInside(position_x, position_y));
+    // relative to the centers of the bins
+    position_x -= 0.5;
+    position_y -= 0.5;
+    int ix(getLowerNode(0, position_x));
+    int iy(getLowerNode(1, position_y));
+    mydouble fraction_x(position_x - ix);
+    mydouble fraction_y(position_y - iy);
+    T value((1.0 - fraction_x)
+        * ((1.0 - fraction_y) * getValueOrZero(ix, iy)
+            + fraction_y * getValueOrZero(ix, iy + 1))
+        + fraction_x
+            * ((1.0 - fraction_y) * getValueOrZero(ix + 1, iy)
+                + fraction_y * getValueOrZero(ix + 1, iy + 1)));
+    return inside ? value : T(0);
+  }
+
+  /**
+   * @returns the bicubic (catmull-rom) interpolation of the 4 x 4 bin
+   * centers around (x, y)
+   */
+  T evaluateBicubic(mydouble x, mydouble y) const {
+    mydouble position_x(getPosition(0, x));
+    mydouble position_y(getPosition(1, y));
+    bool inside(isInside(position_x, position_y));
+    position_x -= 0.5;
+    position_y -= 0.5;
+    int ix(getLowerNode(0, position_x));
+    int iy(getLowerNode(1, position_y));
+    mydouble weights_x[4];
+    mydouble weights_y[4];
+    getCubicWeights(position_x - ix, weights_x);
+    getCubicWeights(position_y - iy, weights_y);
+    T value(0);
+    for (int i = 0; i < 4; ++i) {
+      T column(0);
+      for (int j = 0; j < 4; ++j)
+        column += weights_y[j] * getValueOrZero(ix - 1 + i, iy - 1 + j);
+      value += weights_x[i] * column;
+    }
+    return inside ? value : T(0);
+  }
+
+  /**
+   * Batch version of #evaluateConstant(). The grid is evaluated at
+   * (xs[2i] - shift_x, xs[2i + 1] - shift_y).
+   */
+  void evaluateConstant(const mydouble *xs, unsigned int n, T *out,
+      mydouble shift_x = 0.0, mydouble shift_y = 0.0) const {
+    for (unsigned int i = 0; i < n; ++i)
+      out[i] = evaluateConstant(xs[2 * i] - shift_x, xs[2 * i + 1] - shift_y);
+  }
+
+  /**
+   * Batch version of #evaluateBilinear(), see #evaluateConstant().
+   */
+  void evaluateBilinear(const mydouble *xs, unsigned int n, T *out,
+      mydouble shift_x = 0.0, mydouble shift_y = 0.0) const {
+    for (unsigned int i = 0; i < n; ++i)
+      out[i] = evaluateBilinear(xs[2 * i] - shift_x, xs[2 * i + 1] - shift_y);
+  }
+
+  /**
+   * Batch version of #evaluateBicubic(), see #evaluateConstant().
+   */
+  void evaluateBicubic(const mydouble *xs, unsigned int n, T *out,
+      mydouble shift_x = 0.0, mydouble shift_y = 0.0) const {
+    for (unsigned int i = 0; i < n; ++i)
+      out[i] = evaluateBicubic(xs[2 * i] - shift_x, xs[2 * i + 1] - shift_y);
+  }
+};
+
+#endif /* GRID2D_H_ */
@@ -6,6 +6,10 @@
  */
 
 #include "Model.h"
+#include "ModelCloner.h"
+#include "FitTracer.h"
+
+#include <stdexcept>
 
 //#include <iostream>
 
@@ -69,11 +73,69 @@ std::pair<mydouble, mydouble> Model::getUncertaincy(const mydouble *x) const {
 	return std::make_pair(0.0, 0.0);
 }
 
+bool Model::hasParametrizedParameters() const {
+	return model_par_handler.hasParametrizationModels();
+}
+
+bool Model::hasParameterDerivatives() const {
+	return false;
+}
+
+bool Model::hasParameterDerivative(
+		const std::shared_ptr<ModelPar> &parameter) const {
+	return hasParameterDerivatives() || !dependsOnParameter(parameter);
+}
+
+bool Model::dependsOnParameter(
+		const std::shared_ptr<ModelPar> &parameter) const {
+	// parametrizations may connect to parameters outside of the set
+	if (model_par_handler.hasParametrizations())
+		return true;
+	for (unsigned int i = 0; i < submodel_list.size(); i++) {
+		if (submodel_list[i]->dependsOnParameter(parameter))
+			return true;
+	}
+	return model_par_handler.getModelParameterSet().containsModelParameter(
+			parameter);
+}
+
+void Model::evalParameterDerivatives(const mydouble *x,
+		const std::vector<std::shared_ptr<ModelPar> > &parameters,
+		mydouble *derivatives) const {
+	for (unsigned int i = 0; i < parameters.size(); ++i)
+		derivatives[i] = 0.0;
+}
+
+std::shared_ptr<Model> Model::cloneStructure(ModelCloner &cloner) const {
+	throw std::runtime_error(
+			"Model::cloneStructure: the model " + name + " does not support cloning!");
+}
+
+std::shared_ptr<Model> Model::clone() {
+	ModelCloner cloner;
+	std::shared_ptr<Model> copy(cloner.cloneModel(*this));
+	cloner.copyParameterStates();
+	copy->init();
+	return copy;
+}
+
 mydouble Model::evaluate(const mydouble *x) {
 	//executeParametrizationModels(x);
 	return eval(x);
 }
 
+void Model::evalBatch(const mydouble *xs, unsigned int n,
+		mydouble *out) const {
+	for (unsigned int i = 0; i < n; ++i) {
+		out[i] = eval(&xs[i * dimension]);
+	}
+}
+
+void Model::evaluateBatch(const mydouble *xs, unsigned int n, mydouble *out) {
+	LMDFIT_TRACE_AGGREGATED_SCOPE("evaluateBatch", name);
+	evalBatch(xs, n, out);
+}
+
 void Model::reinit() {
 	model_par_handler.reinitModelParametrizations();
 	initModelParameters();
@@ -122,6 +184,7 @@ void Model::updateModel() {
 	// update the model parameters that really appear in this model
 	model_par_handler.updateModelParameters();
 	// finally recalculate the domain of all models that construct this model
+	LMDFIT_TRACE_SCOPE("updateDomain", name);
 	updateDomain();
 }
 
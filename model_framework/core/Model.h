@@ -15,6 +15,8 @@
 #include <set>
 #include <string>
 
+class ModelCloner;
+
 /**
  * This defines the abstract structure of a Model.
  * In principle a model should generate the model parameters itself, and be able
@@ -47,6 +49,26 @@ protected:
 
 	void addModelToList(std::shared_ptr<Model> model);
 
+	/**
+	 * @returns true if some parameters of this model are set by
+	 * parametrizations. Their derivatives with respect to the free parameters
+	 * are not known, see #hasParameterDerivatives().
+	 */
+	bool hasParametrizedParameters() const;
+
+	/**
+	 * Creates a new instance of this model with the same configuration, whose
+	 * submodels are clones obtained from the cloner (see #ModelCloner::clone()).
+	 * The parameters of the new instance do not have to carry the values of
+	 * the original, these are copied by the cloner afterwards. Heavy inputs
+	 * that are not changed during a fit may be shared with the original. The
+	 * default implementation throws, so models have to override it to become
+	 * clonable.
+	 */
+	virtual std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
+	friend class ModelCloner;
+
 public:
 	/**
 	 * see #Model description
@@ -63,8 +85,56 @@ public:
 	 */
 	virtual mydouble eval(const mydouble *x) const =0;
 
+	/**
+	 * Evaluates this model at n points at once and writes the values to out.
+	 * The coordinates are stored point by point, so the coordinates of point i
+	 * start at xs[i * #getDimension()]. The default implementation calls
+	 * #eval() for each point. Models which are evaluated very often should
+	 * override it, so that parameter lookups and the dispatch are done once
+	 * per batch instead of once per point.
+	 */
+	virtual void evalBatch(const mydouble *xs, unsigned int n,
+			mydouble *out) const;
+
 	virtual std::pair<mydouble, mydouble> getUncertaincy(const mydouble *x) const;
 
+	/**
+	 * @returns true if this model implements #evalParameterDerivatives() for
+	 * all of its parameters. The default implementation returns false, so
+	 * that the minimizer falls back to numerical derivatives.
+	 */
+	virtual bool hasParameterDerivatives() const;
+
+	/**
+	 * @returns true if #evalParameterDerivatives() yields the derivative with
+	 * respect to this single parameter. That is the case if the model provides
+	 * all derivatives or does not depend on the parameter at all. Models which
+	 * only know some of their derivatives (e.g. the one of a linear scale
+	 * parameter) override this, so that the estimator can combine them with
+	 * numerical derivatives of the remaining parameters.
+	 */
+	virtual bool hasParameterDerivative(
+			const std::shared_ptr<ModelPar> &parameter) const;
+
+	/**
+	 * @returns false only if the parameter is neither part of the parameter
+	 * set of this model nor can enter through a parametrization of this model
+	 * or one of its submodels.
+	 */
+	bool dependsOnParameter(const std::shared_ptr<ModelPar> &parameter) const;
+
+	/**
+	 * Computes the partial derivatives of the model at x with respect to each
+	 * of the given parameters and writes them to derivatives in the same
+	 * order. Only the entries of parameters for which
+	 * #hasParameterDerivative() returns true are meaningful. The default
+	 * implementation sets all derivatives to zero, which is correct for the
+	 * parameters the model does not depend on.
+	 */
+	virtual void evalParameterDerivatives(const mydouble *x,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *derivatives) const;
+
 	/**
 	 * This function will be called by the fitter when an evaluation at a certain
 	 * position is made. It calls all of the ParametrizationModels that modify
@@ -73,6 +143,11 @@ public:
 	 */
 	mydouble evaluate(const mydouble *x);
 
+	/**
+	 * Batch version of #evaluate(), see #evalBatch()
+	 */
+	void evaluateBatch(const mydouble *xs, unsigned int n, mydouble *out);
+
 	virtual mydouble Integral(const std::vector<DataStructs::DimensionRange> &ranges
 			, mydouble precision) =0;
 
@@ -133,6 +208,17 @@ public:
 	 * this method will be called once the parameters have changes.
 	 */
 	virtual void updateDomain() =0;
+
+	/**
+	 * Creates a deep copy of this model, including all submodels, parameters
+	 * and parametrizations. Parameters shared between submodels of this model
+	 * are shared between the corresponding submodels of the copy as well, but
+	 * no parameter is shared with the original. The copy can therefore be
+	 * evaluated and fitted concurrently to the original, e.g. one copy per
+	 * thread. Large immutable inputs like resolution matrices and acceptance
+	 * grids are shared read-only between the original and the copy.
+	 */
+	std::shared_ptr<Model> clone();
 };
 
 #endif /* MODEL_H_ */
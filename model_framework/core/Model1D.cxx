@@ -6,6 +6,7 @@
  */
 
 #include "Model1D.h"
+#include "FitTracer.h"
 #include "operators1d/integration/IntegralStrategyGSL1D.h"
 
 Model1D::Model1D(std::string name_) :
@@ -18,6 +19,7 @@ Model1D::~Model1D() {
 
 mydouble Model1D::Integral(const std::vector<DataStructs::DimensionRange> &ranges,
 		mydouble precision) {
+	LMDFIT_TRACE_AGGREGATED_SCOPE("Integral", getName());
 	return integral_strategy->Integral(this, ranges[0].range_low,
 			ranges[0].range_high, precision);
 }
@@ -6,9 +6,12 @@
  */
 
 #include "Model2D.h"
+#include "FitTracer.h"
 
 #include "operators2d/integration/IntegralStrategyGSL2D.h"
 
+#include <stdexcept>
+
 Model2D::Model2D(std::string name_) :
 		Model(name_, 2), var1_domain_bounds(), var2_domain_bounds(), integral_strategy(
 				new IntegralStrategyGSL2D()) {
@@ -47,6 +50,20 @@ void Model2D::setIntegralStrategy(
 
 mydouble Model2D::Integral(const std::vector<DataStructs::DimensionRange> &ranges,
 		mydouble precision) {
+	LMDFIT_TRACE_AGGREGATED_SCOPE("Integral", getName());
+	if (hasAnalyticIntegral())
+		return AnalyticIntegral(ranges);
 	return integral_strategy->Integral(this, ranges,
 			precision);
 }
+
+bool Model2D::hasAnalyticIntegral() const {
+	return false;
+}
+
+mydouble Model2D::AnalyticIntegral(
+		const std::vector<DataStructs::DimensionRange> &ranges) const {
+	throw std::runtime_error(
+			"Model2D::AnalyticIntegral: model " + getName()
+					+ " has no closed form integral!");
+}
@@ -33,8 +33,27 @@ public:
 
 	void setIntegralStrategy(std::shared_ptr<IntegralStrategy2D> integral_strategy_);
 
+	/**
+	 * Integrates the model over the rectangle given by ranges. If the model
+	 * provides a closed form integral (see #hasAnalyticIntegral()), it is used
+	 * and the integral strategy as well as the precision are ignored.
+	 */
 	mydouble Integral(const std::vector<DataStructs::DimensionRange> &ranges
 			, mydouble precision);
+
+	/**
+	 * @returns true if #AnalyticIntegral() is implemented by this model. The
+	 * default implementation returns false.
+	 */
+	virtual bool hasAnalyticIntegral() const;
+
+	/**
+	 * Closed form integral of the model over the rectangle given by ranges.
+	 * Models which override it also have to override #hasAnalyticIntegral().
+	 * The default implementation throws.
+	 */
+	virtual mydouble AnalyticIntegral(
+			const std::vector<DataStructs::DimensionRange> &ranges) const;
 };
 
 #endif /* MODEL2D_H_ */
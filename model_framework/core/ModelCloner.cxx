@@ -0,0 +1,92 @@
+/*
+ * ModelCloner.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ModelCloner.h"
+
+ModelCloner::ModelCloner() {
+}
+
+ModelCloner::~ModelCloner() {
+}
+
+std::shared_ptr<Model> ModelCloner::cloneModel(Model &original) {
+  auto const cloned_model = cloned_models.find(&original);
+  if (cloned_model != cloned_models.end())
+    return cloned_model->second;
+
+  std::shared_ptr<Model> copy(original.cloneStructure(*this));
+  cloned_models[&original] = copy;
+
+  // the models of the parametrization models are cloned here, so that their
+  // parameters are known when the parameter sets are linked
+  copy->getModelParameterHandler().cloneParametrizations(
+      original.getModelParameterHandler(), *this);
+  linkParameters(original, *copy);
+  return copy;
+}
+
+void ModelCloner::linkParameters(Model &original, Model &copy) {
+  auto &original_map = original.getModelParameterSet().getModelParameterMap();
+  auto &copy_map = copy.getModelParameterSet().getModelParameterMap();
+
+  bool reassigned(false);
+  for (auto const &entry : original_map) {
+    const ModelPar *original_par = entry.second.get();
+    auto cloned_par = cloned_parameters.find(original_par);
+    auto copy_entry = copy_map.find(entry.first);
+
+    if (copy_entry == copy_map.end()) {
+      // the parameter was added to the original after its construction, e.g.
+      // an injected parameter of another model
+      if (cloned_par == cloned_parameters.end()) {
+        cloned_par = cloned_parameters.insert(
+            std::make_pair(original_par,
+                std::make_shared<ModelPar>(original_par->getName(), 0.0,
+                    true))).first;
+      }
+      copy_map[entry.first] = cloned_par->second;
+    }
+    else if (cloned_par == cloned_parameters.end()) {
+      cloned_parameters[original_par] = copy_entry->second;
+    }
+    else if (cloned_par->second != copy_entry->second) {
+      // the parameter is shared with another model in the original, but the
+      // constructors did not share it in the copy (e.g. superior parameters
+      // which are declared after the construction)
+      copy_entry->second = cloned_par->second;
+      reassigned = true;
+    }
+  }
+  // keys of parameters which were reassigned in the original before they
+  // were added to this model
+  for (auto copy_entry = copy_map.begin(); copy_entry != copy_map.end();) {
+    if (original_map.find(copy_entry->first) == original_map.end())
+      copy_entry = copy_map.erase(copy_entry);
+    else
+      ++copy_entry;
+  }
+  // same as in Model::addModelToList(): the model and its parametrizations
+  // have to fetch the reassigned parameters again
+  if (reassigned)
+    copy.reinit();
+}
+
+std::shared_ptr<Parametrization> ModelCloner::cloneParametrization(
+    const Parametrization &parametrization, ModelParSet &model_par_set) {
+  auto const cloned_parametrization = cloned_parametrizations.find(
+      &parametrization);
+  if (cloned_parametrization != cloned_parametrizations.end())
+    return cloned_parametrization->second;
+
+  std::shared_ptr<Parametrization> copy(parametrization.clone(model_par_set));
+  cloned_parametrizations[&parametrization] = copy;
+  return copy;
+}
+
+void ModelCloner::copyParameterStates() {
+  for (auto const &cloned_par : cloned_parameters)
+    cloned_par.second->copyStateFrom(*cloned_par.first);
+}
@@ -0,0 +1,66 @@
+/*
+ * ModelCloner.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MODELCLONER_H_
+#define MODELCLONER_H_
+
+#include "Model.h"
+
+#include <map>
+#include <memory>
+
+/**
+ * Creates deep copies of model graphs, see #Model::clone().
+ *
+ * Every model of the graph is cloned exactly once: a model which appears
+ * several times in the graph (e.g. the 1D dpm model used by several 2D
+ * models) is represented by a single clone as well. The same holds for the
+ * parameters, so parameters shared between models of the original graph are
+ * shared between the corresponding clones. The clones do not share any
+ * parameter with the original graph.
+ *
+ * The structure of each model is rebuilt by #Model::cloneStructure(), which
+ * runs the constructors again. Afterwards the parameter sets of the clone are
+ * linked like the ones of the original, and the parametrizations are cloned.
+ * Once all models are cloned, #copyParameterStates() copies the values and
+ * flags of the original parameters.
+ */
+class ModelCloner {
+  std::map<const Model*, std::shared_ptr<Model> > cloned_models;
+  std::map<const ModelPar*, std::shared_ptr<ModelPar> > cloned_parameters;
+  std::map<const Parametrization*, std::shared_ptr<Parametrization> > cloned_parametrizations;
+
+  void linkParameters(Model &original, Model &copy);
+
+public:
+  ModelCloner();
+  virtual ~ModelCloner();
+
+  /**
+   * @returns the clone of original, which is created if it does not exist yet
+   */
+  std::shared_ptr<Model> cloneModel(Model &original);
+
+  template<class T> std::shared_ptr<T> clone(
+      const std::shared_ptr<T> &original) {
+    return std::dynamic_pointer_cast<T>(cloneModel(*original));
+  }
+
+  /**
+   * @returns the clone of parametrization working on model_par_set, which is
+   * created if it does not exist yet
+   */
+  std::shared_ptr<Parametrization> cloneParametrization(
+      const Parametrization &parametrization, ModelParSet &model_par_set);
+
+  /**
+   * Copies the values and flags of all original parameters to their clones.
+   * Has to be called once after all models are cloned.
+   */
+  void copyParameterStates();
+};
+
+#endif /* MODELCLONER_H_ */
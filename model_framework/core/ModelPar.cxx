@@ -97,3 +97,15 @@ void ModelPar::setConnectionTo(const std::shared_ptr<ModelPar> &model_par) {
 std::set<std::shared_ptr<ModelPar> >& ModelPar::getParameterConnections() {
 	return connections;
 }
+
+void ModelPar::copyStateFrom(const ModelPar &model_par) {
+	value = model_par.value;
+	lower_bound = model_par.lower_bound;
+	upper_bound = model_par.upper_bound;
+	fixed = model_par.fixed;
+	superior = model_par.superior;
+	set = model_par.set;
+	locked = model_par.locked;
+	bounded = model_par.bounded;
+	modified = model_par.modified;
+}
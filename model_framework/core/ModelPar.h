@@ -70,6 +70,13 @@ public:
 
   std::set<std::shared_ptr<ModelPar> >& getParameterConnections();
 
+  /**
+   * Copies value, bounds and all flags of model_par to this parameter. The
+   * connections are not copied, as they are set up by the parametrizations
+   * working on this parameter (used by the #ModelCloner).
+   */
+  void copyStateFrom(const ModelPar &model_par);
+
 };
 
 #endif /* MODELPAR_H_ */
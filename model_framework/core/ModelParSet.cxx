@@ -119,6 +119,17 @@ bool ModelParSet::modelParameterExists(
 	}
 }
 
+bool ModelParSet::containsModelParameter(
+		const std::shared_ptr<ModelPar> &model_par) const {
+	for (std::map<std::pair<std::string, std::string>, std::shared_ptr<ModelPar>,
+			ModelStructs::stringpair_comp>::const_iterator it =
+			model_par_map.begin(); it != model_par_map.end(); it++) {
+		if (it->second == model_par)
+			return true;
+	}
+	return false;
+}
+
 int ModelParSet::addModelParameters(ModelParSet &daughter_model_par_set) {
 	int num_pars_reassigned = 0;
 	// loop over all parameters to be added
@@ -46,6 +46,12 @@ public:
 			const std::pair<std::string, std::string> &name_) const;
 	bool modelParameterExists(const std::shared_ptr<ModelPar> &model_par) const;
 	bool modelParameterExists(const std::string &name_) const;
+	/**
+	 * In contrast to #modelParameterExists this checks for the parameter
+	 * object itself, which also finds parameters of daughter models.
+	 */
+	bool containsModelParameter(
+			const std::shared_ptr<ModelPar> &model_par) const;
 
 	void printInfo() const;
 
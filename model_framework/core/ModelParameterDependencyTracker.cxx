@@ -0,0 +1,105 @@
+/*
+ * ModelParameterDependencyTracker.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ModelParameterDependencyTracker.h"
+
+ModelParameterDependencyTracker::ModelParameterDependencyTracker() :
+    scale_parameter_name(""), computed_scale(0.0), valid(false) {
+}
+
+ModelParameterDependencyTracker::~ModelParameterDependencyTracker() {
+}
+
+bool ModelParameterDependencyTracker::isScaleParameter(
+    const std::pair<std::string, std::string> &parameter_name) const {
+  return scale_parameter_name != ""
+      && parameter_name.second.compare(scale_parameter_name) == 0;
+}
+
+void ModelParameterDependencyTracker::setScaleParameterName(
+    const std::string &scale_parameter_name_) {
+  scale_parameter_name = scale_parameter_name_;
+  invalidate();
+}
+
+const std::string& ModelParameterDependencyTracker::getScaleParameterName() const {
+  return scale_parameter_name;
+}
+
+bool ModelParameterDependencyTracker::isScaleParameter(
+    ModelParSet &dependencies,
+    const std::shared_ptr<ModelPar> &parameter) const {
+  for (auto const& model_par : dependencies.getModelParameterMap()) {
+    if (model_par.second == parameter && isScaleParameter(model_par.first))
+      return true;
+  }
+  return false;
+}
+
+ModelParameterDependencyTracker::UpdateType ModelParameterDependencyTracker::checkForUpdate(
+    ModelParSet &dependencies) const {
+  if (!valid)
+    return FULL_UPDATE;
+
+  bool scale_changed(false);
+  unsigned int number_of_parameters(0);
+  for (auto const& model_par : dependencies.getModelParameterMap()) {
+    if (isScaleParameter(model_par.first)) {
+      if (model_par.second->getValue() != computed_scale)
+        scale_changed = true;
+      continue;
+    }
+    ++number_of_parameters;
+    auto computed_value = computed_parameter_values.find(
+        model_par.second.get());
+    if (computed_value == computed_parameter_values.end()
+        || computed_value->second != model_par.second->getValue())
+      return FULL_UPDATE;
+  }
+  // the parameter set itself has changed
+  if (number_of_parameters != computed_parameter_values.size())
+    return FULL_UPDATE;
+
+  if (scale_changed) {
+    // a cache computed with a vanishing scale cannot be rescaled
+    if (computed_scale == 0.0)
+      return FULL_UPDATE;
+    return RESCALE;
+  }
+  return NO_UPDATE;
+}
+
+mydouble ModelParameterDependencyTracker::getScaleFactor(
+    ModelParSet &dependencies) const {
+  for (auto const& model_par : dependencies.getModelParameterMap()) {
+    if (isScaleParameter(model_par.first))
+      return model_par.second->getValue() / computed_scale;
+  }
+  return 1.0;
+}
+
+mydouble ModelParameterDependencyTracker::getScaleFactorDerivative() const {
+  if (computed_scale == 0.0)
+    return 0.0;
+  return 1.0 / computed_scale;
+}
+
+void ModelParameterDependencyTracker::markComputed(ModelParSet &dependencies) {
+  computed_parameter_values.clear();
+  computed_scale = 1.0;
+  for (auto const& model_par : dependencies.getModelParameterMap()) {
+    if (isScaleParameter(model_par.first))
+      computed_scale = model_par.second->getValue();
+    else
+      computed_parameter_values[model_par.second.get()] =
+          model_par.second->getValue();
+  }
+  valid = true;
+}
+
+void ModelParameterDependencyTracker::invalidate() {
+  valid = false;
+}
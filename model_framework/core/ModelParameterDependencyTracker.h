@@ -0,0 +1,97 @@
+/*
+ * ModelParameterDependencyTracker.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MODELPARAMETERDEPENDENCYTRACKER_H_
+#define MODELPARAMETERDEPENDENCYTRACKER_H_
+
+#include "ModelParSet.h"
+
+#include <map>
+#include <string>
+
+/**
+ * Keeps track of the model parameter values a cached computation stage (for
+ * example a model grid) was computed with. On each model update the stage
+ * can then ask via #checkForUpdate() whether its cache is still valid, has
+ * to be recomputed or only has to be rescaled.
+ *
+ * A stage can declare one of its parameters as a linear scale parameter
+ * (see #setScaleParameterName()), i.e. the cached quantity is directly
+ * proportional to it. A change of only this parameter then does not require
+ * a recomputation, but only a rescaling with #getScaleFactor().
+ */
+class ModelParameterDependencyTracker {
+public:
+  enum UpdateType {
+    NO_UPDATE, RESCALE, FULL_UPDATE
+  };
+
+private:
+  std::string scale_parameter_name;
+
+  /**
+   * Values of the parameters (except the scale parameter) at the time of the
+   * last #markComputed() call.
+   */
+  std::map<const ModelPar*, mydouble> computed_parameter_values;
+  mydouble computed_scale;
+  bool valid;
+
+  bool isScaleParameter(
+      const std::pair<std::string, std::string> &parameter_name) const;
+
+public:
+  ModelParameterDependencyTracker();
+  virtual ~ModelParameterDependencyTracker();
+
+  void setScaleParameterName(const std::string &scale_parameter_name_);
+  const std::string& getScaleParameterName() const;
+
+  /**
+   * @returns true if parameter is the declared scale parameter within the
+   * dependencies. The cached quantity is proportional to it, so its
+   * derivative is the cache times #getScaleFactorDerivative().
+   */
+  bool isScaleParameter(ModelParSet &dependencies,
+      const std::shared_ptr<ModelPar> &parameter) const;
+
+  /**
+   * Compares the current values of the dependencies with the ones at the
+   * time of the last #markComputed() call.
+   * @returns #NO_UPDATE if nothing changed, #RESCALE if only the scale
+   * parameter changed and #FULL_UPDATE otherwise or if the stage was never
+   * computed/invalidated.
+   */
+  UpdateType checkForUpdate(ModelParSet &dependencies) const;
+
+  /**
+   * Returns the ratio of the current value of the scale parameter and its
+   * value at the last #markComputed() call.
+   */
+  mydouble getScaleFactor(ModelParSet &dependencies) const;
+
+  /**
+   * Returns the derivative of the scale factor with respect to the scale
+   * parameter, i.e. one over its value at the last #markComputed() call.
+   * A cache computed with a vanishing scale carries no information about its
+   * slope, in which case 0 is returned.
+   */
+  mydouble getScaleFactorDerivative() const;
+
+  /**
+   * Stores the current values of the dependencies. Has to be called after
+   * the stage was (fully) recomputed.
+   */
+  void markComputed(ModelParSet &dependencies);
+
+  /**
+   * Forces a #FULL_UPDATE on the next check, for example if an input of the
+   * stage changed that is not described by model parameters.
+   */
+  void invalidate();
+};
+
+#endif /* MODELPARAMETERDEPENDENCYTRACKER_H_ */
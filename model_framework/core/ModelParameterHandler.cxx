@@ -7,6 +7,7 @@
 
 #include "ModelParameterHandler.h"
 #include "Model.h"
+#include "ModelCloner.h"
 
 #include <iostream>
 
@@ -22,6 +23,10 @@ ModelParSet& ModelParameterHandler::getModelParameterSet() {
 	return model_par_set;
 }
 
+const ModelParSet& ModelParameterHandler::getModelParameterSet() const {
+	return model_par_set;
+}
+
 int ModelParameterHandler::checkParametrizations() const {
 	int error_code = 0;
 
@@ -43,6 +48,10 @@ int ModelParameterHandler::checkParametrizations() const {
 	return error_code;
 }
 
+bool ModelParameterHandler::hasParametrizations() const {
+	return !parametrizations.empty();
+}
+
 bool ModelParameterHandler::hasParametrizationModels() const {
 	for (std::map<const std::shared_ptr<ModelPar>, ParametrizationProxy>::const_iterator it =
 			parametrizations.begin(); it != parametrizations.end(); it++) {
@@ -212,3 +221,28 @@ void ModelParameterHandler::initModelParametersFromFitResult(
 		}
 	}
 }
+
+void ModelParameterHandler::cloneParametrizations(
+		ModelParameterHandler &original, ModelCloner &cloner) {
+	for (std::map<const std::shared_ptr<ModelPar>, ParametrizationProxy>::iterator it =
+			original.parametrizations.begin(); it != original.parametrizations.end();
+			it++) {
+		// parametrizations are only registered for parameters of the model itself,
+		// so the clone owns a parameter with the same name
+		std::shared_ptr<ModelPar> model_par = model_par_set.getModelParameter(
+				it->first->getName());
+		if (it->second.hasParametrization()) {
+			parametrizations[model_par].setParametrization(
+					cloner.cloneParametrization(*it->second.getParametrization(),
+							model_par_set));
+		} else if (it->second.hasParametrizationModel()) {
+			std::shared_ptr<ParametrizationModel> parametrization_model(
+					new ParametrizationModel(
+							cloner.clone(
+									it->second.getParametrizationModel()->getModel())));
+			parametrization_model->setModelPar(model_par);
+			parametrizations[model_par].setParametrizationModel(
+					parametrization_model);
+		}
+	}
+}
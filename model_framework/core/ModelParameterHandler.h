@@ -17,6 +17,8 @@
 #include <map>
 #include <set>
 
+class ModelCloner;
+
 class ModelParameterHandler {
 private:
 	/**
@@ -40,9 +42,12 @@ public:
 	virtual ~ModelParameterHandler();
 
 	ModelParSet& getModelParameterSet();
+	const ModelParSet& getModelParameterSet() const;
 
 	int checkParametrizations() const;
 
+	bool hasParametrizations() const;
+
 	bool hasParametrizationModels() const;
 
 	int checkParameters();
@@ -73,6 +78,15 @@ public:
 	void updateModelParameters();
 
 	void initModelParametersFromFitResult(const ModelFitResult &fit_result);
+
+	/**
+	 * Registers copies of all parametrizations of the original handler for the
+	 * corresponding parameters of this handler, which belongs to a clone of
+	 * the model of the original handler. The models of the parametrization
+	 * models are cloned with the cloner as well.
+	 */
+	void cloneParametrizations(ModelParameterHandler &original,
+			ModelCloner &cloner);
 };
 
 #endif /* MODELPARAMETERHANDLER_H_ */
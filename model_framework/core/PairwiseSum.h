@@ -0,0 +1,80 @@
+/*
+ * PairwiseSum.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef PAIRWISESUM_H_
+#define PAIRWISESUM_H_
+
+#include "ProjectWideSettings.h"
+
+/**
+ * Streaming pairwise (cascade) summation with a fixed tree shape.
+ *
+ * The values are added one by one. Level k holds the sum of a block of 2^k
+ * consecutive values, and two blocks of the same level are merged as soon as
+ * both are complete, like the carry of a binary counter. The rounding error
+ * therefore grows only logarithmically with the number of values, and the
+ * order of all additions depends on nothing but the sequence of values. Two
+ * sums over the same sequence are bitwise identical, no matter how the work
+ * around them is split up. No memory is allocated, so an instance can live
+ * on the stack of a hot loop.
+ */
+class PairwiseSum {
+  // enough levels for any unsigned long long number of values
+  mydouble partial_sums[64];
+  unsigned long long number_of_values;
+
+public:
+  PairwiseSum() :
+      number_of_values(0) {
+  }
+
+  void reset() {
+    number_of_values = 0;
+  }
+
+  void add(mydouble value) {
+    // the set low bits of the counter are the completed blocks that merge
+    // with the new value
+    unsigned int level(0);
+    for (unsigned long long n = number_of_values; n & 1; n >>= 1, ++level)
+      value = partial_sums[level] + value;
+    partial_sums[level] = value;
+    ++number_of_values;
+  }
+
+  /**
+   * @returns the sum of all values added so far. The incomplete blocks are
+   * combined from the smallest to the largest one.
+   */
+  mydouble sum() const {
+    mydouble result(0.0);
+    bool first(true);
+    unsigned int level(0);
+    for (unsigned long long n = number_of_values; n != 0; n >>= 1, ++level) {
+      if (n & 1) {
+        result = (first ? partial_sums[level] : partial_sums[level] + result);
+        first = false;
+      }
+    }
+    return result;
+  }
+
+  unsigned long long size() const {
+    return number_of_values;
+  }
+
+  /**
+   * Pairwise sum of the first size elements of values.
+   */
+  static mydouble sum(const mydouble *values, unsigned int size) {
+    PairwiseSum pairwise_sum;
+    for (unsigned int i = 0; i < size; ++i)
+      pairwise_sum.add(values[i]);
+    return pairwise_sum.sum();
+  }
+};
+
+#endif /* PAIRWISESUM_H_ */
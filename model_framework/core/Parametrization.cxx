@@ -7,6 +7,8 @@
 
 #include "Parametrization.h"
 
+#include <stdexcept>
+
 Parametrization::Parametrization(ModelParSet &model_par_set_) :
     model_par_set(model_par_set_), dependency_parameters() {
 }
@@ -27,3 +29,9 @@ int Parametrization::check() const {
   }
   return 0;
 }
+
+std::shared_ptr<Parametrization> Parametrization::clone(
+    ModelParSet &model_par_set_) const {
+  throw std::runtime_error(
+      "Parametrization::clone: this parametrization does not support cloning!");
+}
@@ -49,6 +49,15 @@ public:
 
   virtual void parametrize() =0;
 
+  /**
+   * Creates the same parametrization working on model_par_set_, which is the
+   * parameter set of a cloned model (see #ModelCloner). The default
+   * implementation throws, so parametrizations have to override it to make
+   * their models clonable.
+   */
+  virtual std::shared_ptr<Parametrization> clone(
+      ModelParSet &model_par_set_) const;
+
   int check() const;
 };
 
@@ -0,0 +1,102 @@
+/*
+ * WorkerPool.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int number_of_threads) :
+    nthreads(number_of_threads > 0 ? number_of_threads : 1), current_task(0), current_number_of_tasks(
+        0), generation(0), busy_workers(0), shutdown(false), worker_exceptions(
+        nthreads) {
+  for (unsigned int i = 1; i < nthreads; ++i) {
+    workers.create_thread(boost::bind(&WorkerPool::workerLoop, this, i));
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    boost::lock_guard<boost::mutex> lock(mtx);
+    shutdown = true;
+  }
+  start_condition.notify_all();
+  workers.join_all();
+}
+
+unsigned int WorkerPool::getNumberOfThreads() const {
+  return nthreads;
+}
+
+void WorkerPool::processTasks(unsigned int worker_index, const Task &task,
+    unsigned int number_of_tasks) {
+  try {
+    for (unsigned int i = worker_index; i < number_of_tasks; i += nthreads)
+      task(i);
+  }
+  catch (...) {
+    worker_exceptions[worker_index] = std::current_exception();
+  }
+}
+
+void WorkerPool::workerLoop(unsigned int worker_index) {
+  unsigned long seen_generation(0);
+  while (true) {
+    const Task *task;
+    unsigned int number_of_tasks;
+    {
+      boost::unique_lock<boost::mutex> lock(mtx);
+      while (!shutdown && generation == seen_generation)
+        start_condition.wait(lock);
+      if (shutdown)
+        return;
+      seen_generation = generation;
+      task = current_task;
+      number_of_tasks = current_number_of_tasks;
+    }
+
+    processTasks(worker_index, *task, number_of_tasks);
+
+    {
+      boost::lock_guard<boost::mutex> lock(mtx);
+      --busy_workers;
+    }
+    finished_condition.notify_one();
+  }
+}
+
+void WorkerPool::run(const Task &task, unsigned int number_of_tasks) {
+  if (nthreads == 1 || number_of_tasks == 1) {
+    for (unsigned int i = 0; i < number_of_tasks; ++i)
+      task(i);
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(mtx);
+    current_task = &task;
+    current_number_of_tasks = number_of_tasks;
+    busy_workers = nthreads - 1;
+    ++generation;
+  }
+  start_condition.notify_all();
+
+  // the calling thread takes the share of worker 0
+  processTasks(0, task, number_of_tasks);
+
+  {
+    boost::unique_lock<boost::mutex> lock(mtx);
+    while (busy_workers > 0)
+      finished_condition.wait(lock);
+    current_task = 0;
+  }
+
+  for (unsigned int i = 0; i < worker_exceptions.size(); ++i) {
+    if (worker_exceptions[i]) {
+      std::exception_ptr e(worker_exceptions[i]);
+      for (unsigned int j = i; j < worker_exceptions.size(); ++j)
+        worker_exceptions[j] = std::exception_ptr();
+      std::rethrow_exception(e);
+    }
+  }
+}
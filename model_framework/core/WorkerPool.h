@@ -0,0 +1,75 @@
+/*
+ * WorkerPool.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <exception>
+#include <functional>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+/**
+ * Long-lived pool of worker threads with a barrier style fork/join.
+ *
+ * The threads are created once in the constructor and then sleep on a
+ * condition variable between calls to #run(). A call to #run() wakes all
+ * workers, lets every worker (including the calling thread, which acts as
+ * worker 0) process its share of the tasks and returns only after all tasks
+ * have finished. Nothing is allocated per call, so the pool is suited for
+ * code paths that are executed for every minimizer iteration.
+ */
+class WorkerPool {
+public:
+  typedef std::function<void(unsigned int)> Task;
+
+private:
+  unsigned int nthreads;
+  boost::thread_group workers;
+
+  boost::mutex mtx;
+  boost::condition_variable start_condition;
+  boost::condition_variable finished_condition;
+
+  const Task *current_task;
+  unsigned int current_number_of_tasks;
+  // incremented for each call to run(), so workers can tell new work apart
+  // from spurious wakeups
+  unsigned long generation;
+  unsigned int busy_workers;
+  bool shutdown;
+
+  std::vector<std::exception_ptr> worker_exceptions;
+
+  void workerLoop(unsigned int worker_index);
+  void processTasks(unsigned int worker_index, const Task &task,
+      unsigned int number_of_tasks);
+
+  WorkerPool(const WorkerPool &);
+  WorkerPool& operator=(const WorkerPool &);
+
+public:
+  /**
+   * @param number_of_threads total number of threads taking part in #run(),
+   * the calling thread included. Hence number_of_threads - 1 additional
+   * threads are spawned.
+   */
+  WorkerPool(unsigned int number_of_threads);
+  virtual ~WorkerPool();
+
+  unsigned int getNumberOfThreads() const;
+
+  /**
+   * Executes task(i) for all i in [0, number_of_tasks). Task i is processed
+   * by worker i % #nthreads, so the assignment of tasks to threads is fixed.
+   * Blocks until all tasks are done. If a task throws, the first exception
+   * is rethrown in the calling thread after all workers finished.
+   */
+  void run(const Task &task, unsigned int number_of_tasks);
+};
+
+#endif /* WORKERPOOL_H_ */
@@ -10,7 +10,7 @@
 #include <iostream>
 
 EstimatorOptions::EstimatorOptions() :
-		with_integral_scaling(true), fit_range_x(), fit_range_y() {
+		with_integral_scaling(true), profiled_scale_parameter_name(""), fit_range_x(), fit_range_y() {
 }
 
 EstimatorOptions::~EstimatorOptions() {
@@ -25,6 +25,15 @@ void EstimatorOptions::setWithIntegralScaling(bool with_integral_scaling_) {
 	with_integral_scaling = with_integral_scaling_;
 }
 
+const std::string& EstimatorOptions::getProfiledScaleParameterName() const {
+	return profiled_scale_parameter_name;
+}
+
+void EstimatorOptions::setProfiledScaleParameterName(
+		const std::string& profiled_scale_parameter_name_) {
+	profiled_scale_parameter_name = profiled_scale_parameter_name_;
+}
+
 const DataStructs::DimensionRange& EstimatorOptions::getFitRangeX() const {
 	return fit_range_x;
 }
@@ -47,6 +56,11 @@ bool EstimatorOptions::operator<(const EstimatorOptions &rhs) const {
 	else if (with_integral_scaling > rhs.isWithIntegralScaling())
 		return false;
 
+	if (profiled_scale_parameter_name < rhs.getProfiledScaleParameterName())
+		return true;
+	else if (profiled_scale_parameter_name > rhs.getProfiledScaleParameterName())
+		return false;
+
 	if (fit_range_x < rhs.getFitRangeX())
 		return true;
 	else if (fit_range_x > rhs.getFitRangeX())
@@ -82,5 +96,9 @@ std::ostream& operator<<(std::ostream& os,
 		os << "secondary dimension upper fit range: "
 				<< est_options.getFitRangeY().range_high << std::endl;
 	}
+	if (est_options.getProfiledScaleParameterName() != "") {
+		os << "analytically profiled parameter: "
+				<< est_options.getProfiledScaleParameterName() << std::endl;
+	}
 	return os;
 }
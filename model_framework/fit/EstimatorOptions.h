@@ -10,11 +10,16 @@
 
 #include "fit/data/DataStructs.h"
 
+#include <string>
 #include <utility>
 
 class EstimatorOptions {
 		bool with_integral_scaling;
 
+		// name of the model parameter that is profiled analytically, empty if
+		// no parameter is profiled
+		std::string profiled_scale_parameter_name;
+
 		DataStructs::DimensionRange fit_range_x;
 		DataStructs::DimensionRange fit_range_y;
 
@@ -24,6 +29,17 @@ class EstimatorOptions {
 		bool isWithIntegralScaling() const;
 		void setWithIntegralScaling(bool with_integral_scaling_);
 
+		const std::string& getProfiledScaleParameterName() const;
+		/**
+		 * Lets the estimator determine the model parameter with this name in
+		 * closed form at each evaluation, instead of leaving it to the
+		 * minimizer. The model has to be directly proportional to this
+		 * parameter (e.g. the luminosity). An empty name switches the
+		 * profiling off.
+		 */
+		void setProfiledScaleParameterName(
+				const std::string& profiled_scale_parameter_name_);
+
 		void setFitRangeX(DataStructs::DimensionRange& fit_range_);
 		void setFitRangeY(DataStructs::DimensionRange& fit_range_);
 
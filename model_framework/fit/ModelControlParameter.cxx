@@ -7,6 +7,8 @@
 
 #include "ModelControlParameter.h"
 
+#include <stdexcept>
+
 ModelControlParameter::ModelControlParameter() {
 	// TODO Auto-generated constructor stub
 
@@ -19,3 +21,31 @@ ModelControlParameter::~ModelControlParameter() {
 vector<ModelStructs::minimization_parameter>& ModelControlParameter::getParameterList() {
 	return parameters;
 }
+
+bool ModelControlParameter::providesGradient() const {
+	return false;
+}
+
+void ModelControlParameter::evaluateGradient(const mydouble *pars,
+		mydouble *gradient) {
+	throw std::runtime_error(
+			"ModelControlParameter::evaluateGradient: no gradient available!");
+}
+
+bool ModelControlParameter::providesResiduals() const {
+	return false;
+}
+
+bool ModelControlParameter::providesResidualJacobian() const {
+	return false;
+}
+
+unsigned int ModelControlParameter::getNumberOfResiduals() const {
+	return 0;
+}
+
+void ModelControlParameter::evaluateResiduals(const mydouble *pars,
+		mydouble *residuals, mydouble *jacobian) {
+	throw std::runtime_error(
+			"ModelControlParameter::evaluateResiduals: no residuals available!");
+}
@@ -24,6 +24,47 @@ public:
 
 	virtual mydouble evaluate(const mydouble *pars) =0;
 
+	/**
+	 * @returns true if #evaluateGradient() is implemented, so that minimizers
+	 * can use the analytic gradient instead of finite differences. The
+	 * default implementation returns false.
+	 */
+	virtual bool providesGradient() const;
+
+	/**
+	 * Computes the derivatives of #evaluate() with respect to the parameters
+	 * in the order of #getParameterList() and writes them to gradient. The
+	 * default implementation throws.
+	 */
+	virtual void evaluateGradient(const mydouble *pars, mydouble *gradient);
+
+	/**
+	 * @returns true if #evaluateResiduals() is implemented, i.e. #evaluate()
+	 * is a sum of squared residuals r_i (up to a constant) or behaves like
+	 * one to second order in the parameters. Least squares minimizers (e.g.
+	 * Levenberg-Marquardt) require this. The default implementation returns
+	 * false.
+	 */
+	virtual bool providesResiduals() const;
+	/**
+	 * @returns true if #evaluateResiduals() can also compute the jacobian of
+	 * the residuals. The default implementation returns false.
+	 */
+	virtual bool providesResidualJacobian() const;
+	/**
+	 * Number of residuals written by #evaluateResiduals(). The default
+	 * implementation returns 0.
+	 */
+	virtual unsigned int getNumberOfResiduals() const;
+	/**
+	 * Computes the residuals for the parameters and writes them to residuals.
+	 * If jacobian is not null, the derivatives dr_i/dp_j are written to it
+	 * row major (one row of #getParameterList().size() values per residual).
+	 * The default implementation throws.
+	 */
+	virtual void evaluateResiduals(const mydouble *pars, mydouble *residuals,
+			mydouble *jacobian);
+
 	vector<ModelStructs::minimization_parameter>& getParameterList();
 };
 
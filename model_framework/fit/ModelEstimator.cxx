@@ -8,18 +8,28 @@
 #include "ModelEstimator.h"
 #include "core/Model.h"
 #include "core/ModelPar.h"
+#include "core/FitTracer.h"
+#include "core/PairwiseSum.h"
 #include "fit/data/Data.h"
 
 #include <cmath>
-#include <thread>
-#include <future>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 
 ModelEstimator::ModelEstimator(bool allow_initial_normalization_) :
     free_parameters(), data(), fit_model(), estimator_options(), mtx(), nthreads(
         1), initial_estimator_value(0.0), allow_initial_normalization(
-        allow_initial_normalization_) {
+        allow_initial_normalization_), number_of_residuals(0), current_residuals(
+        0), current_jacobian(0) {
+  chunk_evaluation_task = std::bind(&ModelEstimator::evaluateChunk, this,
+      std::placeholders::_1);
+  chunk_profile_task = std::bind(&ModelEstimator::evaluateChunkProfileSums,
+      this, std::placeholders::_1);
+  chunk_gradient_task = std::bind(&ModelEstimator::evaluateChunkGradient,
+      this, std::placeholders::_1);
+  chunk_residual_task = std::bind(&ModelEstimator::evaluateChunkResiduals,
+      this, std::placeholders::_1);
 }
 
 ModelEstimator::~ModelEstimator() {
@@ -30,35 +40,162 @@ void ModelEstimator::setNumberOfThreads(unsigned int number_of_threads) {
   nthreads = number_of_threads;
   std::cout << "using multithreading with " << nthreads
       << " concurrent threads!" << std::endl;
-  if (chopped_data.size() != nthreads)
-    chopData();
+  if (nthreads > 1) {
+    if (!worker_pool || worker_pool->getNumberOfThreads() != nthreads)
+      worker_pool.reset(new WorkerPool(nthreads));
+  }
+  else
+    worker_pool.reset();
+}
+
+void ModelEstimator::runTask(const WorkerPool::Task &task,
+    unsigned int number_of_tasks) {
+  if (worker_pool) {
+    worker_pool->run(task, number_of_tasks);
+  }
+  else {
+    for (unsigned int i = 0; i < number_of_tasks; i++)
+      task(i);
+  }
+}
+
+void ModelEstimator::runChunkTask(const WorkerPool::Task &task) {
+  runTask(task, chopped_data.size());
 }
 
 void ModelEstimator::chopData() {
-  // chop data into bunches
-  if (nthreads > 1 && data.get()) {
-    std::cout << "chopping data into " << nthreads << " bunches" << std::endl;
-    chopped_data.clear();
-    unsigned int data_points_per_bunch = data->getNumberOfUsedDataPoints()
-        / nthreads + 1;
-    std::vector<DataPointProxy> &data_points = data->getData();
-    std::shared_ptr<Data> bunch(new Data(data->getDimension()));
-    std::vector<DataPointProxy>::iterator data_point_iter;
-    unsigned int counter = 1;
-    for (data_point_iter = data_points.begin();
-        data_point_iter != data_points.end(); data_point_iter++) {
-      if (counter > data_points_per_bunch) {
+  // chop data into bunches of a fixed size, which does not depend on the
+  // number of threads, so that the estimator value is always summed up in
+  // the same way
+  chopped_data.clear();
+  if (data.get()) {
+    // binned data: only the used bins are copied into the bunches
+    const BinnedDataSet &binned_data = data->getBinnedDataSet();
+    const unsigned char *used = binned_data.getUsedMask();
+    unsigned int bunch_begin(0);
+    unsigned int counter(0);
+    for (unsigned int i = 0; i < binned_data.size(); ++i) {
+      if (used[i])
+        ++counter;
+      if (counter == data_points_per_chunk
+          || (i + 1 == binned_data.size() && counter > 0)) {
+        std::shared_ptr<Data> bunch(new Data(data->getDimension()));
+        bunch->getBinnedDataSet().addDataPoints(binned_data, bunch_begin,
+            i + 1, true);
         chopped_data.push_back(bunch);
-        bunch.reset(new Data(data->getDimension()));
-        counter = 1;
+        bunch_begin = i + 1;
+        counter = 0;
       }
-      if (data_point_iter->isPointUsed()) {
-        bunch->insertData(*data_point_iter);
-        counter++;
+    }
+
+    // unbinned data: same for the events
+    const UnbinnedDataSet &unbinned_data = data->getUnbinnedDataSet();
+    const unsigned char *used_events = unbinned_data.getUsedMask();
+    bunch_begin = 0;
+    counter = 0;
+    for (unsigned int i = 0; i < unbinned_data.size(); ++i) {
+      if (used_events[i])
+        ++counter;
+      if (counter == data_points_per_chunk
+          || (i + 1 == unbinned_data.size() && counter > 0)) {
+        std::shared_ptr<Data> bunch(new Data(data->getDimension()));
+        bunch->getUnbinnedDataSet().addDataPoints(unbinned_data, bunch_begin,
+            i + 1, true);
+        chopped_data.push_back(bunch);
+        bunch_begin = i + 1;
+        counter = 0;
       }
     }
-    chopped_data.push_back(bunch);
+    chunk_estimator_values.resize(chopped_data.size());
+    chunk_profile_sums.resize(chopped_data.size());
+    chunk_gradients.resize(chopped_data.size());
+
+    // the bunches only contain used bins, so each of them contributes all
+    // of its bins as residuals
+    chunk_residual_offsets.resize(chopped_data.size());
+    number_of_residuals = 0;
+    for (unsigned int i = 0; i < chopped_data.size(); i++) {
+      chunk_residual_offsets[i] = number_of_residuals;
+      number_of_residuals += chopped_data[i]->getBinnedDataSet().size();
+    }
+  }
+}
+
+void ModelEstimator::evaluateChunk(unsigned int chunk_index) {
+  chunk_estimator_values[chunk_index] = eval(chopped_data[chunk_index]);
+}
+
+void ModelEstimator::evaluateChunkProfileSums(unsigned int chunk_index) {
+  chunk_profile_sums[chunk_index] = evalScaleProfileSums(
+      chopped_data[chunk_index]);
+}
+
+void ModelEstimator::evaluateChunkGradient(unsigned int chunk_index) {
+  std::vector<mydouble> &chunk_gradient = chunk_gradients[chunk_index];
+  chunk_gradient.assign(analytic_gradient_parameters.size(), 0.0);
+  evalGradient(chopped_data[chunk_index], analytic_gradient_parameters,
+      gradient_scale, chunk_gradient.data());
+}
+
+void ModelEstimator::evaluateChunkResiduals(unsigned int chunk_index) {
+  const unsigned int offset(chunk_residual_offsets[chunk_index]);
+  evalResiduals(chopped_data[chunk_index], gradient_parameters,
+      current_residuals + offset,
+      current_jacobian ?
+          current_jacobian + offset * gradient_parameters.size() : 0);
+}
+
+ModelEstimator::ScaleProfileSums ModelEstimator::calculateScaleProfileSums() {
+  ScaleProfileSums sums;
+  runChunkTask(chunk_profile_task);
+  for (unsigned int i = 0; i < chunk_profile_sums.size(); i++) {
+    sums += chunk_profile_sums[i];
   }
+  return sums;
+}
+
+ModelEstimator::ScaleProfileSums ModelEstimator::evalScaleProfileSums(
+    std::shared_ptr<Data> data) {
+  throw std::runtime_error(
+      "ModelEstimator::evalScaleProfileSums: this estimator does not support the profiling of a scale parameter!");
+}
+
+std::pair<mydouble, mydouble> ModelEstimator::calculateProfiledScale(
+    const ScaleProfileSums &sums) const {
+  throw std::runtime_error(
+      "ModelEstimator::calculateProfiledScale: this estimator does not support the profiling of a scale parameter!");
+}
+
+mydouble ModelEstimator::calculateProfiledEstimatorValue(
+    const ScaleProfileSums &sums) const {
+  throw std::runtime_error(
+      "ModelEstimator::calculateProfiledEstimatorValue: this estimator does not support the profiling of a scale parameter!");
+}
+
+mydouble ModelEstimator::evalDataIndependentTerm() {
+  return 0.0;
+}
+
+bool ModelEstimator::implementsGradient() const {
+  return false;
+}
+
+void ModelEstimator::evalGradient(std::shared_ptr<Data> data,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters, mydouble scale,
+    mydouble *gradient) {
+  throw std::runtime_error(
+      "ModelEstimator::evalGradient: this estimator does not provide a gradient!");
+}
+
+bool ModelEstimator::implementsResiduals() const {
+  return false;
+}
+
+void ModelEstimator::evalResiduals(std::shared_ptr<Data> data,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *residuals, mydouble *jacobian) {
+  throw std::runtime_error(
+      "ModelEstimator::evalResiduals: this estimator does not provide residuals!");
 }
 
 const std::shared_ptr<Model> ModelEstimator::getModel() const {
@@ -67,14 +204,102 @@ const std::shared_ptr<Model> ModelEstimator::getModel() const {
 
 void ModelEstimator::setModel(std::shared_ptr<Model> new_model) {
   fit_model = new_model;
+  profiled_scale_parameter.reset();
+
+  determineFreeParameters();
+}
 
+void ModelEstimator::determineFreeParameters() {
   // get list of all free parameters
   getParameterList().clear();
   free_parameters.clear();
+  gradient_parameters.clear();
   free_parameters = fit_model->getModelParameterSet().getFreeModelParameters();
+  // the profiled scale parameter is not handed to the minimizer
+  for (auto it = free_parameters.begin(); it != free_parameters.end();) {
+    if (it->second == profiled_scale_parameter)
+      it = free_parameters.erase(it);
+    else
+      ++it;
+  }
+  for (auto const& free_parameter : free_parameters)
+    gradient_parameters.push_back(free_parameter.second);
+
+  analytic_gradient_parameters.clear();
+  analytic_gradient_indices.clear();
+  numerical_gradient_indices.clear();
+  for (unsigned int i = 0; i < gradient_parameters.size(); i++) {
+    if (fit_model->hasParameterDerivative(gradient_parameters[i])) {
+      analytic_gradient_parameters.push_back(gradient_parameters[i]);
+      analytic_gradient_indices.push_back(i);
+    }
+    else
+      numerical_gradient_indices.push_back(i);
+  }
   insertParameters();
 }
 
+const std::map<std::pair<std::string, std::string>, std::shared_ptr<ModelPar>,
+    ModelStructs::stringpair_comp>& ModelEstimator::getFreeParameters() const {
+  return free_parameters;
+}
+
+bool ModelEstimator::isScaleParameterProfiled() const {
+  return (bool) profiled_scale_parameter;
+}
+
+ModelStructs::minimization_parameter ModelEstimator::getProfiledScaleParameter() const {
+  ModelStructs::minimization_parameter profiled_parameter(
+      profiled_scale_parameter_name);
+  if (profiled_scale_parameter) {
+    std::pair<mydouble, mydouble> scale = calculateProfiledScale(
+        last_profile_sums);
+    profiled_parameter.value = profiled_scale_parameter->getValue()
+        * scale.first;
+    profiled_parameter.error = profiled_scale_parameter->getValue()
+        * scale.second;
+  }
+  return profiled_parameter;
+}
+
+ModelStructs::minimization_parameter ModelEstimator::profileScaleParameter(
+    const mydouble *par, const std::vector<double> &covariance) {
+  evaluate(par);
+  ModelStructs::minimization_parameter profiled_parameter(
+      getProfiledScaleParameter());
+  const unsigned int n(gradient_parameters.size());
+  if (!profiled_scale_parameter || covariance.size() != n * n || n == 0)
+    return profiled_parameter;
+
+  // derivatives of the optimal scale with respect to the free parameters
+  std::vector<mydouble> shifted_par(par, par + n);
+  std::vector<double> derivatives(n, 0.0);
+  for (unsigned int i = 0; i < n; i++) {
+    double step(0.1 * std::sqrt(covariance[i * n + i]));
+    if (!(step > 0.0))
+      continue;
+    shifted_par[i] = par[i] + step;
+    evaluate(shifted_par.data());
+    double value_up(getProfiledScaleParameter().value);
+    shifted_par[i] = par[i] - step;
+    evaluate(shifted_par.data());
+    double value_down(getProfiledScaleParameter().value);
+    shifted_par[i] = par[i];
+    derivatives[i] = (value_up - value_down) / (2.0 * step);
+  }
+
+  double variance(profiled_parameter.error * profiled_parameter.error);
+  for (unsigned int i = 0; i < n; i++) {
+    for (unsigned int j = 0; j < n; j++)
+      variance += derivatives[i] * covariance[i * n + j] * derivatives[j];
+  }
+  profiled_parameter.error = std::sqrt(variance);
+
+  // leave the model and the profile sums at the requested parameters
+  evaluate(par);
+  return profiled_parameter;
+}
+
 const std::shared_ptr<Data> ModelEstimator::getData() const {
   return data;
 }
@@ -147,8 +372,33 @@ void ModelEstimator::updateFreeModelParameters(const mydouble *new_values) {
 
 void ModelEstimator::applyEstimatorOptions(
     const EstimatorOptions &estimator_options_) {
+  LMDFIT_TRACE_SCOPE("estimator", "ModelEstimator::applyEstimatorOptions");
   estimator_options = estimator_options_;
 
+  // determine the parameter which is profiled analytically
+  profiled_scale_parameter.reset();
+  const std::string &profiled_name =
+      estimator_options.getProfiledScaleParameterName();
+  if (profiled_name != "" && fit_model) {
+    for (auto const& model_par : fit_model->getModelParameterSet().getModelParameterMap()) {
+      if (model_par.first.second == profiled_name) {
+        profiled_scale_parameter = model_par.second;
+        profiled_scale_parameter_name = model_par.first;
+        break;
+      }
+    }
+    if (!profiled_scale_parameter)
+      throw std::runtime_error(
+          "ModelEstimator::applyEstimatorOptions: the profiled parameter "
+              + profiled_name + " is not a parameter of the model!");
+    // the closed form solution is relative to the current value
+    if (profiled_scale_parameter->getValue() == 0.0)
+      profiled_scale_parameter->setValue(1.0);
+    std::cout << "profiling " << profiled_name << " analytically" << std::endl;
+  }
+  if (fit_model)
+    determineFreeParameters();
+
   double combined_inner_radius_square(0.0);
   double combined_outer_radius_square(0.0);
   bool combined_fit_range_type(false);
@@ -162,85 +412,102 @@ void ModelEstimator::applyEstimatorOptions(
         estimator_options.getFitRangeX().range_high, 2);
   }
 
-  std::vector<DataPointProxy> &datapoints = data->getData();
-  for (unsigned int i = 0; i < datapoints.size(); i++) {
-    if (datapoints[i].isBinnedDataPoint()) {
-      std::shared_ptr<DataStructs::binned_data_point> data_point =
-          datapoints[i].getBinnedDataPoint();
-      // check fit ranges
-      if (combined_fit_range_type) {
-        double data_point_radius_squared(
-            std::pow(data_point->bin_center_value[0], 2)
-                + std::pow(data_point->bin_center_value[1], 2));
-        if (data_point_radius_squared < combined_inner_radius_square
-            || data_point_radius_squared > combined_outer_radius_square) {
-          datapoints[i].setPointUsed(false);
+  BinnedDataSet &binned_data = data->getBinnedDataSet();
+  const mydouble *x = binned_data.getX();
+  const mydouble *y = binned_data.getY();
+  const mydouble *bin_width_x = binned_data.getBinWidthX();
+  const mydouble *bin_width_y = binned_data.getBinWidthY();
+  mydouble *z = binned_data.getZ();
+  mydouble *z_error = binned_data.getZError();
+  mydouble *scale = binned_data.getScale();
+
+  for (unsigned int i = 0; i < binned_data.size(); i++) {
+    // check fit ranges
+    if (combined_fit_range_type) {
+      double data_point_radius_squared(std::pow(x[i], 2) + std::pow(y[i], 2));
+      if (data_point_radius_squared < combined_inner_radius_square
+          || data_point_radius_squared > combined_outer_radius_square) {
+        binned_data.setPointUsed(i, false);
+        continue;
+      }
+    }
+    else {
+      if (data->getDimension() > 0
+          && estimator_options.getFitRangeX().is_active) {
+        if (x[i] < estimator_options.getFitRangeX().range_low
+            || x[i] > estimator_options.getFitRangeX().range_high) {
+          binned_data.setPointUsed(i, false);
           continue;
         }
-      }
-      else {
-        if (data->getDimension() > 0
-            && estimator_options.getFitRangeX().is_active) {
-          if (data_point->bin_center_value[0]
-              < estimator_options.getFitRangeX().range_low
-              || data_point->bin_center_value[0]
-                  > estimator_options.getFitRangeX().range_high) {
-            datapoints[i].setPointUsed(false);
+        if (data->getDimension() > 1
+            && estimator_options.getFitRangeY().is_active) {
+          if (y[i] < estimator_options.getFitRangeY().range_low
+              || y[i] > estimator_options.getFitRangeY().range_high) {
+            binned_data.setPointUsed(i, false);
             continue;
           }
-          if (data->getDimension() > 1
-              && estimator_options.getFitRangeY().is_active) {
-            if (data_point->bin_center_value[1]
-                < estimator_options.getFitRangeY().range_low
-                || data_point->bin_center_value[1]
-                    > estimator_options.getFitRangeY().range_high) {
-              datapoints[i].setPointUsed(false);
-              continue;
-            }
-          }
-          datapoints[i].setPointUsed(true);
         }
+        binned_data.setPointUsed(i, true);
       }
-      if (estimator_options.isWithIntegralScaling()) {
-        if (fit_model.get()) {
-          std::vector<DataStructs::DimensionRange> bin_ranges;
-          for (unsigned int dim = 0; dim < data->getDimension(); dim++) {
-            DataStructs::DimensionRange bin_range;
-            bin_range.range_low = data_point->bin_center_value[dim]
-                - data_point->bin_widths[dim] / 2.0;
-            bin_range.range_high = bin_range.range_low
-                + data_point->bin_widths[dim];
-            bin_ranges.push_back(bin_range);
-          }
-
-          double scale = 1.0;
-          double precision = 1e-3;
-          mydouble int_func_real = fit_model->Integral(bin_ranges, precision);
-          mydouble int_func_approx = fit_model->evaluate(
-              data_point->bin_center_value);
-          for (unsigned int dim = 0; dim < data->getDimension(); dim++) {
-            int_func_approx *= (bin_ranges[dim].range_high
-                - bin_ranges[dim].range_low);
-          }
+    }
+    if (estimator_options.isWithIntegralScaling()) {
+      if (fit_model.get()) {
+        mydouble bin_center_value[2] = { x[i], y[i] };
+        mydouble bin_widths[2] = { bin_width_x[i], bin_width_y[i] };
+        std::vector<DataStructs::DimensionRange> bin_ranges;
+        for (unsigned int dim = 0; dim < data->getDimension(); dim++) {
+          DataStructs::DimensionRange bin_range;
+          bin_range.range_low = bin_center_value[dim] - bin_widths[dim] / 2.0;
+          bin_range.range_high = bin_range.range_low + bin_widths[dim];
+          bin_ranges.push_back(bin_range);
+        }
 
-          if (int_func_approx > 0.0 && int_func_real > 0.0) {
-            scale = int_func_approx / int_func_real;
-          }
+        double bin_scale = 1.0;
+        double precision = 1e-3;
+        mydouble int_func_real = fit_model->Integral(bin_ranges, precision);
+        mydouble int_func_approx = fit_model->evaluate(bin_center_value);
+        for (unsigned int dim = 0; dim < data->getDimension(); dim++) {
+          int_func_approx *= (bin_ranges[dim].range_high
+              - bin_ranges[dim].range_low);
+        }
 
-          data_point->scale = scale;
-          data_point->z = data_point->z * scale;
-          data_point->z_error = data_point->z_error * sqrt(scale);
+        if (int_func_approx > 0.0 && int_func_real > 0.0) {
+          bin_scale = int_func_approx / int_func_real;
         }
+
+        scale[i] = bin_scale;
+        z[i] = z[i] * bin_scale;
+        z_error[i] = z_error[i] * sqrt(bin_scale);
       }
     }
-    else if (datapoints[i].isUnbinnedDataPoint()) {
-      // TODO implement for unbinned data
+  }
+
+  // unbinned data: the events outside of the fit ranges are not used
+  UnbinnedDataSet &unbinned_data = data->getUnbinnedDataSet();
+  const mydouble *event_x = unbinned_data.getX();
+  const mydouble *event_y = unbinned_data.getY();
+  for (unsigned int i = 0; i < unbinned_data.size(); i++) {
+    bool is_used(true);
+    if (combined_fit_range_type) {
+      double event_radius_squared(
+          std::pow(event_x[i], 2) + std::pow(event_y[i], 2));
+      is_used = event_radius_squared >= combined_inner_radius_square
+          && event_radius_squared <= combined_outer_radius_square;
     }
     else {
-      // this point is neither...
-
+      if (estimator_options.getFitRangeX().is_active)
+        is_used = estimator_options.getFitRangeX().isDataWithinRange(
+            event_x[i]);
+      if (is_used && data->getDimension() > 1
+          && estimator_options.getFitRangeY().is_active)
+        is_used = estimator_options.getFitRangeY().isDataWithinRange(
+            event_y[i]);
     }
+    unbinned_data.setPointUsed(i, is_used);
   }
+
+  // the bunches hold copies of the used bins, so they have to be recreated
+  chopData();
 }
 
 void ModelEstimator::setInitialEstimatorValue(
@@ -253,6 +520,7 @@ mydouble ModelEstimator::getLastEstimatorValue() const {
 }
 
 mydouble ModelEstimator::evaluate(const mydouble *par) {
+  LMDFIT_TRACE_SCOPE("estimator", "ModelEstimator::evaluate");
   /* This point is crucial: because this method is called for every iteration
    * of the fitter, the "newly changed" parameters have to be updated in the
    * model so that the changes are actually registered.
@@ -261,56 +529,18 @@ mydouble ModelEstimator::evaluate(const mydouble *par) {
 
   mydouble estimator_value = 0.0;
 
-  if (nthreads > 1) {
-    // create threads and let them evaluate a part of the data
-    boost::thread_group threads;
-
-    std::vector<boost::unique_future<mydouble> > futures;
-    std::vector<boost::packaged_task<mydouble>*> pts;
-
-    for (unsigned int i = 0; i < nthreads; i++) {
-      pts.push_back(
-          new boost::packaged_task<mydouble>(
-              boost::bind(&ModelEstimator::eval, this, chopped_data[i])));
-      futures.push_back(pts[i]->get_future());
-
-      threads.create_thread(
-          boost::bind(&boost::packaged_task < mydouble > ::operator(), pts[i]));
-    }
-
-    threads.join_all();
-
-    for (unsigned int i = 0; i < futures.size(); i++) {
-      estimator_value += futures[i].get();
-    }
-
-    for (unsigned int i = 0; i < pts.size(); i++) {
-      delete pts[i];
-    }
-
-    /* std::vector<std::future<unsigned int> > future_list;
-     std::vector<std::thread> thread_list;
-
-     for (unsigned int i = 0; i < nthreads; i++) {
-     std::packaged_task<unsigned int()> task(
-     std::bind(&ModelEstimator::eval, this, std::cref(chopped_data[i])));
-     future_list.push_back(task.get_future());
-     thread_list.push_back(std::thread(std::move(task)));
-
-     }
-     for (auto& future : future_list) {
-     estimator_value += future.get();
-     }
-
-     // join all threads
-     for (auto& thread : thread_list) {
-     if (thread.joinable())
-     thread.join();
-     }*/
-
+  if (profiled_scale_parameter) {
+    ScaleProfileSums sums = calculateScaleProfileSums();
+    last_profile_sums = sums;
+    estimator_value = calculateProfiledEstimatorValue(sums);
   }
   else {
-    estimator_value = eval(data);
+    // let the worker pool evaluate the data chunks, the values are summed
+    // afterwards in a fixed order
+    runChunkTask(chunk_evaluation_task);
+    estimator_value = PairwiseSum::sum(chunk_estimator_values.data(),
+        chunk_estimator_values.size());
+    estimator_value += evalDataIndependentTerm();
   }
   //std::cout << "initial estimator value: " << initial_estimator_value
   //    << std::endl;
@@ -338,3 +568,81 @@ mydouble ModelEstimator::evaluate(const mydouble *par) {
   last_estimator_value = estimator_value;
   return estimator_value;
 }
+
+bool ModelEstimator::providesGradient() const {
+  return implementsGradient() && fit_model
+      && !analytic_gradient_parameters.empty();
+}
+
+void ModelEstimator::evaluateGradient(const mydouble *par,
+    mydouble *gradient) {
+  LMDFIT_TRACE_SCOPE("estimator", "ModelEstimator::evaluateGradient");
+  for (unsigned int i = 0; i < gradient_parameters.size(); i++)
+    gradient[i] = 0.0;
+
+  if (!numerical_gradient_indices.empty()) {
+    // central differences for the parameters without model derivatives, the
+    // step is a small fraction of the initial step size of the minimizer
+    const mydouble estimator_value(last_estimator_value);
+    const ScaleProfileSums profile_sums(last_profile_sums);
+    std::vector<mydouble> shifted_par(par, par + gradient_parameters.size());
+    for (unsigned int index : numerical_gradient_indices) {
+      mydouble step(std::fabs(0.2 * par[index]));
+      if (getParameterList()[index].error > 0.0)
+        step = getParameterList()[index].error;
+      else if (step == 0.0)
+        step = 0.1;
+      step *= 1e-3;
+
+      shifted_par[index] = par[index] + step;
+      mydouble value_up(evaluate(shifted_par.data()));
+      shifted_par[index] = par[index] - step;
+      mydouble value_down(evaluate(shifted_par.data()));
+      shifted_par[index] = par[index];
+      gradient[index] = (value_up - value_down) / (2.0 * step);
+    }
+    last_estimator_value = estimator_value;
+    last_profile_sums = profile_sums;
+  }
+
+  updateFreeModelParameters(par);
+
+  gradient_scale = 1.0;
+  if (profiled_scale_parameter) {
+    // the estimator is stationary in the scale at its optimum, so only the
+    // explicit dependence on the other parameters remains
+    last_profile_sums = calculateScaleProfileSums();
+    gradient_scale = calculateProfiledScale(last_profile_sums).first;
+  }
+
+  runChunkTask(chunk_gradient_task);
+  // summed in a fixed order, like the estimator values
+  for (unsigned int i = 0; i < chunk_gradients.size(); i++) {
+    for (unsigned int j = 0; j < analytic_gradient_indices.size(); j++)
+      gradient[analytic_gradient_indices[j]] += chunk_gradients[i][j];
+  }
+}
+
+bool ModelEstimator::providesResiduals() const {
+  return implementsResiduals() && !profiled_scale_parameter;
+}
+
+bool ModelEstimator::providesResidualJacobian() const {
+  return providesResiduals() && fit_model
+      && fit_model->hasParameterDerivatives();
+}
+
+unsigned int ModelEstimator::getNumberOfResiduals() const {
+  return number_of_residuals;
+}
+
+void ModelEstimator::evaluateResiduals(const mydouble *par,
+    mydouble *residuals, mydouble *jacobian) {
+  LMDFIT_TRACE_SCOPE("estimator", "ModelEstimator::evaluateResiduals");
+  updateFreeModelParameters(par);
+
+  // every chunk writes to its own part of the arrays
+  current_residuals = residuals;
+  current_jacobian = jacobian;
+  runChunkTask(chunk_residual_task);
+}
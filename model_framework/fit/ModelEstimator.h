@@ -11,6 +11,7 @@
 #include "core/ModelStructs.h"
 #include "fit/ModelControlParameter.h"
 #include "fit/EstimatorOptions.h"
+#include "core/WorkerPool.h"
 
 #include <memory>
 
@@ -41,6 +42,29 @@ struct CostFunctor {
 };
 
 class ModelEstimator: public ModelControlParameter {
+public:
+  /**
+   * Sums over the data from which the estimator value at the optimal value
+   * of a profiled scale parameter, this value and its error can be computed
+   * in closed form. Their meaning depends on the estimator implementation.
+   */
+  struct ScaleProfileSums {
+    mydouble data_term;
+    mydouble mixed_term;
+    mydouble model_term;
+
+    ScaleProfileSums() :
+        data_term(0.0), mixed_term(0.0), model_term(0.0) {
+    }
+
+    ScaleProfileSums& operator+=(const ScaleProfileSums &rhs) {
+      data_term += rhs.data_term;
+      mixed_term += rhs.mixed_term;
+      model_term += rhs.model_term;
+      return *this;
+    }
+  };
+
 private:
   boost::mutex mtx;    // lock variable for multi threading
   unsigned int nthreads;
@@ -53,15 +77,62 @@ private:
   std::map<std::pair<std::string, std::string>, std::shared_ptr<ModelPar>,
       ModelStructs::stringpair_comp> free_parameters;
 
+  // analytically profiled scale parameter, see #applyEstimatorOptions()
+  std::shared_ptr<ModelPar> profiled_scale_parameter;
+  std::pair<std::string, std::string> profiled_scale_parameter_name;
+  ScaleProfileSums last_profile_sums;
+
+  // the free parameters in the order of the parameter array, for the
+  // derivatives of the model
+  std::vector<std::shared_ptr<ModelPar> > gradient_parameters;
+  // the free parameters the model provides derivatives for and their
+  // positions in the parameter array, the remaining ones are differentiated
+  // numerically in #evaluateGradient()
+  std::vector<std::shared_ptr<ModelPar> > analytic_gradient_parameters;
+  std::vector<unsigned int> analytic_gradient_indices;
+  std::vector<unsigned int> numerical_gradient_indices;
+
   void insertParameters();
+  void determineFreeParameters();
 
   void updateFreeModelParameters(const mydouble *new_values);
 
   // data
   std::shared_ptr<Data> data;
 
-  // chopped data
+  // the data is chopped into bunches of this many used data points, which
+  // are evaluated independently of the number of threads
+  static const unsigned int data_points_per_chunk = 2048;
   std::vector<std::shared_ptr<Data> > chopped_data;
+  // estimator values of the individual data chunks
+  std::vector<mydouble> chunk_estimator_values;
+  std::vector<ScaleProfileSums> chunk_profile_sums;
+  std::vector<std::vector<mydouble> > chunk_gradients;
+  // position of the first residual of each chunk, see #evaluateResiduals()
+  std::vector<unsigned int> chunk_residual_offsets;
+  unsigned int number_of_residuals;
+  // output arrays of the current #evaluateResiduals() call
+  mydouble *current_residuals;
+  mydouble *current_jacobian;
+  // scale factor of the model in the current #evaluateGradient() call
+  mydouble gradient_scale;
+
+  // persistent threads evaluating the data chunks, created only once per
+  // thread count instead of once per evaluate() call
+  std::unique_ptr<WorkerPool> worker_pool;
+  WorkerPool::Task chunk_evaluation_task;
+  WorkerPool::Task chunk_profile_task;
+  WorkerPool::Task chunk_gradient_task;
+  WorkerPool::Task chunk_residual_task;
+
+  void evaluateChunk(unsigned int chunk_index);
+  void evaluateChunkProfileSums(unsigned int chunk_index);
+  void evaluateChunkGradient(unsigned int chunk_index);
+  void evaluateChunkResiduals(unsigned int chunk_index);
+
+  // runs the task for all data chunks, on the worker pool if available
+  void runChunkTask(const WorkerPool::Task &task);
+  ScaleProfileSums calculateScaleProfileSums();
 
   void chopData();
 
@@ -71,6 +142,69 @@ protected:
 
   EstimatorOptions estimator_options;
 
+  /**
+   * Runs the task with the indices 0 to number_of_tasks - 1, on the worker
+   * pool of the data chunks if available.
+   */
+  void runTask(const WorkerPool::Task &task, unsigned int number_of_tasks);
+
+  /**
+   * Part of the estimator that does not depend on the individual data points
+   * (e.g. the normalization term of an unbinned likelihood). It is computed
+   * once per #evaluate() call, outside of the data chunks, and added to the
+   * sum of their #eval() values. The default implementation returns 0.
+   */
+  virtual mydouble evalDataIndependentTerm();
+
+  /**
+   * Computes the #ScaleProfileSums of the data for the current model. Has to
+   * be overwritten by estimators that support the profiling of a scale
+   * parameter, the default implementation throws.
+   */
+  virtual ScaleProfileSums evalScaleProfileSums(std::shared_ptr<Data> data);
+  /**
+   * Returns the optimal scale factor (relative to the current value of the
+   * scale parameter) and its error for the given sums.
+   */
+  virtual std::pair<mydouble, mydouble> calculateProfiledScale(
+      const ScaleProfileSums &sums) const;
+  /**
+   * Returns the estimator value at the optimal scale factor.
+   */
+  virtual mydouble calculateProfiledEstimatorValue(
+      const ScaleProfileSums &sums) const;
+
+  /**
+   * Returns true if the estimator implements #evalGradient(). The default
+   * implementation returns false.
+   */
+  virtual bool implementsGradient() const;
+  /**
+   * Adds the derivatives of the estimator with respect to the parameters
+   * for the model scaled by scale to gradient. The model derivatives are
+   * obtained from #Model::evalParameterDerivatives(). The default
+   * implementation throws.
+   */
+  virtual void evalGradient(std::shared_ptr<Data> data,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble scale, mydouble *gradient);
+
+  /**
+   * Returns true if the estimator implements #evalResiduals(). The default
+   * implementation returns false.
+   */
+  virtual bool implementsResiduals() const;
+  /**
+   * Writes one residual per used binned data point of the data to
+   * residuals, see #ModelControlParameter::evaluateResiduals(). If jacobian
+   * is not null, the derivatives with respect to the parameters are written
+   * to it as well, using #Model::evalParameterDerivatives(). The default
+   * implementation throws.
+   */
+  virtual void evalResiduals(std::shared_ptr<Data> data,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble *residuals, mydouble *jacobian);
+
 public:
   ModelEstimator(bool allow_initial_normalization_);
   virtual ~ModelEstimator();
@@ -86,10 +220,71 @@ public:
   void setInitialEstimatorValue(mydouble initial_estimator_value_);
   std::vector<std::shared_ptr<ModelPar> >& getFreeParameterList();
 
+  /**
+   * Returns the model parameters handed to the minimizer, in the order of
+   * the parameter array of #evaluate(). A profiled scale parameter is not
+   * part of them.
+   */
+  const std::map<std::pair<std::string, std::string>, std::shared_ptr<ModelPar>,
+      ModelStructs::stringpair_comp>& getFreeParameters() const;
+
+  bool isScaleParameterProfiled() const;
+  /**
+   * Returns the value and error of the profiled scale parameter at the last
+   * #evaluate() call. The error is the conditional one, i.e. for fixed values
+   * of the other parameters.
+   */
+  ModelStructs::minimization_parameter getProfiledScaleParameter() const;
+
+  /**
+   * Determines the profiled scale parameter at the parameter values par
+   * (e.g. the minimum found by the minimizer) and leaves the model at these
+   * values. If the covariance matrix of the free parameters (row major, in
+   * the order of par) is given, the error includes the correlations with the
+   * other parameters: the derivatives g of the optimal scale with respect to
+   * the free parameters are computed with central differences and g^T C g is
+   * added to the conditional variance. This costs two #evaluate() calls per
+   * free parameter. Without a covariance matrix the error is the
+   * conditional one.
+   */
+  ModelStructs::minimization_parameter profileScaleParameter(
+      const mydouble *par, const std::vector<double> &covariance);
+
   mydouble getLastEstimatorValue() const;
 
   mydouble evaluate(const mydouble *par);
 
+  /**
+   * The gradient is available if the estimator implements it and the model
+   * provides the derivatives with respect to at least one free parameter.
+   */
+  bool providesGradient() const;
+
+  /**
+   * Gradient of #evaluate(). A profiled scale parameter is at its optimum,
+   * so its variation does not contribute and the gradient is the one of the
+   * estimator with the optimal scale inserted. The components of the
+   * parameters without model derivatives (see Model::hasParameterDerivative())
+   * are central differences of #evaluate().
+   */
+  void evaluateGradient(const mydouble *par, mydouble *gradient);
+
+  /**
+   * Residuals are available if the estimator implements them and no scale
+   * parameter is profiled. The jacobian additionally requires the model
+   * derivatives.
+   */
+  bool providesResiduals() const;
+  bool providesResidualJacobian() const;
+  unsigned int getNumberOfResiduals() const;
+  void evaluateResiduals(const mydouble *par, mydouble *residuals,
+      mydouble *jacobian);
+
+  /**
+   * Applies the fit ranges and integral scaling to the data. If the options
+   * name a profiled scale parameter, it is removed from the free parameters
+   * and determined analytically in each #evaluate() call instead.
+   */
   void applyEstimatorOptions(const EstimatorOptions &estimator_options_);
 
   /**
@@ -7,13 +7,17 @@
 
 #include "ModelFitFacade.h"
 #include "fit/data/Data.h"
+#include "core/FitTracer.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using std::cout;
 using std::endl;
 
 ModelFitFacade::ModelFitFacade() :
-    data(), model(), estimator(), minimizer(), estimator_options() {
+    data(), model(), estimator(), minimizer(), estimator_options(),
+    warm_start_result(), warm_start(false) {
 }
 
 ModelFitFacade::~ModelFitFacade() {
@@ -95,7 +99,7 @@ Data ModelFitFacade::scanEstimatorSpace(
 
   std::cout << "Now performing actual scan!!!!\n";
   // find the correct parameters first
-  auto free_params = model->getModelParameterSet().getFreeModelParameters();
+  auto free_params = estimator->getFreeParameters();
   mydouble params[free_params.size()];
   unsigned int index_1(0);
   unsigned int index_2(0);
@@ -115,22 +119,17 @@ Data ModelFitFacade::scanEstimatorSpace(
   mydouble stepsize_x = x_center * scanwidth / num_bins;
   mydouble stepsize_y = y_center * scanwidth / num_bins;
 
-  DataPointProxy dpp;
+  BinnedDataSet &scan_points = scan_data.getBinnedDataSet();
+  scan_points.reserve((2 * num_bins + 1) * (2 * num_bins + 1));
   for (int ix = -num_bins; ix < num_bins + 1; ++ix) {
     for (int iy = -num_bins; iy < num_bins + 1; ++iy) {
-      std::shared_ptr<DataStructs::binned_data_point> bdp(
-          new DataStructs::binned_data_point);
-      bdp->bin_widths[0] = stepsize_x;
-      bdp->bin_widths[1] = stepsize_y;
-      dpp.setBinnedDataPoint(bdp);
       params[index_1] = x_center + stepsize_x * ix;
       params[index_2] = y_center + stepsize_y * iy;
-      bdp->bin_center_value[0] = params[index_1];
-      bdp->bin_center_value[1] = params[index_2];
-      bdp->z = estimator->evaluate(params);
-      scan_data.insertData(dpp);
-      std::cout << "adding: " << bdp->bin_center_value[0] << " : "
-          << bdp->bin_center_value[1] << " = " << bdp->z << std::endl;
+      mydouble estimator_value = estimator->evaluate(params);
+      scan_points.addDataPoint(params[index_1], params[index_2], stepsize_x,
+          stepsize_y, estimator_value, 0.0);
+      std::cout << "adding: " << params[index_1] << " : " << params[index_2]
+          << " = " << estimator_value << std::endl;
     }
   }
 
@@ -171,7 +170,7 @@ std::vector<mydouble> ModelFitFacade::findGoodStartParameters(
   std::cout << "Finding good start parameters for parameters!\n";
 
   // find the correct parameters first
-  auto free_params = model->getModelParameterSet().getFreeModelParameters();
+  auto free_params = estimator->getFreeParameters();
   std::vector<mydouble> params(free_params.size());
   std::vector<unsigned int> indices(variable_names.size());
 
@@ -251,7 +250,51 @@ std::vector<mydouble> ModelFitFacade::findGoodStartParameters(
   return best_parameters;
 }
 
+void ModelFitFacade::setWarmStart(const ModelFitResult& previous_fit_result) {
+  warm_start_result = previous_fit_result;
+  warm_start = true;
+}
+
+void ModelFitFacade::applyWarmStart() {
+  auto const& previous_parameters = warm_start_result.getFitParameters();
+  auto const& covariance_names =
+      warm_start_result.getCovarianceParameterNames();
+  auto &parameters = estimator->getParameterList();
+
+  unsigned int counter(0);
+  unsigned int number_of_warm_started_parameters(0);
+  for (auto const &param : estimator->getFreeParameters()) {
+    auto previous_parameter = previous_parameters.find(
+        ModelStructs::minimization_parameter(param.first));
+    if (previous_parameter != previous_parameters.end()) {
+      param.second->setValue(previous_parameter->value);
+      parameters[counter].value = previous_parameter->value;
+
+      double error(previous_parameter->error);
+      if (warm_start_result.hasCovarianceMatrix()
+          && std::find(covariance_names.begin(), covariance_names.end(),
+              param.first) != covariance_names.end()) {
+        double variance(
+            warm_start_result.getCovariance(param.first, param.first));
+        if (variance > 0.0)
+          error = std::sqrt(variance);
+      }
+      // a vanishing error leaves the default step size of the minimizer
+      parameters[counter].error = error;
+      ++number_of_warm_started_parameters;
+    }
+    ++counter;
+  }
+  std::cout << "warm start: " << number_of_warm_started_parameters << " of "
+      << counter << " free parameters start at the previous fit result"
+      << std::endl;
+}
+
 ModelFitResult ModelFitFacade::Fit() {
+  // writes the trace and the summary of this fit at its end
+  LMDFIT_TRACE_FIT("ModelFitFacade::Fit");
+  LMDFIT_TRACE_SCOPE("fit", "ModelFitFacade::Fit");
+
   ModelFitResult fit_result_dummy;
 
 // check that estimator is set
@@ -286,8 +329,12 @@ ModelFitResult ModelFitFacade::Fit() {
 
   minimizer->setControlParameter(estimator);
 
-  auto const& free_params =
-      model->getModelParameterSet().getFreeModelParameters();
+  if (warm_start) {
+    applyWarmStart();
+    warm_start = false;
+  }
+
+  auto const& free_params = estimator->getFreeParameters();
   std::cout << free_params.size() << " free parameters in fit\n";
   std::vector<mydouble> pars;
   for (auto const &param : free_params) {
@@ -329,6 +376,33 @@ ModelFitResult ModelFitFacade::Fit() {
   ModelFitResult fit_result = minimizer->createModelFitResult();
   fit_result.setFitStatus(fit_status);
 
+  if (estimator->isScaleParameterProfiled()) {
+    // the profiled parameter is determined by the estimator at the fitted
+    // values of the other parameters, with an error including their
+    // correlations if the minimizer provides a covariance matrix
+    std::vector<mydouble> fitted_pars;
+    for (auto const &param : free_params)
+      fitted_pars.push_back(fit_result.getFitParameter(param.first).value);
+    std::vector<double> covariance;
+    if (fit_result.hasCovarianceMatrix()) {
+      for (auto const &param1 : free_params) {
+        for (auto const &param2 : free_params)
+          covariance.push_back(
+              fit_result.getCovariance(param1.first, param2.first));
+      }
+    }
+    ModelStructs::minimization_parameter profiled_parameter =
+        estimator->profileScaleParameter(fitted_pars.data(), covariance);
+    fit_result.addFitParameter(profiled_parameter.name,
+        profiled_parameter.value, profiled_parameter.error);
+    model->getModelParameterSet().getModelParameter(profiled_parameter.name)->setValue(
+        profiled_parameter.value);
+    model->updateModel();
+    std::cout << "profiled " << profiled_parameter.name.second << ": "
+        << profiled_parameter.value << " +- " << profiled_parameter.error
+        << std::endl;
+  }
+
   fit_result.setFinalEstimatorValue(estimator->getLastEstimatorValue());
   fit_result.setNumberOfDataPoints(
       estimator->getData()->getNumberOfUsedDataPoints());
@@ -22,6 +22,12 @@ private:
 
 	EstimatorOptions estimator_options;
 
+	// result of a previous fit, which is the start point of the next #Fit()
+	ModelFitResult warm_start_result;
+	bool warm_start;
+
+	void applyWarmStart();
+
 public:
 	ModelFitFacade();
 	virtual ~ModelFitFacade();
@@ -42,6 +48,17 @@ public:
 	std::vector<mydouble> findGoodStartParameters(
 	    const std::vector<std::string>& variable_names, const std::vector<double>& search_factors);
 
+	/**
+	 * Starts the next #Fit() from the result of a previous fit, e.g. of an
+	 * earlier stage of a staged fit. The free parameters which are also
+	 * parameters of previous_fit_result (same model and parameter name) start
+	 * at their fitted values, and their fitted errors (the diagonal of the
+	 * covariance matrix, if available) are used as the initial step sizes of
+	 * the minimizer instead of its defaults. The other free parameters start
+	 * as usual. The warm start is used only by the next #Fit().
+	 */
+	void setWarmStart(const ModelFitResult& previous_fit_result);
+
 	ModelFitResult Fit();
 
 };
@@ -7,7 +7,9 @@
 
 #include "ModelFitResult.h"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 ModelFitResult::ModelFitResult() :
 		fit_status(-1), num_data_points(0), fit_parameters(), final_estimator_value(
@@ -23,6 +25,18 @@ ModelFitResult::ModelFitResult(const ModelFitResult &fit_result) {
 			fit_param != fit_result.getFitParameters().end(); fit_param++) {
 		addFitParameter(fit_param->name, fit_param->value, fit_param->error);
 	}
+	covariance_parameter_names = fit_result.covariance_parameter_names;
+	covariance_matrix = fit_result.covariance_matrix;
+}
+
+ModelFitResult& ModelFitResult::operator=(const ModelFitResult &fit_result) {
+	fit_status = fit_result.fit_status;
+	num_data_points = fit_result.num_data_points;
+	fit_parameters = fit_result.fit_parameters;
+	final_estimator_value = fit_result.final_estimator_value;
+	covariance_parameter_names = fit_result.covariance_parameter_names;
+	covariance_matrix = fit_result.covariance_matrix;
+	return *this;
 }
 
 ModelFitResult::~ModelFitResult() {
@@ -82,6 +96,40 @@ const std::set<ModelStructs::minimization_parameter>& ModelFitResult::getFitPara
 	return fit_parameters;
 }
 
+void ModelFitResult::setCovarianceMatrix(
+		const std::vector<std::pair<std::string, std::string> > &names,
+		const std::vector<double> &matrix) {
+	if (matrix.size() != names.size() * names.size())
+		throw std::runtime_error(
+				"ModelFitResult::setCovarianceMatrix: the matrix does not match the number of parameters!");
+	covariance_parameter_names = names;
+	covariance_matrix = matrix;
+}
+
+bool ModelFitResult::hasCovarianceMatrix() const {
+	return !covariance_matrix.empty();
+}
+
+const std::vector<std::pair<std::string, std::string> >& ModelFitResult::getCovarianceParameterNames() const {
+	return covariance_parameter_names;
+}
+
+double ModelFitResult::getCovariance(
+		const std::pair<std::string, std::string> &name1,
+		const std::pair<std::string, std::string> &name2) const {
+	auto index1 = std::find(covariance_parameter_names.begin(),
+			covariance_parameter_names.end(), name1);
+	auto index2 = std::find(covariance_parameter_names.begin(),
+			covariance_parameter_names.end(), name2);
+	if (index1 == covariance_parameter_names.end()
+			|| index2 == covariance_parameter_names.end())
+		throw std::runtime_error(
+				"ModelFitResult::getCovariance: parameter is not part of the covariance matrix!");
+	return covariance_matrix[(index1 - covariance_parameter_names.begin())
+			* covariance_parameter_names.size()
+			+ (index2 - covariance_parameter_names.begin())];
+}
+
 int ModelFitResult::getFitStatus() const {
 	return fit_status;
 }
@@ -13,6 +13,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 class ModelFitResult {
 private:
@@ -21,11 +23,17 @@ private:
 	std::set<ModelStructs::minimization_parameter> fit_parameters;
 	double final_estimator_value;
 
+	// covariance matrix of the minimizer parameters (row major, in the order
+	// of covariance_parameter_names), empty if the minimizer provides none
+	std::vector<std::pair<std::string, std::string> > covariance_parameter_names;
+	std::vector<double> covariance_matrix;
+
 	unsigned int getNumberOfDataPoints() const;
 
 public:
 	ModelFitResult();
 	ModelFitResult(const ModelFitResult &fit_result);
+	ModelFitResult& operator=(const ModelFitResult &fit_result);
 	virtual ~ModelFitResult();
 
 	double getFinalEstimatorValue() const;
@@ -43,6 +51,22 @@ public:
 	const ModelStructs::minimization_parameter& getFitParameter(
 			std::pair<std::string, std::string> name_) const;
 	const std::set<ModelStructs::minimization_parameter>& getFitParameters() const;
+
+	/**
+	 * Sets the covariance matrix of the parameters with the given names, row
+	 * major with names.size() rows.
+	 */
+	void setCovarianceMatrix(
+			const std::vector<std::pair<std::string, std::string> > &names,
+			const std::vector<double> &matrix);
+	bool hasCovarianceMatrix() const;
+	const std::vector<std::pair<std::string, std::string> >& getCovarianceParameterNames() const;
+	/**
+	 * @returns the covariance of the two parameters. Throws if one of them is
+	 * not part of the covariance matrix.
+	 */
+	double getCovariance(const std::pair<std::string, std::string> &name1,
+			const std::pair<std::string, std::string> &name2) const;
 };
 
 #endif /* MODELFITRESULT_H_ */
@@ -0,0 +1,162 @@
+/*
+ * BinnedDataSet.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "BinnedDataSet.h"
+
+BinnedDataSet::BinnedDataSet() {
+}
+
+BinnedDataSet::~BinnedDataSet() {
+}
+
+void BinnedDataSet::clear() {
+  x.clear();
+  y.clear();
+  bin_width_x.clear();
+  bin_width_y.clear();
+  z.clear();
+  z_error.clear();
+  scale.clear();
+  used.clear();
+}
+
+void BinnedDataSet::reserve(unsigned int number_of_bins) {
+  x.reserve(number_of_bins);
+  y.reserve(number_of_bins);
+  bin_width_x.reserve(number_of_bins);
+  bin_width_y.reserve(number_of_bins);
+  z.reserve(number_of_bins);
+  z_error.reserve(number_of_bins);
+  scale.reserve(number_of_bins);
+  used.reserve(number_of_bins);
+}
+
+void BinnedDataSet::addDataPoint(mydouble x_, mydouble y_,
+    mydouble bin_width_x_, mydouble bin_width_y_, mydouble z_,
+    mydouble z_error_, mydouble scale_, bool is_used) {
+  x.push_back(x_);
+  y.push_back(y_);
+  bin_width_x.push_back(bin_width_x_);
+  bin_width_y.push_back(bin_width_y_);
+  z.push_back(z_);
+  z_error.push_back(z_error_);
+  scale.push_back(scale_);
+  used.push_back(is_used);
+}
+
+void BinnedDataSet::addDataPoint(
+    const DataStructs::binned_data_point &data_point, bool is_used) {
+  addDataPoint(data_point.bin_center_value[0], data_point.bin_center_value[1],
+      data_point.bin_widths[0], data_point.bin_widths[1], data_point.z,
+      data_point.z_error, data_point.scale, is_used);
+}
+
+void BinnedDataSet::addDataPoints(const BinnedDataSet &data_set,
+    unsigned int begin, unsigned int end, bool only_used_points) {
+  if (end > data_set.size())
+    end = data_set.size();
+  for (unsigned int i = begin; i < end; ++i) {
+    if (only_used_points && !data_set.used[i])
+      continue;
+    addDataPoint(data_set.x[i], data_set.y[i], data_set.bin_width_x[i],
+        data_set.bin_width_y[i], data_set.z[i], data_set.z_error[i],
+        data_set.scale[i], data_set.used[i]);
+  }
+}
+
+unsigned int BinnedDataSet::size() const {
+  return x.size();
+}
+
+unsigned int BinnedDataSet::getNumberOfUsedDataPoints() const {
+  unsigned int num_points = 0;
+  for (unsigned int i = 0; i < used.size(); ++i)
+    num_points += used[i];
+  return num_points;
+}
+
+DataStructs::binned_data_point BinnedDataSet::getDataPoint(
+    unsigned int index) const {
+  DataStructs::binned_data_point data_point;
+  data_point.bin_center_value[0] = x[index];
+  data_point.bin_center_value[1] = y[index];
+  data_point.bin_widths[0] = bin_width_x[index];
+  data_point.bin_widths[1] = bin_width_y[index];
+  data_point.z = z[index];
+  data_point.z_error = z_error[index];
+  data_point.scale = scale[index];
+  return data_point;
+}
+
+unsigned int BinnedDataSet::gatherUsedDataPoints(unsigned int &position,
+    unsigned int dimension, unsigned int max_points, mydouble *coordinates,
+    unsigned int *indices) const {
+  unsigned int count(0);
+  const unsigned int size(x.size());
+  if (dimension > 1) {
+    for (; position < size && count < max_points; ++position) {
+      if (used[position]) {
+        coordinates[2 * count] = x[position];
+        coordinates[2 * count + 1] = y[position];
+        indices[count] = position;
+        ++count;
+      }
+    }
+  }
+  else {
+    for (; position < size && count < max_points; ++position) {
+      if (used[position]) {
+        coordinates[count] = x[position];
+        indices[count] = position;
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+bool BinnedDataSet::isPointUsed(unsigned int index) const {
+  return used[index];
+}
+
+void BinnedDataSet::setPointUsed(unsigned int index, bool is_used) {
+  used[index] = is_used;
+}
+
+const mydouble* BinnedDataSet::getX() const {
+  return x.data();
+}
+const mydouble* BinnedDataSet::getY() const {
+  return y.data();
+}
+const mydouble* BinnedDataSet::getBinWidthX() const {
+  return bin_width_x.data();
+}
+const mydouble* BinnedDataSet::getBinWidthY() const {
+  return bin_width_y.data();
+}
+const mydouble* BinnedDataSet::getZ() const {
+  return z.data();
+}
+const mydouble* BinnedDataSet::getZError() const {
+  return z_error.data();
+}
+const mydouble* BinnedDataSet::getScale() const {
+  return scale.data();
+}
+const unsigned char* BinnedDataSet::getUsedMask() const {
+  return used.data();
+}
+
+mydouble* BinnedDataSet::getZ() {
+  return z.data();
+}
+mydouble* BinnedDataSet::getZError() {
+  return z_error.data();
+}
+mydouble* BinnedDataSet::getScale() {
+  return scale.data();
+}
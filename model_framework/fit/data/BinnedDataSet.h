@@ -0,0 +1,89 @@
+/*
+ * BinnedDataSet.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef BINNEDDATASET_H_
+#define BINNEDDATASET_H_
+
+#include "DataStructs.h"
+
+#include <vector>
+
+/**
+ * Columnar (structure of arrays) storage of binned data. Every bin quantity
+ * is held in its own contiguous array, so the estimators can loop linearly
+ * over the data without following a pointer per bin. For 1D data the y
+ * columns are filled with zeros.
+ */
+class BinnedDataSet {
+private:
+  std::vector<mydouble> x;
+  std::vector<mydouble> y;
+  std::vector<mydouble> bin_width_x;
+  std::vector<mydouble> bin_width_y;
+  std::vector<mydouble> z;
+  std::vector<mydouble> z_error;
+  std::vector<mydouble> scale;
+  // used mask, deliberately not a std::vector<bool>
+  std::vector<unsigned char> used;
+
+public:
+  BinnedDataSet();
+  virtual ~BinnedDataSet();
+
+  void clear();
+  void reserve(unsigned int number_of_bins);
+
+  void addDataPoint(mydouble x_, mydouble y_, mydouble bin_width_x_,
+      mydouble bin_width_y_, mydouble z_, mydouble z_error_,
+      mydouble scale_ = 1.0, bool is_used = true);
+  void addDataPoint(const DataStructs::binned_data_point &data_point,
+      bool is_used = true);
+  /**
+   * Appends the bins of the index range [begin, end) of the data_set to
+   * this data set. If only_used_points is true, bins which are not used
+   * are skipped.
+   */
+  void addDataPoints(const BinnedDataSet &data_set, unsigned int begin,
+      unsigned int end, bool only_used_points = false);
+
+  unsigned int size() const;
+  unsigned int getNumberOfUsedDataPoints() const;
+
+  /**
+   * Returns a copy of the bin at position index in the old struct form.
+   */
+  DataStructs::binned_data_point getDataPoint(unsigned int index) const;
+
+  /**
+   * Copies the bin centers of the next used bins, starting at index
+   * position, point by point into coordinates (dimension values per bin)
+   * and their indices into indices. At most max_points bins are gathered.
+   * The position is advanced behind the last inspected bin. This is the
+   * coordinate layout expected by Model::evaluateBatch().
+   * @returns the number of gathered bins
+   */
+  unsigned int gatherUsedDataPoints(unsigned int &position,
+      unsigned int dimension, unsigned int max_points, mydouble *coordinates,
+      unsigned int *indices) const;
+
+  bool isPointUsed(unsigned int index) const;
+  void setPointUsed(unsigned int index, bool is_used);
+
+  const mydouble* getX() const;
+  const mydouble* getY() const;
+  const mydouble* getBinWidthX() const;
+  const mydouble* getBinWidthY() const;
+  const mydouble* getZ() const;
+  const mydouble* getZError() const;
+  const mydouble* getScale() const;
+  const unsigned char* getUsedMask() const;
+
+  mydouble* getZ();
+  mydouble* getZError();
+  mydouble* getScale();
+};
+
+#endif /* BINNEDDATASET_H_ */
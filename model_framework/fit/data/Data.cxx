@@ -8,8 +8,7 @@
 #include "Data.h"
 
 Data::Data(unsigned int dimension_) :
-		data_points(), dimension(dimension_), binning_factor(1.0), is_binning_factor_set(
-				false) {
+		binned_data(), unbinned_data(), dimension(dimension_) {
 }
 
 Data::~Data() {
@@ -21,30 +20,31 @@ unsigned int Data::getDimension() const {
 }
 
 unsigned int Data::getNumberOfDataPoints() const {
-	return data_points.size();
+	return binned_data.size() + unbinned_data.size();
 }
 
 unsigned int Data::getNumberOfUsedDataPoints() const {
-	unsigned int num_points = 0;
-
-	for (unsigned int i = 0; i < data_points.size(); i++) {
-		if (data_points[i].isPointUsed())
-			num_points++;
-	}
-	return num_points;
+	return binned_data.getNumberOfUsedDataPoints()
+			+ unbinned_data.getNumberOfUsedDataPoints();
 }
 
 double Data::getBinningFactor() const {
+	double binning_factor(1.0);
+	if (isBinningFactorSet()) {
+		binning_factor = binned_data.getBinWidthX()[0];
+		if (getDimension() > 1)
+			binning_factor *= binned_data.getBinWidthY()[0];
+	}
 	return binning_factor;
 }
 
 bool Data::isBinningFactorSet() const {
-	return is_binning_factor_set;
+	return binned_data.size() > 0 && unbinned_data.size() == 0;
 }
 
 void Data::clearData() {
-	data_points.clear();
-	is_binning_factor_set = false;
+	binned_data.clear();
+	unbinned_data.clear();
 }
 
 void Data::insertData(std::vector<DataPointProxy> &data_points_) {
@@ -54,20 +54,40 @@ void Data::insertData(std::vector<DataPointProxy> &data_points_) {
 }
 void Data::insertData(DataPointProxy &data_point_) {
 	if (data_point_.isBinnedDataPoint()) {
-		if (!is_binning_factor_set) {
-			is_binning_factor_set = true;
-			binning_factor = 1.0;
-			for (unsigned int i = 0; i < getDimension(); i++) {
-				binning_factor *= data_point_.getBinnedDataPoint()->bin_widths[i];
-			}
+		DataStructs::binned_data_point bdp(*data_point_.getBinnedDataPoint());
+		if (getDimension() < 2) {
+			bdp.bin_center_value[1] = 0.0;
+			bdp.bin_widths[1] = 0.0;
 		}
-	} else {
-		is_binning_factor_set = false;
-		binning_factor = 1.0;
+		binned_data.addDataPoint(bdp, data_point_.isPointUsed());
+	} else if (data_point_.isUnbinnedDataPoint()) {
+		DataStructs::unbinned_data_point udp(*data_point_.getUnbinnedDataPoint());
+		if (getDimension() < 2)
+			udp.x[1] = 0.0;
+		unbinned_data.addDataPoint(udp, data_point_.isPointUsed());
 	}
-	data_points.push_back(data_point_);
 }
 
-std::vector<DataPointProxy>& Data::getData() {
-	return data_points;
+void Data::insertData(const BinnedDataSet &binned_data_) {
+	binned_data.addDataPoints(binned_data_, 0, binned_data_.size());
+}
+
+void Data::insertData(const UnbinnedDataSet &unbinned_data_) {
+	unbinned_data.addDataPoints(unbinned_data_, 0, unbinned_data_.size());
+}
+
+BinnedDataSet& Data::getBinnedDataSet() {
+	return binned_data;
+}
+
+const BinnedDataSet& Data::getBinnedDataSet() const {
+	return binned_data;
+}
+
+UnbinnedDataSet& Data::getUnbinnedDataSet() {
+	return unbinned_data;
+}
+
+const UnbinnedDataSet& Data::getUnbinnedDataSet() const {
+	return unbinned_data;
 }
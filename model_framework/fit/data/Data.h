@@ -9,17 +9,18 @@
 #define DATA_H_
 
 #include "DataPointProxy.h"
+#include "BinnedDataSet.h"
+#include "UnbinnedDataSet.h"
 
 #include <vector>
 
 class Data {
 private:
-	// this is the vector that stores the information
-	std::vector<DataPointProxy> data_points;
+	// binned data is stored in columnar form
+	BinnedDataSet binned_data;
 
-	// binning factor
-	double binning_factor;
-	bool is_binning_factor_set;
+	// unbinned data (events) is stored in columnar form as well
+	UnbinnedDataSet unbinned_data;
 
 	// dimension of the data
 	unsigned int dimension;
@@ -32,14 +33,29 @@ public:
 	unsigned int getNumberOfDataPoints() const;
 	unsigned int getNumberOfUsedDataPoints() const;
 
+	/**
+	 * The binning factor is the bin volume of the first binned data point.
+	 * It is 1 in case unbinned data is present.
+	 */
 	double getBinningFactor() const;
 	bool isBinningFactorSet() const;
 
 	void clearData();
 
+	/**
+	 * Inserts data points. Binned data points are copied into the
+	 * #binned_data set, unbinned points into the #unbinned_data set.
+	 */
 	void insertData(std::vector<DataPointProxy> & data_points_);
 	void insertData(DataPointProxy & data_point_);
-	std::vector<DataPointProxy> & getData();
+	void insertData(const BinnedDataSet & binned_data_);
+	void insertData(const UnbinnedDataSet & unbinned_data_);
+
+	BinnedDataSet & getBinnedDataSet();
+	const BinnedDataSet & getBinnedDataSet() const;
+
+	UnbinnedDataSet & getUnbinnedDataSet();
+	const UnbinnedDataSet & getUnbinnedDataSet() const;
 };
 
 #endif /* BINNEDDATA_H_ */
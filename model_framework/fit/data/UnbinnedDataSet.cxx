@@ -0,0 +1,103 @@
+/*
+ * UnbinnedDataSet.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "UnbinnedDataSet.h"
+
+UnbinnedDataSet::UnbinnedDataSet() {
+}
+
+UnbinnedDataSet::~UnbinnedDataSet() {
+}
+
+void UnbinnedDataSet::clear() {
+  x.clear();
+  y.clear();
+  used.clear();
+}
+
+void UnbinnedDataSet::reserve(unsigned int number_of_events) {
+  x.reserve(number_of_events);
+  y.reserve(number_of_events);
+  used.reserve(number_of_events);
+}
+
+void UnbinnedDataSet::addDataPoint(mydouble x_, mydouble y_, bool is_used) {
+  x.push_back(x_);
+  y.push_back(y_);
+  used.push_back(is_used);
+}
+
+void UnbinnedDataSet::addDataPoint(
+    const DataStructs::unbinned_data_point &data_point, bool is_used) {
+  addDataPoint(data_point.x[0], data_point.x[1], is_used);
+}
+
+void UnbinnedDataSet::addDataPoints(const UnbinnedDataSet &data_set,
+    unsigned int begin, unsigned int end, bool only_used_points) {
+  if (end > data_set.size())
+    end = data_set.size();
+  for (unsigned int i = begin; i < end; ++i) {
+    if (only_used_points && !data_set.used[i])
+      continue;
+    addDataPoint(data_set.x[i], data_set.y[i], data_set.used[i]);
+  }
+}
+
+unsigned int UnbinnedDataSet::size() const {
+  return x.size();
+}
+
+unsigned int UnbinnedDataSet::getNumberOfUsedDataPoints() const {
+  unsigned int num_points = 0;
+  for (unsigned int i = 0; i < used.size(); ++i)
+    num_points += used[i];
+  return num_points;
+}
+
+unsigned int UnbinnedDataSet::gatherUsedDataPoints(unsigned int &position,
+    unsigned int dimension, unsigned int max_points, mydouble *coordinates,
+    unsigned int *indices) const {
+  unsigned int count(0);
+  const unsigned int size(x.size());
+  if (dimension > 1) {
+    for (; position < size && count < max_points; ++position) {
+      if (used[position]) {
+        coordinates[2 * count] = x[position];
+        coordinates[2 * count + 1] = y[position];
+        indices[count] = position;
+        ++count;
+      }
+    }
+  }
+  else {
+    for (; position < size && count < max_points; ++position) {
+      if (used[position]) {
+        coordinates[count] = x[position];
+        indices[count] = position;
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+bool UnbinnedDataSet::isPointUsed(unsigned int index) const {
+  return used[index];
+}
+
+void UnbinnedDataSet::setPointUsed(unsigned int index, bool is_used) {
+  used[index] = is_used;
+}
+
+const mydouble* UnbinnedDataSet::getX() const {
+  return x.data();
+}
+const mydouble* UnbinnedDataSet::getY() const {
+  return y.data();
+}
+const unsigned char* UnbinnedDataSet::getUsedMask() const {
+  return used.data();
+}
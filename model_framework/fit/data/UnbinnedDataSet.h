@@ -0,0 +1,64 @@
+/*
+ * UnbinnedDataSet.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef UNBINNEDDATASET_H_
+#define UNBINNEDDATASET_H_
+
+#include "DataStructs.h"
+
+#include <vector>
+
+/**
+ * Columnar (structure of arrays) storage of unbinned data, the event
+ * counterpart of #BinnedDataSet. The coordinates of all events are held in
+ * contiguous arrays, so the event loop of the estimators does not follow a
+ * pointer per event. For 1D data the y column is filled with zeros.
+ */
+class UnbinnedDataSet {
+private:
+  std::vector<mydouble> x;
+  std::vector<mydouble> y;
+  // used mask, deliberately not a std::vector<bool>
+  std::vector<unsigned char> used;
+
+public:
+  UnbinnedDataSet();
+  virtual ~UnbinnedDataSet();
+
+  void clear();
+  void reserve(unsigned int number_of_events);
+
+  void addDataPoint(mydouble x_, mydouble y_, bool is_used = true);
+  void addDataPoint(const DataStructs::unbinned_data_point &data_point,
+      bool is_used = true);
+  /**
+   * Appends the events of the index range [begin, end) of the data_set to
+   * this data set. If only_used_points is true, events which are not used
+   * are skipped.
+   */
+  void addDataPoints(const UnbinnedDataSet &data_set, unsigned int begin,
+      unsigned int end, bool only_used_points = false);
+
+  unsigned int size() const;
+  unsigned int getNumberOfUsedDataPoints() const;
+
+  /**
+   * Same as #BinnedDataSet::gatherUsedDataPoints(), with the event
+   * coordinates instead of the bin centers.
+   */
+  unsigned int gatherUsedDataPoints(unsigned int &position,
+      unsigned int dimension, unsigned int max_points, mydouble *coordinates,
+      unsigned int *indices) const;
+
+  bool isPointUsed(unsigned int index) const;
+  void setPointUsed(unsigned int index, bool is_used);
+
+  const mydouble* getX() const;
+  const mydouble* getY() const;
+  const unsigned char* getUsedMask() const;
+};
+
+#endif /* UNBINNEDDATASET_H_ */
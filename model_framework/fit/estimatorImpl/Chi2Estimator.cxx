@@ -7,8 +7,10 @@
 
 #include "Chi2Estimator.h"
 #include "core/Model.h"
+#include "core/PairwiseSum.h"
 #include "fit/data/Data.h"
 
+#include <cmath>
 #include <iostream>
 
 Chi2Estimator::Chi2Estimator() : ModelEstimator(false) {
@@ -21,35 +23,164 @@ Chi2Estimator::~Chi2Estimator() {
 
 mydouble Chi2Estimator::eval(std::shared_ptr<Data> data) {
 	//calculate chisquare
-	mydouble chisq = 0.0;
+	PairwiseSum chisq;
 	mydouble delta;
 
-	std::vector<DataPointProxy> &data_points = data->getData();
-	// loop over data
-	for (unsigned int i = 0; i < data_points.size(); i++) {
-		std::shared_ptr<DataStructs::binned_data_point> data_point;
-		if (data_points[i].isPointUsed()) {
-			data_point = data_points[i].getBinnedDataPoint();
-			delta =
-					(data_point->z
-							- fit_model->evaluate(
-											data_point->bin_center_value)*data->getBinningFactor());
+	const BinnedDataSet &binned_data = data->getBinnedDataSet();
+	const mydouble *z = binned_data.getZ();
+	const mydouble *z_error = binned_data.getZError();
+	const mydouble binning_factor = data->getBinningFactor();
+
+	// the model is evaluated in batches of used data points
+	const unsigned int batch_size(256);
+	mydouble coordinates[2 * batch_size];
+	unsigned int indices[batch_size];
+	mydouble model_values[batch_size];
+
+	unsigned int position(0);
+	while (position < binned_data.size()) {
+		unsigned int count = binned_data.gatherUsedDataPoints(position,
+				data->getDimension(), batch_size, coordinates, indices);
+		fit_model->evaluateBatch(coordinates, count, model_values);
+		for (unsigned int j = 0; j < count; j++) {
+			const unsigned int i = indices[j];
+			delta = (z[i] - model_values[j] * binning_factor);
+			mydouble weightsquare(1.0);
+			if (z_error[i] != 0.0)
+				weightsquare = z_error[i] * z_error[i];
+			chisq.add(delta * delta / weightsquare);
+		}
+	}
+	return chisq.sum();
+}
+
+ModelEstimator::ScaleProfileSums Chi2Estimator::evalScaleProfileSums(
+		std::shared_ptr<Data> data) {
+	const BinnedDataSet &binned_data = data->getBinnedDataSet();
+	const mydouble *z = binned_data.getZ();
+	const mydouble *z_error = binned_data.getZError();
+	const mydouble binning_factor = data->getBinningFactor();
+
+	ScaleProfileSums sums;
+
+	const unsigned int batch_size(256);
+	mydouble coordinates[2 * batch_size];
+	unsigned int indices[batch_size];
+	mydouble model_values[batch_size];
+
+	unsigned int position(0);
+	while (position < binned_data.size()) {
+		unsigned int count = binned_data.gatherUsedDataPoints(position,
+				data->getDimension(), batch_size, coordinates, indices);
+		fit_model->evaluateBatch(coordinates, count, model_values);
+		for (unsigned int j = 0; j < count; j++) {
+			const unsigned int i = indices[j];
+			mydouble model_value = model_values[j] * binning_factor;
+			mydouble weightsquare(1.0);
+			if (z_error[i] != 0.0)
+				weightsquare = z_error[i] * z_error[i];
+			sums.data_term += z[i] * z[i] / weightsquare;
+			sums.mixed_term += z[i] * model_value / weightsquare;
+			sums.model_term += model_value * model_value / weightsquare;
+		}
+	}
+	return sums;
+}
+
+std::pair<mydouble, mydouble> Chi2Estimator::calculateProfiledScale(
+		const ScaleProfileSums &sums) const {
+	if (sums.model_term <= 0.0)
+		return std::make_pair(0.0, 0.0);
+	// the second derivative of the chi2 is 2 * sum(m^2 / w)
+	return std::make_pair(sums.mixed_term / sums.model_term,
+			1.0 / std::sqrt(sums.model_term));
+}
+
+mydouble Chi2Estimator::calculateProfiledEstimatorValue(
+		const ScaleProfileSums &sums) const {
+	if (sums.model_term <= 0.0)
+		return sums.data_term;
+	return sums.data_term - sums.mixed_term * sums.mixed_term / sums.model_term;
+}
+
+bool Chi2Estimator::implementsGradient() const {
+	return true;
+}
+
+void Chi2Estimator::evalGradient(std::shared_ptr<Data> data,
+		const std::vector<std::shared_ptr<ModelPar> > &parameters,
+		mydouble scale, mydouble *gradient) {
+	const BinnedDataSet &binned_data = data->getBinnedDataSet();
+	const mydouble *z = binned_data.getZ();
+	const mydouble *z_error = binned_data.getZError();
+	const mydouble binning_factor = data->getBinningFactor();
+	const unsigned int dimension = data->getDimension();
+
+	std::vector<mydouble> derivatives(parameters.size());
+
+	const unsigned int batch_size(256);
+	mydouble coordinates[2 * batch_size];
+	unsigned int indices[batch_size];
+	mydouble model_values[batch_size];
+
+	unsigned int position(0);
+	while (position < binned_data.size()) {
+		unsigned int count = binned_data.gatherUsedDataPoints(position,
+				dimension, batch_size, coordinates, indices);
+		fit_model->evaluateBatch(coordinates, count, model_values);
+		for (unsigned int j = 0; j < count; j++) {
+			const unsigned int i = indices[j];
+			mydouble delta = z[i] - scale * model_values[j] * binning_factor;
 			mydouble weightsquare(1.0);
-			if(data_point->z_error != 0.0)
-			  weightsquare = data_point->z_error * data_point->z_error;
-			mydouble modelweight = 0.0;
-		/*	if (delta > 0.0) {
-				modelweight += data->getBinningFactor()
-						* fit_model->getUncertaincy(
-								data_point->bin_center_value).second; // take upper error of model (second)
-			} else {
-				modelweight += data->getBinningFactor()
-						* fit_model->getUncertaincy(
-								data_point->bin_center_value).first; // take lower error of model (first)
+			if (z_error[i] != 0.0)
+				weightsquare = z_error[i] * z_error[i];
+			fit_model->evalParameterDerivatives(&coordinates[j * dimension],
+					parameters, derivatives.data());
+			mydouble factor = -2.0 * delta / weightsquare * scale * binning_factor;
+			for (unsigned int k = 0; k < parameters.size(); k++)
+				gradient[k] += factor * derivatives[k];
+		}
+	}
+}
+
+bool Chi2Estimator::implementsResiduals() const {
+	return true;
+}
+
+void Chi2Estimator::evalResiduals(std::shared_ptr<Data> data,
+		const std::vector<std::shared_ptr<ModelPar> > &parameters,
+		mydouble *residuals, mydouble *jacobian) {
+	const BinnedDataSet &binned_data = data->getBinnedDataSet();
+	const mydouble *z = binned_data.getZ();
+	const mydouble *z_error = binned_data.getZError();
+	const mydouble binning_factor = data->getBinningFactor();
+	const unsigned int dimension = data->getDimension();
+
+	const unsigned int batch_size(256);
+	mydouble coordinates[2 * batch_size];
+	unsigned int indices[batch_size];
+	mydouble model_values[batch_size];
+
+	unsigned int residual_index(0);
+	unsigned int position(0);
+	while (position < binned_data.size()) {
+		unsigned int count = binned_data.gatherUsedDataPoints(position,
+				dimension, batch_size, coordinates, indices);
+		fit_model->evaluateBatch(coordinates, count, model_values);
+		for (unsigned int j = 0; j < count; j++, residual_index++) {
+			const unsigned int i = indices[j];
+			mydouble weight(1.0);
+			if (z_error[i] != 0.0)
+				weight = std::abs(z_error[i]);
+			residuals[residual_index] = (z[i] - model_values[j] * binning_factor)
+					/ weight;
+			if (jacobian) {
+				mydouble *row = jacobian + residual_index * parameters.size();
+				fit_model->evalParameterDerivatives(&coordinates[j * dimension],
+						parameters, row);
+				for (unsigned int k = 0; k < parameters.size(); k++)
+					row[k] *= -binning_factor / weight;
 			}
-			weightsquare += modelweight * modelweight;*/
-			chisq += delta * delta / weightsquare;
 		}
 	}
-	return chisq;
 }
@@ -11,6 +11,35 @@
 #include "fit/ModelEstimator.h"
 
 class Chi2Estimator: public ModelEstimator {
+protected:
+	/**
+	 * For a model s * m the chi2 is minimal at
+	 * s = sum(z * m / w) / sum(m^2 / w), with w the squared errors. The sums
+	 * are data_term = sum(z^2 / w), mixed_term = sum(z * m / w) and
+	 * model_term = sum(m^2 / w).
+	 */
+	ScaleProfileSums evalScaleProfileSums(std::shared_ptr<Data> data);
+	std::pair<mydouble, mydouble> calculateProfiledScale(
+			const ScaleProfileSums &sums) const;
+	mydouble calculateProfiledEstimatorValue(
+			const ScaleProfileSums &sums) const;
+
+	bool implementsGradient() const;
+	/**
+	 * d/dp sum((z - s * m)^2 / w) = -2 * sum((z - s * m) / w * s * dm/dp)
+	 */
+	void evalGradient(std::shared_ptr<Data> data,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble scale, mydouble *gradient);
+
+	bool implementsResiduals() const;
+	/**
+	 * r = (z - m) / sqrt(w), so the chi2 is exactly sum(r^2).
+	 */
+	void evalResiduals(std::shared_ptr<Data> data,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *residuals, mydouble *jacobian);
+
 public:
 	Chi2Estimator();
 	virtual ~Chi2Estimator();
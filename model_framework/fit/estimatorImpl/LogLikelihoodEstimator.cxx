@@ -1,7 +1,9 @@
 #include "LogLikelihoodEstimator.h"
 #include "core/Model.h"
+#include "core/PairwiseSum.h"
 #include "fit/data/Data.h"
 
+#include <algorithm>
 #include <cmath>
 
 LogLikelihoodEstimator::LogLikelihoodEstimator() : ModelEstimator(true) {
@@ -16,54 +18,178 @@ mydouble LogLikelihoodEstimator::eval(std::shared_ptr<Data> data) {
   //calculate loglikelihood
   // poisson sum_i(y_i * ln (f(x_i)) - f(x_i))
 
-  std::vector<DataPointProxy> &data_points = data->getData();
+  const BinnedDataSet &binned_data = data->getBinnedDataSet();
+  const mydouble *z = binned_data.getZ();
+  const mydouble binning_factor = data->getBinningFactor();
 
-  //mydouble loglikelihood(0.0);
-  //mydouble delta;
+  // summed pairwise in a fixed order, so the result is reproducible
+  PairwiseSum sum;
 
-  std::vector<mydouble> deltas;
-  deltas.reserve(data_points.size());
+  // the model is evaluated in batches of used data points
+  const unsigned int batch_size(256);
+  mydouble coordinates[2 * batch_size];
+  unsigned int indices[batch_size];
+  mydouble model_values[batch_size];
 
-  // loop over data
-  for (unsigned int i = 0; i < data_points.size(); i++) {
-    std::shared_ptr<DataStructs::binned_data_point> data_point;
-    if (data_points[i].isPointUsed()) {
-      data_point = data_points[i].getBinnedDataPoint();
-      mydouble model_value = fit_model->evaluate(data_point->bin_center_value)
-          * data->getBinningFactor();
+  unsigned int position(0);
+  while (position < binned_data.size()) {
+    unsigned int count = binned_data.gatherUsedDataPoints(position,
+        data->getDimension(), batch_size, coordinates, indices);
+    fit_model->evaluateBatch(coordinates, count, model_values);
+    for (unsigned int j = 0; j < count; j++) {
+      mydouble model_value = model_values[j] * binning_factor;
       // if model is zero at this point should be removed otherwise log(0)!!!
       if (model_value <= 0.0)
         continue;
-      //delta = model_value - data_point->z * log(model_value);
-      //loglikelihood += delta;
-      deltas.push_back(model_value);
-      deltas.push_back(-data_point->z * std::log(model_value));
+      sum.add(model_value);
+      sum.add(-z[indices[j]] * std::log(model_value));
     }
   }
 
-  while (deltas.size() > 2) {
-    std::vector<mydouble> temp_sum;
-    temp_sum.reserve(deltas.size() / 2 + 1);
-    if (deltas.size() % 2 == 0) {
-      for (unsigned int i = 0; i < deltas.size(); i = i + 2) {
-        temp_sum.push_back(deltas[i] + deltas[i + 1]);
-      }
-    }
-    else {
-      for (unsigned int i = 0; i < deltas.size() - 1; i = i + 2) {
-        temp_sum.push_back(deltas[i] + deltas[i + 1]);
-      }
-      temp_sum.push_back(deltas.back());
+  return sum.sum();
+}
+
+ModelEstimator::ScaleProfileSums LogLikelihoodEstimator::evalScaleProfileSums(
+    std::shared_ptr<Data> data) {
+  const BinnedDataSet &binned_data = data->getBinnedDataSet();
+  const mydouble *z = binned_data.getZ();
+  const mydouble binning_factor = data->getBinningFactor();
+
+  ScaleProfileSums sums;
+
+  const unsigned int batch_size(256);
+  mydouble coordinates[2 * batch_size];
+  unsigned int indices[batch_size];
+  mydouble model_values[batch_size];
+
+  unsigned int position(0);
+  while (position < binned_data.size()) {
+    unsigned int count = binned_data.gatherUsedDataPoints(position,
+        data->getDimension(), batch_size, coordinates, indices);
+    fit_model->evaluateBatch(coordinates, count, model_values);
+    for (unsigned int j = 0; j < count; j++) {
+      mydouble model_value = model_values[j] * binning_factor;
+      // same as in eval(): points with a vanishing model are skipped
+      if (model_value <= 0.0)
+        continue;
+      sums.data_term += z[indices[j]];
+      sums.mixed_term += z[indices[j]] * std::log(model_value);
+      sums.model_term += model_value;
     }
-    deltas = temp_sum;
   }
+  return sums;
+}
+
+std::pair<mydouble, mydouble> LogLikelihoodEstimator::calculateProfiledScale(
+    const ScaleProfileSums &sums) const {
+  if (sums.model_term <= 0.0 || sums.data_term <= 0.0)
+    return std::make_pair(0.0, 0.0);
+  mydouble scale = sums.data_term / sums.model_term;
+  // the second derivative of the likelihood is sum(z) / s^2
+  return std::make_pair(scale, scale / std::sqrt(sums.data_term));
+}
 
-  mydouble sum_value(0.0);
-  if (deltas.size() == 1)
-    sum_value = deltas[0];
-  if (deltas.size() == 2)
-    sum_value = deltas[0] + deltas[1];
+mydouble LogLikelihoodEstimator::calculateProfiledEstimatorValue(
+    const ScaleProfileSums &sums) const {
+  // sum(s * m - z * ln(s * m)) with s = sum(z) / sum(m)
+  if (sums.model_term <= 0.0 || sums.data_term <= 0.0)
+    return -sums.mixed_term;
+  mydouble scale = sums.data_term / sums.model_term;
+  return sums.data_term * (1.0 - std::log(scale)) - sums.mixed_term;
+}
 
-  return sum_value;
+bool LogLikelihoodEstimator::implementsGradient() const {
+  return true;
 }
 
+void LogLikelihoodEstimator::evalGradient(std::shared_ptr<Data> data,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters, mydouble scale,
+    mydouble *gradient) {
+  const BinnedDataSet &binned_data = data->getBinnedDataSet();
+  const mydouble *z = binned_data.getZ();
+  const mydouble binning_factor = data->getBinningFactor();
+  const unsigned int dimension = data->getDimension();
+
+  std::vector<mydouble> derivatives(parameters.size());
+
+  const unsigned int batch_size(256);
+  mydouble coordinates[2 * batch_size];
+  unsigned int indices[batch_size];
+  mydouble model_values[batch_size];
+
+  unsigned int position(0);
+  while (position < binned_data.size()) {
+    unsigned int count = binned_data.gatherUsedDataPoints(position, dimension,
+        batch_size, coordinates, indices);
+    fit_model->evaluateBatch(coordinates, count, model_values);
+    for (unsigned int j = 0; j < count; j++) {
+      mydouble model_value = model_values[j] * binning_factor;
+      // same as in eval(): points with a vanishing model are skipped
+      if (model_value <= 0.0)
+        continue;
+      fit_model->evalParameterDerivatives(&coordinates[j * dimension],
+          parameters, derivatives.data());
+      mydouble factor = (scale - z[indices[j]] / model_value) * binning_factor;
+      for (unsigned int k = 0; k < parameters.size(); k++)
+        gradient[k] += factor * derivatives[k];
+    }
+  }
+}
+
+bool LogLikelihoodEstimator::implementsResiduals() const {
+  return true;
+}
+
+void LogLikelihoodEstimator::evalResiduals(std::shared_ptr<Data> data,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *residuals, mydouble *jacobian) {
+  const BinnedDataSet &binned_data = data->getBinnedDataSet();
+  const mydouble *z = binned_data.getZ();
+  const mydouble binning_factor = data->getBinningFactor();
+  const unsigned int dimension = data->getDimension();
+
+  const unsigned int batch_size(256);
+  mydouble coordinates[2 * batch_size];
+  unsigned int indices[batch_size];
+  mydouble model_values[batch_size];
+
+  unsigned int residual_index(0);
+  unsigned int position(0);
+  while (position < binned_data.size()) {
+    unsigned int count = binned_data.gatherUsedDataPoints(position, dimension,
+        batch_size, coordinates, indices);
+    fit_model->evaluateBatch(coordinates, count, model_values);
+    for (unsigned int j = 0; j < count; j++, residual_index++) {
+      mydouble model_value = model_values[j] * binning_factor;
+      mydouble *row(
+          jacobian ? jacobian + residual_index * parameters.size() : 0);
+      // same as in eval(): points with a vanishing model are skipped
+      if (model_value <= 0.0) {
+        residuals[residual_index] = 0.0;
+        if (row) {
+          for (unsigned int k = 0; k < parameters.size(); k++)
+            row[k] = 0.0;
+        }
+        continue;
+      }
+      const mydouble data_value(z[indices[j]]);
+      mydouble deviance(model_value - data_value);
+      if (data_value > 0.0)
+        deviance += data_value * std::log(data_value / model_value);
+      mydouble residual(std::sqrt(std::max(deviance, (mydouble) 0.0)));
+      if (data_value < model_value)
+        residual = -residual;
+      residuals[residual_index] = residual;
+      if (row) {
+        fit_model->evalParameterDerivatives(&coordinates[j * dimension],
+            parameters, row);
+        // for z -> m the factor approaches -1 / sqrt(2 * m)
+        mydouble factor(-1.0 / std::sqrt(2.0 * model_value));
+        if (std::abs(residual) > 1e-6 * std::sqrt(model_value))
+          factor = (1.0 - data_value / model_value) / (2.0 * residual);
+        for (unsigned int k = 0; k < parameters.size(); k++)
+          row[k] *= factor * binning_factor;
+      }
+    }
+  }
+}
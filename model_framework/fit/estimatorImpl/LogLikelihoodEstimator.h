@@ -4,7 +4,38 @@
 #include "fit/ModelEstimator.h"
 
 class LogLikelihoodEstimator: public ModelEstimator {
-private:
+protected:
+	/**
+	 * For a model s * m the likelihood is minimal at
+	 * s = sum(z) / sum(m). The sums are
+	 * data_term = sum(z), mixed_term = sum(z * ln(m)) and model_term = sum(m).
+	 */
+	ScaleProfileSums evalScaleProfileSums(std::shared_ptr<Data> data);
+	std::pair<mydouble, mydouble> calculateProfiledScale(
+			const ScaleProfileSums &sums) const;
+	mydouble calculateProfiledEstimatorValue(
+			const ScaleProfileSums &sums) const;
+
+	bool implementsGradient() const;
+	/**
+	 * d/dp sum(s * m - z * ln(s * m)) = sum((s - z / m) * dm/dp)
+	 */
+	void evalGradient(std::shared_ptr<Data> data,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble scale, mydouble *gradient);
+
+	bool implementsResiduals() const;
+	/**
+	 * Signed deviance residuals r = sign(z - m) * sqrt(m - z + z * ln(z / m)),
+	 * so the likelihood is sum(r^2) up to a constant. With
+	 * dr/dp = (1 - z / m) * dm/dp / (2 * r) the gradient 2 * J^T * r is the
+	 * one of the likelihood (Gauss-Newton form of the poisson likelihood).
+	 * Points with a vanishing model have zero residuals.
+	 */
+	void evalResiduals(std::shared_ptr<Data> data,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *residuals, mydouble *jacobian);
+
 public:
 		LogLikelihoodEstimator();
 	virtual ~LogLikelihoodEstimator();
@@ -1,65 +1,164 @@
 #include "UnbinnedLogLikelihoodEstimator.h"
 #include "core/Model.h"
+#include "core/PairwiseSum.h"
 #include "fit/data/Data.h"
 
 #include <cmath>
-#include <iostream>
+#include <functional>
+#include <stdexcept>
 
-UnbinnedLogLikelihoodEstimator::UnbinnedLogLikelihoodEstimator() :
-    ModelEstimator(true), last_integral(0.0), skip_integral(false), integral_skip_counter(
-        0), integral_skip_amount(5) {
-  // TODO Auto-generated constructor stub
+UnbinnedLogLikelihoodEstimator::UnbinnedLogLikelihoodEstimator(
+    bool extended_) :
+    ModelEstimator(true), extended(extended_), normalization_bins(200), normalization_integral(
+        0.0) {
+  normalization_row_task = std::bind(
+      &UnbinnedLogLikelihoodEstimator::evaluateNormalizationRow, this,
+      std::placeholders::_1);
 }
 
 UnbinnedLogLikelihoodEstimator::~UnbinnedLogLikelihoodEstimator() {
   // TODO Auto-generated destructor stub
 }
 
+bool UnbinnedLogLikelihoodEstimator::isExtended() const {
+  return extended;
+}
+
+void UnbinnedLogLikelihoodEstimator::setExtended(bool extended_) {
+  extended = extended_;
+}
+
+void UnbinnedLogLikelihoodEstimator::setNormalizationScaleParameterName(
+    const std::string &scale_parameter_name) {
+  normalization_tracker.setScaleParameterName(scale_parameter_name);
+}
+
+void UnbinnedLogLikelihoodEstimator::setNormalizationGridBins(
+    unsigned int normalization_bins_) {
+  if (normalization_bins_ == 0)
+    throw std::runtime_error(
+        "UnbinnedLogLikelihoodEstimator::setNormalizationGridBins: the grid needs at least one bin!");
+  normalization_bins = normalization_bins_;
+  normalization_tracker.invalidate();
+}
+
 mydouble UnbinnedLogLikelihoodEstimator::eval(std::shared_ptr<Data> data) {
-  //calculate loglikelihood
-  // poisson sum_i(y_i * ln (f(x_i)) - f(x_i))
-
-  mydouble loglikelihood = 0.0;
-
-  std::vector<DataPointProxy> &data_points = data->getData();
-  // loop over data
-  for (unsigned int i = 0; i < data_points.size(); i++) {
-    std::shared_ptr<DataStructs::unbinned_data_point> data_point;
-    if (data_points[i].isPointUsed()) {
-      data_point = data_points[i].getUnbinnedDataPoint();
-      mydouble model_value = fit_model->evaluate(data_point->x);
+  // -sum_i ln(m(x_i)), the normalization is added once per evaluation in
+  // evalDataIndependentTerm()
+  const UnbinnedDataSet &events = data->getUnbinnedDataSet();
+
+  // summed pairwise in a fixed order, so the result is reproducible
+  PairwiseSum sum;
+
+  // the model is evaluated in batches of used events
+  const unsigned int batch_size(256);
+  mydouble coordinates[2 * batch_size];
+  unsigned int indices[batch_size];
+  mydouble model_values[batch_size];
+
+  unsigned int position(0);
+  while (position < events.size()) {
+    unsigned int count = events.gatherUsedDataPoints(position,
+        data->getDimension(), batch_size, coordinates, indices);
+    fit_model->evaluateBatch(coordinates, count, model_values);
+    for (unsigned int j = 0; j < count; j++) {
       // if model is zero at this point should be removed otherwise log(0)!!!
-      if (model_value <= 0.0)
+      if (model_values[j] <= 0.0)
         continue;
+      sum.add(-std::log(model_values[j]));
+    }
+  }
 
-      loglikelihood += log(model_value);
+  return sum.sum();
+}
+
+void UnbinnedLogLikelihoodEstimator::evaluateNormalizationRow(
+    unsigned int row_index) {
+  const unsigned int dimension(getData()->getDimension());
+  const unsigned int bins_y(dimension > 1 ? normalization_bins : 1);
+
+  // same radial fit range as in ModelEstimator::applyEstimatorOptions(), the
+  // grid then covers the whole disk of the outer radius
+  const bool radial_range(
+      dimension > 1 && normalization_range_x == normalization_range_y);
+  const mydouble inner_radius_square(
+      std::pow(normalization_range_x.range_low, 2));
+  const mydouble outer_radius_square(
+      std::pow(normalization_range_x.range_high, 2));
+  DataStructs::DimensionRange grid_range_x(normalization_range_x);
+  DataStructs::DimensionRange grid_range_y(normalization_range_y);
+  if (radial_range) {
+    grid_range_x = DataStructs::DimensionRange(
+        -normalization_range_x.range_high, normalization_range_x.range_high);
+    grid_range_y = grid_range_x;
+  }
+
+  const mydouble bin_width_x(
+      grid_range_x.getDimensionLength() / normalization_bins);
+  const mydouble bin_width_y(
+      dimension > 1 ? grid_range_y.getDimensionLength() / normalization_bins :
+          1.0);
+  const mydouble x(grid_range_x.range_low + (0.5 + row_index) * bin_width_x);
+
+  std::vector<mydouble> coordinates(dimension * bins_y);
+  unsigned int count(0);
+  for (unsigned int iy = 0; iy < bins_y; ++iy) {
+    const mydouble y(grid_range_y.range_low + (0.5 + iy) * bin_width_y);
+    if (radial_range) {
+      mydouble radius_square(x * x + y * y);
+      if (radius_square < inner_radius_square
+          || radius_square > outer_radius_square)
+        continue;
     }
+    coordinates[dimension * count] = x;
+    if (dimension > 1)
+      coordinates[dimension * count + 1] = y;
+    ++count;
   }
+  std::vector<mydouble> model_values(count);
+  fit_model->evaluateBatch(coordinates.data(), count, model_values.data());
+  normalization_row_integrals[row_index] = PairwiseSum::sum(
+      model_values.data(), count) * bin_width_x * bin_width_y;
+}
+
+mydouble UnbinnedLogLikelihoodEstimator::getNormalizationIntegral() {
+  const DataStructs::DimensionRange &fit_range_x =
+      estimator_options.getFitRangeX();
+  const DataStructs::DimensionRange &fit_range_y =
+      estimator_options.getFitRangeY();
+  if (!fit_range_x.is_active
+      || (getData()->getDimension() > 1 && !fit_range_y.is_active))
+    throw std::runtime_error(
+        "UnbinnedLogLikelihoodEstimator: the normalization integral requires active fit ranges!");
+  if (fit_range_x != normalization_range_x
+      || fit_range_y != normalization_range_y) {
+    normalization_range_x = fit_range_x;
+    normalization_range_y = fit_range_y;
+    normalization_tracker.invalidate();
+  }
+
+  ModelParSet &dependencies = fit_model->getModelParameterSet();
+  ModelParameterDependencyTracker::UpdateType update_type =
+      normalization_tracker.checkForUpdate(dependencies);
+  if (update_type == ModelParameterDependencyTracker::RESCALE) {
+    normalization_integral *= normalization_tracker.getScaleFactor(
+        dependencies);
+    normalization_tracker.markComputed(dependencies);
+  }
+  else if (update_type == ModelParameterDependencyTracker::FULL_UPDATE) {
+    normalization_row_integrals.resize(normalization_bins);
+    runTask(normalization_row_task, normalization_bins);
+    normalization_integral = PairwiseSum::sum(
+        normalization_row_integrals.data(), normalization_bins);
+    normalization_tracker.markComputed(dependencies);
+  }
+  return normalization_integral;
+}
 
-  // normalization integral
-  std::cout << "calculating normalization integral..." << std::endl;
-  std::vector<DataStructs::DimensionRange> int_ranges;
-  int_ranges.push_back(estimator_options.getFitRangeX());
-  int_ranges.push_back(estimator_options.getFitRangeY());
-
-  mydouble integral = fit_model->Integral(int_ranges, 1e-3);
-  std::cout << "calculated!" << std::endl;
-  std::cout << data_points.size() << std::endl;
-  /*if (!skip_integral) {
-   if (integral > 0.0) {
-   if (fabs(integral - last_integral) / integral < 1e-2) {
-   skip_integral = false;
-   integral_skip_counter = integral_skip_amount;
-   }
-   }
-   last_integral = integral;
-   std::cout << "calculated!" << std::endl;
-   } else {
-   if (integral_skip_counter < 0)
-   skip_integral = false;
-   else
-   --integral_skip_counter;
-   }*/
-
-  return -(loglikelihood - data_points.size() * integral);
+mydouble UnbinnedLogLikelihoodEstimator::evalDataIndependentTerm() {
+  mydouble integral = getNormalizationIntegral();
+  if (extended)
+    return integral;
+  return getData()->getUnbinnedDataSet().getNumberOfUsedDataPoints()
+      * std::log(integral);
 }
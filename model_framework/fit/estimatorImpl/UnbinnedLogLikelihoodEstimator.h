@@ -2,18 +2,80 @@
 #define UNBINNEDLOGLIKELIHOODESTIMATOR_H_
 
 #include "fit/ModelEstimator.h"
+#include "core/ModelParameterDependencyTracker.h"
 
+/**
+ * Unbinned negative log likelihood of the events within the fit ranges.
+ *
+ * The model is the event density (number of events per unit of the data
+ * dimensions), so its integral over the fit ranges is the expected number
+ * of events nu. The standard likelihood normalizes the model to unity,
+ *
+ *   -sum_i ln(m(x_i)) + N * ln(nu),
+ *
+ * and is therefore independent of the overall scale of the model. The
+ * extended likelihood (see #setExtended()) adds the poisson term of the
+ * number of events instead,
+ *
+ *   -sum_i ln(m(x_i)) + nu,
+ *
+ * so a scale parameter of the model like the luminosity can be fitted
+ * directly.
+ *
+ * The event sum runs on the data chunks of the #ModelEstimator. The
+ * normalization integral is computed once per evaluation on a regular grid
+ * over the fit ranges (midpoint rule), whose rows are distributed on the
+ * worker pool. It is cached and only recomputed if a model parameter
+ * changed. If a linear scale parameter is declared with
+ * #setNormalizationScaleParameterName(), a change of only this parameter
+ * rescales the cached integral.
+ */
 class UnbinnedLogLikelihoodEstimator: public ModelEstimator {
 private:
-	mydouble last_integral;
-	bool skip_integral;
+	bool extended;
+
+	unsigned int normalization_bins;
+
+	ModelParameterDependencyTracker normalization_tracker;
+	mydouble normalization_integral;
+	// fit ranges the cached integral was computed for
+	DataStructs::DimensionRange normalization_range_x;
+	DataStructs::DimensionRange normalization_range_y;
+
+	// integrals of the individual grid rows, summed in a fixed order
+	std::vector<mydouble> normalization_row_integrals;
+	WorkerPool::Task normalization_row_task;
+
+	void evaluateNormalizationRow(unsigned int row_index);
+	mydouble getNormalizationIntegral();
+
+protected:
+	/**
+	 * The normalization term, N * ln(nu) or nu for the extended likelihood.
+	 */
+	mydouble evalDataIndependentTerm();
 
-	int integral_skip_counter;
-	int integral_skip_amount;
 public:
-	UnbinnedLogLikelihoodEstimator();
+	UnbinnedLogLikelihoodEstimator(bool extended_ = false);
 	virtual ~UnbinnedLogLikelihoodEstimator();
 
+	bool isExtended() const;
+	void setExtended(bool extended_);
+
+	/**
+	 * Declares the model parameter with this name (e.g. the luminosity) as a
+	 * pure scale factor of the model, see #ModelParameterDependencyTracker.
+	 */
+	void setNormalizationScaleParameterName(
+			const std::string &scale_parameter_name);
+
+	/**
+	 * Number of grid bins per dimension of the normalization integral
+	 * (default 200). For a #CachedModel2D the grid of the cached model should
+	 * be used, then the integral is exact.
+	 */
+	void setNormalizationGridBins(unsigned int normalization_bins_);
+
 	// the likelihood function
 	mydouble eval(std::shared_ptr<Data> data);
 };
@@ -0,0 +1,289 @@
+/*
+ * LevenbergMarquardtMinimizer.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "LevenbergMarquardtMinimizer.h"
+#include "core/FitTracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+/**
+ * In place cholesky decomposition of the symmetric n x n matrix a (row
+ * major) into the lower triangle. Returns false if a is not positive
+ * definite.
+ */
+bool choleskyDecompose(std::vector<mydouble> &a, unsigned int n) {
+  for (unsigned int j = 0; j < n; ++j) {
+    mydouble diagonal(a[j * n + j]);
+    for (unsigned int k = 0; k < j; ++k)
+      diagonal -= a[j * n + k] * a[j * n + k];
+    if (!(diagonal > 0.0))
+      return false;
+    a[j * n + j] = std::sqrt(diagonal);
+    for (unsigned int i = j + 1; i < n; ++i) {
+      mydouble value(a[i * n + j]);
+      for (unsigned int k = 0; k < j; ++k)
+        value -= a[i * n + k] * a[j * n + k];
+      a[i * n + j] = value / a[j * n + j];
+    }
+  }
+  return true;
+}
+
+/**
+ * Solves l * l^T * x = b in place for the decomposition of
+ * #choleskyDecompose().
+ */
+void choleskySolve(const std::vector<mydouble> &l, unsigned int n,
+    mydouble *b) {
+  for (unsigned int i = 0; i < n; ++i) {
+    for (unsigned int k = 0; k < i; ++k)
+      b[i] -= l[i * n + k] * b[k];
+    b[i] /= l[i * n + i];
+  }
+  for (unsigned int i = n; i-- > 0;) {
+    for (unsigned int k = i + 1; k < n; ++k)
+      b[i] -= l[k * n + i] * b[k];
+    b[i] /= l[i * n + i];
+  }
+}
+}
+
+LevenbergMarquardtMinimizer::LevenbergMarquardtMinimizer() :
+    max_iterations(100), edm_tolerance(1e-5), finite_difference_step(1e-6), has_covariance(
+        false) {
+}
+
+LevenbergMarquardtMinimizer::~LevenbergMarquardtMinimizer() {
+}
+
+void LevenbergMarquardtMinimizer::setMaximumIterations(
+    unsigned int max_iterations_) {
+  max_iterations = max_iterations_;
+}
+
+void LevenbergMarquardtMinimizer::setTolerance(mydouble edm_tolerance_) {
+  edm_tolerance = edm_tolerance_;
+}
+
+void LevenbergMarquardtMinimizer::setFiniteDifferenceStep(
+    mydouble finite_difference_step_) {
+  finite_difference_step = finite_difference_step_;
+}
+
+void LevenbergMarquardtMinimizer::increaseFunctionCallLimit() {
+  max_iterations *= 2;
+}
+
+void LevenbergMarquardtMinimizer::calculateJacobian(
+    const std::vector<mydouble> &pars, const std::vector<mydouble> &residuals,
+    std::vector<mydouble> &jacobian) {
+  const unsigned int number_of_parameters(pars.size());
+  const unsigned int number_of_residuals(residuals.size());
+  std::vector<mydouble> shifted_pars(pars);
+  std::vector<mydouble> shifted_residuals(number_of_residuals);
+  for (unsigned int k = 0; k < number_of_parameters; ++k) {
+    mydouble scale(pars[k] != 0.0 ? std::abs(pars[k]) : 0.1);
+    shifted_pars[k] = pars[k] + finite_difference_step * scale;
+    // the exactly representable step
+    mydouble step(shifted_pars[k] - pars[k]);
+    control_parameter->evaluateResiduals(shifted_pars.data(),
+        shifted_residuals.data(), 0);
+    for (unsigned int i = 0; i < number_of_residuals; ++i)
+      jacobian[i * number_of_parameters + k] = (shifted_residuals[i]
+          - residuals[i]) / step;
+    shifted_pars[k] = pars[k];
+  }
+}
+
+void LevenbergMarquardtMinimizer::calculateNormalEquations(
+    const std::vector<mydouble> &residuals,
+    const std::vector<mydouble> &jacobian, std::vector<mydouble> &jtj,
+    std::vector<mydouble> &jtr) const {
+  const unsigned int n(jtr.size());
+  std::fill(jtj.begin(), jtj.end(), 0.0);
+  std::fill(jtr.begin(), jtr.end(), 0.0);
+  for (unsigned int i = 0; i < residuals.size(); ++i) {
+    const mydouble *row = &jacobian[i * n];
+    for (unsigned int j = 0; j < n; ++j) {
+      jtr[j] += row[j] * residuals[i];
+      for (unsigned int k = 0; k <= j; ++k)
+        jtj[j * n + k] += row[j] * row[k];
+    }
+  }
+  for (unsigned int j = 0; j < n; ++j) {
+    for (unsigned int k = 0; k < j; ++k)
+      jtj[k * n + j] = jtj[j * n + k];
+  }
+}
+
+ModelFitResult LevenbergMarquardtMinimizer::createModelFitResult() const {
+  ModelFitResult fit_result;
+
+  auto const &parameters = control_parameter->getParameterList();
+  const unsigned int n(parameter_values.size());
+  std::vector<std::pair<std::string, std::string> > names;
+  std::vector<double> matrix(n * n, 0.0);
+  for (unsigned int i = 0; i < n; i++) {
+    double error(0.0);
+    if (has_covariance) {
+      error = std::sqrt(covariance[i * n + i]);
+      for (unsigned int j = 0; j < n; j++)
+        matrix[i * n + j] = covariance[i * n + j];
+    }
+    fit_result.addFitParameter(parameters[i].name, parameter_values[i], error);
+    names.push_back(parameters[i].name);
+  }
+  if (has_covariance)
+    fit_result.setCovarianceMatrix(names, matrix);
+
+  return fit_result;
+}
+
+int LevenbergMarquardtMinimizer::minimize() {
+  LMDFIT_TRACE_SCOPE("minimizer", "LevenbergMarquardtMinimizer::minimize");
+  if (!control_parameter->providesResiduals())
+    throw std::runtime_error(
+        "LevenbergMarquardtMinimizer: the control parameter does not provide residuals!");
+
+  const unsigned int n(control_parameter->getParameterList().size());
+  const unsigned int m(control_parameter->getNumberOfResiduals());
+  const bool analytic_jacobian(control_parameter->providesResidualJacobian());
+  std::cout << "Levenberg-Marquardt fit of " << n << " parameters to " << m
+      << " residuals, using the "
+      << (analytic_jacobian ? "analytic" : "numerical") << " jacobian"
+      << std::endl;
+
+  parameter_values.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+    parameter_values[i] = control_parameter->getParameterList()[i].value;
+  has_covariance = false;
+
+  std::vector<mydouble> residuals(m);
+  std::vector<mydouble> jacobian(m * n);
+  std::vector<mydouble> jtj(n * n);
+  std::vector<mydouble> jtr(n);
+  std::vector<mydouble> decomposition(n * n);
+  std::vector<mydouble> delta(n);
+  std::vector<mydouble> trial_values(n);
+
+  mydouble estimator_value = control_parameter->evaluate(
+      parameter_values.data());
+  control_parameter->evaluateResiduals(parameter_values.data(),
+      residuals.data(), analytic_jacobian ? jacobian.data() : 0);
+  if (!analytic_jacobian)
+    calculateJacobian(parameter_values, residuals, jacobian);
+
+  const mydouble max_lambda(1e20);
+  mydouble lambda(1e-3);
+  mydouble nu(2.0);
+  int status(1);
+
+  for (unsigned int iteration = 0; iteration < max_iterations; ++iteration) {
+    calculateNormalEquations(residuals, jacobian, jtj, jtr);
+
+    // estimated distance to the minimum
+    decomposition = jtj;
+    if (choleskyDecompose(decomposition, n)) {
+      delta = jtr;
+      choleskySolve(decomposition, n, delta.data());
+      mydouble edm(0.0);
+      for (unsigned int j = 0; j < n; ++j)
+        edm += jtr[j] * delta[j];
+      std::cout << "iteration " << iteration << ": estimator "
+          << estimator_value << ", edm " << edm << ", lambda " << lambda
+          << std::endl;
+      if (edm < edm_tolerance) {
+        status = 0;
+        break;
+      }
+    }
+
+    // increase the damping until a step lowers the estimator
+    bool accepted(false);
+    while (!accepted && lambda < max_lambda) {
+      decomposition = jtj;
+      for (unsigned int j = 0; j < n; ++j) {
+        // parameters without any influence are damped with unity
+        mydouble diagonal(jtj[j * n + j] > 0.0 ? jtj[j * n + j] : 1.0);
+        decomposition[j * n + j] += lambda * diagonal;
+      }
+      if (!choleskyDecompose(decomposition, n)) {
+        lambda *= nu;
+        nu *= 2.0;
+        continue;
+      }
+      for (unsigned int j = 0; j < n; ++j)
+        delta[j] = -jtr[j];
+      choleskySolve(decomposition, n, delta.data());
+
+      // reduction predicted by the damped linear model of the residuals
+      mydouble predicted_reduction(0.0);
+      for (unsigned int j = 0; j < n; ++j) {
+        mydouble diagonal(jtj[j * n + j] > 0.0 ? jtj[j * n + j] : 1.0);
+        predicted_reduction += delta[j]
+            * (lambda * diagonal * delta[j] - jtr[j]);
+        trial_values[j] = parameter_values[j] + delta[j];
+      }
+      mydouble trial_estimator_value = control_parameter->evaluate(
+          trial_values.data());
+
+      mydouble reduction(estimator_value - trial_estimator_value);
+      if (std::isfinite(trial_estimator_value) && reduction > 0.0
+          && predicted_reduction > 0.0) {
+        accepted = true;
+        mydouble rho(reduction / predicted_reduction);
+        lambda *= std::max((mydouble) (1.0 / 3.0),
+            1 - std::pow(2 * rho - 1, 3));
+        nu = 2.0;
+        parameter_values = trial_values;
+        estimator_value = trial_estimator_value;
+        control_parameter->evaluateResiduals(parameter_values.data(),
+            residuals.data(), analytic_jacobian ? jacobian.data() : 0);
+        if (!analytic_jacobian)
+          calculateJacobian(parameter_values, residuals, jacobian);
+      }
+      else {
+        lambda *= nu;
+        nu *= 2.0;
+      }
+    }
+    if (!accepted) {
+      std::cout << "no further reduction of the estimator possible" << std::endl;
+      break;
+    }
+  }
+
+  // covariance at the final parameters
+  calculateNormalEquations(residuals, jacobian, jtj, jtr);
+  decomposition = jtj;
+  if (choleskyDecompose(decomposition, n)) {
+    covariance.assign(n * n, 0.0);
+    for (unsigned int j = 0; j < n; ++j) {
+      std::vector<mydouble> unit(n, 0.0);
+      unit[j] = 1.0;
+      choleskySolve(decomposition, n, unit.data());
+      for (unsigned int k = 0; k < n; ++k)
+        covariance[k * n + j] = unit[k];
+    }
+    has_covariance = true;
+  }
+  else {
+    std::cout << "WARNING: the covariance matrix is not positive definite!"
+        << std::endl;
+    if (status == 0)
+      status = 2;
+  }
+
+  // leave the control parameter at the final parameters, the last
+  // evaluation might have been a rejected step
+  control_parameter->evaluate(parameter_values.data());
+  std::cout << "Fit done!" << std::endl;
+  return status;
+}
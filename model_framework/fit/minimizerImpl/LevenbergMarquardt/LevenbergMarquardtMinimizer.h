@@ -0,0 +1,73 @@
+/*
+ * LevenbergMarquardtMinimizer.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef LEVENBERGMARQUARDTMINIMIZER_H_
+#define LEVENBERGMARQUARDTMINIMIZER_H_
+
+#include "fit/ModelMinimizer.h"
+#include "fit/ModelFitResult.h"
+
+#include <vector>
+
+/**
+ * Levenberg-Marquardt minimizer for control parameters which are (or behave
+ * like) a sum of squared residuals, see
+ * #ModelControlParameter::providesResiduals(). The chi2 is one directly, the
+ * poisson likelihood via its deviance residuals.
+ *
+ * Each iteration solves (J^T J + lambda * diag(J^T J)) * delta = -J^T r for
+ * the residuals r and their jacobian J at the current parameters. The step
+ * is accepted if it lowers the value of the control parameter, and lambda
+ * is adapted to the ratio of the actual and the predicted reduction
+ * (Nielsen's strategy). The jacobian is taken from the control parameter if
+ * it provides one, otherwise it is computed with forward differences. The
+ * minimization has converged once the estimated distance to the minimum,
+ * r^T J (J^T J)^-1 J^T r, drops below the tolerance.
+ *
+ * The parameter errors and the covariance matrix are (J^T J)^-1 at the
+ * minimum. This is the same convention as for the ROOTMinimizer, where a
+ * change of the control parameter by 1 defines one standard deviation.
+ */
+class LevenbergMarquardtMinimizer: public ModelMinimizer {
+private:
+	unsigned int max_iterations;
+	mydouble edm_tolerance;
+	mydouble finite_difference_step;
+
+	std::vector<mydouble> parameter_values;
+	std::vector<mydouble> covariance;
+	bool has_covariance;
+
+	void calculateJacobian(const std::vector<mydouble> &pars,
+			const std::vector<mydouble> &residuals, std::vector<mydouble> &jacobian);
+	void calculateNormalEquations(const std::vector<mydouble> &residuals,
+			const std::vector<mydouble> &jacobian, std::vector<mydouble> &jtj,
+			std::vector<mydouble> &jtr) const;
+
+	int minimize();
+
+public:
+	LevenbergMarquardtMinimizer();
+	virtual ~LevenbergMarquardtMinimizer();
+
+	void setMaximumIterations(unsigned int max_iterations_);
+	/**
+	 * Convergence threshold on the estimated distance to the minimum
+	 * (default 1e-5).
+	 */
+	void setTolerance(mydouble edm_tolerance_);
+	/**
+	 * Relative step of the forward differences for a numerical jacobian
+	 * (default 1e-6).
+	 */
+	void setFiniteDifferenceStep(mydouble finite_difference_step_);
+
+	void increaseFunctionCallLimit();
+
+	virtual ModelFitResult createModelFitResult() const;
+};
+
+#endif /* LEVENBERGMARQUARDTMINIMIZER_H_ */
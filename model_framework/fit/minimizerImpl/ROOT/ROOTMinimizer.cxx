@@ -6,11 +6,14 @@
  */
 
 #include "ROOTMinimizer.h"
+#include "core/FitTracer.h"
 
 #include "Math/Factory.h"
 #include "Math/Functor.h"
 #include "TMath.h"
 
+#include <algorithm>
+
 ROOTMinimizer::ROOTMinimizer(int type) {
   std::cout << "Initializing Minuit Minimizer..." << std::endl;
 
@@ -51,8 +54,26 @@ double ROOTMinimizer::root_func_wrapper(const double *x) {
   return (double) control_parameter->evaluate(xtemp);
 }
 
+double ROOTMinimizer::root_gradient_wrapper(const double *x,
+    unsigned int coordinate) {
+  unsigned int size(control_parameter->getParameterList().size());
+  if (gradient_point.size() != size
+      || !std::equal(gradient_point.begin(), gradient_point.end(), x)) {
+    gradient_point.assign(x, x + size);
+    mydouble xtemp[size];
+    mydouble gradient[size];
+    for (unsigned int i = 0; i < size; ++i) {
+      xtemp[i] = (mydouble) x[i];
+    }
+    control_parameter->evaluateGradient(xtemp, gradient);
+    gradient_values.assign(gradient, gradient + size);
+  }
+  return gradient_values[coordinate];
+}
+
 ModelFitResult ROOTMinimizer::createModelFitResult() const {
   ModelFitResult fit_result;
+  std::vector<std::pair<std::string, std::string> > names;
 
   for (unsigned int i = 0; i < min->NDim(); i++) {
     std::string model_name;
@@ -65,20 +86,45 @@ ModelFitResult ROOTMinimizer::createModelFitResult() const {
 
     fit_result.addFitParameter(std::make_pair(model_name, param_name),
         min->X()[i], min->Errors()[i]);
+    names.push_back(std::make_pair(model_name, param_name));
+  }
+
+  // the covariance matrix is only available if minuit could compute it
+  if (min->CovMatrixStatus() > 0) {
+    std::vector<double> matrix(min->NDim() * min->NDim());
+    for (unsigned int i = 0; i < min->NDim(); i++) {
+      for (unsigned int j = 0; j < min->NDim(); j++)
+        matrix[i * min->NDim() + j] = min->CovMatrix(i, j);
+    }
+    fit_result.setCovarianceMatrix(names, matrix);
   }
 
   return fit_result;
 }
 
 int ROOTMinimizer::minimize() {
+  // the self time of this scope is the overhead of minuit
+  LMDFIT_TRACE_SCOPE("minimizer", "ROOTMinimizer::minimize");
   std::cout << "Setting up fit..." << std::endl;
   min->Clear();
   // create function wrapper for minmizer  a IMultiGenFunction type
   std::cout << "Number of free parameters in fit: "
       << control_parameter->getParameterList().size() << std::endl;
-  ROOT::Math::Functor fc(this, &ROOTMinimizer::root_func_wrapper,
+  unsigned int number_of_parameters(
       control_parameter->getParameterList().size());
-  min->SetFunction(fc);
+  // the function is copied by the minimizer
+  if (control_parameter->providesGradient()) {
+    std::cout << "Using the analytic gradient of the estimator" << std::endl;
+    gradient_point.clear();
+    ROOT::Math::GradFunctor fc(this, &ROOTMinimizer::root_func_wrapper,
+        &ROOTMinimizer::root_gradient_wrapper, number_of_parameters);
+    min->SetFunction(fc);
+  }
+  else {
+    ROOT::Math::Functor fc(this, &ROOTMinimizer::root_func_wrapper,
+        number_of_parameters);
+    min->SetFunction(fc);
+  }
 
   // Set the free variables to be minimized!
   for (unsigned int i = 0; i < control_parameter->getParameterList().size();
@@ -87,6 +133,11 @@ int ROOTMinimizer::minimize() {
         0.2 * control_parameter->getParameterList()[i].value);
     if (0.0 == control_parameter->getParameterList()[i].value)
       stepsize = 0.1;
+    // a known error (e.g. of a previous fit stage, see
+    // ModelFitFacade::setWarmStart()) is the better step size, minuit builds
+    // its start covariance matrix from the step sizes
+    if (control_parameter->getParameterList()[i].error > 0.0)
+      stepsize = control_parameter->getParameterList()[i].error;
     min->SetVariable(i,
         control_parameter->getParameterList()[i].name.first + ":"
             + control_parameter->getParameterList()[i].name.second,
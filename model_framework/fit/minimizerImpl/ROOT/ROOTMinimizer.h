@@ -13,6 +13,8 @@
 
 #include "Math/Minimizer.h"
 
+#include <vector>
+
 class ROOTMinimizer: public ModelMinimizer {
 private:
 	ROOT::Math::Minimizer* min;
@@ -21,6 +23,13 @@ private:
 
   double root_func_wrapper(const double *x);
 
+  // the gradient is computed completely for each new parameter point and
+  // cached, since ROOT requests the derivatives one coordinate at a time
+  std::vector<double> gradient_point;
+  std::vector<double> gradient_values;
+
+  double root_gradient_wrapper(const double *x, unsigned int coordinate);
+
 public:
 	ROOTMinimizer(int type=0);
 	virtual ~ROOTMinimizer();
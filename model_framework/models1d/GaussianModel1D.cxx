@@ -6,6 +6,7 @@
  */
 
 #include "GaussianModel1D.h"
+#include "core/ModelCloner.h"
 
 #include <cmath>
 
@@ -44,7 +45,50 @@ mydouble GaussianModel1D::eval(const mydouble *x) const {
       / (gauss_sigma->getValue() * std::sqrt(2.0 * M_PI));
 }
 
+void GaussianModel1D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  const mydouble mean = gauss_mean->getValue();
+  const mydouble one_over_sigma = 1.0 / gauss_sigma->getValue();
+  const mydouble normalization = gauss_amplitude->getValue() * one_over_sigma
+      / std::sqrt(2.0 * M_PI);
+  for (unsigned int i = 0; i < n; ++i) {
+    const mydouble xval = (xs[i] - mean) * one_over_sigma;
+    out[i] = normalization * std::exp(-0.5 * xval * xval);
+  }
+}
+
+bool GaussianModel1D::hasParameterDerivatives() const {
+  return !hasParametrizedParameters();
+}
+
+void GaussianModel1D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  const mydouble one_over_sigma = 1.0 / gauss_sigma->getValue();
+  const mydouble xval = (x[0] - gauss_mean->getValue()) * one_over_sigma;
+  // value without the amplitude, which is the derivative by the amplitude
+  const mydouble normalized_value = one_over_sigma / std::sqrt(2.0 * M_PI)
+      * std::exp(-0.5 * xval * xval);
+  const mydouble value = normalized_value * gauss_amplitude->getValue();
+
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    const std::shared_ptr<ModelPar> &par = parameters[i];
+    derivatives[i] = 0.0;
+    if (par == gauss_mean)
+      derivatives[i] += value * xval * one_over_sigma;
+    if (par == gauss_sigma)
+      derivatives[i] += value * (xval * xval - 1.0) * one_over_sigma;
+    if (par == gauss_amplitude)
+      derivatives[i] += normalized_value;
+  }
+}
+
 void GaussianModel1D::updateDomain() {
   mydouble temp = num_sigmas * gauss_sigma->getValue();
   setDomain(-temp + gauss_mean->getValue(), temp + gauss_mean->getValue());
 }
+
+std::shared_ptr<Model> GaussianModel1D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(new GaussianModel1D(getName()));
+}
@@ -17,6 +17,9 @@ private:
 	std::shared_ptr<ModelPar> gauss_mean;
 	std::shared_ptr<ModelPar> gauss_amplitude;
 
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
 	/**
 	 * The constructor for creating a normalized gaussian model in 1D
@@ -37,6 +40,17 @@ public:
 	 */
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+	bool hasParameterDerivatives() const;
+
+	/**
+	 * Analytic derivatives with respect to the mean, sigma and amplitude.
+	 */
+	void evalParameterDerivatives(const mydouble *x,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *derivatives) const;
+
 	void updateDomain();
 };
 
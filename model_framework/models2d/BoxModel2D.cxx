@@ -1,5 +1,7 @@
 #include "BoxModel2D.h"
+#include "core/ModelCloner.h"
 
+#include <algorithm>
 #include <limits>
 
 BoxModel2D::BoxModel2D(std::string name_) : Model2D(name_) {
@@ -19,6 +21,23 @@ mydouble BoxModel2D::eval(const mydouble *x) const {
 	return 0.0;
 }
 
+bool BoxModel2D::hasAnalyticIntegral() const {
+	return true;
+}
+
+mydouble BoxModel2D::AnalyticIntegral(
+		const std::vector<DataStructs::DimensionRange> &ranges) const {
+	mydouble overlap_var1 = std::min(ranges[0].range_high,
+			upper_edge_var1->getValue())
+			- std::max(ranges[0].range_low, lower_edge_var1->getValue());
+	mydouble overlap_var2 = std::min(ranges[1].range_high,
+			upper_edge_var2->getValue())
+			- std::max(ranges[1].range_low, lower_edge_var2->getValue());
+	if (overlap_var1 <= 0.0 || overlap_var2 <= 0.0)
+		return 0.0;
+	return amplitude->getValue() * overlap_var1 * overlap_var2;
+}
+
 void BoxModel2D::initModelParameters() {
 	amplitude = getModelParameterSet().addModelParameter("amplitude");
 	amplitude->setValue(1.0);
@@ -37,3 +56,7 @@ void BoxModel2D::updateDomain() {
 		setVar1Domain(lower_edge_var1->getValue(), upper_edge_var1->getValue());
 		setVar2Domain(lower_edge_var2->getValue(), upper_edge_var2->getValue());
 }
+
+std::shared_ptr<Model> BoxModel2D::cloneStructure(ModelCloner &cloner) const {
+	return std::shared_ptr<Model>(new BoxModel2D(getName()));
+}
@@ -11,12 +11,24 @@ private:
   std::shared_ptr<ModelPar> lower_edge_var2;
   std::shared_ptr<ModelPar> upper_edge_var2;
 
+protected:
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
   BoxModel2D(std::string name_);
 	virtual ~BoxModel2D();
 
   mydouble eval(const mydouble *x) const;
 
+  bool hasAnalyticIntegral() const;
+
+  /**
+   * Amplitude times the area of the overlap of the box with the rectangle
+   * given by ranges.
+   */
+  mydouble AnalyticIntegral(
+      const std::vector<DataStructs::DimensionRange> &ranges) const;
+
   void initModelParameters();
 
   void updateDomain();
@@ -1,4 +1,5 @@
 #include "DataModel2D.h"
+#include "core/ModelCloner.h"
 
 #include <cmath>
 #include <iostream>
@@ -6,15 +7,13 @@
 
 DataModel2D::DataModel2D(std::string name_,
     ModelStructs::InterpolationType type) :
-    Model2D(name_), data(0), grid_density(1.0), intpol_type(type) {
+    Model2D(name_), intpol_type(type) {
   setIntpolType(type);
   initModelParameters();
 }
 
 DataModel2D::DataModel2D(const DataModel2D &data_model_) :
-    Model2D(data_model_.getName()), data(
-        new mydouble[data_model_.cell_count[0] * data_model_.cell_count[1]]), grid_density(
-        1.0), intpol_type(data_model_.intpol_type) {
+    Model2D(data_model_.getName()), grid(data_model_.grid) {
   grid_spacing[0] = data_model_.grid_spacing[0];
   grid_spacing[1] = data_model_.grid_spacing[1];
 
@@ -27,14 +26,14 @@ DataModel2D::DataModel2D(const DataModel2D &data_model_) :
   domain_high[0] = data_model_.domain_high[0];
   domain_high[1] = data_model_.domain_high[1];
 
-  for (unsigned int i = 0; i < cell_count[0] * cell_count[1]; i++) {
-    data[i] = data_model_.data[i];
-  }
+  setIntpolType(data_model_.intpol_type);
+  initModelParameters();
+
+  setVar1Domain(domain_low[0], domain_high[0]);
+  setVar2Domain(domain_low[1], domain_high[1]);
 }
 
 DataModel2D::~DataModel2D() {
-  if (data)
-    delete[] data;
 }
 
 std::pair<mydouble, bool> DataModel2D::getCellSpacing(
@@ -71,9 +70,8 @@ std::pair<mydouble, bool> DataModel2D::getCellSpacing(
 
 void DataModel2D::setData(
     const std::map<std::pair<mydouble, mydouble>, mydouble> &data_) {
-  // delete old data if existent
-  if (data)
-    delete[] data;
+  // release old data if existent
+  grid.reset();
 
   std::set<mydouble> x_values;
   std::set<mydouble> y_values;
@@ -124,7 +122,10 @@ void DataModel2D::setData(
     domain_low[1] = domain_low[1] - 0.5 * grid_spacing[1];
     domain_high[1] = domain_high[1] + 0.5 * grid_spacing[1];
 
-    data = new mydouble[cell_count[0] * cell_count[1]];
+    std::shared_ptr<Grid2D<mydouble> > new_grid(
+        new Grid2D<mydouble>(cell_count[0], cell_count[1]));
+    new_grid->setAxes(domain_low[0], grid_spacing[0], domain_low[1],
+        grid_spacing[1]);
 
     int idx_last(0);
     int idy_last(0);
@@ -133,8 +134,8 @@ void DataModel2D::setData(
       int idx = ((it->first.first - domain_low[0]) / grid_spacing[0]);
       int idy = ((it->first.second - domain_low[1]) / grid_spacing[1]);
 
-      // ok we address the data as idy+ycellcount*idx (so y before x) because the data
-      // is presorted with x as a stronger variable, then its easier to find out the missing values
+      // the data is presorted with x as a stronger variable, so the running
+      // index idy+ycellcount*idx makes it easier to find out the missing values
 
       bool missing(false);
       unsigned int missing_start_x = idx_last;
@@ -170,19 +171,19 @@ void DataModel2D::setData(
       idx_last = idx;
       idy_last = idy;
 
-      data[idx * cell_count[1] + idy] = it->second;
+      (*new_grid)(idx, idy) = it->second;
     }
 
     // now fix the missing values
     std::cout << "found " << missing_indices.size()
         << " missing evaluation points. Fixing interpolation!" << std::endl;
     for (unsigned int i = 0; i < missing_indices.size(); i++) {
-      data[missing_indices[i]] = 0.0;
+      (*new_grid)(missing_indices[i] / cell_count[1],
+          missing_indices[i] % cell_count[1]) = 0.0;
     }
+    grid = new_grid;
   }
 
-  grid_density = 1.0 / grid_spacing[0] / grid_spacing[1];
-
   std::cout << "initialized interpolation model!" << std::endl;
 
   setVar1Domain(domain_low[0], domain_high[0]);
@@ -207,10 +208,14 @@ void DataModel2D::setIntpolType(ModelStructs::InterpolationType intpol_type_) {
 }
 
 mydouble DataModel2D::evaluateConstant(const mydouble *x) const {
-  unsigned int idx = (unsigned int) ((x[0] - domain_low[0]) / grid_spacing[0]);
-  unsigned int idy = (unsigned int) ((x[1] - domain_low[1]) / grid_spacing[1]);
+  return grid->evaluateConstant(x[0], x[1]);
+}
 
-  return data[idx * cell_count[1] + idy];
+mydouble DataModel2D::getCellValue(int idx, int idy) const {
+  if (idx < 0 || idy < 0 || idx >= (int) cell_count[0]
+      || idy >= (int) cell_count[1])
+    return 0.0;
+  return (*grid)(idx, idy);
 }
 
 mydouble DataModel2D::evaluateLinear(const mydouble *x) const {
@@ -231,29 +236,31 @@ mydouble DataModel2D::evaluateLinear(const mydouble *x) const {
   else
     --idy_low;
 
+  // the interpolation vanishes unless all four neighboring cells are inner
+  // cells of the grid, except for the partial sums directly at the border
   mydouble p11(0.0), p12(0.0), p21(0.0), p22(0.0);
   if (idx_low > 0 && idy_low > 0 && idx_high < (int) cell_count[0] - 1
       && idy_high < (int) cell_count[1] - 1) {
-    p11 = data[idx_low * cell_count[1] + idy_low];
-    p12 = data[idx_low * cell_count[1] + idy_high];
-    p21 = data[idx_high * cell_count[1] + idy_low];
-    p22 = data[idx_high * cell_count[1] + idy_high];
+    p11 = getCellValue(idx_low, idy_low);
+    p12 = getCellValue(idx_low, idy_high);
+    p21 = getCellValue(idx_high, idy_low);
+    p22 = getCellValue(idx_high, idy_high);
   }
   else if (idx_low < 0) {
-    p21 = data[idx_high * cell_count[1] + idy_low];
-    p22 = data[idx_high * cell_count[1] + idy_high];
+    p21 = getCellValue(idx_high, idy_low);
+    p22 = getCellValue(idx_high, idy_high);
   }
   else if (idx_high > (int) cell_count[0] - 1) {
-    p11 = data[idx_low * cell_count[1] + idy_low];
-    p12 = data[idx_low * cell_count[1] + idy_high];
+    p11 = getCellValue(idx_low, idy_low);
+    p12 = getCellValue(idx_low, idy_high);
   }
   else if (idy_low < 0) {
-    p11 = data[idx_low * cell_count[1] + idy_low];
-    p12 = data[idx_low * cell_count[1] + idy_high];
+    p11 = getCellValue(idx_low, idy_low);
+    p12 = getCellValue(idx_low, idy_high);
   }
   else if (idy_high > (int) cell_count[1] - 1) {
-    p12 = data[idx_low * cell_count[1] + idy_high];
-    p22 = data[idx_high * cell_count[1] + idy_high];
+    p12 = getCellValue(idx_low, idy_high);
+    p22 = getCellValue(idx_high, idy_high);
   }
 
   mydouble dx2x(domain_low[0] + (0.5 + idx_high) * grid_spacing[0] - x[0]);
@@ -261,7 +268,7 @@ mydouble DataModel2D::evaluateLinear(const mydouble *x) const {
   mydouble dy2y(domain_low[1] + (0.5 + idy_high) * grid_spacing[1] - x[1]);
   mydouble dyy1(x[1] - (domain_low[1] + (0.5 + idy_low) * grid_spacing[1]));
   mydouble value = (p11 * dx2x * dy2y + p21 * dxx1 * dy2y + p12 * dx2x * dyy1
-      + p22 * dxx1 * dyy1) * grid_density;
+      + p22 * dxx1 * dyy1) / grid_spacing[0] / grid_spacing[1];
   return value;
 }
 
@@ -276,6 +283,27 @@ mydouble DataModel2D::eval(const mydouble *x) const {
   return (this->*model_func)(shifted_x);
 }
 
+void DataModel2D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  if (intpol_type == ModelStructs::CONSTANT) {
+    // the grid vanishes outside of the domain
+    grid->evaluateConstant(xs, n, out, offset_x->getValue(),
+        offset_y->getValue());
+    return;
+  }
+  const mydouble offset[2] = { offset_x->getValue(), offset_y->getValue() };
+  mydouble shifted_x[2];
+  for (unsigned int i = 0; i < n; ++i) {
+    shifted_x[0] = xs[2 * i] - offset[0];
+    shifted_x[1] = xs[2 * i + 1] - offset[1];
+    if (shifted_x[0] < domain_low[0] || shifted_x[0] > domain_high[0]
+        || shifted_x[1] < domain_low[1] || shifted_x[1] > domain_high[1])
+      out[i] = 0.0;
+    else
+      out[i] = evaluateLinear(shifted_x);
+  }
+}
+
 void DataModel2D::updateDomain() {
 
 }
@@ -293,9 +321,15 @@ DataModel2D& DataModel2D::operator=(const DataModel2D &data_model_) {
   domain_high[0] = data_model_.domain_high[0];
   domain_high[1] = data_model_.domain_high[1];
 
-  for (unsigned int i = 0; i < cell_count[0] * cell_count[1]; i++) {
-    data[i] = data_model_.data[i];
-  }
+  grid = data_model_.grid;
+  setIntpolType(data_model_.intpol_type);
+
+  setVar1Domain(domain_low[0], domain_high[0]);
+  setVar2Domain(domain_low[1], domain_high[1]);
 
   return *this;
 }
+
+std::shared_ptr<Model> DataModel2D::cloneStructure(ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(new DataModel2D(*this));
+}
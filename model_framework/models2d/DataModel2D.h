@@ -1,19 +1,20 @@
 #ifndef DATAMODEL2D_H_
 #define DATAMODEL2D_H_
 
+#include "core/Grid2D.h"
 #include "core/Model2D.h"
 
 class DataModel2D: public Model2D {
 private:
 	mydouble grid_spacing[2];
 	unsigned int cell_count[2];
-	mydouble *data;
+	// the grid is not changed after #setData(), so it is shared between copies
+	// and clones of this model
+	std::shared_ptr<const Grid2D<mydouble> > grid;
 
 	mydouble domain_low[2];
 	mydouble domain_high[2];
 
-	mydouble grid_density;
-
 	ModelStructs::InterpolationType intpol_type;
 
 	std::shared_ptr<ModelPar> offset_x;
@@ -26,6 +27,12 @@ private:
 
 	std::pair<mydouble, bool> getCellSpacing(
 			const std::set<mydouble> &values);
+
+	// value of the cell, or zero for cells beyond the border of the grid
+	mydouble getCellValue(int idx, int idy) const;
+
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
 public:
 	DataModel2D(std::string name_, ModelStructs::InterpolationType type = ModelStructs::LINEAR);
 	DataModel2D(const DataModel2D &data_model_);
@@ -41,6 +48,8 @@ public:
 
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
 	void initModelParameters();
 
 	void updateDomain();
@@ -6,8 +6,142 @@
  */
 
 #include "GaussianModel2D.h"
+#include "core/ModelCloner.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+
+namespace {
+mydouble standardNormalCDF(mydouble z) {
+  return 0.5 * std::erfc(-z / std::sqrt((mydouble) 2.0));
+}
+
+/**
+ * Probability P(X > h, Y > k) of a standard bivariate normal distribution
+ * with correlation r. Algorithm of A. Genz, "Numerical computation of
+ * rectangular bivariate and trivariate normal and t probabilities",
+ * Statistics and Computing 14 (2004) 251, which is accurate to about 1e-15.
+ */
+mydouble bivariateNormalUpperProbability(mydouble h, mydouble k, mydouble r) {
+  const mydouble infinity(std::numeric_limits<mydouble>::infinity());
+  if (h == infinity || k == infinity)
+    return 0.0;
+  if (h == -infinity)
+    return (k == -infinity ? 1.0 : standardNormalCDF(-k));
+  if (k == -infinity)
+    return standardNormalCDF(-h);
+  if (r == 0.0)
+    return standardNormalCDF(-h) * standardNormalCDF(-k);
+
+  // gauss legendre weights and abscissae for 6, 12 and 20 points
+  static const mydouble w6[3] = { 0.1713244923791705, 0.3607615730481384,
+      0.4679139345726904 };
+  static const mydouble x6[3] = { 0.9324695142031522, 0.6612093864662647,
+      0.2386191860831970 };
+  static const mydouble w12[6] = { 0.04717533638651177, 0.1069393259953183,
+      0.1600783285433464, 0.2031674267230659, 0.2334925365383547,
+      0.2491470458134029 };
+  static const mydouble x12[6] = { 0.9815606342467191, 0.9041172563704750,
+      0.7699026741943050, 0.5873179542866171, 0.3678314989981802,
+      0.1252334085114692 };
+  static const mydouble w20[10] = { 0.01761400713915212, 0.04060142980038694,
+      0.06267204833410906, 0.08327674157670475, 0.1019301198172404,
+      0.1181945319615184, 0.1316886384491766, 0.1420961093183821,
+      0.1491729864726037, 0.1527533871307259 };
+  static const mydouble x20[10] = { 0.9931285991850949, 0.9639719272779138,
+      0.9122344282513259, 0.8391169718222188, 0.7463319064601508,
+      0.6360536807265150, 0.5108670019508271, 0.3737060887154196,
+      0.2277858511416451, 0.07652652113349733 };
+
+  const mydouble *w(w20);
+  const mydouble *x(x20);
+  unsigned int n(10);
+  if (std::abs(r) < 0.3) {
+    w = w6;
+    x = x6;
+    n = 3;
+  } else if (std::abs(r) < 0.75) {
+    w = w12;
+    x = x12;
+    n = 6;
+  }
+
+  const mydouble two_pi(2.0 * M_PI);
+  mydouble hk(h * k);
+  mydouble bvn(0.0);
+  if (std::abs(r) < 0.925) {
+    mydouble hs((h * h + k * k) / 2.0);
+    mydouble asr(std::asin(r) / 2.0);
+    for (unsigned int i = 0; i < n; ++i) {
+      for (int sign = -1; sign <= 1; sign += 2) {
+        mydouble sn(std::sin(asr * (1.0 + sign * x[i])));
+        bvn += w[i] * std::exp((sn * hk - hs) / (1.0 - sn * sn));
+      }
+    }
+    return std::max((mydouble) 0.0,
+        std::min((mydouble) 1.0,
+            bvn * asr / two_pi + standardNormalCDF(-h) * standardNormalCDF(-k)));
+  }
+
+  if (r < 0.0) {
+    k = -k;
+    hk = -hk;
+  }
+  if (std::abs(r) < 1.0) {
+    mydouble as((1.0 - r) * (1.0 + r));
+    mydouble a(std::sqrt(as));
+    mydouble bs((h - k) * (h - k));
+    mydouble asr(-(bs / as + hk) / 2.0);
+    mydouble c((4.0 - hk) / 8.0);
+    mydouble d((12.0 - hk) / 80.0);
+    if (asr > -100.0)
+      bvn = a * std::exp(asr)
+          * (1.0 - c * (bs - as) * (1.0 - d * bs) / 3.0 + c * d * as * as);
+    if (hk > -100.0) {
+      mydouble b(std::sqrt(bs));
+      mydouble sp(std::sqrt(two_pi) * standardNormalCDF(-b / a));
+      bvn -= std::exp(-hk / 2.0) * sp * b * (1.0 - c * bs * (1.0 - d * bs) / 3.0);
+    }
+    a /= 2.0;
+    for (unsigned int i = 0; i < n; ++i) {
+      for (int sign = -1; sign <= 1; sign += 2) {
+        mydouble xs(a * (1.0 + sign * x[i]));
+        xs *= xs;
+        mydouble asr_i(-(bs / xs + hk) / 2.0);
+        if (asr_i > -100.0) {
+          mydouble sp(1.0 + c * xs * (1.0 + 5.0 * d * xs));
+          mydouble rs(std::sqrt(1.0 - xs));
+          mydouble ep(std::exp(-(hk / 2.0) * xs / ((1.0 + rs) * (1.0 + rs))) / rs);
+          bvn += a * w[i] * std::exp(asr_i) * (ep - sp);
+        }
+      }
+    }
+    bvn = -bvn / two_pi;
+  }
+  if (r > 0.0) {
+    bvn += standardNormalCDF(-std::max(h, k));
+  } else if (h >= k) {
+    bvn = -bvn;
+  } else {
+    mydouble l;
+    if (h < 0.0)
+      l = standardNormalCDF(k) - standardNormalCDF(h);
+    else
+      l = standardNormalCDF(-h) - standardNormalCDF(-k);
+    bvn = l - bvn;
+  }
+  return std::max((mydouble) 0.0, std::min((mydouble) 1.0, bvn));
+}
+
+/**
+ * Cumulative distribution function P(X < h, Y < k) of a standard bivariate
+ * normal distribution with correlation r.
+ */
+mydouble bivariateNormalCDF(mydouble h, mydouble k, mydouble r) {
+  return bivariateNormalUpperProbability(-h, -k, r);
+}
+}
 
 GaussianModel2D::GaussianModel2D(std::string name_, mydouble num_sigmas_) :
     Model2D(name_), num_sigmas(num_sigmas_), gauss_sigma_var1(), gauss_sigma_var2(), gauss_mean_var1(), gauss_mean_var2(), gauss_rho(), gauss_amplitude() {
@@ -54,6 +188,136 @@ mydouble GaussianModel2D::eval(const mydouble *x) const {
   return normalization * exp_value * gauss_amplitude->getValue();
 }
 
+void GaussianModel2D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  const mydouble rho = gauss_rho->getValue();
+  const mydouble rho_factor = (1.0 - rho * rho);
+  const mydouble one_over_sigma_var1 = 1.0 / gauss_sigma_var1->getValue();
+  const mydouble one_over_sigma_var2 = 1.0 / gauss_sigma_var2->getValue();
+  const mydouble mean_var1 = gauss_mean_var1->getValue();
+  const mydouble mean_var2 = gauss_mean_var2->getValue();
+  const mydouble normalization = 0.5 * one_over_sigma_var1
+      * one_over_sigma_var2 / (M_PI * sqrt(rho_factor))
+      * gauss_amplitude->getValue();
+  const mydouble exp_factor = -0.5 / rho_factor;
+  const mydouble two_rho = 2.0 * rho;
+  for (unsigned int i = 0; i < n; ++i) {
+    const mydouble xval = one_over_sigma_var1 * (xs[2 * i] - mean_var1);
+    const mydouble yval = one_over_sigma_var2 * (xs[2 * i + 1] - mean_var2);
+    out[i] = normalization
+        * exp(exp_factor * (xval * xval + yval * yval - two_rho * xval * yval));
+  }
+}
+
+bool GaussianModel2D::hasParameterDerivatives() const {
+  return !hasParametrizedParameters();
+}
+
+void GaussianModel2D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  const mydouble rho = gauss_rho->getValue();
+  const mydouble rho_factor = (1.0 - rho * rho);
+  const mydouble one_over_sigma_var1 = 1.0 / gauss_sigma_var1->getValue();
+  const mydouble one_over_sigma_var2 = 1.0 / gauss_sigma_var2->getValue();
+  const mydouble xval = one_over_sigma_var1 * (x[0] - gauss_mean_var1->getValue());
+  const mydouble yval = one_over_sigma_var2 * (x[1] - gauss_mean_var2->getValue());
+  const mydouble quadratic_form = xval * xval + yval * yval
+      - 2.0 * rho * xval * yval;
+
+  // value without the amplitude, which is the derivative by the amplitude
+  const mydouble normalized_value = 0.5 * one_over_sigma_var1
+      * one_over_sigma_var2 / (M_PI * sqrt(rho_factor))
+      * exp(-0.5 / rho_factor * quadratic_form);
+  const mydouble value = normalized_value * gauss_amplitude->getValue();
+
+  // derivatives of the logarithm of the gaussian
+  const mydouble dlog_mean_var1 = (xval - rho * yval) / rho_factor
+      * one_over_sigma_var1;
+  const mydouble dlog_mean_var2 = (yval - rho * xval) / rho_factor
+      * one_over_sigma_var2;
+  const mydouble dlog_sigma_var1 = (xval * (xval - rho * yval) / rho_factor
+      - 1.0) * one_over_sigma_var1;
+  const mydouble dlog_sigma_var2 = (yval * (yval - rho * xval) / rho_factor
+      - 1.0) * one_over_sigma_var2;
+  const mydouble dlog_rho = (rho + xval * yval) / rho_factor
+      - rho * quadratic_form / (rho_factor * rho_factor);
+
+  // a parameter can be shared by several of the gaussian parameters, so all
+  // contributions are summed
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    const std::shared_ptr<ModelPar> &par = parameters[i];
+    mydouble dlog(0.0);
+    if (par == gauss_mean_var1)
+      dlog += dlog_mean_var1;
+    if (par == gauss_mean_var2)
+      dlog += dlog_mean_var2;
+    if (par == gauss_sigma_var1)
+      dlog += dlog_sigma_var1;
+    if (par == gauss_sigma_var2)
+      dlog += dlog_sigma_var2;
+    if (par == gauss_rho)
+      dlog += dlog_rho;
+    derivatives[i] = value * dlog;
+    if (par == gauss_amplitude)
+      derivatives[i] += normalized_value;
+  }
+}
+
+bool GaussianModel2D::isSeparable() const {
+  return gauss_rho->getValue() == 0.0;
+}
+
+mydouble GaussianModel2D::getAmplitude() const {
+  return gauss_amplitude->getValue();
+}
+
+mydouble GaussianModel2D::getMarginalIntegralVar1(mydouble low,
+    mydouble high) const {
+  const mydouble scale = 1.0 / (std::sqrt(2.0) * gauss_sigma_var1->getValue());
+  const mydouble mean = gauss_mean_var1->getValue();
+  return 0.5 * (std::erf(scale * (high - mean)) - std::erf(scale * (low - mean)));
+}
+
+mydouble GaussianModel2D::getMarginalIntegralVar2(mydouble low,
+    mydouble high) const {
+  const mydouble scale = 1.0 / (std::sqrt(2.0) * gauss_sigma_var2->getValue());
+  const mydouble mean = gauss_mean_var2->getValue();
+  return 0.5 * (std::erf(scale * (high - mean)) - std::erf(scale * (low - mean)));
+}
+
+bool GaussianModel2D::hasAnalyticIntegral() const {
+  return true;
+}
+
+mydouble GaussianModel2D::AnalyticIntegral(
+    const std::vector<DataStructs::DimensionRange> &ranges) const {
+  const mydouble rho = gauss_rho->getValue();
+  if (rho == 0.0) {
+    return gauss_amplitude->getValue()
+        * getMarginalIntegralVar1(ranges[0].range_low, ranges[0].range_high)
+        * getMarginalIntegralVar2(ranges[1].range_low, ranges[1].range_high);
+  }
+
+  // standardized integration bounds
+  const mydouble one_over_sigma_var1 = 1.0 / gauss_sigma_var1->getValue();
+  const mydouble one_over_sigma_var2 = 1.0 / gauss_sigma_var2->getValue();
+  const mydouble low1 = one_over_sigma_var1
+      * (ranges[0].range_low - gauss_mean_var1->getValue());
+  const mydouble high1 = one_over_sigma_var1
+      * (ranges[0].range_high - gauss_mean_var1->getValue());
+  const mydouble low2 = one_over_sigma_var2
+      * (ranges[1].range_low - gauss_mean_var2->getValue());
+  const mydouble high2 = one_over_sigma_var2
+      * (ranges[1].range_high - gauss_mean_var2->getValue());
+
+  mydouble probability = bivariateNormalCDF(high1, high2, rho)
+      - bivariateNormalCDF(low1, high2, rho)
+      - bivariateNormalCDF(high1, low2, rho)
+      + bivariateNormalCDF(low1, low2, rho);
+  return gauss_amplitude->getValue() * std::max((mydouble) 0.0, probability);
+}
+
 void GaussianModel2D::updateDomain() {
   mydouble temp = num_sigmas * std::abs(gauss_sigma_var1->getValue());
   setVar1Domain(-temp + gauss_mean_var1->getValue(),
@@ -63,3 +327,7 @@ void GaussianModel2D::updateDomain() {
       temp + gauss_mean_var2->getValue());
 }
 
+std::shared_ptr<Model> GaussianModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(new GaussianModel2D(getName(), num_sigmas));
+}
@@ -20,6 +20,9 @@ private:
 	std::shared_ptr<ModelPar> gauss_rho;
 	std::shared_ptr<ModelPar> gauss_amplitude;
 
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
 	/**
 	 * The constructor for creating a normalized gaussian model in 2D
@@ -40,6 +43,44 @@ public:
 	 */
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+	bool hasParameterDerivatives() const;
+
+	/**
+	 * Analytic derivatives with respect to the means, sigmas, rho and the
+	 * amplitude.
+	 */
+	void evalParameterDerivatives(const mydouble *x,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *derivatives) const;
+
+	/**
+	 * @returns true if the gaussian factorizes into a gaussian in var1 and
+	 * one in var2, which is the case for a vanishing correlation rho
+	 */
+	bool isSeparable() const;
+
+	mydouble getAmplitude() const;
+
+	/**
+	 * Closed form integrals of the normalized marginal distributions over
+	 * [low, high]. For a separable gaussian the integral over a rectangle is
+	 * the amplitude times the product of both marginal integrals.
+	 */
+	mydouble getMarginalIntegralVar1(mydouble low, mydouble high) const;
+	mydouble getMarginalIntegralVar2(mydouble low, mydouble high) const;
+
+	bool hasAnalyticIntegral() const;
+
+	/**
+	 * Integral over the rectangle given by ranges. For a vanishing rho it is
+	 * a product of erf differences, otherwise it is computed from the
+	 * bivariate normal cumulative distribution function.
+	 */
+	mydouble AnalyticIntegral(
+			const std::vector<DataStructs::DimensionRange> &ranges) const;
+
 	void updateDomain();
 };
 
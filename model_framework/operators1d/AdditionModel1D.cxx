@@ -6,6 +6,7 @@
  */
 
 #include "AdditionModel1D.h"
+#include "core/ModelCloner.h"
 
 #include <iostream>
 
@@ -29,6 +30,28 @@ mydouble AdditionModel1D::eval(const mydouble *x) const {
 	return add(first, second, x);
 }
 
+bool AdditionModel1D::hasParameterDerivatives() const {
+	return !hasParametrizedParameters() && first->hasParameterDerivatives()
+			&& second->hasParameterDerivatives();
+}
+
+bool AdditionModel1D::hasParameterDerivative(
+		const std::shared_ptr<ModelPar> &parameter) const {
+	return !hasParametrizedParameters()
+			&& first->hasParameterDerivative(parameter)
+			&& second->hasParameterDerivative(parameter);
+}
+
+void AdditionModel1D::evalParameterDerivatives(const mydouble *x,
+		const std::vector<std::shared_ptr<ModelPar> > &parameters,
+		mydouble *derivatives) const {
+	std::vector<mydouble> second_derivatives(parameters.size());
+	first->evalParameterDerivatives(x, parameters, derivatives);
+	second->evalParameterDerivatives(x, parameters, second_derivatives.data());
+	for (unsigned int i = 0; i < parameters.size(); ++i)
+		derivatives[i] += second_derivatives[i];
+}
+
 void AdditionModel1D::updateDomain() {
 	// first we need to check if user defined a domain for his models
 	if (first->getDomainRange() == 0) {
@@ -42,3 +65,9 @@ void AdditionModel1D::updateDomain() {
 				std::max(first->getDomain().second, second->getDomain().second));
 	}
 }
+
+std::shared_ptr<Model> AdditionModel1D::cloneStructure(
+		ModelCloner &cloner) const {
+	return std::shared_ptr<Model>(
+		new AdditionModel1D(getName(), cloner.clone(first), cloner.clone(second)));
+}
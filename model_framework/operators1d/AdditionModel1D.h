@@ -15,6 +15,9 @@ private:
   std::shared_ptr<Model1D> first;
   std::shared_ptr<Model1D> second;
 
+protected:
+  std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
   AdditionModel1D(std::string name_, std::shared_ptr<Model1D> first_, std::shared_ptr<Model1D> second_);
   virtual ~AdditionModel1D();
@@ -23,6 +26,18 @@ public:
 
   mydouble eval(const mydouble *x) const;
 
+  bool hasParameterDerivatives() const;
+
+  bool hasParameterDerivative(
+      const std::shared_ptr<ModelPar> &parameter) const;
+
+  /**
+   * Sum of the derivatives of both summands, if both provide them.
+   */
+  void evalParameterDerivatives(const mydouble *x,
+      const std::vector<std::shared_ptr<ModelPar> > &parameters,
+      mydouble *derivatives) const;
+
   void updateDomain();
 };
 
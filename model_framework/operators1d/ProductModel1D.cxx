@@ -6,12 +6,13 @@
  */
 
 #include "ProductModel1D.h"
+#include "core/ModelCloner.h"
 
 #include <iostream>
 
 ProductModel1D::ProductModel1D(std::string name_, std::shared_ptr<Model1D> first_,
 		std::shared_ptr<Model1D> second_) :
-		Model1D(name_), first(first), second(second_) {
+		Model1D(name_), first(first_), second(second_) {
 
 	addModelToList(first);
 	addModelToList(second);
@@ -25,6 +26,32 @@ mydouble ProductModel1D::eval(const mydouble *x) const {
 	return multiply(first, second, x);
 }
 
+bool ProductModel1D::hasParameterDerivatives() const {
+	return !hasParametrizedParameters() && first->hasParameterDerivatives()
+			&& second->hasParameterDerivatives();
+}
+
+bool ProductModel1D::hasParameterDerivative(
+		const std::shared_ptr<ModelPar> &parameter) const {
+	return !hasParametrizedParameters()
+			&& first->hasParameterDerivative(parameter)
+			&& second->hasParameterDerivative(parameter);
+}
+
+void ProductModel1D::evalParameterDerivatives(const mydouble *x,
+		const std::vector<std::shared_ptr<ModelPar> > &parameters,
+		mydouble *derivatives) const {
+	std::vector<mydouble> second_derivatives(parameters.size());
+	first->evalParameterDerivatives(x, parameters, derivatives);
+	second->evalParameterDerivatives(x, parameters, second_derivatives.data());
+	const mydouble first_value(first->eval(x));
+	const mydouble second_value(second->eval(x));
+	for (unsigned int i = 0; i < parameters.size(); ++i) {
+		derivatives[i] = derivatives[i] * second_value
+				+ first_value * second_derivatives[i];
+	}
+}
+
 std::pair<mydouble, mydouble> ProductModel1D::getUncertaincy(
 		const mydouble *x) const {
 	return std::make_pair(
@@ -45,3 +72,9 @@ void ProductModel1D::updateDomain() {
 				std::min(first->getDomain().second, second->getDomain().second));
 	}
 }
+
+std::shared_ptr<Model> ProductModel1D::cloneStructure(
+		ModelCloner &cloner) const {
+	return std::shared_ptr<Model>(
+		new ProductModel1D(getName(), cloner.clone(first), cloner.clone(second)));
+}
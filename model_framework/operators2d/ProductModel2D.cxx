@@ -6,7 +6,9 @@
  */
 
 #include "ProductModel2D.h"
+#include "core/ModelCloner.h"
 
+#include <algorithm>
 #include <iostream>
 
 ProductModel2D::ProductModel2D(std::string name_, std::shared_ptr<Model2D> first_,
@@ -30,6 +32,53 @@ mydouble ProductModel2D::eval(const mydouble *x) const {
   return result1 * result2;
 }
 
+void ProductModel2D::evalBatch(const mydouble *xs, unsigned int n,
+    mydouble *out) const {
+  // the values of the second model are buffered on the stack in chunks
+  const unsigned int chunk_size(128);
+  mydouble second_values[chunk_size];
+
+  first->evaluateBatch(xs, n, out);
+  for (unsigned int offset = 0; offset < n; offset += chunk_size) {
+    unsigned int chunk = std::min(chunk_size, n - offset);
+    second->evaluateBatch(&xs[2 * offset], chunk, second_values);
+    for (unsigned int i = 0; i < chunk; ++i) {
+      // same zero handling as in eval(), so that a vanishing factor masks
+      // a non finite value of the other one
+      if (out[offset + i] == 0.0 || second_values[i] == 0.0)
+        out[offset + i] = 0.0;
+      else
+        out[offset + i] *= second_values[i];
+    }
+  }
+}
+
+bool ProductModel2D::hasParameterDerivatives() const {
+  return !hasParametrizedParameters() && first->hasParameterDerivatives()
+      && second->hasParameterDerivatives();
+}
+
+bool ProductModel2D::hasParameterDerivative(
+    const std::shared_ptr<ModelPar> &parameter) const {
+  return !hasParametrizedParameters()
+      && first->hasParameterDerivative(parameter)
+      && second->hasParameterDerivative(parameter);
+}
+
+void ProductModel2D::evalParameterDerivatives(const mydouble *x,
+    const std::vector<std::shared_ptr<ModelPar> > &parameters,
+    mydouble *derivatives) const {
+  std::vector<mydouble> second_derivatives(parameters.size());
+  first->evalParameterDerivatives(x, parameters, derivatives);
+  second->evalParameterDerivatives(x, parameters, second_derivatives.data());
+  const mydouble first_value(first->eval(x));
+  const mydouble second_value(second->eval(x));
+  for (unsigned int i = 0; i < parameters.size(); ++i) {
+    derivatives[i] = derivatives[i] * second_value
+        + first_value * second_derivatives[i];
+  }
+}
+
 std::pair<mydouble, mydouble> ProductModel2D::getUncertaincy(
     const mydouble *x) const {
   return std::make_pair(
@@ -61,3 +110,9 @@ void ProductModel2D::updateDomain() {
             second->getVar2DomainLowerBound() + second->getVar2DomainRange()));
   }
 }
+
+std::shared_ptr<Model> ProductModel2D::cloneStructure(
+    ModelCloner &cloner) const {
+  return std::shared_ptr<Model>(
+    new ProductModel2D(getName(), cloner.clone(first), cloner.clone(second)));
+}
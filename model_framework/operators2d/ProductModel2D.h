@@ -13,6 +13,9 @@
 class ProductModel2D: public Model2D {
 private:
 	std::shared_ptr<Model2D> first, second;
+protected:
+	std::shared_ptr<Model> cloneStructure(ModelCloner &cloner) const;
+
 public:
 	ProductModel2D(std::string name_, std::shared_ptr<Model2D> first_,
 			std::shared_ptr<Model2D> second_);
@@ -21,6 +24,20 @@ public:
 
 	mydouble eval(const mydouble *x) const;
 
+	void evalBatch(const mydouble *xs, unsigned int n, mydouble *out) const;
+
+	bool hasParameterDerivatives() const;
+
+	bool hasParameterDerivative(
+			const std::shared_ptr<ModelPar> &parameter) const;
+
+	/**
+	 * Derivatives from the product rule, if both factors provide theirs.
+	 */
+	void evalParameterDerivatives(const mydouble *x,
+			const std::vector<std::shared_ptr<ModelPar> > &parameters,
+			mydouble *derivatives) const;
+
 	void updateDomain();
 
 	virtual std::pair<mydouble, mydouble> getUncertaincy(const mydouble *x) const;
@@ -0,0 +1,92 @@
+/*
+ * FastFourierTransform.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "FastFourierTransform.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+FastFourierTransform::FastFourierTransform(unsigned int size_) :
+    size(0) {
+  setSize(size_);
+}
+
+FastFourierTransform::~FastFourierTransform() {
+}
+
+unsigned int FastFourierTransform::nextPowerOfTwo(unsigned int n) {
+  unsigned int power_of_two(1);
+  while (power_of_two < n)
+    power_of_two <<= 1;
+  return power_of_two;
+}
+
+void FastFourierTransform::setSize(unsigned int size_) {
+  if (size_ == 0 || (size_ & (size_ - 1)) != 0)
+    throw std::runtime_error(
+        "FastFourierTransform: the transformation length has to be a power of two!");
+  if (size_ == size)
+    return;
+  size = size_;
+
+  unsigned int number_of_bits(0);
+  while ((1u << number_of_bits) < size)
+    ++number_of_bits;
+
+  bit_reversed_indices.resize(size);
+  for (unsigned int i = 0; i < size; ++i) {
+    unsigned int reversed(0);
+    for (unsigned int bit = 0; bit < number_of_bits; ++bit) {
+      if (i & (1u << bit))
+        reversed |= 1u << (number_of_bits - 1 - bit);
+    }
+    bit_reversed_indices[i] = reversed;
+  }
+
+  // each factor is computed directly instead of recursively, so that the
+  // rounding errors do not accumulate
+  const mydouble pi(std::acos((mydouble) -1.0));
+  twiddle_factors.resize(size / 2);
+  for (unsigned int k = 0; k < size / 2; ++k) {
+    mydouble phase(-2.0 * pi * k / size);
+    twiddle_factors[k] = std::complex<mydouble>(std::cos(phase),
+        std::sin(phase));
+  }
+}
+
+unsigned int FastFourierTransform::getSize() const {
+  return size;
+}
+
+void FastFourierTransform::transform(std::complex<mydouble> *data,
+    bool inverse) const {
+  for (unsigned int i = 0; i < size; ++i) {
+    if (i < bit_reversed_indices[i])
+      std::swap(data[i], data[bit_reversed_indices[i]]);
+  }
+
+  const mydouble sign(inverse ? -1.0 : 1.0);
+  for (unsigned int length = 2; length <= size; length <<= 1) {
+    const unsigned int half_length(length / 2);
+    const unsigned int twiddle_stride(size / length);
+    for (unsigned int start = 0; start < size; start += length) {
+      for (unsigned int k = 0; k < half_length; ++k) {
+        const std::complex<mydouble> &w = twiddle_factors[k * twiddle_stride];
+        const mydouble w_re(w.real());
+        const mydouble w_im(sign * w.imag());
+        std::complex<mydouble> &a = data[start + k];
+        std::complex<mydouble> &b = data[start + k + half_length];
+        // explicit complex multiplication, the operator* of std::complex
+        // performs expensive nan/inf checks
+        const mydouble t_re(b.real() * w_re - b.imag() * w_im);
+        const mydouble t_im(b.real() * w_im + b.imag() * w_re);
+        b = std::complex<mydouble>(a.real() - t_re, a.imag() - t_im);
+        a = std::complex<mydouble>(a.real() + t_re, a.imag() + t_im);
+      }
+    }
+  }
+}
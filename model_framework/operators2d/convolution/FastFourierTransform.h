@@ -0,0 +1,52 @@
+/*
+ * FastFourierTransform.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef FASTFOURIERTRANSFORM_H_
+#define FASTFOURIERTRANSFORM_H_
+
+#include "ProjectWideSettings.h"
+
+#include <complex>
+#include <vector>
+
+/**
+ * Iterative radix-2 complex fast fourier transform of a fixed, power of two
+ * length. It is self-contained on purpose (no external fft library has to be
+ * available) and works in the framework precision #mydouble. The bit
+ * reversal permutation and the twiddle factors are computed once in
+ * #setSize(), so #transform() does not allocate and can be called from
+ * several threads concurrently on different data.
+ */
+class FastFourierTransform {
+  unsigned int size;
+  std::vector<unsigned int> bit_reversed_indices;
+  // exp(-2 pi i k / size) for k in [0, size/2)
+  std::vector<std::complex<mydouble> > twiddle_factors;
+
+public:
+  FastFourierTransform(unsigned int size_ = 1);
+  virtual ~FastFourierTransform();
+
+  /**
+   * @returns the smallest power of two which is larger or equal to n
+   */
+  static unsigned int nextPowerOfTwo(unsigned int n);
+
+  /**
+   * Sets the transformation length, which has to be a power of two.
+   */
+  void setSize(unsigned int size_);
+  unsigned int getSize() const;
+
+  /**
+   * Transforms the #size values in data in place. The transformation is not
+   * normalized, so a forward transformation followed by an inverse one
+   * yields the input multiplied by #size.
+   */
+  void transform(std::complex<mydouble> *data, bool inverse = false) const;
+};
+
+#endif /* FASTFOURIERTRANSFORM_H_ */
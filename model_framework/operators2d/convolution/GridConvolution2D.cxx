@@ -0,0 +1,360 @@
+/*
+ * GridConvolution2D.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "GridConvolution2D.h"
+#include "core/PairwiseSum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+GridConvolution2D::GridConvolution2D(unsigned int output_bins_x_,
+    unsigned int output_bins_y_) :
+    output_bins_x(output_bins_x_), output_bins_y(output_bins_y_), kernel_half_width_x(
+        0), kernel_half_width_y(0), requested_method(AUTOMATIC), used_method(
+        DIRECT), current_input(0), current_output(0), number_of_tasks(1) {
+  direct_task = std::bind(&GridConvolution2D::convolveDirect, this,
+      std::placeholders::_1);
+  fft_input_rows_task = std::bind(&GridConvolution2D::transformInputRows,
+      this, std::placeholders::_1);
+  fft_columns_task = std::bind(&GridConvolution2D::convolveColumns, this,
+      std::placeholders::_1);
+  fft_output_rows_task = std::bind(&GridConvolution2D::transformOutputRows,
+      this, std::placeholders::_1);
+  separable_y_task = std::bind(&GridConvolution2D::convolveSeparableY, this,
+      std::placeholders::_1);
+  separable_x_task = std::bind(&GridConvolution2D::convolveSeparableX, this,
+      std::placeholders::_1);
+}
+
+GridConvolution2D::~GridConvolution2D() {
+}
+
+void GridConvolution2D::setMethod(Method method) {
+  requested_method = method;
+}
+
+GridConvolution2D::Method GridConvolution2D::getMethod() const {
+  return requested_method;
+}
+
+GridConvolution2D::Method GridConvolution2D::getUsedMethod() const {
+  return used_method;
+}
+
+int GridConvolution2D::getKernelHalfWidthX() const {
+  return kernel_half_width_x;
+}
+
+int GridConvolution2D::getKernelHalfWidthY() const {
+  return kernel_half_width_y;
+}
+
+unsigned int GridConvolution2D::getInputBinsX() const {
+  return output_bins_x + 2 * kernel_half_width_x;
+}
+
+unsigned int GridConvolution2D::getInputBinsY() const {
+  return output_bins_y + 2 * kernel_half_width_y;
+}
+
+void GridConvolution2D::setKernel(int half_width_x, int half_width_y,
+    const std::vector<mydouble> &kernel) {
+  if (half_width_x < 0 || half_width_y < 0
+      || kernel.size()
+          != (unsigned int) ((2 * half_width_x + 1) * (2 * half_width_y + 1)))
+    throw std::runtime_error(
+        "GridConvolution2D: the kernel size does not match its half widths!");
+
+  kernel_half_width_x = half_width_x;
+  kernel_half_width_y = half_width_y;
+  std::vector<mydouble>().swap(separable_workspace);
+
+  setDirectKernel(kernel);
+  chooseMethod(direct_weights.size());
+
+  if (used_method == FFT) {
+    calculateKernelSpectrum(kernel);
+  } else {
+    // release the memory of a previous fft setup
+    std::vector<std::complex<mydouble> >().swap(kernel_spectrum);
+    std::vector<std::complex<mydouble> >().swap(fft_workspace);
+  }
+}
+
+void GridConvolution2D::setSeparableKernel(int half_width_x,
+    int half_width_y, const std::vector<mydouble> &kernel_x_,
+    const std::vector<mydouble> &kernel_y_) {
+  if (half_width_x < 0 || half_width_y < 0
+      || kernel_x_.size() != (unsigned int) (2 * half_width_x + 1)
+      || kernel_y_.size() != (unsigned int) (2 * half_width_y + 1))
+    throw std::runtime_error(
+        "GridConvolution2D: the kernel size does not match its half widths!");
+
+  if (requested_method == DIRECT || requested_method == FFT) {
+    std::vector<mydouble> kernel(kernel_x_.size() * kernel_y_.size());
+    for (unsigned int ix = 0; ix < kernel_x_.size(); ++ix) {
+      for (unsigned int iy = 0; iy < kernel_y_.size(); ++iy)
+        kernel[ix * kernel_y_.size() + iy] = kernel_x_[ix] * kernel_y_[iy];
+    }
+    setKernel(half_width_x, half_width_y, kernel);
+    return;
+  }
+
+  kernel_half_width_x = half_width_x;
+  kernel_half_width_y = half_width_y;
+  kernel_x = kernel_x_;
+  kernel_y = kernel_y_;
+  used_method = SEPARABLE;
+
+  direct_offsets.clear();
+  direct_weights.clear();
+  std::vector<std::complex<mydouble> >().swap(kernel_spectrum);
+  std::vector<std::complex<mydouble> >().swap(fft_workspace);
+  separable_workspace.resize(getInputBinsX() * output_bins_y);
+}
+
+void GridConvolution2D::setDirectKernel(const std::vector<mydouble> &kernel) {
+  const unsigned int kernel_bins_y(2 * kernel_half_width_y + 1);
+  const unsigned int input_bins_y(getInputBinsY());
+  direct_offsets.clear();
+  direct_weights.clear();
+  for (int dx = -kernel_half_width_x; dx <= kernel_half_width_x; ++dx) {
+    for (int dy = -kernel_half_width_y; dy <= kernel_half_width_y; ++dy) {
+      mydouble weight(
+          kernel[(dx + kernel_half_width_x) * kernel_bins_y + dy
+              + kernel_half_width_y]);
+      if (weight != 0.0) {
+        direct_offsets.push_back(
+            (kernel_half_width_x - dx) * input_bins_y + kernel_half_width_y
+                - dy);
+        direct_weights.push_back(weight);
+      }
+    }
+  }
+}
+
+void GridConvolution2D::chooseMethod(unsigned int number_of_kernel_elements) {
+  if (requested_method == SEPARABLE)
+    throw std::runtime_error(
+        "GridConvolution2D: the separable convolution requires a separable kernel!");
+  if (requested_method != AUTOMATIC) {
+    used_method = requested_method;
+    return;
+  }
+  used_method = DIRECT;
+  if (number_of_kernel_elements < minimal_fft_kernel_size)
+    return;
+
+  // rough operation counts: one multiply-add per kernel element and output
+  // bin for the direct summation, and a forward plus an inverse 2D transform
+  // for the fft, whose butterflies cost about three multiply-adds
+  double direct_cost((double) output_bins_x * output_bins_y
+      * number_of_kernel_elements);
+  double padded_bins_x(
+      FastFourierTransform::nextPowerOfTwo(
+          getInputBinsX() + 2 * kernel_half_width_x));
+  double padded_bins_y(
+      FastFourierTransform::nextPowerOfTwo(
+          getInputBinsY() + 2 * kernel_half_width_y));
+  double fft_cost(
+      3.0 * padded_bins_x * padded_bins_y
+          * std::log2(padded_bins_x * padded_bins_y));
+  if (fft_cost < direct_cost)
+    used_method = FFT;
+}
+
+void GridConvolution2D::calculateKernelSpectrum(
+    const std::vector<mydouble> &kernel) {
+  // the full linear convolution has input + kernel - 1 bins per axis, so
+  // this padding avoids any wrap around of the cyclic fft convolution
+  fft_x.setSize(
+      FastFourierTransform::nextPowerOfTwo(
+          getInputBinsX() + 2 * kernel_half_width_x));
+  fft_y.setSize(
+      FastFourierTransform::nextPowerOfTwo(
+          getInputBinsY() + 2 * kernel_half_width_y));
+  const unsigned int padded_bins_x(fft_x.getSize());
+  const unsigned int padded_bins_y(fft_y.getSize());
+
+  kernel_spectrum.assign(padded_bins_x * padded_bins_y,
+      std::complex<mydouble>(0.0, 0.0));
+  fft_workspace.resize(padded_bins_x * padded_bins_y);
+
+  const unsigned int kernel_bins_x(2 * kernel_half_width_x + 1);
+  const unsigned int kernel_bins_y(2 * kernel_half_width_y + 1);
+  for (unsigned int ix = 0; ix < kernel_bins_x; ++ix) {
+    for (unsigned int iy = 0; iy < kernel_bins_y; ++iy) {
+      kernel_spectrum[ix * padded_bins_y + iy] = kernel[ix * kernel_bins_y
+          + iy];
+    }
+    fft_y.transform(&kernel_spectrum[ix * padded_bins_y]);
+  }
+  std::vector<std::complex<mydouble> > column(padded_bins_x);
+  for (unsigned int iy = 0; iy < padded_bins_y; ++iy) {
+    for (unsigned int ix = 0; ix < padded_bins_x; ++ix)
+      column[ix] = kernel_spectrum[ix * padded_bins_y + iy];
+    fft_x.transform(column.data());
+    for (unsigned int ix = 0; ix < padded_bins_x; ++ix)
+      kernel_spectrum[ix * padded_bins_y + iy] = column[ix];
+  }
+}
+
+std::pair<unsigned int, unsigned int> GridConvolution2D::getTaskRange(
+    unsigned int task_index, unsigned int size) const {
+  unsigned int chunk_size((size + number_of_tasks - 1) / number_of_tasks);
+  unsigned int begin(std::min(size, task_index * chunk_size));
+  unsigned int end(std::min(size, begin + chunk_size));
+  return std::make_pair(begin, end);
+}
+
+void GridConvolution2D::convolve(const mydouble *input, mydouble *output,
+    WorkerPool &worker_pool) {
+  current_input = input;
+  current_output = output;
+  number_of_tasks = worker_pool.getNumberOfThreads();
+
+  if (used_method == FFT) {
+    column_buffers.resize(number_of_tasks);
+    for (auto &column_buffer : column_buffers)
+      column_buffer.resize(fft_x.getSize());
+    worker_pool.run(fft_input_rows_task, number_of_tasks);
+    worker_pool.run(fft_columns_task, number_of_tasks);
+    worker_pool.run(fft_output_rows_task, number_of_tasks);
+  } else if (used_method == SEPARABLE) {
+    worker_pool.run(separable_y_task, number_of_tasks);
+    worker_pool.run(separable_x_task, number_of_tasks);
+  } else {
+    worker_pool.run(direct_task, number_of_tasks);
+  }
+}
+
+void GridConvolution2D::convolveDirect(unsigned int task_index) {
+  std::pair<unsigned int, unsigned int> row_range(
+      getTaskRange(task_index, output_bins_x));
+  const unsigned int input_bins_y(getInputBinsY());
+  const unsigned int number_of_elements(direct_weights.size());
+
+  PairwiseSum sum;
+  for (unsigned int ix = row_range.first; ix < row_range.second; ++ix) {
+    for (unsigned int iy = 0; iy < output_bins_y; ++iy) {
+      const mydouble *input_bin = current_input + ix * input_bins_y + iy;
+      sum.reset();
+      for (unsigned int i = 0; i < number_of_elements; ++i)
+        sum.add(input_bin[direct_offsets[i]] * direct_weights[i]);
+      current_output[ix * output_bins_y + iy] = sum.sum();
+    }
+  }
+}
+
+void GridConvolution2D::convolveSeparableY(unsigned int task_index) {
+  const unsigned int input_bins_y(getInputBinsY());
+  const unsigned int kernel_bins_y(kernel_y.size());
+
+  std::pair<unsigned int, unsigned int> row_range(
+      getTaskRange(task_index, getInputBinsX()));
+  PairwiseSum sum;
+  for (unsigned int ix = row_range.first; ix < row_range.second; ++ix) {
+    for (unsigned int iy = 0; iy < output_bins_y; ++iy) {
+      // input bin iy - dy + half width for kernel element dy
+      const mydouble *input_bin = current_input + ix * input_bins_y + iy
+          + 2 * kernel_half_width_y;
+      sum.reset();
+      for (unsigned int i = 0; i < kernel_bins_y; ++i)
+        sum.add(*(input_bin - i) * kernel_y[i]);
+      separable_workspace[ix * output_bins_y + iy] = sum.sum();
+    }
+  }
+}
+
+void GridConvolution2D::convolveSeparableX(unsigned int task_index) {
+  const unsigned int kernel_bins_x(kernel_x.size());
+
+  std::pair<unsigned int, unsigned int> row_range(
+      getTaskRange(task_index, output_bins_x));
+  PairwiseSum sum;
+  for (unsigned int ix = row_range.first; ix < row_range.second; ++ix) {
+    for (unsigned int iy = 0; iy < output_bins_y; ++iy) {
+      sum.reset();
+      for (unsigned int i = 0; i < kernel_bins_x; ++i) {
+        sum.add(separable_workspace[(ix + 2 * kernel_half_width_x - i)
+            * output_bins_y + iy] * kernel_x[i]);
+      }
+      current_output[ix * output_bins_y + iy] = sum.sum();
+    }
+  }
+}
+
+void GridConvolution2D::transformInputRows(unsigned int task_index) {
+  const unsigned int padded_bins_x(fft_x.getSize());
+  const unsigned int padded_bins_y(fft_y.getSize());
+  const unsigned int input_bins_x(getInputBinsX());
+  const unsigned int input_bins_y(getInputBinsY());
+
+  std::pair<unsigned int, unsigned int> row_range(
+      getTaskRange(task_index, padded_bins_x));
+  for (unsigned int ix = row_range.first; ix < row_range.second; ++ix) {
+    std::complex<mydouble> *row = &fft_workspace[ix * padded_bins_y];
+    if (ix < input_bins_x) {
+      const mydouble *input_row = current_input + ix * input_bins_y;
+      for (unsigned int iy = 0; iy < input_bins_y; ++iy)
+        row[iy] = input_row[iy];
+      for (unsigned int iy = input_bins_y; iy < padded_bins_y; ++iy)
+        row[iy] = 0.0;
+      fft_y.transform(row);
+    } else {
+      // zero padding, which transforms to zero
+      for (unsigned int iy = 0; iy < padded_bins_y; ++iy)
+        row[iy] = 0.0;
+    }
+  }
+}
+
+void GridConvolution2D::convolveColumns(unsigned int task_index) {
+  const unsigned int padded_bins_x(fft_x.getSize());
+  const unsigned int padded_bins_y(fft_y.getSize());
+  std::vector<std::complex<mydouble> > &column = column_buffers[task_index];
+
+  std::pair<unsigned int, unsigned int> column_range(
+      getTaskRange(task_index, padded_bins_y));
+  for (unsigned int iy = column_range.first; iy < column_range.second; ++iy) {
+    for (unsigned int ix = 0; ix < padded_bins_x; ++ix)
+      column[ix] = fft_workspace[ix * padded_bins_y + iy];
+    fft_x.transform(column.data());
+    for (unsigned int ix = 0; ix < padded_bins_x; ++ix) {
+      const std::complex<mydouble> &a = column[ix];
+      const std::complex<mydouble> &b = kernel_spectrum[ix * padded_bins_y
+          + iy];
+      column[ix] = std::complex<mydouble>(
+          a.real() * b.real() - a.imag() * b.imag(),
+          a.real() * b.imag() + a.imag() * b.real());
+    }
+    fft_x.transform(column.data(), true);
+    for (unsigned int ix = 0; ix < padded_bins_x; ++ix)
+      fft_workspace[ix * padded_bins_y + iy] = column[ix];
+  }
+}
+
+void GridConvolution2D::transformOutputRows(unsigned int task_index) {
+  const unsigned int padded_bins_y(fft_y.getSize());
+  const mydouble normalization(
+      1.0 / ((mydouble) fft_x.getSize() * fft_y.getSize()));
+
+  // output bin (ix, iy) is located at (ix + 2 * half width) in the linear
+  // convolution of the input with the kernel
+  std::pair<unsigned int, unsigned int> row_range(
+      getTaskRange(task_index, output_bins_x));
+  for (unsigned int ix = row_range.first; ix < row_range.second; ++ix) {
+    std::complex<mydouble> *row = &fft_workspace[(ix + 2 * kernel_half_width_x)
+        * padded_bins_y];
+    fft_y.transform(row, true);
+    for (unsigned int iy = 0; iy < output_bins_y; ++iy) {
+      current_output[ix * output_bins_y + iy] = normalization
+          * row[iy + 2 * kernel_half_width_y].real();
+    }
+  }
+}
@@ -0,0 +1,148 @@
+/*
+ * GridConvolution2D.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef GRIDCONVOLUTION2D_H_
+#define GRIDCONVOLUTION2D_H_
+
+#include "FastFourierTransform.h"
+#include "core/WorkerPool.h"
+
+#include <complex>
+#include <vector>
+
+/**
+ * Discrete convolution of a regular 2D grid with a translation invariant
+ * kernel, which is given on the same grid:
+ *
+ *   output[ix][iy] = sum_(dx,dy) kernel[dx][dy] * input[ix - dx][iy - dy]
+ *
+ * with dx in [-kernel_half_width_x, kernel_half_width_x] (same for y). The
+ * input therefore has to be supplied on the output grid extended by the
+ * kernel half widths on each side (see #getInputBinsX()), so no boundary
+ * treatment is necessary and the result is exactly the one of the direct
+ * summation.
+ *
+ * Two methods are available: the direct summation, which costs
+ * O(N * K) for N output bins and K non vanishing kernel elements, and a
+ * zero padded fft convolution, which costs O(P log P) for P padded bins.
+ * By default (#AUTOMATIC) the cheaper one is chosen when the kernel is set,
+ * so tiny kernels are always summed directly. A kernel which factorizes into
+ * a kernel in x and one in y (see #setSeparableKernel()) is applied as two
+ * 1D passes (#SEPARABLE), which costs O(N * (Kx + Ky)). All methods
+ * distribute their work on the #WorkerPool passed to #convolve().
+ */
+class GridConvolution2D {
+public:
+  enum Method {
+    AUTOMATIC, DIRECT, FFT, SEPARABLE
+  };
+
+  /**
+   * Kernels with less non vanishing elements than this are always summed
+   * directly in the #AUTOMATIC mode.
+   */
+  static const unsigned int minimal_fft_kernel_size = 32;
+
+private:
+  unsigned int output_bins_x;
+  unsigned int output_bins_y;
+  int kernel_half_width_x;
+  int kernel_half_width_y;
+
+  Method requested_method;
+  Method used_method;
+
+  // non vanishing kernel elements for the direct summation, as offsets into
+  // the input grid relative to the input bin of the output bin
+  std::vector<unsigned int> direct_offsets;
+  std::vector<mydouble> direct_weights;
+
+  std::vector<mydouble> kernel_x;
+  std::vector<mydouble> kernel_y;
+  // result of the pass in y, (#getInputBinsX() x output_bins_y) row major
+  std::vector<mydouble> separable_workspace;
+
+  FastFourierTransform fft_x;
+  FastFourierTransform fft_y;
+  std::vector<std::complex<mydouble> > kernel_spectrum;
+  std::vector<std::complex<mydouble> > fft_workspace;
+  std::vector<std::vector<std::complex<mydouble> > > column_buffers;
+
+  // state of the current #convolve() call for the worker tasks
+  const mydouble *current_input;
+  mydouble *current_output;
+  unsigned int number_of_tasks;
+
+  WorkerPool::Task direct_task;
+  WorkerPool::Task fft_input_rows_task;
+  WorkerPool::Task fft_columns_task;
+  WorkerPool::Task fft_output_rows_task;
+  WorkerPool::Task separable_y_task;
+  WorkerPool::Task separable_x_task;
+
+  void convolveDirect(unsigned int task_index);
+  void convolveSeparableY(unsigned int task_index);
+  void convolveSeparableX(unsigned int task_index);
+  void transformInputRows(unsigned int task_index);
+  void convolveColumns(unsigned int task_index);
+  void transformOutputRows(unsigned int task_index);
+
+  void setDirectKernel(const std::vector<mydouble> &kernel);
+  void chooseMethod(unsigned int number_of_kernel_elements);
+  void calculateKernelSpectrum(const std::vector<mydouble> &kernel);
+
+  std::pair<unsigned int, unsigned int> getTaskRange(unsigned int task_index,
+      unsigned int size) const;
+
+public:
+  GridConvolution2D(unsigned int output_bins_x_, unsigned int output_bins_y_);
+  virtual ~GridConvolution2D();
+
+  /**
+   * Sets the method used by the next #setKernel() or #setSeparableKernel()
+   * call. The methods other than #AUTOMATIC are meant for benchmarks and
+   * cross checks. #SEPARABLE can only be used with separable kernels.
+   */
+  void setMethod(Method method);
+  Method getMethod() const;
+  Method getUsedMethod() const;
+
+  /**
+   * Sets the convolution kernel. The weights are stored row major,
+   * kernel[(dx + half_width_x) * (2 * half_width_y + 1) + dy + half_width_y].
+   * With the fft method the spectrum of the kernel is computed here, so a
+   * kernel should be set only when it actually changed.
+   */
+  void setKernel(int half_width_x, int half_width_y,
+      const std::vector<mydouble> &kernel);
+
+  /**
+   * Sets a kernel which factorizes, kernel[dx][dy] = kernel_x_[dx] *
+   * kernel_y_[dy], with kernel_x_[dx + half_width_x] and likewise in y. In
+   * the #AUTOMATIC mode the convolution is then carried out as two 1D
+   * passes. If #DIRECT or #FFT was requested, the full 2D kernel is built
+   * and used instead.
+   */
+  void setSeparableKernel(int half_width_x, int half_width_y,
+      const std::vector<mydouble> &kernel_x_,
+      const std::vector<mydouble> &kernel_y_);
+
+  int getKernelHalfWidthX() const;
+  int getKernelHalfWidthY() const;
+
+  unsigned int getInputBinsX() const;
+  unsigned int getInputBinsY() const;
+
+  /**
+   * Convolves the input grid (row major, #getInputBinsX() x #getInputBinsY())
+   * with the kernel and writes the result row major into output
+   * (output_bins_x x output_bins_y).
+   */
+  void convolve(const mydouble *input, mydouble *output,
+      WorkerPool &worker_pool);
+};
+
+#endif /* GRIDCONVOLUTION2D_H_ */
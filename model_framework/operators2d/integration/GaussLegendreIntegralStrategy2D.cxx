@@ -0,0 +1,177 @@
+/*
+ * GaussLegendreIntegralStrategy2D.cxx
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <operators2d/integration/GaussLegendreIntegralStrategy2D.h>
+#include <core/Model2D.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "boost/thread/lock_guard.hpp"
+
+GaussLegendreIntegralStrategy2D::GaussLegendreIntegralStrategy2D(
+    unsigned int order_, unsigned int max_refinement_level_) :
+    order(order_), max_refinement_level(max_refinement_level_), number_of_evaluations(
+        0) {
+  if (order % 2 == 0) {
+    throw std::runtime_error(
+        "GaussLegendreIntegralStrategy2D: the order has to be odd, so that the midpoint rule is embedded!");
+  }
+  computeNodesAndWeights();
+}
+
+GaussLegendreIntegralStrategy2D::~GaussLegendreIntegralStrategy2D() {
+}
+
+void GaussLegendreIntegralStrategy2D::computeNodesAndWeights() {
+  nodes.resize(order);
+  weights.resize(order);
+  const mydouble pi(std::acos(mydouble(-1.0)));
+  // the roots of the legendre polynomial P_order are found with the newton
+  // method, starting from the chebyshev like approximation of the roots
+  for (unsigned int i = 0; i < (order + 1) / 2; ++i) {
+    mydouble x(std::cos(pi * (i + 0.75) / (order + 0.5)));
+    mydouble derivative(0.0);
+    for (unsigned int iteration = 0; iteration < 100; ++iteration) {
+      // recursion (k+1) P_{k+1} = (2k+1) x P_k - k P_{k-1}
+      mydouble p(1.0);
+      mydouble p_previous(0.0);
+      for (unsigned int k = 0; k < order; ++k) {
+        mydouble p_next(((2.0 * k + 1.0) * x * p - k * p_previous) / (k + 1.0));
+        p_previous = p;
+        p = p_next;
+      }
+      derivative = order * (x * p - p_previous) / (x * x - 1.0);
+      mydouble step(p / derivative);
+      x -= step;
+      if (std::fabs(step) <= 4.0 * std::numeric_limits<mydouble>::epsilon())
+        break;
+    }
+    mydouble weight(2.0 / ((1.0 - x * x) * derivative * derivative));
+    nodes[i] = -x;
+    nodes[order - 1 - i] = x;
+    weights[i] = weight;
+    weights[order - 1 - i] = weight;
+  }
+  // the center node is zero, which the midpoint rule relies on
+  nodes[order / 2] = 0.0;
+}
+
+void GaussLegendreIntegralStrategy2D::setMaximumRefinementLevel(
+    unsigned int max_refinement_level_) {
+  max_refinement_level = max_refinement_level_;
+}
+
+void GaussLegendreIntegralStrategy2D::resetRefinementLevels() {
+  boost::lock_guard<boost::mutex> lock(refinement_levels_mutex);
+  refinement_levels.clear();
+}
+
+unsigned long long GaussLegendreIntegralStrategy2D::getNumberOfFunctionEvaluations() const {
+  return number_of_evaluations;
+}
+
+unsigned int GaussLegendreIntegralStrategy2D::getRefinementLevel(
+    const RangeKey &key) {
+  boost::lock_guard<boost::mutex> lock(refinement_levels_mutex);
+  auto level = refinement_levels.find(key);
+  if (level == refinement_levels.end())
+    return 0;
+  return std::min(level->second, max_refinement_level);
+}
+
+void GaussLegendreIntegralStrategy2D::setRefinementLevel(const RangeKey &key,
+    unsigned int level) {
+  boost::lock_guard<boost::mutex> lock(refinement_levels_mutex);
+  refinement_levels[key] = level;
+}
+
+void GaussLegendreIntegralStrategy2D::integrate(Model2D *model2d,
+    const std::vector<DataStructs::DimensionRange> &ranges,
+    unsigned int level, mydouble &result, mydouble &error) {
+  const unsigned int cells(1u << level);
+  const unsigned int nodes_per_axis(cells * order);
+  const mydouble cell_width_x(
+      (ranges[0].range_high - ranges[0].range_low) / cells);
+  const mydouble cell_width_y(
+      (ranges[1].range_high - ranges[1].range_low) / cells);
+
+  std::vector<mydouble> node_weights_x(nodes_per_axis);
+  std::vector<mydouble> node_weights_y(nodes_per_axis);
+  // each row of nodes is evaluated as one batch
+  std::vector<mydouble> row_coordinates(2 * nodes_per_axis);
+  std::vector<mydouble> values(nodes_per_axis * nodes_per_axis);
+
+  for (unsigned int i = 0; i < nodes_per_axis; ++i) {
+    unsigned int cell(i / order);
+    unsigned int node(i % order);
+    node_weights_x[i] = 0.5 * cell_width_x * weights[node];
+    node_weights_y[i] = 0.5 * cell_width_y * weights[node];
+    row_coordinates[2 * i + 1] = ranges[1].range_low
+        + cell_width_y * (cell + 0.5 * (1.0 + nodes[node]));
+  }
+  for (unsigned int ix = 0; ix < nodes_per_axis; ++ix) {
+    mydouble x(
+        ranges[0].range_low
+            + cell_width_x * (ix / order + 0.5 * (1.0 + nodes[ix % order])));
+    for (unsigned int iy = 0; iy < nodes_per_axis; ++iy)
+      row_coordinates[2 * iy] = x;
+    model2d->evaluateBatch(row_coordinates.data(), nodes_per_axis,
+        &values[ix * nodes_per_axis]);
+  }
+  number_of_evaluations += nodes_per_axis * nodes_per_axis;
+
+  result = 0.0;
+  error = 0.0;
+  const unsigned int center(order / 2);
+  const mydouble cell_area(cell_width_x * cell_width_y);
+  for (unsigned int cell_x = 0; cell_x < cells; ++cell_x) {
+    for (unsigned int cell_y = 0; cell_y < cells; ++cell_y) {
+      const unsigned int first_x(cell_x * order);
+      const unsigned int first_y(cell_y * order);
+      mydouble cell_result(0.0);
+      for (unsigned int ix = first_x; ix < first_x + order; ++ix) {
+        mydouble column(0.0);
+        for (unsigned int iy = first_y; iy < first_y + order; ++iy)
+          column += node_weights_y[iy] * values[ix * nodes_per_axis + iy];
+        cell_result += node_weights_x[ix] * column;
+      }
+      mydouble midpoint_result(
+          cell_area
+              * values[(first_x + center) * nodes_per_axis + first_y + center]);
+
+      mydouble difference(std::fabs(cell_result - midpoint_result));
+      mydouble relative_difference(1.0);
+      if (cell_result != 0.0)
+        relative_difference = std::min(mydouble(1.0),
+            difference / std::fabs(cell_result));
+
+      result += cell_result;
+      error += difference * std::pow(relative_difference, (int) order - 1);
+    }
+  }
+}
+
+mydouble GaussLegendreIntegralStrategy2D::Integral(Model2D *model2d,
+    const std::vector<DataStructs::DimensionRange> &ranges, mydouble precision) {
+  RangeKey key(ranges[0].range_low, ranges[0].range_high, ranges[1].range_low,
+      ranges[1].range_high);
+  const unsigned int start_level(getRefinementLevel(key));
+
+  unsigned int level(start_level);
+  mydouble result, error;
+  integrate(model2d, ranges, level, result, error);
+  while (error > precision * std::fabs(result) && level < max_refinement_level) {
+    ++level;
+    integrate(model2d, ranges, level, result, error);
+  }
+
+  if (level != start_level)
+    setRefinementLevel(key, level);
+  return result;
+}
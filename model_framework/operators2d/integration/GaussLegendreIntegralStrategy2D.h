@@ -0,0 +1,96 @@
+/*
+ * GaussLegendreIntegralStrategy2D.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef GAUSSLEGENDREINTEGRALSTRATEGY2D_H_
+#define GAUSSLEGENDREINTEGRALSTRATEGY2D_H_
+
+#include <operators2d/integration/IntegralStrategy2D.h>
+
+#include <atomic>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "boost/thread/mutex.hpp"
+
+class Model2D;
+
+/**
+ * Adaptive integration of a 2D model over a rectangle (typically a bin) with
+ * a tensor product Gauss-Legendre rule.
+ *
+ * On refinement level l the rectangle is divided into 2^l x 2^l cells, each
+ * of which is integrated with the order x order Gauss-Legendre rule. The
+ * order is odd, so the center of a cell is one of its nodes and the
+ * midpoint rule is embedded in the Gauss-Legendre rule at no extra cost.
+ * The difference d of both rules, relative to the cell integral q, is of
+ * order (h/L)^2 for a cell size h and a length scale L of the model, while
+ * the error of the Gauss-Legendre rule is of order (h/L)^(2 order).
+ * Therefore the error of a cell is estimated as d * min(1, (d/q)^(order-1))
+ * and the errors of all cells are summed up. The level is increased until
+ * the estimated error meets the relative precision or the maximum level is
+ * reached.
+ *
+ * The level which met the precision is remembered for each integration
+ * rectangle, so repeated integrations of the same bins (e.g. each
+ * regeneration of a cached model grid during a fit) start on the level
+ * found before and only refine further if needed. Integrations of different
+ * rectangles can run in parallel threads.
+ */
+class GaussLegendreIntegralStrategy2D: public IntegralStrategy2D {
+  typedef std::tuple<mydouble, mydouble, mydouble, mydouble> RangeKey;
+
+  unsigned int order;
+  unsigned int max_refinement_level;
+
+  // nodes and weights of the gauss-legendre rule on [-1, 1]
+  std::vector<mydouble> nodes;
+  std::vector<mydouble> weights;
+
+  std::map<RangeKey, unsigned int> refinement_levels;
+  boost::mutex refinement_levels_mutex;
+
+  std::atomic<unsigned long long> number_of_evaluations;
+
+  void computeNodesAndWeights();
+
+  unsigned int getRefinementLevel(const RangeKey &key);
+  void setRefinementLevel(const RangeKey &key, unsigned int level);
+
+  void integrate(Model2D *model2d,
+      const std::vector<DataStructs::DimensionRange> &ranges,
+      unsigned int level, mydouble &result, mydouble &error);
+
+public:
+  /**
+   * @param order_ number of nodes per dimension of the Gauss-Legendre rule
+   * of a cell, which has to be odd
+   */
+  GaussLegendreIntegralStrategy2D(unsigned int order_ = 3,
+      unsigned int max_refinement_level_ = 4);
+  virtual ~GaussLegendreIntegralStrategy2D();
+
+  void setMaximumRefinementLevel(unsigned int max_refinement_level_);
+
+  /**
+   * Forgets the remembered refinement levels, e.g. after the binning or the
+   * model changed substantially.
+   */
+  void resetRefinementLevels();
+
+  /**
+   * @returns the number of model evaluations of all integrations so far
+   */
+  unsigned long long getNumberOfFunctionEvaluations() const;
+
+  /**
+   * @param precision relative precision of the integral
+   */
+  mydouble Integral(Model2D *model2d,
+      const std::vector<DataStructs::DimensionRange> &ranges, mydouble precision);
+};
+
+#endif /* GAUSSLEGENDREINTEGRALSTRATEGY2D_H_ */
@@ -9,6 +9,7 @@
 #include <core/Model2D.h>
 #include <iostream>
 #include <cmath>
+#include <vector>
 
 SimpleIntegralStrategy2D::SimpleIntegralStrategy2D() {
   // TODO Auto-generated constructor stub
@@ -47,18 +48,27 @@ unsigned int SimpleIntegralStrategy2D::determineOptimalCallNumber(Model2D *model
 mydouble SimpleIntegralStrategy2D::Integral(Model2D *model2d,
     const std::vector<DataStructs::DimensionRange> &ranges, mydouble precision) {
   mydouble result = 0.0;
-  mydouble x[2];
 
   mydouble wx = (ranges[0].range_high - ranges[0].range_low) / used_grid_constant;
   mydouble wy = (ranges[1].range_high - ranges[1].range_low) / used_grid_constant;
 
+  // each grid row is evaluated as one batch
+  std::vector<mydouble> row_coordinates(2 * used_grid_constant);
+  std::vector<mydouble> row_values(used_grid_constant);
+
   mydouble half(0.5);
+  for (unsigned int iy = 0; iy < used_grid_constant; ++iy) {
+    row_coordinates[2 * iy + 1] = ranges[1].range_low + wy * (half + iy);
+  }
   for (unsigned int ix = 0; ix < used_grid_constant; ++ix) {
+    mydouble x = ranges[0].range_low + wx * (half + ix);
+    for (unsigned int iy = 0; iy < used_grid_constant; ++iy) {
+      row_coordinates[2 * iy] = x;
+    }
+    model2d->evaluateBatch(row_coordinates.data(), used_grid_constant,
+        row_values.data());
     for (unsigned int iy = 0; iy < used_grid_constant; ++iy) {
-      x[0] = ranges[0].range_low + wx * (half + ix);
-      x[1] = ranges[1].range_low + wy * (half + iy);
-      mydouble tempresult = model2d->evaluate(x);
-      result += tempresult;
+      result += row_values[iy];
     }
   }
   result = result * wx * wy;
@@ -14,6 +14,7 @@
 #include <cmath>
 #include <limits>
 #include <iostream>
+#include <vector>
 
 ROOTPlotter::ROOTPlotter() {
 	// TODO Auto-generated constructor stub
@@ -36,12 +37,17 @@ TGraphAsymmErrors* ROOTPlotter::createGraphFromModel1D(std::shared_ptr<Model> mo
 
 	mydouble stepsize = visualization_properties.getPlotRange().getDimensionLength()
 			/ visualization_properties.getEvaluations();
-	mydouble x;
+	std::vector<mydouble> xs(visualization_properties.getEvaluations());
+	std::vector<mydouble> values(visualization_properties.getEvaluations());
+	for (unsigned int i = 0; i < xs.size(); i++)
+		xs[i] = visualization_properties.getPlotRange().range_low + stepsize * i;
+	model->evaluateBatch(xs.data(), xs.size(), values.data());
 
+	mydouble x;
 	for (unsigned int i = 0; i < visualization_properties.getEvaluations(); i++) {
-		x = visualization_properties.getPlotRange().range_low + stepsize * i;
+		x = xs[i];
 		graph->SetPoint(i, x,
-				model->evaluate(&x) * visualization_properties.getBinningFactor());
+				values[i] * visualization_properties.getBinningFactor());
 		graph->SetPointError(i, 0, 0,
 				model->getUncertaincy(&x).first
 						* visualization_properties.getBinningFactor(),
@@ -74,19 +80,27 @@ TH2D* ROOTPlotter::createHistogramFromModel2D(std::shared_ptr<Model> model,
 					/ visualization_properties.second.getEvaluations();
 	mydouble x[2];
 
+	// the model is evaluated row by row in batches
+	unsigned int evaluations_y = visualization_properties.second.getEvaluations();
+	std::vector<mydouble> row_coordinates(2 * evaluations_y);
+	std::vector<mydouble> row_values(evaluations_y);
+	for (unsigned int iy = 0; iy < evaluations_y; iy++) {
+		row_coordinates[2 * iy + 1] =
+				visualization_properties.second.getPlotRange().range_low
+						+ stepsize_y * (1.0 * iy + 0.5);
+	}
+
 	for (unsigned int ix = 0;
 			ix < visualization_properties.first.getEvaluations(); ix++) {
 		x[0] = visualization_properties.first.getPlotRange().range_low
 				+ stepsize_x * (1.0 * ix + 0.5);
-		DataStructs::DimensionRange drx(x[0] - 0.5 * stepsize_x,
-				x[0] + 0.5 * stepsize_x);
-		for (unsigned int iy = 0;
-				iy < visualization_properties.second.getEvaluations(); iy++) {
-			x[1] = visualization_properties.second.getPlotRange().range_low
-					+ stepsize_y * (1.0 * iy + 0.5);
-
-			DataStructs::DimensionRange dry(x[1] - 0.5 * stepsize_y,
-					x[1] + 0.5 * stepsize_y);
+		for (unsigned int iy = 0; iy < evaluations_y; iy++)
+			row_coordinates[2 * iy] = x[0];
+		model->evaluateBatch(row_coordinates.data(), evaluations_y,
+				row_values.data());
+
+		for (unsigned int iy = 0; iy < evaluations_y; iy++) {
+			x[1] = row_coordinates[2 * iy + 1];
 			/*std::cout << "[" << x[0] << ", " << x[1] << "] -> "
 			 << model->evaluate(x)
 			 * visualization_properties.first.getBinningFactor()
@@ -100,10 +114,10 @@ TH2D* ROOTPlotter::createHistogramFromModel2D(std::shared_ptr<Model> model,
 
 			 hist->Fill(x[0], x[1], integral);*/
 
-			mydouble value = model->evaluate(x);
+			mydouble value = row_values[iy];
 			if (std::fabs(value) > std::numeric_limits<mydouble>::min())
 				hist->Fill(x[0], x[1],
-						model->evaluate(x)
+						value
 								* visualization_properties.first.getBinningFactor()
 								* visualization_properties.second.getBinningFactor());
 
@@ -3,22 +3,30 @@
 #include "fit/estimatorImpl/Chi2Estimator.h"
 #include "fit/estimatorImpl/LogLikelihoodEstimator.h"
 #include "fit/minimizerImpl/ROOT/ROOTMinimizer.h"
+#include "fit/minimizerImpl/LevenbergMarquardt/LevenbergMarquardtMinimizer.h"
 //#include "fit/minimizerImpl/Ceres/CeresMinimizer.h"
 #include "fit/data/Data.h"
 #include "PndLmdDataFacade.h"
 #include "PndLmdComparisonStructs.h"
 #include "model/PndLmdModelFactory.h"
+#include "core/WorkerPool.h"
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <csignal>
+#include <memory>
+#include <stdexcept>
 
 #include "boost/property_tree/ptree.hpp"
 #include "boost/filesystem.hpp"
 #include "boost/foreach.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/lock_guard.hpp"
 
 #include "TFile.h"
 #include "TH1D.h"
+#include "TROOT.h"
 #include "TVectorD.h"
 
 using std::cout;
@@ -28,8 +36,15 @@ using std::pair;
 
 using boost::property_tree::ptree;
 
+namespace {
+// serializes the creation and destruction of ROOT objects and models of
+// concurrent fits
+boost::mutex root_object_mutex;
+}
+
 PndLmdFitFacade::PndLmdFitFacade() :
-    lmd_runtime_config(PndLmdRuntimeConfiguration::Instance()) {
+    lmd_runtime_config(PndLmdRuntimeConfiguration::Instance()), number_of_threads(
+        lmd_runtime_config.getNumberOfThreads()) {
   signal(SIGINT, signalHandler);
 }
 
@@ -44,6 +59,11 @@ void PndLmdFitFacade::signalHandler(int signum) {
   exit(signum);
 }
 
+void PndLmdFitFacade::setNumberOfThreads(unsigned int number_of_threads_) {
+  number_of_threads = number_of_threads_;
+  model_factory.setNumberOfThreads(number_of_threads);
+}
+
 void PndLmdFitFacade::setModelFactoryAcceptence(const PndLmdAcceptance &lmd_acc) {
   model_factory.setAcceptance(lmd_acc);
 }
@@ -195,6 +215,9 @@ EstimatorOptions PndLmdFitFacade::constructEstimatorOptionsFromConfig(const ptre
   EstimatorOptions est_opt;
 
   est_opt.setWithIntegralScaling(pt.get<bool>("with_integral_scaling"));
+  // optional, the luminosity is then determined in closed form by the estimator
+  if (pt.get<bool>("profile_luminosity", false))
+    est_opt.setProfiledScaleParameterName("luminosity");
 
   DataStructs::DimensionRange dim_range;
   dim_range.is_active = pt.get<bool>("fit_range_x_active");
@@ -299,6 +322,20 @@ void PndLmdFitFacade::addBeamParametersToFreeParameterList(PndLmdFitOptions &fit
   fit_opts.free_parameter_names.insert("luminosity");
 }
 
+std::shared_ptr<ModelMinimizer> PndLmdFitFacade::createMinimizer(
+    const PndLmdFitOptions &fit_options, int minuit_type) const {
+  if (fit_options.minimizer_type == LumiFit::LEVENBERG_MARQUARDT) {
+    // least squares fit on the residuals of the estimator, which are not
+    // available for a profiled luminosity
+    if (fit_options.getEstimatorOptions().getProfiledScaleParameterName()
+        != "")
+      throw std::runtime_error(
+          "PndLmdFitFacade: the Levenberg-Marquardt minimizer can not be used with a profiled luminosity!");
+    return std::make_shared<LevenbergMarquardtMinimizer>();
+  }
+  return std::make_shared<ROOTMinimizer>(minuit_type);
+}
+
 PndLmdFitOptions PndLmdFitFacade::createFitOptions(const PndLmdAbstractData &lmd_data) const {
   std::cout << "creating fit options..." << std::endl;
 
@@ -308,6 +345,8 @@ PndLmdFitOptions PndLmdFitFacade::createFitOptions(const PndLmdAbstractData &lmd
 
   fit_opts.estimator_type = LumiFit::StringToLmdEstimatorType.at(
       fit_config_ptree.get<std::string>("fit.estimator_type"));
+  fit_opts.minimizer_type = LumiFit::StringToLmdMinimizerType.at(
+      fit_config_ptree.get<std::string>("fit.minimizer_type", "MINUIT"));
   fit_opts.est_opt = constructEstimatorOptionsFromConfig(
       fit_config_ptree.get_child("fit.estimator_options"));
   ptree model_option_ptree = fit_config_ptree.get_child("fit.fit_model_options");
@@ -354,19 +393,68 @@ PndLmdFitOptions PndLmdFitFacade::createFitOptions(const PndLmdAbstractData &lmd
   return fit_opts;
 }
 
+void PndLmdFitFacade::runLuminosityFitJob(LuminosityFitJob &job) const {
+  std::unique_ptr<PndLmdFitFacade> job_fit_facade;
+  std::unique_ptr<PndLmdAngularData> job_lmd_data;
+  {
+    // copies of ROOT objects are not thread safe
+    boost::lock_guard<boost::mutex> lock(root_object_mutex);
+    job_fit_facade.reset(new PndLmdFitFacade());
+    job_fit_facade->setNumberOfThreads(job.number_of_threads);
+    if (job.acceptance)
+      job_fit_facade->model_factory.setAcceptance(*job.acceptance);
+    if (job.with_resolution_map)
+      job_fit_facade->model_factory.setResolutionMapData(
+          *resolution_map_pool.begin());
+    job_lmd_data.reset(new PndLmdAngularData(*job.lmd_data));
+  }
+
+  job_fit_facade->fitElasticPPbar(*job_lmd_data);
+
+  // keep only the results of this job
+  auto const& previous_fit_results = job.lmd_data->getFitResults();
+  for (auto const& fit_results : job_lmd_data->getFitResults()) {
+    unsigned int number_of_previous_results(0);
+    auto previous = previous_fit_results.find(fit_results.first);
+    if (previous != previous_fit_results.end())
+      number_of_previous_results = previous->second.size();
+    for (unsigned int i = number_of_previous_results;
+        i < fit_results.second.size(); ++i)
+      job.fit_results.push_back(
+          std::make_pair(fit_results.first, fit_results.second[i]));
+  }
+
+  boost::lock_guard<boost::mutex> lock(root_object_mutex);
+  job_lmd_data.reset();
+  job_fit_facade.reset();
+}
+
 PndLmdFitDataBundle PndLmdFitFacade::doLuminosityFits(
     std::vector<PndLmdAngularData>& lmd_data_vec) {
   PndLmdDataFacade lmd_data_facade;
   PndLmdFitDataBundle data_bundle;
 
-  std::vector<PndLmdAcceptance> matching_acc;
-
   cout << "Running LumiFit on " << lmd_data_vec.size() << " angular data sets...." << endl;
 
-  for (auto& lmd_data : lmd_data_vec) {
+  // collect the fits, the jobs of a data set are consecutive
+  std::vector<LuminosityFitJob> jobs;
+  std::vector<std::pair<unsigned int, unsigned int> > job_ranges(
+      lmd_data_vec.size(), std::make_pair(0u, 0u));
+  // data sets skipped because of missing resolution map data
+  std::vector<bool> skipped_data(lmd_data_vec.size(), true);
+
+  for (unsigned int data_index = 0; data_index < lmd_data_vec.size();
+      ++data_index) {
+    auto const& lmd_data = lmd_data_vec[data_index];
+    job_ranges[data_index].first = jobs.size();
+    job_ranges[data_index].second = jobs.size();
 
     PndLmdFitOptions fit_options(createFitOptions(lmd_data));
 
+    LuminosityFitJob job;
+    job.lmd_data = &lmd_data;
+    job.with_resolution_map = false;
+
     if (fit_options.getModelOptionsPropertyTree().get<bool>("resolution_smearing_active")) {
       //matching_res = lmd_data_facade.getMatchingResolutions(resolution_pool,
       //    lmd_data_vec[elastic_data_index]);
@@ -378,7 +466,7 @@ PndLmdFitDataBundle PndLmdFitFacade::doLuminosityFits(
               << "Hence skipping this fit!\n";
           continue;
         }
-        model_factory.setResolutionMapData(*resolution_map_pool.begin());
+        job.with_resolution_map = true;
       } else {
         std::cout
             << "Requesting fit with resolution smearing, however no resolution map data was specified!"
@@ -387,24 +475,63 @@ PndLmdFitDataBundle PndLmdFitFacade::doLuminosityFits(
       }
     }
 
-    if (fit_options.getModelOptionsPropertyTree().get<bool>("acceptance_correction_active")) {
-      matching_acc = lmd_data_facade.getMatchingAcceptances(acceptance_pool, lmd_data);
+    skipped_data[data_index] = false;
 
+    if (fit_options.getModelOptionsPropertyTree().get<bool>("acceptance_correction_active")) {
+      std::vector<PndLmdAcceptance> matching_acc =
+          lmd_data_facade.getMatchingAcceptances(acceptance_pool, lmd_data);
       for (auto const& acc : matching_acc) {
-        // set acc in factory
-        model_factory.setAcceptance(acc);
-
-        fitElasticPPbar(lmd_data);
-
-        data_bundle.addFittedElasticData(lmd_data);
-        data_bundle.attachAcceptanceToCurrentData(model_factory.getAcceptance());
-        if (fit_options.getModelOptionsPropertyTree().get<bool>("resolution_smearing_active"))
-          data_bundle.attachResolutionMapDataToCurrentData(*resolution_map_pool.begin());
+        job.acceptance.reset(new PndLmdAcceptance(acc));
+        jobs.push_back(job);
       }
     } else {
-      fitElasticPPbar(lmd_data);
+      jobs.push_back(job);
+    }
+    job_ranges[data_index].second = jobs.size();
+  }
+
+  // the fits share the core budget
+  const unsigned int core_budget(std::max(1u, number_of_threads));
+  const unsigned int number_of_concurrent_fits(
+      std::max(1u,
+          std::min(lmd_runtime_config.getNumberOfConcurrentFits(),
+              std::min((unsigned int) jobs.size(), core_budget))));
+  const unsigned int threads_per_fit(core_budget / number_of_concurrent_fits);
+  for (auto& job : jobs)
+    job.number_of_threads = threads_per_fit;
+
+  cout << "Running " << jobs.size() << " fits, " << number_of_concurrent_fits
+      << " at a time with " << threads_per_fit << " threads each..." << endl;
+
+  if (number_of_concurrent_fits > 1)
+    ROOT::EnableThreadSafety();
+
+  std::atomic<unsigned int> next_job(0);
+  WorkerPool::Task fit_task = [&](unsigned int) {
+    for (unsigned int i = next_job++; i < jobs.size(); i = next_job++)
+      runLuminosityFitJob(jobs[i]);
+  };
+
+  WorkerPool fit_pool(number_of_concurrent_fits);
+  fit_pool.run(fit_task, number_of_concurrent_fits);
+
+  // merge the results in the order of a serial run
+  for (unsigned int data_index = 0; data_index < lmd_data_vec.size();
+      ++data_index) {
+    auto& lmd_data = lmd_data_vec[data_index];
+    if (skipped_data[data_index])
+      continue;
+
+    for (unsigned int i = job_ranges[data_index].first;
+        i < job_ranges[data_index].second; ++i) {
+      for (auto const& fit_result : jobs[i].fit_results)
+        lmd_data.addFitResult(fit_result.first, fit_result.second);
 
       data_bundle.addFittedElasticData(lmd_data);
+      if (jobs[i].acceptance)
+        data_bundle.attachAcceptanceToCurrentData(*jobs[i].acceptance);
+      if (jobs[i].with_resolution_map)
+        data_bundle.attachResolutionMapDataToCurrentData(*resolution_map_pool.begin());
     }
     data_bundle.addCurrentDataBundleToList();
     data_bundle.printInfo();
@@ -414,34 +541,38 @@ PndLmdFitDataBundle PndLmdFitFacade::doLuminosityFits(
 }
 
 void PndLmdFitFacade::fitElasticPPbar(PndLmdAngularData &lmd_data) {
-// generate model
-
   PndLmdFitOptions fit_options(createFitOptions(lmd_data));
 
+  FitStageState state;
+
   if (fit_options.model_opt_map["divergence_smearing_active"] == "true") {
+    // the fit without the divergence smearing is cheap and determines all
+    // other parameters, so that the expensive fit with the divergence
+    // smearing starts close to the minimum
     PndLmdFitOptions fit_options_no_div(fit_options);
 
     fit_options_no_div.model_opt_map["divergence_smearing_active"] = "false";
     fit_options_no_div.free_parameter_names.erase("gauss_sigma_var1");
     fit_options_no_div.free_parameter_names.erase("gauss_sigma_var2");
 
-    std::shared_ptr<Model> model = generateModel(lmd_data, fit_options_no_div);
-
-    // init beam parameters in model
-    initBeamParametersForModel(model, fit_options_no_div.getModelOptionsPropertyTree());
-
-    if (model->init()) {
-      std::cout << "ERROR: Not all parameters of the model were successfully initialized!"
-          << std::endl;
-      model->getModelParameterSet().printInfo();
-    }
-
-    // free parameters
-    freeParametersForModel(model, fit_options_no_div);
+    runFitStage(lmd_data, fit_options_no_div, std::vector<std::string>(),
+        state);
+    runFitStage(lmd_data, fit_options,
+        { "gauss_sigma_var1", "gauss_sigma_var2" }, state);
+  }
+  else {
+    runFitStage(lmd_data, fit_options, std::vector<std::string>(), state);
+  }
+}
 
-    // set model
-    model_fit_facade.setModel(model);
+void PndLmdFitFacade::runFitStage(PndLmdAngularData &lmd_data,
+    const PndLmdFitOptions &fit_options,
+    const std::vector<std::string> &scanned_parameter_names,
+    FitStageState &state) {
+  std::shared_ptr<Model> model = generateModel(lmd_data, fit_options,
+      state.model_components);
 
+  if (!state.model) {
     unsigned int fit_dimension = fit_options.getModelOptionsPropertyTree().get<unsigned int>(
         "fit_dimension");
 
@@ -454,30 +585,32 @@ void PndLmdFitFacade::fitElasticPPbar(PndLmdAngularData &lmd_data) {
       model_fit_facade.setData(createData1D(lmd_data));
     }
 
-    // now set better starting amplitude value
-    std::vector<DataStructs::DimensionRange> range = calcRange(lmd_data,
-        fit_options.getEstimatorOptions());
-    double integral_data = 0.0;
-    std::cout << "calculating data integral..." << std::endl;
-    if (fit_dimension == 2)
-      integral_data = calcHistIntegral(lmd_data.get2DHistogram(), range);
-    else
-      integral_data = calcHistIntegral(lmd_data.get1DHistogram(), range);
-    std::cout << "calculating model integral..." << std::endl;
-    double integral_func = model->Integral(range, 1e-1);
-    double binning_factor = lmd_data.getBinningFactor(fit_dimension);
-    double lumi_start = integral_data / integral_func / binning_factor;
-    cout << "binning factor: " << binning_factor << endl;
-    cout << "integral (model): " << integral_func << endl;
-    cout << integral_data << " / " << integral_func * binning_factor << endl;
-    cout << "Using start luminosity: " << lumi_start << endl;
-    model->getModelParameterSet().setModelParameterValue("luminosity", lumi_start);
+    // a profiled luminosity is determined by the estimator, so there is no
+    // need for a start value
+    if (fit_options.getEstimatorOptions().getProfiledScaleParameterName() == "") {
+      // now set better starting amplitude value
+      std::vector<DataStructs::DimensionRange> range = calcRange(lmd_data,
+          fit_options.getEstimatorOptions());
+      double integral_data = 0.0;
+      std::cout << "calculating data integral..." << std::endl;
+      if (fit_dimension == 2)
+        integral_data = calcHistIntegral(lmd_data.get2DHistogram(), range);
+      else
+        integral_data = calcHistIntegral(lmd_data.get1DHistogram(), range);
+      double binning_factor = lmd_data.getBinningFactor(fit_dimension);
+
+      std::cout << "calculating model integral..." << std::endl;
+      double integral_func = model->Integral(range, 1e-1);
+      double lumi_start = integral_data / integral_func / binning_factor;
+      cout << "binning factor: " << binning_factor << endl;
+      cout << "integral (model): " << integral_func << endl;
+      cout << integral_data << " / " << integral_func * binning_factor << endl;
+      cout << "Using start luminosity: " << lumi_start << endl;
+      model->getModelParameterSet().setModelParameterValue("luminosity", lumi_start);
+    }
 
     // create minimizer instance with control parameter
-    std::shared_ptr<ROOTMinimizer> minuit_minimizer(new ROOTMinimizer());
-    //std::shared_ptr<CeresMinimizer> ceres_minimizer(new CeresMinimizer());
-
-    model_fit_facade.setMinimizer(minuit_minimizer);
+    model_fit_facade.setMinimizer(createMinimizer(fit_options));
     // create estimator
     std::shared_ptr<ModelEstimator> estimator;
     if (fit_options.estimator_type == LumiFit::CHI2)
@@ -485,151 +618,62 @@ void PndLmdFitFacade::fitElasticPPbar(PndLmdAngularData &lmd_data) {
     else
       estimator.reset(new LogLikelihoodEstimator());
 
-    PndLmdRuntimeConfiguration& lmd_runtime_config = PndLmdRuntimeConfiguration::Instance();
-
-    estimator->setNumberOfThreads(lmd_runtime_config.getNumberOfThreads());
+    estimator->setNumberOfThreads(number_of_threads);
 
     model_fit_facade.setEstimator(estimator);
-    model_fit_facade.setEstimatorOptions(fit_options.getEstimatorOptions());
-
-    doFit(lmd_data, fit_options_no_div);
-
-    model = generateModel(lmd_data, fit_options);
-
-    // init beam parameters in model
-    initBeamParametersForModel(model, fit_options.getModelOptionsPropertyTree());
-
-    if (model->init()) {
-      std::cout << "ERROR: Not all parameters of the model were successfully initialized!"
-          << std::endl;
-      model->getModelParameterSet().printInfo();
-    }
-
-    // free parameters
-    freeParametersForModel(model, fit_options);
-
-    std::vector<std::string> var_names = { "tilt_x", "tilt_y" };
-
-    auto const& no_div_fit_res_params =
-        lmd_data.getFitResults(fit_options_no_div).back().getFitParameters();
-    // overwrite the start values
-    for (auto const& var : var_names) {
-      for (auto const param : no_div_fit_res_params) {
-        if (param.name.second == var) {
-          model->getModelParameterSet().getModelParameter(var)->setValue(param.value);
-          std::cout << "setting " << var << " to " << param.value << std::endl;
-          break;
-        }
-      }
-    }
-
-    // now set better starting amplitude value
-    std::cout << "calculating model integral..." << std::endl;
-    integral_func = model->Integral(range, 1e-1);
-    lumi_start = integral_data / integral_func / binning_factor;
-    cout << "binning factor: " << binning_factor << endl;
-    cout << "integral (model): " << integral_func << endl;
-    cout << integral_data << " / " << integral_func * binning_factor << endl;
-    cout << "Using start luminosity: " << lumi_start << endl;
-    model->getModelParameterSet().setModelParameterValue("luminosity", lumi_start);
+  } else {
+    // the luminosity of the previous stage is already a good start value,
+    // so the model integral is not needed again
+    carryParameterState(state.model, model);
+    model_fit_facade.setWarmStart(state.fit_result);
+  }
 
-    // set model
-    model_fit_facade.setModel(model);
+  // set model
+  model_fit_facade.setModel(model);
+  model_fit_facade.setEstimatorOptions(fit_options.getEstimatorOptions());
 
-    std::vector<std::string> scan_var_names = { "gauss_sigma_var1", "gauss_sigma_var2" };
+  // the parameters which are new in this stage need a better start value
+  if (scanned_parameter_names.size() > 0) {
     std::vector<std::shared_ptr<ModelPar> > pars;
-    bool has_divergence_parameters(true);
-    for (unsigned int i = 0; i < scan_var_names.size(); ++i) {
+    bool has_scanned_parameters(true);
+    for (auto const& name : scanned_parameter_names) {
       std::shared_ptr<ModelPar> temp_par = model->getModelParameterSet().getModelParameter(
-          scan_var_names[i]);
+          name);
       if (temp_par->isParameterFixed() == false) {
         pars.push_back(temp_par);
       } else {
-        has_divergence_parameters = false;
+        has_scanned_parameters = false;
         break;
       }
     }
-    if (has_divergence_parameters) {
-      std::vector<mydouble> start_values = model_fit_facade.findGoodStartParameters(scan_var_names,
-          { 1.5, 2.0 });
+    if (has_scanned_parameters) {
+      std::vector<mydouble> start_values = model_fit_facade.findGoodStartParameters(
+          scanned_parameter_names, { 1.5, 2.0 });
 
       for (unsigned int i = 0; i < pars.size(); ++i) {
         pars[i]->setValue(start_values[i]);
       }
     }
-
-    doFit(lmd_data, fit_options);
   }
 
-  else {
-    std::shared_ptr<Model> model = generateModel(lmd_data, fit_options);
-
-// init beam parameters in model
-    initBeamParametersForModel(model, fit_options.getModelOptionsPropertyTree());
+  doFit(lmd_data, fit_options);
 
-    if (model->init()) {
-      std::cout << "ERROR: Not all parameters of the model were successfully initialized!"
-          << std::endl;
-      model->getModelParameterSet().printInfo();
-    }
-
-// free parameters
-    freeParametersForModel(model, fit_options);
-
-// set model
-    model_fit_facade.setModel(model);
-
-    unsigned int fit_dimension = fit_options.getModelOptionsPropertyTree().get<unsigned int>(
-        "fit_dimension");
+  state.model = model;
+  state.fit_result = lmd_data.getFitResults(fit_options).back();
+}
 
-// create and set data
-    if (fit_dimension == 2) {
-      std::cout << "creating 2D data..." << std::endl;
-      model_fit_facade.setData(createData2D(lmd_data));
-    } else {
-      std::cout << "creating 1D data..." << std::endl;
-      model_fit_facade.setData(createData1D(lmd_data));
+void PndLmdFitFacade::carryParameterState(
+    std::shared_ptr<Model> previous_model, std::shared_ptr<Model> model) const {
+  auto &previous_parameters =
+      previous_model->getModelParameterSet().getModelParameterMap();
+  for (auto const& free_parameter :
+      model->getModelParameterSet().getFreeModelParameters()) {
+    auto previous_parameter = previous_parameters.find(free_parameter.first);
+    if (previous_parameter != previous_parameters.end()) {
+      free_parameter.second->setValue(previous_parameter->second->getValue());
+      std::cout << "setting " << free_parameter.first.second << " to "
+          << previous_parameter->second->getValue() << std::endl;
     }
-
-// now set better starting amplitude value
-    std::vector<DataStructs::DimensionRange> range = calcRange(lmd_data,
-        fit_options.getEstimatorOptions());
-    double integral_data = 0.0;
-    std::cout << "calculating data integral..." << std::endl;
-    if (fit_dimension == 2)
-      integral_data = calcHistIntegral(lmd_data.get2DHistogram(), range);
-    else
-      integral_data = calcHistIntegral(lmd_data.get1DHistogram(), range);
-    std::cout << "calculating model integral..." << std::endl;
-    double integral_func = model->Integral(range, 1e-1);
-    double binning_factor = lmd_data.getBinningFactor(fit_dimension);
-    double lumi_start = integral_data / integral_func / binning_factor;
-    cout << "binning factor: " << binning_factor << endl;
-    cout << "integral (model): " << integral_func << endl;
-    cout << integral_data << " / " << integral_func * binning_factor << endl;
-    cout << "Using start luminosity: " << lumi_start << endl;
-    model->getModelParameterSet().setModelParameterValue("luminosity", lumi_start);
-
-// create minimizer instance with control parameter
-    std::shared_ptr<ROOTMinimizer> minuit_minimizer(new ROOTMinimizer());
-    //std::shared_ptr<CeresMinimizer> ceres_minimizer(new CeresMinimizer());
-
-    model_fit_facade.setMinimizer(minuit_minimizer);
-    // create estimator
-    std::shared_ptr<ModelEstimator> estimator;
-    if (fit_options.estimator_type == LumiFit::CHI2)
-      estimator.reset(new Chi2Estimator());
-    else
-      estimator.reset(new LogLikelihoodEstimator());
-
-    PndLmdRuntimeConfiguration& lmd_runtime_config = PndLmdRuntimeConfiguration::Instance();
-
-    estimator->setNumberOfThreads(lmd_runtime_config.getNumberOfThreads());
-
-    model_fit_facade.setEstimator(estimator);
-    model_fit_facade.setEstimatorOptions(fit_options.getEstimatorOptions());
-
-    doFit(lmd_data, fit_options);
   }
 }
 
@@ -641,8 +685,18 @@ std::shared_ptr<Model> PndLmdFitFacade::generateModel(const PndLmdAngularData &l
 
 std::shared_ptr<Model> PndLmdFitFacade::generateModel(const PndLmdAngularData &lmd_data,
     const PndLmdFitOptions &fit_options) {
+  PndLmdModelFactory::ModelComponents model_components;
+  return generateModel(lmd_data, fit_options, model_components);
+}
+
+std::shared_ptr<Model> PndLmdFitFacade::generateModel(const PndLmdAngularData &lmd_data,
+    const PndLmdFitOptions &fit_options,
+    PndLmdModelFactory::ModelComponents &model_components) {
+  // the model generation uses ROOT objects, see #doLuminosityFits()
+  boost::lock_guard<boost::mutex> lock(root_object_mutex);
+
   std::shared_ptr<Model> model = model_factory.generateModel(
-      fit_options.getModelOptionsPropertyTree(), lmd_data);
+      fit_options.getModelOptionsPropertyTree(), lmd_data, model_components);
 
 // init beam parameters in model
   initBeamParametersForModel(model, fit_options.getModelOptionsPropertyTree());
@@ -672,9 +726,7 @@ void PndLmdFitFacade::scanEstimatorSpace(PndLmdHistogramData &lmd_hist_data,
   else
     estimator.reset(new LogLikelihoodEstimator());
 
-  PndLmdRuntimeConfiguration& lmd_runtime_config = PndLmdRuntimeConfiguration::Instance();
-
-  estimator->setNumberOfThreads(lmd_runtime_config.getNumberOfThreads());
+  estimator->setNumberOfThreads(number_of_threads);
 
   model_fit_facade.setEstimator(estimator);
 
@@ -685,15 +737,15 @@ void PndLmdFitFacade::scanEstimatorSpace(PndLmdHistogramData &lmd_hist_data,
   // lets make a 2d plot here
   TFile f("div_likelihood_scan.root", "RECREATE");
   //TH2D hist2d("name", "div likelihood scan", 60, 0.0000997, 0.000103, 60, 0.000194, 0.000206);
-  unsigned int bins(scanned_data.getData().size());
+  const BinnedDataSet& datapoints = scanned_data.getBinnedDataSet();
+  unsigned int bins(datapoints.size());
   TVectorD datax(bins);
   TVectorD datay(bins);
   TVectorD dataz(bins);
-  auto& datapoints = scanned_data.getData();
-  for (unsigned int i = 0; i < scanned_data.getData().size(); ++i) {
-    datax[i] = datapoints[i].getBinnedDataPoint()->bin_center_value[0];
-    datay[i] = datapoints[i].getBinnedDataPoint()->bin_center_value[1];
-    dataz[i] = datapoints[i].getBinnedDataPoint()->z;
+  for (unsigned int i = 0; i < bins; ++i) {
+    datax[i] = datapoints.getX()[i];
+    datay[i] = datapoints.getY()[i];
+    dataz[i] = datapoints.getZ()[i];
   }
   datax.Write("xdata");
   datay.Write("ydata");
@@ -721,9 +773,7 @@ void PndLmdFitFacade::doFit(PndLmdHistogramData &lmd_hist_data,
   else
     estimator.reset(new LogLikelihoodEstimator());
 
-  PndLmdRuntimeConfiguration& lmd_runtime_config = PndLmdRuntimeConfiguration::Instance();
-
-  estimator->setNumberOfThreads(lmd_runtime_config.getNumberOfThreads());
+  estimator->setNumberOfThreads(number_of_threads);
 
   model_fit_facade.setEstimator(estimator);
 
@@ -816,9 +866,7 @@ void PndLmdFitFacade::fitVertexData(std::vector<PndLmdHistogramData> &lmd_data)
     model_fit_facade.setModel(vertex_model);
 
     // create minimizer instance with control parameter
-    std::shared_ptr<ROOTMinimizer> minuit_minimizer(new ROOTMinimizer(1));
-
-    model_fit_facade.setMinimizer(minuit_minimizer);
+    model_fit_facade.setMinimizer(createMinimizer(fit_options, 1));
 
     doFit(lmd_data[i], fit_options);
   }
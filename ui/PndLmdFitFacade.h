@@ -24,11 +24,39 @@ class PndLmdHistogramData;
 
 class PndLmdFitFacade {
 private:
+  /**
+   * A single fit of #doLuminosityFits(): one data set, fitted with one of its
+   * matching acceptances if the acceptance correction is active.
+   */
+  struct LuminosityFitJob {
+    const PndLmdAngularData *lmd_data;
+    std::shared_ptr<const PndLmdAcceptance> acceptance;
+    bool with_resolution_map;
+    // threads of the models and the estimator of this fit
+    unsigned int number_of_threads;
+    // results of this job, for each fit option in the order of the fits
+    std::vector<std::pair<PndLmdFitOptions, ModelFitResult> > fit_results;
+  };
+
+  /**
+   * State handed from one stage of a staged fit to the next, see
+   * #runFitStage().
+   */
+  struct FitStageState {
+    // model and fit result of the last stage, empty before the first stage
+    std::shared_ptr<Model> model;
+    ModelFitResult fit_result;
+    PndLmdModelFactory::ModelComponents model_components;
+  };
+
   std::vector<PndLmdAcceptance> acceptance_pool;
   std::set<PndLmdHistogramData> resolution_pool;
   std::set<PndLmdMapData> resolution_map_pool;
 
   const PndLmdRuntimeConfiguration& lmd_runtime_config;
+  // threads of the models and estimators of the fits, see
+  // #setNumberOfThreads()
+  unsigned int number_of_threads;
 
   // ROOT data helper class
   ROOTDataHelper data_helper;
@@ -58,10 +86,58 @@ private:
 
   PndLmdFitOptions createFitOptions(const PndLmdAbstractData &lmd_data) const;
 
+  /**
+   * Creates the minimizer selected by the minimizer type of the fit options.
+   * minuit_type is passed on to the ROOTMinimizer.
+   */
+  std::shared_ptr<ModelMinimizer> createMinimizer(
+      const PndLmdFitOptions &fit_options, int minuit_type = 0) const;
+
+  /**
+   * Runs the fit of the job with a model factory and fit facade of its own,
+   * so that several jobs can run at the same time.
+   */
+  void runLuminosityFitJob(LuminosityFitJob &job) const;
+
+  std::shared_ptr<Model> generateModel(const PndLmdAngularData &lmd_data,
+      const PndLmdFitOptions &fit_options,
+      PndLmdModelFactory::ModelComponents &model_components);
+
+  /**
+   * Fits lmd_data with fit_options as the next stage of a staged fit and
+   * stores the model and fit result of this stage in state. The model is
+   * built with the model components of the state, so the acceptance and the
+   * resolution smearing are built only by the first stage. The first stage
+   * also sets the data and starts at a luminosity estimated from the data
+   * and model integrals. Each later stage starts at the parameters of the
+   * previous stage and uses their fitted errors as the initial step sizes of
+   * the minimizer (see ModelFitFacade::setWarmStart()). The start values of
+   * the parameters in scanned_parameter_names, which should be the ones that
+   * are new in this stage, are searched on a coarse grid before the fit.
+   */
+  void runFitStage(PndLmdAngularData &lmd_data,
+      const PndLmdFitOptions &fit_options,
+      const std::vector<std::string> &scanned_parameter_names,
+      FitStageState &state);
+
+  /**
+   * Sets the free parameters of model to the values of the parameters of
+   * previous_model with the same model and parameter name.
+   */
+  void carryParameterState(std::shared_ptr<Model> previous_model,
+      std::shared_ptr<Model> model) const;
+
 public:
   PndLmdFitFacade();
   virtual ~PndLmdFitFacade();
 
+  /**
+   * Sets the number of threads of each fit, which are used by the models
+   * and the estimator. The default is the number of threads of the runtime
+   * configuration.
+   */
+  void setNumberOfThreads(unsigned int number_of_threads_);
+
   void setModelFactoryAcceptence(const PndLmdAcceptance &lmd_acc);
   void setModelFactoryResolutions(
       const std::vector<PndLmdHistogramData> &lmd_res);
@@ -85,6 +161,15 @@ public:
   void initBeamParametersForModel(std::shared_ptr<Model> current_model,
       const boost::property_tree::ptree& model_opt_ptree) const;
 
+  /**
+   * Fits all data sets, each one with all of its matching acceptances if the
+   * acceptance correction is active. These fits are independent, so up to
+   * PndLmdRuntimeConfiguration::getNumberOfConcurrentFits() of them run at
+   * the same time. The number of threads of the runtime configuration is the
+   * core budget shared by the concurrent fits, each fit uses an equal part of
+   * it for its grid and estimator computations. The fit results are added to
+   * the data sets and the bundle in the same order as for a serial run.
+   */
   PndLmdFitDataBundle doLuminosityFits(
       std::vector<PndLmdAngularData>& lmd_data_vec);
 
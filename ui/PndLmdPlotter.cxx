@@ -275,6 +275,9 @@ namespace LumiFit {
     model->getModelParameterHandler().initModelParametersFromFitResult(
         data.getFitResults(fit_opt)[0]);
 
+    // trigger model calculations
+    model->updateModel();
+
     ModelVisualizationProperties1D vis_prop = create1DVisualizationProperties(
         fit_opt.getEstimatorOptions(), data);
 
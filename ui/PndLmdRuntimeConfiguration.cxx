@@ -11,7 +11,7 @@ using boost::filesystem::path;
 using boost::property_tree::ptree;
 
 PndLmdRuntimeConfiguration::PndLmdRuntimeConfiguration() :
-    number_of_threads(1), elastic_data_name("lmd_data.root"), acc_data_name(
+    number_of_threads(1), number_of_concurrent_fits(1), elastic_data_name("lmd_data.root"), acc_data_name(
         "lmd_acc_data.root"), res_data_name("lmd_res_data.root"), res_param_data_name(
         "resolution_params_1.root"), fitted_elastic_data_name(
         "lmd_fitted_data.root"), vertex_data_name("lmd_vertex_data.root") {
@@ -32,6 +32,9 @@ void PndLmdRuntimeConfiguration::readSimulationParameters(
 unsigned int PndLmdRuntimeConfiguration::getNumberOfThreads() const {
   return number_of_threads;
 }
+unsigned int PndLmdRuntimeConfiguration::getNumberOfConcurrentFits() const {
+  return number_of_concurrent_fits;
+}
 double PndLmdRuntimeConfiguration::getMomentum() const {
   return momentum;
 }
@@ -98,6 +101,10 @@ void PndLmdRuntimeConfiguration::setNumberOfThreads(
     unsigned int number_of_threads_) {
   number_of_threads = number_of_threads_;
 }
+void PndLmdRuntimeConfiguration::setNumberOfConcurrentFits(
+    unsigned int number_of_concurrent_fits_) {
+  number_of_concurrent_fits = number_of_concurrent_fits_;
+}
 void PndLmdRuntimeConfiguration::setMomentum(double momentum_) {
   momentum = momentum_;
 }
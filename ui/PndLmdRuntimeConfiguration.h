@@ -16,6 +16,7 @@
 class PndLmdRuntimeConfiguration {
 	//general config
 	unsigned int number_of_threads;
+	unsigned int number_of_concurrent_fits;
 	boost::property_tree::ptree general_config_tree;
 
 	// directory paths
@@ -66,6 +67,7 @@ public:
 
 	// getters
 	unsigned int getNumberOfThreads() const;
+	unsigned int getNumberOfConcurrentFits() const;
 	double getMomentum() const;
 	unsigned int getNumEvents() const;
 	double getTotalElasticCrossSection() const;
@@ -91,6 +93,12 @@ public:
 
 	// setters
 	void setNumberOfThreads(unsigned int number_of_threads_);
+	/**
+	 * Sets the maximal number of independent luminosity fits that are run at
+	 * the same time (see PndLmdFitFacade::doLuminosityFits()). The number of
+	 * threads is the core budget shared by these fits.
+	 */
+	void setNumberOfConcurrentFits(unsigned int number_of_concurrent_fits_);
 	void setMomentum(double momentum_);
 	void setNumEvents(unsigned int num_events_);
 	void setTotalElasticCrossSection(double total_elastic_cross_section_);